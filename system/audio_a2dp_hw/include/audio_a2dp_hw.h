@@ -85,6 +85,10 @@ typedef enum {
   A2DP_CTRL_GET_OUTPUT_AUDIO_CONFIG,
   A2DP_CTRL_SET_OUTPUT_AUDIO_CONFIG,
   A2DP_CTRL_GET_PRESENTATION_POSITION,
+  /* Switches the audio data to a shared memory PCM ring: after the ACK, the
+   * stack sends one octet along with the ring memfd and eventfd (SCM_RIGHTS).
+   * The data channel is still connected to start and stop the stream. */
+  A2DP_CTRL_GET_PCM_RING,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
@@ -150,6 +154,10 @@ size_t audio_a2dp_hw_stream_compute_buffer_size(
 // Returns whether the delay reporting property is set.
 bool delay_reporting_enabled();
 
+// Returns whether the audio data should be written to a shared memory PCM
+// ring instead of the data socket - see |A2DP_CTRL_GET_PCM_RING|.
+bool pcm_ring_enabled();
+
 // Returns a string representation of |event|.
 const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event);
 
@@ -47,6 +47,7 @@
 #include "osi/include/hash_map_utils.h"
 #include "osi/include/osi.h"
 #include "osi/include/socket_utils/sockets.h"
+#include "udrv/include/pcm_ring.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -123,6 +124,8 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  bool use_pcm_ring;    // Request a PCM ring when the data path is started
+  tPCM_RING* pcm_ring;  // Replaces the data socket for the audio data if set
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -339,6 +342,31 @@ static int skt_write(int fd, const void* p, size_t len) {
   return (int)count;
 }
 
+// Writes to the PCM ring shared with the stack, polling for room as
+// skt_write() does with the data socket.
+static int pcm_ring_write(tPCM_RING* ring, const void* p, size_t len) {
+  int ms_timeout = SOCK_SEND_TIMEOUT_MS;
+  size_t count = 0;
+
+  ts_log("pcm_ring_write", len, NULL);
+
+  while (count < len) {
+    uint32_t sent =
+        PCM_RING_Write(*ring, (const uint8_t*)p + count, len - count);
+    if (sent == 0) {
+      if (ms_timeout >= WRITE_POLL_MS) {
+        usleep(WRITE_POLL_MS * 1000);
+        ms_timeout -= WRITE_POLL_MS;
+        continue;
+      }
+      WARN("write timeout exceeded, sent %zu bytes", count);
+      return -1;
+    }
+    count += sent;
+  }
+  return (int)count;
+}
+
 static int skt_disconnect(int fd) {
   INFO("fd %d", fd);
 
@@ -476,6 +504,59 @@ static int a2dp_command(struct a2dp_stream_common* common, tA2DP_CTRL_CMD cmd) {
   return 0;
 }
 
+// Receives the PCM ring sent by the stack after the ACK of
+// A2DP_CTRL_GET_PCM_RING, and attaches to it.
+// On success, returns the ring, otherwise NULL.
+static tPCM_RING* a2dp_ctrl_receive_pcm_ring(
+    struct a2dp_stream_common* common) {
+  uint8_t msg;
+  struct iovec iov;
+  iov.iov_base = &msg;
+  iov.iov_len = sizeof(msg);
+  union {
+    char buf[CMSG_SPACE(sizeof(int) * 2)];
+    struct cmsghdr align;
+  } control;
+
+  struct msghdr hdr = {};
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = control.buf;
+  hdr.msg_controllen = sizeof(control.buf);
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = recvmsg(common->ctrl_fd, &hdr, MSG_CMSG_CLOEXEC));
+  if (ret <= 0) {
+    ERROR("receive PCM ring failed: error(%s)",
+          ret == 0 ? "peer closed" : strerror(errno));
+    skt_disconnect(common->ctrl_fd);
+    common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
+    return NULL;
+  }
+
+  int fds[2];
+  size_t num_fds = 0;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+  if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS) {
+    num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * num_fds);
+  }
+  if (num_fds != 2 || (hdr.msg_flags & MSG_CTRUNC)) {
+    ERROR("receive PCM ring failed: %zu descriptors", num_fds);
+    for (size_t i = 0; i < num_fds; i++) close(fds[i]);
+    return NULL;
+  }
+
+  std::unique_ptr<tPCM_RING> ring = PCM_RING_Attach(fds[0], fds[1]);
+  if (ring == nullptr) {
+    close(fds[0]);
+    close(fds[1]);
+    return NULL;
+  }
+  return ring.release();
+}
+
 static int check_a2dp_ready(struct a2dp_stream_common* common) {
   if (a2dp_command(common, A2DP_CTRL_CMD_CHECK_READY) < 0) {
     ERROR("check a2dp ready failed");
@@ -817,6 +898,11 @@ static void a2dp_open_ctrl_path(struct a2dp_stream_common* common) {
  *
  ****************************************************************************/
 
+static void a2dp_close_pcm_ring(struct a2dp_stream_common* common) {
+  delete common->pcm_ring;
+  common->pcm_ring = NULL;
+}
+
 static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
   FNLOG();
 
@@ -824,6 +910,8 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->use_pcm_ring = false;
+  common->pcm_ring = NULL;
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -833,10 +921,25 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
   FNLOG();
 
+  a2dp_close_pcm_ring(common);
   delete common->mutex;
   common->mutex = NULL;
 }
 
+// Requests a new PCM ring from the stack for the audio data. Stacks without
+// A2DP_CTRL_GET_PCM_RING NACK it, and the data socket is used instead.
+static void a2dp_open_pcm_ring(struct a2dp_stream_common* common) {
+  a2dp_close_pcm_ring(common);
+
+  if (a2dp_command(common, A2DP_CTRL_GET_PCM_RING) != 0) {
+    WARN("PCM ring not available, using the data socket");
+    return;
+  }
+  common->pcm_ring = a2dp_ctrl_receive_pcm_ring(common);
+  INFO("audio data written to %s",
+       common->pcm_ring != NULL ? "the PCM ring" : "the data socket");
+}
+
 static int start_audio_datapath(struct a2dp_stream_common* common) {
   INFO("state %d", common->state);
 
@@ -854,6 +957,8 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
 
   /* connect socket if not yet connected */
   if (common->audio_fd == AUDIO_SKT_DISCONNECTED) {
+    /* the stack reads from the ring as soon as the socket is connected */
+    if (common->use_pcm_ring) a2dp_open_pcm_ring(common);
     common->audio_fd = skt_connect(A2DP_DATA_PATH, common->buffer_sz);
     if (common->audio_fd < 0) {
       ERROR("Audiopath start failed - error opening data socket");
@@ -963,7 +1068,12 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   }
 
   lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  // The ring is only replaced when the data path is started, by this thread
+  if (out->common.pcm_ring != NULL) {
+    sent = pcm_ring_write(out->common.pcm_ring, buffer, write_bytes);
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   lock.lock();
 
   if (sent == -1) {
@@ -1616,6 +1726,7 @@ static int adev_open_output_stream(struct audio_hw_device* dev,
 
   /* initialize a2dp specifics */
   a2dp_stream_common_init(&out->common);
+  out->common.use_pcm_ring = pcm_ring_enabled();
 
   // Make sure we always have the feeding parameters configured
   btav_a2dp_codec_config_t codec_config;
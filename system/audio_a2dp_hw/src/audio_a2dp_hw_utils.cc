@@ -34,6 +34,7 @@ const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event) {
     CASE_RETURN_STR(A2DP_CTRL_GET_OUTPUT_AUDIO_CONFIG)
     CASE_RETURN_STR(A2DP_CTRL_SET_OUTPUT_AUDIO_CONFIG)
     CASE_RETURN_STR(A2DP_CTRL_GET_PRESENTATION_POSITION)
+    CASE_RETURN_STR(A2DP_CTRL_GET_PCM_RING)
   }
 
   return "UNKNOWN A2DP_CTRL_CMD";
@@ -42,3 +43,8 @@ const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event) {
 bool delay_reporting_enabled() {
   return !osi_property_get_bool("persist.bluetooth.disabledelayreports", false);
 }
+
+bool pcm_ring_enabled() {
+  return osi_property_get_bool("persist.bluetooth.a2dp_pcm_ring.enabled",
+                               false);
+}
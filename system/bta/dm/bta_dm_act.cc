@@ -39,6 +39,7 @@
 #include "bta/dm/bta_dm_int.h"
 #include "bta/dm/bta_dm_sec_int.h"
 #include "bta/include/bta_api.h"
+#include "bta/include/bta_gatt_api.h"
 #include "bta/include/bta_le_audio_api.h"
 #include "bta/include/bta_sdp_api.h"
 #include "bta/include/bta_sec_api.h"
@@ -1617,6 +1618,32 @@ void bta_dm_clear_filter_accept_list(void) {
   bluetooth::shim::BTM_ClearFilterAcceptList();
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_dm_begin_le_list_updates
+ *
+ * Description      Starts staging the accept and resolving list updates.
+ *
+ ******************************************************************************/
+void bta_dm_begin_le_list_updates(void) {
+  bluetooth::shim::ACL_BeginLeListUpdates();
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_commit_le_list_updates
+ *
+ * Description      Sends the accept and resolving list updates staged since
+ *                  the matching bta_dm_begin_le_list_updates. Profiles restore
+ *                  their accept list entries with BTA_GATTC_Open, so the
+ *                  updates are sent once the queued open requests are done.
+ *
+ ******************************************************************************/
+void bta_dm_commit_le_list_updates(void) {
+  BTA_GATTC_RunAfterQueuedOpens(
+      base::BindOnce(bluetooth::shim::ACL_CommitLeListUpdates));
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_disconnect_all_acls
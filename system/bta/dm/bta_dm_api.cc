@@ -341,6 +341,37 @@ void BTA_DmClearFilterAcceptList(void) {
   do_in_main_thread(FROM_HERE, base::BindOnce(bta_dm_clear_filter_accept_list));
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_DmBeginLeListUpdates
+ *
+ * Description      This function starts a batch of accept list and resolving
+ *                  list updates, e.g. when loading the bonded devices. The
+ *                  updates made on the main thread until
+ *                  BTA_DmCommitLeListUpdates runs there are sent to the
+ *                  controller together. Batches may be nested.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_DmBeginLeListUpdates(void) {
+  do_in_main_thread(FROM_HERE, base::BindOnce(bta_dm_begin_le_list_updates));
+}
+
+/*******************************************************************************
+ *
+ * Function         BTA_DmCommitLeListUpdates
+ *
+ * Description      This function ends a batch started by
+ *                  BTA_DmBeginLeListUpdates.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_DmCommitLeListUpdates(void) {
+  do_in_main_thread(FROM_HERE, base::BindOnce(bta_dm_commit_le_list_updates));
+}
+
 /*******************************************************************************
  *
  * Function         BTA_DmLeRand
@@ -329,6 +329,8 @@ tBTA_DM_PEER_DEVICE* bta_dm_find_peer_device(const RawAddress& peer_addr);
 void bta_dm_clear_event_filter(void);
 void bta_dm_clear_event_mask(void);
 void bta_dm_clear_filter_accept_list(void);
+void bta_dm_begin_le_list_updates(void);
+void bta_dm_commit_le_list_updates(void);
 void bta_dm_disconnect_all_acls(void);
 void bta_dm_le_rand(bluetooth::hci::LeRandCallback cb);
 void bta_dm_set_event_filter_connection_setup_all_devices();
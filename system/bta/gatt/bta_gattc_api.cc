@@ -27,8 +27,10 @@
 #include <base/functional/bind.h>
 #include <bluetooth/log.h>
 
+#include <atomic>
 #include <ios>
 #include <list>
+#include <utility>
 #include <vector>
 
 #include "bta/gatt/bta_gattc_int.h"
@@ -52,6 +54,11 @@ using namespace bluetooth;
 static const tBTA_SYS_REG bta_gattc_reg = {bta_gattc_hdl_event,
                                            BTA_GATTC_Disable};
 
+/* Open requests posted to the main thread and not processed yet */
+static std::atomic<size_t> bta_gattc_queued_opens{0};
+/* Run on the main thread once no open request is queued */
+static std::vector<base::OnceClosure> bta_gattc_after_queued_opens;
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_Disable
@@ -165,7 +172,34 @@ void BTA_GATTC_Open(tGATT_IF client_if, const RawAddress& remote_bda,
           },
   };
 
-  post_on_bt_main([data]() { bta_gattc_process_api_open(&data); });
+  bta_gattc_queued_opens++;
+  post_on_bt_main([data]() {
+    bta_gattc_process_api_open(&data);
+    if (--bta_gattc_queued_opens > 0) return;
+
+    std::vector<base::OnceClosure> callbacks;
+    std::swap(callbacks, bta_gattc_after_queued_opens);
+    for (auto& callback : callbacks) {
+      std::move(callback).Run();
+    }
+  });
+}
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_RunAfterQueuedOpens
+ *
+ * Description      Runs |callback| once the open requests queued so far have
+ *                  been processed, e.g. to follow the accept list updates of
+ *                  background connections. Must be called on the main thread.
+ *
+ ******************************************************************************/
+void BTA_GATTC_RunAfterQueuedOpens(base::OnceClosure callback) {
+  if (bta_gattc_queued_opens == 0) {
+    std::move(callback).Run();
+    return;
+  }
+  bta_gattc_after_queued_opens.push_back(std::move(callback));
 }
 
 void BTA_GATTC_Open(tGATT_IF client_if, const RawAddress& remote_bda,
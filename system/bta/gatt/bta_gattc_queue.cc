@@ -19,6 +19,7 @@
 #include <bluetooth/log.h>
 
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -26,6 +27,9 @@
 #include "bta_gatt_queue.h"
 #include "os/log.h"
 #include "osi/include/allocator.h"
+#include "stack/gatt/gatt_int.h"
+#include "stack/include/gatt_api.h"
+#include "types/raw_address.h"
 
 using gatt_operation = BtaGattQueue::gatt_operation;
 using namespace bluetooth;
@@ -45,6 +49,7 @@ struct gatt_read_op_data {
 std::unordered_map<uint16_t, std::list<gatt_operation>>
     BtaGattQueue::gatt_op_queue;
 std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_executing;
+std::unordered_set<uint16_t> BtaGattQueue::gatt_read_coalesce_disabled;
 
 void BtaGattQueue::mark_as_not_executing(uint16_t conn_id) {
   gatt_op_queue_executing.erase(conn_id);
@@ -139,6 +144,129 @@ void BtaGattQueue::gatt_read_multi_op_finished(uint16_t conn_id,
   }
 }
 
+struct gatt_read_coalesced_op_data {
+  struct read {
+    uint16_t handle;
+    GATT_READ_OP_CB cb;
+    void* cb_data;
+  };
+  std::vector<read> reads;
+};
+
+bool BtaGattQueue::gatt_read_coalesce_supported(uint16_t conn_id) {
+  if (gatt_read_coalesce_disabled.count(conn_id)) return false;
+
+  tGATT_IF gatt_if;
+  RawAddress bd_addr;
+  tBT_TRANSPORT transport;
+  if (!GATT_GetConnectionInfor(conn_id, &gatt_if, bd_addr, &transport)) {
+    return false;
+  }
+  return transport == BT_TRANSPORT_LE && gatt_profile_get_eatt_support(bd_addr);
+}
+
+/* Sends the characteristic reads at the front of |gatt_ops| as a single Read
+ * Multiple Variable Length request. Returns false if there is only one read to
+ * send. */
+bool BtaGattQueue::gatt_execute_coalesced_read(
+    uint16_t conn_id, std::list<gatt_operation>& gatt_ops) {
+  size_t num_reads = 0;
+  for (const gatt_operation& op : gatt_ops) {
+    if (op.type != GATT_READ_CHAR || op.read_alone ||
+        num_reads == GATT_MAX_READ_MULTI_HANDLES) {
+      break;
+    }
+    num_reads++;
+  }
+  if (num_reads < 2 || !gatt_read_coalesce_supported(conn_id)) return false;
+
+  auto* data = new gatt_read_coalesced_op_data();
+  tBTA_GATTC_MULTI handles = {.num_attr = static_cast<uint8_t>(num_reads)};
+  for (size_t i = 0; i < num_reads; i++) {
+    gatt_operation& op = gatt_ops.front();
+    handles.handles[i] = op.handle;
+    data->reads.push_back({op.handle, op.read_cb, op.read_cb_data});
+    gatt_ops.pop_front();
+  }
+
+  log::verbose("conn_id=0x{:x}, coalescing {} reads", conn_id, num_reads);
+  BTA_GATTC_ReadMultiple(conn_id, handles, true, GATT_AUTH_REQ_NONE,
+                         gatt_read_coalesced_op_finished, data);
+  return true;
+}
+
+void BtaGattQueue::gatt_read_coalesced_op_finished(
+    uint16_t conn_id, tGATT_STATUS status, tBTA_GATTC_MULTI& /* handles */,
+    uint16_t len, uint8_t* value, void* data) {
+  std::unique_ptr<gatt_read_coalesced_op_data> op_data(
+      static_cast<gatt_read_coalesced_op_data*>(data));
+  auto& reads = op_data->reads;
+
+  /* Reads queued after this one were dropped if the queue was cleaned */
+  bool cleaned = !gatt_op_queue_executing.count(conn_id);
+  mark_as_not_executing(conn_id);
+
+  if (status != GATT_SUCCESS) {
+    tGATT_IF gatt_if;
+    RawAddress bd_addr;
+    tBT_TRANSPORT transport;
+    if (cleaned ||
+        !GATT_GetConnectionInfor(conn_id, &gatt_if, bd_addr, &transport)) {
+      gatt_execute_next_op(conn_id);
+      for (const auto& read : reads) {
+        if (read.cb) {
+          read.cb(conn_id, status, read.handle, 0, value, read.cb_data);
+        }
+      }
+      return;
+    }
+
+    log::info("conn_id=0x{:x}, coalesced read failed with {}, reading alone",
+              conn_id, gatt_status_text(status));
+    gatt_read_coalesce_disabled.insert(conn_id);
+  }
+
+  /* The response holds a length and a value for each handle, the last ones
+   * possibly truncated to the MTU. Complete reads are delivered, the others
+   * are queued again, the first incomplete one to be read on its own. */
+  struct read_result {
+    uint16_t len;
+    uint8_t* value;
+  };
+  std::vector<read_result> results;
+  if (status == GATT_SUCCESS) {
+    uint8_t* p = value;
+    uint16_t remaining = len;
+    while (results.size() < reads.size() && remaining >= 2) {
+      uint16_t value_len = p[0] | (p[1] << 8);
+      if (value_len > remaining - 2) break;
+      results.push_back({value_len, p + 2});
+      p += 2 + value_len;
+      remaining -= 2 + value_len;
+    }
+  }
+
+  if (!cleaned && results.size() < reads.size()) {
+    auto& gatt_ops = gatt_op_queue[conn_id];
+    for (size_t i = reads.size(); i > results.size(); i--) {
+      const auto& read = reads[i - 1];
+      gatt_ops.push_front({.type = GATT_READ_CHAR,
+                           .handle = read.handle,
+                           .read_cb = read.cb,
+                           .read_cb_data = read.cb_data,
+                           .read_alone = (i - 1 == results.size())});
+    }
+  }
+  gatt_execute_next_op(conn_id);
+
+  for (size_t i = 0; i < results.size(); i++) {
+    if (reads[i].cb) {
+      reads[i].cb(conn_id, GATT_SUCCESS, reads[i].handle, results[i].len,
+                  results[i].value, reads[i].cb_data);
+    }
+  }
+}
+
 void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
   log::verbose("conn_id=0x{:x}", conn_id);
   if (gatt_op_queue.empty()) {
@@ -161,6 +289,8 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
 
   std::list<gatt_operation>& gatt_ops = map_ptr->second;
 
+  if (gatt_execute_coalesced_read(conn_id, gatt_ops)) return;
+
   gatt_operation& op = gatt_ops.front();
 
   if (op.type == GATT_READ_CHAR) {
@@ -219,6 +349,7 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
 void BtaGattQueue::Clean(uint16_t conn_id) {
   gatt_op_queue.erase(conn_id);
   gatt_op_queue_executing.erase(conn_id);
+  gatt_read_coalesce_disabled.erase(conn_id);
 }
 
 void BtaGattQueue::ReadCharacteristic(uint16_t conn_id, uint16_t handle,
@@ -21,6 +21,7 @@
 #include <bluetooth/log.h>
 
 #include <algorithm>
+#include <iterator>
 #include <list>
 #include <sstream>
 
@@ -46,6 +47,10 @@ const Uuid CHARACTERISTIC_EXTENDED_PROPERTIES =
 bool HandleInRange(const Service& svc, uint16_t handle) {
   return handle >= svc.handle && handle <= svc.end_handle;
 }
+
+/* An index entry takes 16 times the size of a handle slot; the slot table is
+ * used when it is smaller than the index. */
+constexpr size_t kHandleSlotsPerEntry = 16;
 }  // namespace
 
 static size_t UuidSize(const Uuid& uuid) {
@@ -62,6 +67,156 @@ Service* FindService(std::list<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+Database::Database(const Database& other) : services(other.services) {
+  BuildHandleIndex();
+}
+
+Database& Database::operator=(const Database& other) {
+  if (this != &other) {
+    services = other.services;
+    BuildHandleIndex();
+  }
+  return *this;
+}
+
+void Database::BuildHandleIndex() {
+  handle_index.clear();
+  handle_slots.clear();
+  service_index.clear();
+
+  uint16_t previous_end_handle = 0;
+  for (const Service& service : services) {
+    if (service.handle > service.end_handle ||
+        (!service_index.empty() && service.handle <= previous_end_handle)) {
+      log::warn("services out of order or overlapping, not indexing");
+      handle_index.clear();
+      service_index.clear();
+      return;
+    }
+    previous_end_handle = service.end_handle;
+    service_index.push_back(&service);
+
+    for (const Characteristic& c : service.characteristics) {
+      handle_index.push_back({c.value_handle, &service, &c, nullptr});
+      for (const Descriptor& d : c.descriptors) {
+        handle_index.push_back({d.handle, &service, &c, &d});
+      }
+    }
+  }
+
+  std::sort(handle_index.begin(), handle_index.end(),
+            [](const HandleIndexEntry& a, const HandleIndexEntry& b) {
+              return a.handle < b.handle;
+            });
+
+  for (size_t i = 0; i < handle_index.size(); i++) {
+    const HandleIndexEntry& entry = handle_index[i];
+    if (!HandleInRange(*entry.service, entry.handle) ||
+        (i > 0 && handle_index[i - 1].handle == entry.handle)) {
+      log::warn("attribute handle 0x{:x} misplaced or repeated, not indexing",
+                entry.handle);
+      handle_index.clear();
+      service_index.clear();
+      return;
+    }
+  }
+
+  // Resolve handles directly when the table takes less memory than the index
+  if (handle_index.empty()) return;
+  handle_slots_base = handle_index.front().handle;
+  size_t span = handle_index.back().handle - handle_slots_base + 1;
+  if (span > kHandleSlotsPerEntry * handle_index.size()) return;
+  handle_slots.assign(span, 0);
+  for (size_t i = 0; i < handle_index.size(); i++) {
+    handle_slots[handle_index[i].handle - handle_slots_base] = i + 1;
+  }
+}
+
+const Service* Database::FindService(uint16_t handle) const {
+  if (!HasHandleIndex()) {
+    for (const Service& service : services) {
+      if (HandleInRange(service, handle)) return &service;
+    }
+    return nullptr;
+  }
+
+  auto it = std::upper_bound(
+      service_index.begin(), service_index.end(), handle,
+      [](uint16_t handle, const Service* s) { return handle < s->handle; });
+  if (it == service_index.begin()) return nullptr;
+  const Service* service = *std::prev(it);
+  return HandleInRange(*service, handle) ? service : nullptr;
+}
+
+const Characteristic* Database::FindCharacteristic(uint16_t handle) const {
+  if (!HasHandleIndex()) {
+    const Service* service = FindService(handle);
+    if (!service) return nullptr;
+    for (const Characteristic& c : service->characteristics) {
+      if (c.value_handle == handle) return &c;
+    }
+    return nullptr;
+  }
+
+  const HandleIndexEntry* entry = FindHandleIndexEntry(handle);
+  if (!entry || entry->descriptor) return nullptr;
+  return entry->characteristic;
+}
+
+const Descriptor* Database::FindDescriptor(uint16_t handle) const {
+  if (!HasHandleIndex()) {
+    const Service* service = FindService(handle);
+    if (!service) return nullptr;
+    for (const Characteristic& c : service->characteristics) {
+      for (const Descriptor& d : c.descriptors) {
+        if (d.handle == handle) return &d;
+      }
+    }
+    return nullptr;
+  }
+
+  const HandleIndexEntry* entry = FindHandleIndexEntry(handle);
+  return entry ? entry->descriptor : nullptr;
+}
+
+const Characteristic* Database::FindOwningCharacteristic(
+    uint16_t handle) const {
+  if (!HasHandleIndex()) {
+    const Service* service = FindService(handle);
+    if (!service) return nullptr;
+    for (const Characteristic& c : service->characteristics) {
+      for (const Descriptor& d : c.descriptors) {
+        if (d.handle == handle) return &c;
+      }
+    }
+    return nullptr;
+  }
+
+  const HandleIndexEntry* entry = FindHandleIndexEntry(handle);
+  if (!entry || !entry->descriptor) return nullptr;
+  return entry->characteristic;
+}
+
+const Database::HandleIndexEntry* Database::FindHandleIndexEntry(
+    uint16_t handle) const {
+  if (!handle_slots.empty()) {
+    size_t offset = handle - handle_slots_base;
+    if (handle < handle_slots_base || offset >= handle_slots.size()) {
+      return nullptr;
+    }
+    uint16_t slot = handle_slots[offset];
+    return slot ? &handle_index[slot - 1] : nullptr;
+  }
+
+  auto it = std::lower_bound(
+      handle_index.begin(), handle_index.end(), handle,
+      [](const HandleIndexEntry& e, uint16_t handle) {
+        return e.handle < handle;
+      });
+  if (it == handle_index.end() || it->handle != handle) return nullptr;
+  return &*it;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -140,11 +295,17 @@ std::vector<StoredAttribute> Database::Serialize() const {
 
 Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
                                bool* success) {
+  return Deserialize(nv_attr.data(), nv_attr.size(), success);
+}
+
+Database Database::Deserialize(const StoredAttribute* nv_attr, size_t count,
+                               bool* success) {
   // clear reallocating
   Database result;
-  auto it = nv_attr.cbegin();
+  const StoredAttribute* it = nv_attr;
+  const StoredAttribute* end = nv_attr + count;
 
-  for (; it != nv_attr.cend(); ++it) {
+  for (; it != end; ++it) {
     const auto& attr = *it;
     if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE) break;
     result.services.emplace_back(Service{
@@ -158,7 +319,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
   }
 
   auto current_service_it = result.services.begin();
-  for (; it != nv_attr.cend(); it++) {
+  for (; it != end; it++) {
     const auto& attr = *it;
 
     // go to the service this attribute belongs to; attributes are stored in
@@ -177,8 +338,8 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
     }
 
     if (attr.type == INCLUDE) {
-      Service* included_service =
-          FindService(result.services, attr.value.included_service.handle);
+      Service* included_service = gatt::FindService(
+          result.services, attr.value.included_service.handle);
       if (!included_service) {
         log::error("Non-existing included service!");
         *success = false;
@@ -217,6 +378,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
       }
     }
   }
+  result.BuildHandleIndex();
   *success = true;
   return result;
 }
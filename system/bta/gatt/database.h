@@ -104,22 +104,48 @@ class DatabaseBuilder;
 
 class Database {
  public:
+  Database() = default;
+  Database(const Database& other);
+  Database& operator=(const Database& other);
+  Database(Database&& other) = default;
+  Database& operator=(Database&& other) = default;
+
   /* Return true if there are no services in this database. */
   bool IsEmpty() const { return services.empty(); }
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::list<Service>().swap(services); }
+  void Clear() {
+    std::list<Service>().swap(services);
+    std::vector<HandleIndexEntry>().swap(handle_index);
+    std::vector<uint16_t>().swap(handle_slots);
+    std::vector<const Service*>().swap(service_index);
+  }
 
   /* Return list of services available in this database */
   const std::list<Service>& Services() const { return services; }
 
+  /* Return the service whose handle range contains |handle|. */
+  const Service* FindService(uint16_t handle) const;
+
+  /* Return the characteristic with value handle |handle|. */
+  const Characteristic* FindCharacteristic(uint16_t handle) const;
+
+  /* Return the descriptor with handle |handle|. */
+  const Descriptor* FindDescriptor(uint16_t handle) const;
+
+  /* Return the characteristic owning the descriptor with handle |handle|. */
+  const Characteristic* FindOwningCharacteristic(uint16_t handle) const;
+
   std::string ToString() const;
 
   std::vector<gatt::StoredAttribute> Serialize() const;
 
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
                               bool* success);
+  /* Deserialize |count| attributes, e.g. mapped from storage */
+  static Database Deserialize(const gatt::StoredAttribute* nv_attr,
+                              size_t count, bool* success);
 
   /* Return 128 bit unique identifier of this GATT database */
   Octet16 Hash() const;
@@ -127,7 +153,32 @@ class Database {
   friend class DatabaseBuilder;
 
  private:
+  /* Entry of the handle index: a characteristic value or descriptor handle,
+   * and the attributes it resolves to. */
+  struct HandleIndexEntry {
+    uint16_t handle;
+    const Service* service;
+    const Characteristic* characteristic;
+    const Descriptor* descriptor;
+  };
+
+  /* Build the handle indexes once the services are final. The indexes are
+   * left empty, and the lookups walk the services instead, when the services
+   * overlap or handles are repeated. */
+  void BuildHandleIndex();
+  bool HasHandleIndex() const { return !service_index.empty(); }
+  const HandleIndexEntry* FindHandleIndexEntry(uint16_t handle) const;
+
   std::list<Service> services;
+
+  /* Characteristic value and descriptor handles, sorted by handle */
+  std::vector<HandleIndexEntry> handle_index;
+  /* When the handles are dense enough, position in |handle_index| plus one of
+   * each handle from |handle_slots_base|, or 0 if the handle isn't indexed */
+  std::vector<uint16_t> handle_slots;
+  uint16_t handle_slots_base = 0;
+  /* Services sorted by start handle */
+  std::vector<const Service*> service_index;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
@@ -0,0 +1,571 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_bta_gattc"
+
+#include "gatt/database_store.h"
+
+#include <base/strings/string_number_conversions.h>
+#include <bluetooth/log.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <ctime>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "osi/include/osi.h"
+#include "stack/include/gattdefs.h"
+
+using namespace bluetooth;
+
+namespace gatt {
+
+namespace {
+
+/* File layout: a FileHeader, then records made of a RecordHeader and a
+ * payload padded to kRecordAlignment, so that the attributes of a mapped
+ * database record are suitably aligned. */
+constexpr uint32_t kFileMagic = 0x53424447; /* "GDBS" */
+constexpr uint16_t kFileVersion = 1;
+constexpr size_t kRecordAlignment = 8;
+
+/* Compact once obsolete records take this much and more than live ones */
+constexpr off_t kCompactionThreshold = 64 * 1024;
+
+enum RecordType : uint16_t {
+  kRecordDatabase = 1,
+  kRecordLink = 2,
+  kRecordUnlink = 3,
+  kRecordRemove = 4,
+};
+
+struct FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+};
+
+struct RecordHeader {
+  uint16_t type;
+  uint16_t reserved;
+  uint32_t length;
+  uint32_t checksum;
+  uint32_t reserved2;
+};
+
+struct DatabaseRecord {
+  Octet16 hash;
+  int64_t write_time;
+  uint16_t num_attributes;
+  uint8_t reserved[6];
+  /* followed by num_attributes StoredAttribute */
+};
+
+struct LinkRecord {
+  uint8_t address[6];
+  uint8_t reserved[2];
+  Octet16 hash;
+};
+
+static_assert(sizeof(FileHeader) % kRecordAlignment == 0);
+static_assert(sizeof(RecordHeader) % kRecordAlignment == 0);
+static_assert(sizeof(DatabaseRecord) % kRecordAlignment == 0);
+static_assert(sizeof(StoredAttribute) == StoredAttribute::kSizeOnDisk);
+static_assert(kRecordAlignment % alignof(StoredAttribute) == 0);
+
+constexpr size_t padded(size_t length) {
+  return (length + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+constexpr off_t kLinkRecordSize =
+    sizeof(RecordHeader) + padded(sizeof(LinkRecord));
+
+/* FNV-1a style hash of the record type, length and payload, taken a word at
+ * a time to keep indexing a large store cheap */
+uint32_t checksum(uint16_t type, const uint8_t* payload, uint32_t length) {
+  constexpr uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL ^ ((uint64_t)type << 32 | length);
+  hash *= kPrime;
+  uint32_t i = 0;
+  for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, payload + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+    hash ^= hash >> 29;
+  }
+  for (; i < length; i++) hash = (hash ^ payload[i]) * kPrime;
+  return (uint32_t)(hash ^ (hash >> 32));
+}
+
+std::vector<uint8_t> make_record(uint16_t type, const uint8_t* payload,
+                                 uint32_t length) {
+  std::vector<uint8_t> record(sizeof(RecordHeader) + padded(length), 0);
+  RecordHeader header = {.type = type,
+                         .reserved = 0,
+                         .length = length,
+                         .checksum = checksum(type, payload, length),
+                         .reserved2 = 0};
+  memcpy(record.data(), &header, sizeof(header));
+  memcpy(record.data() + sizeof(header), payload, length);
+  return record;
+}
+
+bool write_all(int fd, const uint8_t* data, size_t len, off_t offset) {
+  while (len > 0) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = pwrite(fd, data, len, offset));
+    if (ret <= 0) return false;
+    data += ret;
+    len -= ret;
+    offset += ret;
+  }
+  return true;
+}
+
+void sync_directory(const std::string& path) {
+  std::string dir = path.substr(0, path.find_last_of('/') + 1);
+  int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd < 0) return;
+  fsync(dir_fd);
+  close(dir_fd);
+}
+
+const std::vector<uint8_t> kFileHeaderBytes = [] {
+  FileHeader header = {
+      .magic = kFileMagic, .version = kFileVersion, .reserved = 0};
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&header);
+  return std::vector<uint8_t>(p, p + sizeof(header));
+}();
+
+}  // namespace
+
+void StoredAttribute::SerializeStoredAttribute(const StoredAttribute& attr,
+                                               std::vector<uint8_t>& bytes) {
+  size_t original_size = bytes.size();
+  // handle
+  bytes.push_back(attr.handle & 0xff);
+  bytes.push_back(attr.handle >> 8);
+  auto uuid = attr.type.To128BitBE();
+  bytes.insert(bytes.cend(), uuid.cbegin(), uuid.cend());
+
+  if (attr.type.Is16Bit()) {
+    switch (attr.type.As16Bit()) {
+      /* primary or secondary service definition */
+      case GATT_UUID_PRI_SERVICE:
+      case GATT_UUID_SEC_SERVICE:
+        uuid = attr.value.service.uuid.To128BitBE();
+        bytes.insert(bytes.cend(), uuid.cbegin(), uuid.cend());
+        bytes.push_back(attr.value.service.end_handle & 0xff);
+        bytes.push_back(attr.value.service.end_handle >> 8);
+        break;
+      case GATT_UUID_INCLUDE_SERVICE:
+        /* included service definition */
+        bytes.push_back(attr.value.included_service.handle & 0xff);
+        bytes.push_back(attr.value.included_service.handle >> 8);
+        bytes.push_back(attr.value.included_service.end_handle & 0xff);
+        bytes.push_back(attr.value.included_service.end_handle >> 8);
+        uuid = attr.value.included_service.uuid.To128BitBE();
+        bytes.insert(bytes.cend(), uuid.cbegin(), uuid.cend());
+        break;
+      case GATT_UUID_CHAR_DECLARE:
+        /* characteristic definition */
+        bytes.push_back(attr.value.characteristic.properties);
+        bytes.push_back(0);  // Padding byte
+        bytes.push_back(attr.value.characteristic.value_handle & 0xff);
+        bytes.push_back(attr.value.characteristic.value_handle >> 8);
+        uuid = attr.value.characteristic.uuid.To128BitBE();
+        bytes.insert(bytes.cend(), uuid.cbegin(), uuid.cend());
+        break;
+      case GATT_UUID_CHAR_EXT_PROP:
+        /* for descriptor we store value only for
+         * «Characteristic Extended Properties» */
+        bytes.push_back(attr.value.characteristic_extended_properties & 0xff);
+        bytes.push_back(attr.value.characteristic_extended_properties >> 8);
+        break;
+      default:
+        // log::verbose("Unhandled type UUID 0x{:04x}", attr.type.As16Bit());
+        break;
+    }
+  }
+  // padding
+  for (size_t i = bytes.size() - original_size;
+       i < StoredAttribute::kSizeOnDisk; i++) {
+    bytes.push_back(0);
+  }
+}
+
+DatabaseStore::~DatabaseStore() { Close(); }
+
+bool DatabaseStore::Open(const std::string& path) {
+  Close();
+  path_ = path;
+
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+  if (fd_ < 0) {
+    log::error("can't open GATT database store {}, error: {}", path,
+               strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd_, &st) < 0) {
+    log::error("can't stat GATT database store {}, error: {}", path,
+               strerror(errno));
+    Close();
+    return false;
+  }
+  file_size_ = st.st_size;
+
+  if (file_size_ < (off_t)sizeof(FileHeader) || !Map() ||
+      memcmp(map_, kFileHeaderBytes.data(), sizeof(FileHeader)) != 0) {
+    if (file_size_ != 0) {
+      log::warn("discarding GATT database store {} with unknown format", path);
+    }
+    if (!Reset()) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  Replay();
+  return true;
+}
+
+void DatabaseStore::Close() {
+  Unmap();
+  if (fd_ != -1) close(fd_);
+  fd_ = -1;
+  file_size_ = 0;
+  obsolete_bytes_ = 0;
+  databases_.clear();
+  links_.clear();
+}
+
+/* Truncate the store to an empty log */
+bool DatabaseStore::Reset() {
+  Unmap();
+  databases_.clear();
+  links_.clear();
+  obsolete_bytes_ = 0;
+  if (ftruncate(fd_, 0) < 0 ||
+      !write_all(fd_, kFileHeaderBytes.data(), kFileHeaderBytes.size(), 0) ||
+      fsync(fd_) < 0) {
+    log::error("can't initialize GATT database store {}, error: {}", path_,
+               strerror(errno));
+    return false;
+  }
+  sync_directory(path_);
+  file_size_ = kFileHeaderBytes.size();
+  return Map();
+}
+
+bool DatabaseStore::Map() {
+  Unmap();
+  void* addr = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    log::error("can't map GATT database store {}, error: {}", path_,
+               strerror(errno));
+    return false;
+  }
+  map_ = static_cast<const uint8_t*>(addr);
+  map_size_ = file_size_;
+  return true;
+}
+
+void DatabaseStore::Unmap() {
+  if (map_ != nullptr) munmap(const_cast<uint8_t*>(map_), map_size_);
+  map_ = nullptr;
+  map_size_ = 0;
+}
+
+/* Rebuild the index from the records. The log is cut at the first record that
+ * is incomplete or fails its checksum, i.e. one torn by a crash. */
+void DatabaseStore::Replay() {
+  off_t offset = sizeof(FileHeader);
+  while (offset < file_size_) {
+    if (file_size_ - offset < (off_t)sizeof(RecordHeader)) break;
+    RecordHeader header;
+    memcpy(&header, map_ + offset, sizeof(header));
+    off_t record_size = sizeof(RecordHeader) + padded(header.length);
+    if (file_size_ - offset < record_size) break;
+    if (checksum(header.type, map_ + offset + sizeof(RecordHeader),
+                 header.length) != header.checksum) {
+      break;
+    }
+    if (!ApplyRecord(header.type, offset, record_size)) break;
+    offset += record_size;
+  }
+
+  if (offset < file_size_) {
+    log::warn("dropping {} bytes of GATT database store {} from offset {}",
+              file_size_ - offset, path_, offset);
+    if (ftruncate(fd_, offset) < 0 || fsync(fd_) < 0) {
+      log::error("can't truncate GATT database store {}, error: {}", path_,
+                 strerror(errno));
+    }
+    file_size_ = offset;
+    Map();
+  }
+}
+
+bool DatabaseStore::ApplyRecord(uint16_t type, off_t record_offset,
+                                off_t record_size) {
+  const uint8_t* payload = map_ + record_offset + sizeof(RecordHeader);
+  RecordHeader header;
+  memcpy(&header, map_ + record_offset, sizeof(header));
+
+  switch (type) {
+    case kRecordDatabase: {
+      if (header.length < sizeof(DatabaseRecord)) return false;
+      DatabaseRecord db;
+      memcpy(&db, payload, sizeof(db));
+      if (header.length != sizeof(DatabaseRecord) +
+                               db.num_attributes * sizeof(StoredAttribute)) {
+        return false;
+      }
+      auto it = databases_.find(db.hash);
+      if (it != databases_.end()) obsolete_bytes_ += it->second.record_size;
+      databases_[db.hash] = {.record_offset = record_offset,
+                             .record_size = record_size,
+                             .num_attributes = db.num_attributes,
+                             .write_time = db.write_time};
+      return true;
+    }
+    case kRecordLink: {
+      if (header.length != sizeof(LinkRecord)) return false;
+      LinkRecord link;
+      memcpy(&link, payload, sizeof(link));
+      RawAddress bda;
+      memcpy(bda.address, link.address, sizeof(bda.address));
+      if (links_.count(bda)) obsolete_bytes_ += record_size;
+      links_[bda] = link.hash;
+      return true;
+    }
+    case kRecordUnlink: {
+      RawAddress bda;
+      if (header.length != sizeof(bda.address)) return false;
+      memcpy(bda.address, payload, sizeof(bda.address));
+      /* The unlink record and the link record it cancels are obsolete */
+      obsolete_bytes_ += record_size;
+      if (links_.erase(bda)) obsolete_bytes_ += kLinkRecordSize;
+      return true;
+    }
+    case kRecordRemove: {
+      Octet16 hash;
+      if (header.length != sizeof(hash)) return false;
+      memcpy(hash.data(), payload, sizeof(hash));
+      auto it = databases_.find(hash);
+      if (it != databases_.end()) {
+        obsolete_bytes_ += it->second.record_size;
+        databases_.erase(it);
+      }
+      obsolete_bytes_ += record_size;
+      return true;
+    }
+    default:
+      log::error("unknown record type {} in GATT database store {}", type,
+                 path_);
+      return false;
+  }
+}
+
+/* Append a record, durably, and apply it to the index */
+bool DatabaseStore::Append(uint16_t type, const uint8_t* payload,
+                           uint32_t length) {
+  if (fd_ == -1) return false;
+
+  std::vector<uint8_t> record = make_record(type, payload, length);
+  if (!write_all(fd_, record.data(), record.size(), file_size_) ||
+      fsync(fd_) < 0) {
+    log::error("can't write to GATT database store {}, error: {}", path_,
+               strerror(errno));
+    /* Drop the partial record, replay would do the same */
+    if (ftruncate(fd_, file_size_) < 0) {
+      log::error("can't truncate GATT database store {}", path_);
+    }
+    return false;
+  }
+
+  off_t record_offset = file_size_;
+  file_size_ += record.size();
+  if (!Map()) {
+    Close();
+    return false;
+  }
+  ApplyRecord(type, record_offset, record.size());
+  return true;
+}
+
+Database DatabaseStore::Load(const Octet16& hash) const {
+  auto it = databases_.find(hash);
+  if (it == databases_.end()) return Database();
+
+  const DatabaseEntry& entry = it->second;
+  const auto* attributes = reinterpret_cast<const StoredAttribute*>(
+      map_ + entry.record_offset + sizeof(RecordHeader) +
+      sizeof(DatabaseRecord));
+  bool success = false;
+  Database result =
+      Database::Deserialize(attributes, entry.num_attributes, &success);
+  return success ? result : Database();
+}
+
+Database DatabaseStore::Load(const RawAddress& server_bda) const {
+  auto it = links_.find(server_bda);
+  if (it == links_.end()) return Database();
+  return Load(it->second);
+}
+
+bool DatabaseStore::Write(const Octet16& hash, const Database& database) {
+  if (Contains(hash)) return true;
+
+  int64_t now = time(nullptr);
+  EvictUnlinkedDatabases(now);
+
+  std::vector<StoredAttribute> attributes = database.Serialize();
+  if (attributes.size() > UINT16_MAX) {
+    log::error("too many attributes to store: {}", attributes.size());
+    return false;
+  }
+
+  DatabaseRecord db = {.hash = hash,
+                       .write_time = now,
+                       .num_attributes = (uint16_t)attributes.size(),
+                       .reserved = {}};
+  std::vector<uint8_t> payload(reinterpret_cast<const uint8_t*>(&db),
+                               reinterpret_cast<const uint8_t*>(&db + 1));
+  payload.reserve(sizeof(db) +
+                  attributes.size() * StoredAttribute::kSizeOnDisk);
+  for (const StoredAttribute& attribute : attributes) {
+    StoredAttribute::SerializeStoredAttribute(attribute, payload);
+  }
+
+  if (!Append(kRecordDatabase, payload.data(), payload.size())) return false;
+  CompactIfNeeded();
+  return true;
+}
+
+bool DatabaseStore::Link(const RawAddress& server_bda, const Octet16& hash) {
+  if (!Contains(hash)) {
+    log::error("no database to link {} to", server_bda);
+    return false;
+  }
+  auto it = links_.find(server_bda);
+  if (it != links_.end() && it->second == hash) return true;
+
+  LinkRecord link = {.address = {}, .reserved = {}, .hash = hash};
+  memcpy(link.address, server_bda.address, sizeof(link.address));
+  if (!Append(kRecordLink, reinterpret_cast<const uint8_t*>(&link),
+              sizeof(link))) {
+    return false;
+  }
+  CompactIfNeeded();
+  return true;
+}
+
+void DatabaseStore::Unlink(const RawAddress& server_bda) {
+  if (!links_.count(server_bda)) return;
+  Append(kRecordUnlink, server_bda.address, sizeof(server_bda.address));
+  CompactIfNeeded();
+}
+
+void DatabaseStore::Remove(const Octet16& hash) {
+  Append(kRecordRemove, hash.data(), hash.size());
+}
+
+void DatabaseStore::EvictUnlinkedDatabases(int64_t now) {
+  std::set<Octet16> linked;
+  for (const auto& [bda, hash] : links_) linked.insert(hash);
+
+  std::vector<Octet16> expired;
+  const Octet16* oldest = nullptr;
+  const DatabaseEntry* oldest_entry = nullptr;
+  for (const auto& [hash, entry] : databases_) {
+    if (linked.count(hash)) continue;
+    if (entry.write_time + kUnlinkedDatabaseExpiry < now) {
+      expired.push_back(hash);
+    } else if (oldest_entry == nullptr ||
+               std::tie(entry.write_time, entry.record_offset) <
+                   std::tie(oldest_entry->write_time,
+                            oldest_entry->record_offset)) {
+      oldest = &hash;
+      oldest_entry = &entry;
+    }
+  }
+
+  bool full = databases_.size() - expired.size() >= kMaxDatabases;
+  if (full && oldest != nullptr) expired.push_back(*oldest);
+
+  for (const Octet16& hash : expired) {
+    log::debug("evicting GATT database {}",
+               base::HexEncode(hash.data(), hash.size()));
+    Remove(hash);
+  }
+}
+
+void DatabaseStore::CompactIfNeeded() {
+  off_t live_bytes = file_size_ - obsolete_bytes_;
+  if (obsolete_bytes_ < kCompactionThreshold || obsolete_bytes_ < live_bytes) {
+    return;
+  }
+  if (!Compact()) log::error("can't compact GATT database store {}", path_);
+}
+
+/* Write the live records to a new file and rename it over the log, so that a
+ * crash leaves either the old or the new log in place. */
+bool DatabaseStore::Compact() {
+  std::string tmp_path = path_ + ".tmp";
+  int tmp_fd =
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+  if (tmp_fd < 0) return false;
+
+  std::vector<uint8_t> data = kFileHeaderBytes;
+  for (const auto& [hash, entry] : databases_) {
+    const uint8_t* record = map_ + entry.record_offset;
+    data.insert(data.end(), record, record + entry.record_size);
+  }
+  for (const auto& [bda, hash] : links_) {
+    LinkRecord link = {.address = {}, .reserved = {}, .hash = hash};
+    memcpy(link.address, bda.address, sizeof(link.address));
+    std::vector<uint8_t> record = make_record(
+        kRecordLink, reinterpret_cast<const uint8_t*>(&link), sizeof(link));
+    data.insert(data.end(), record.begin(), record.end());
+  }
+
+  bool written = write_all(tmp_fd, data.data(), data.size(), 0) &&
+                 fsync(tmp_fd) == 0;
+  close(tmp_fd);
+  if (!written || rename(tmp_path.c_str(), path_.c_str()) < 0) {
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  sync_directory(path_);
+
+  log::info("compacted GATT database store {} from {} to {} bytes", path_,
+            file_size_, data.size());
+  return Open(path_);
+}
+
+}  // namespace gatt
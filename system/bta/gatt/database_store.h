@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "gatt/database.h"
+#include "stack/include/bt_octets.h"
+#include "types/raw_address.h"
+
+namespace gatt {
+
+/* Single file store of remote GATT databases, keyed by database hash, and of
+ * the links from server addresses to those databases.
+ *
+ * The file is an append-only log of checksummed records, memory mapped for
+ * reading. Databases are deserialized straight from the mapped attribute
+ * records. A record torn by a crash fails its checksum and is dropped, with
+ * everything after it, when the store is opened. Once enough records are
+ * obsolete, the live ones are written to a new file that atomically replaces
+ * the log.
+ */
+class DatabaseStore {
+ public:
+  /* Databases no server links to are evicted once they are older than
+   * kUnlinkedDatabaseExpiry seconds, and the oldest of them when more than
+   * kMaxDatabases are stored. */
+  static constexpr size_t kMaxDatabases = 30;
+  static constexpr int64_t kUnlinkedDatabaseExpiry = 7 * 24 * 60 * 60;
+
+  DatabaseStore() = default;
+  DatabaseStore(const DatabaseStore&) = delete;
+  DatabaseStore& operator=(const DatabaseStore&) = delete;
+  ~DatabaseStore();
+
+  /* Open the store at |path|, creating it if needed */
+  bool Open(const std::string& path);
+  void Close();
+  bool IsOpen() const { return fd_ != -1; }
+
+  /* Return the database with |hash|, or an empty database */
+  Database Load(const Octet16& hash) const;
+  /* Return the database |server_bda| links to, or an empty database */
+  Database Load(const RawAddress& server_bda) const;
+
+  /* Store |database| under |hash|, unless it is already stored */
+  bool Write(const Octet16& hash, const Database& database);
+  /* Link |server_bda| to the database stored under |hash| */
+  bool Link(const RawAddress& server_bda, const Octet16& hash);
+  /* Remove the link of |server_bda|, if any */
+  void Unlink(const RawAddress& server_bda);
+
+  bool Contains(const Octet16& hash) const {
+    return databases_.count(hash) != 0;
+  }
+  size_t DatabaseCount() const { return databases_.size(); }
+  off_t FileSize() const { return file_size_; }
+
+ private:
+  struct DatabaseEntry {
+    off_t record_offset;
+    off_t record_size;
+    uint16_t num_attributes;
+    int64_t write_time;
+  };
+
+  bool Append(uint16_t type, const uint8_t* payload, uint32_t length);
+  bool Map();
+  void Unmap();
+  bool Reset();
+  void Replay();
+  bool ApplyRecord(uint16_t type, off_t record_offset, off_t record_size);
+  void EvictUnlinkedDatabases(int64_t now);
+  void Remove(const Octet16& hash);
+  void CompactIfNeeded();
+  bool Compact();
+
+  std::string path_;
+  int fd_{-1};
+  off_t file_size_{0};
+  const uint8_t* map_{nullptr};
+  size_t map_size_{0};
+  /* Bytes taken by records that no longer describe the current state */
+  off_t obsolete_bytes_{0};
+
+  std::map<Octet16, DatabaseEntry> databases_;
+  std::map<RawAddress, Octet16> links_;
+};
+
+}  // namespace gatt
@@ -1502,16 +1502,35 @@ class HearingAidImpl : public HearingAid {
     // reallocations
     // TODO: this should basically fit the encoded data, tune the size later
     std::vector<uint8_t> encoded_data_left;
-    auto time_point = std::chrono::steady_clock::now();
-    if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
+    std::vector<uint8_t> encoded_data_right;
+    // TODO: instead of a magic number, we need to figure out the correct
+    // buffer size
+    if (left && right) {
+      // Both channels are encoded at once
+      encoded_data_left.resize(4000);
+      encoded_data_right.resize(4000);
+      int encoded_size = g722_encode_stereo(
+          encoder_state_left, encoder_state_right, encoded_data_left.data(),
+          encoded_data_right.data(), (const int16_t*)chan_left.data(),
+          (const int16_t*)chan_right.data(), chan_left.size());
+      encoded_data_left.resize(encoded_size);
+      encoded_data_right.resize(encoded_size);
+    } else if (left) {
       encoded_data_left.resize(4000);
       int encoded_size =
           g722_encode(encoder_state_left, encoded_data_left.data(),
                       (const int16_t*)chan_left.data(), chan_left.size());
       encoded_data_left.resize(encoded_size);
+    } else {
+      encoded_data_right.resize(4000);
+      int encoded_size =
+          g722_encode(encoder_state_right, encoded_data_right.data(),
+                      (const int16_t*)chan_right.data(), chan_right.size());
+      encoded_data_right.resize(encoded_size);
+    }
 
+    auto time_point = std::chrono::steady_clock::now();
+    if (left) {
       uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
       uint16_t packets_in_chans = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_in_chans > l2cap_flush_threshold) {
@@ -1540,16 +1559,7 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
     if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_right.resize(4000);
-      int encoded_size =
-          g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      encoded_data_right.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
       uint16_t packets_in_chans = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_in_chans > l2cap_flush_threshold) {
@@ -35,6 +35,7 @@
 #include "bta/include/bta_hh_co.h"
 #include "bta/sys/bta_sys.h"
 #include "btif/include/btif_storage.h"
+#include "common/time_util.h"
 #include "os/log.h"
 #include "osi/include/allocator.h"
 #include "stack/include/acl_api.h"
@@ -655,7 +656,7 @@ void bta_hh_data_act(tBTA_HH_DEV_CB* p_cb, const tBTA_HH_DATA* p_data) {
   uint8_t* p_rpt = (uint8_t*)(pdata + 1) + pdata->offset;
 
   bta_hh_co_data((uint8_t)p_data->hid_cback.hdr.layer_specific, p_rpt,
-                 pdata->len);
+                 pdata->len, p_data->hid_cback.rx_timestamp_us);
 
   osi_free_and_reset((void**)&pdata);
 }
@@ -1195,6 +1196,7 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
     p_buf->link_spec.addrt.type = BLE_ADDR_PUBLIC;
     p_buf->link_spec.transport = BT_TRANSPORT_BR_EDR;
     p_buf->p_data = pdata;
+    p_buf->rx_timestamp_us = bluetooth::common::time_get_os_boottime_us();
 
     bta_sys_sendmsg(p_buf);
   }
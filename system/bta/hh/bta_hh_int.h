@@ -94,6 +94,7 @@ typedef struct {
   tAclLinkSpec link_spec;
   uint32_t data;
   BT_HDR* p_data;
+  uint64_t rx_timestamp_us;
 } tBTA_HH_CBACK_DATA;
 
 typedef struct {
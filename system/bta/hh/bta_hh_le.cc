@@ -30,6 +30,7 @@
 #include "bta/include/bta_gatt_queue.h"
 #include "bta/include/bta_hh_co.h"
 #include "bta/include/bta_le_audio_api.h"
+#include "common/time_util.h"
 #include "device/include/interop.h"
 #include "osi/include/allocator.h"
 #include "osi/include/osi.h"    // ARRAY_SIZE
@@ -1632,6 +1633,7 @@ static void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
  *
  ******************************************************************************/
 static void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
+  uint64_t rx_timestamp_us = bluetooth::common::time_get_os_boottime_us();
   tBTA_HH_DEV_CB* p_dev_cb = bta_hh_le_find_dev_cb_by_conn_id(p_data->conn_id);
   uint8_t* p_buf;
   tBTA_HH_LE_RPT* p_rpt;
@@ -1679,7 +1681,8 @@ static void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
     p_buf = p_data->value;
   }
 
-  bta_hh_co_data((uint8_t)p_dev_cb->hid_handle, p_buf, p_data->len);
+  bta_hh_co_data((uint8_t)p_dev_cb->hid_handle, p_buf, p_data->len,
+                 rx_timestamp_us);
 
   if (p_buf != p_data->value) osi_free(p_buf);
 }
@@ -2359,6 +2362,7 @@ static bool bta_hh_le_iso_data_callback(const RawAddress& addr,
     return false;
   }
 
-  bta_hh_co_data(p_dev_cb->hid_handle, data, size);
+  bta_hh_co_data(p_dev_cb->hid_handle, data, size,
+                 bluetooth::common::time_get_os_boottime_us());
   return true;
 }
@@ -763,6 +763,30 @@ void BTA_DmDisconnectAllAcls(void);
  ******************************************************************************/
 void BTA_DmClearFilterAcceptList(void);
 
+/*******************************************************************************
+ *
+ * Function         BTA_DmBeginLeListUpdates
+ *
+ * Description      This function starts a batch of accept list and resolving
+ *                  list updates, sent together by BTA_DmCommitLeListUpdates
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_DmBeginLeListUpdates(void);
+
+/*******************************************************************************
+ *
+ * Function         BTA_DmCommitLeListUpdates
+ *
+ * Description      This function sends the accept list and resolving list
+ *                  updates requested since BTA_DmBeginLeListUpdates
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_DmCommitLeListUpdates(void);
+
 /*******************************************************************************
  *
  * Function         BTA_DmLeRand
@@ -507,6 +507,18 @@ void BTA_GATTC_Open(tGATT_IF client_if, const RawAddress& remote_bda,
                     tBTM_BLE_CONN_TYPE connection_type, tBT_TRANSPORT transport,
                     bool opportunistic, uint8_t initiating_phys);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_RunAfterQueuedOpens
+ *
+ * Description      Runs a callback on the main thread once the open requests
+ *                  queued so far have been processed
+ *
+ * Parameters       callback: run once no open request is queued
+ *
+ ******************************************************************************/
+void BTA_GATTC_RunAfterQueuedOpens(base::OnceClosure callback);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_CancelOpen
@@ -30,6 +30,10 @@
  * Methods below can be used as replacement to BTA_GATTC_* in BTA app. They do
  * queue the commands if another command is currently being executed.
  *
+ * Consecutive characteristic reads are sent as one Read Multiple Variable
+ * Length request when the peer supports EATT, which implies support for that
+ * request. The callbacks are still called once per read, in order.
+ *
  * If you decide to use those methods in your app, make sure to not mix it with
  * existing BTA_GATTC_* API.
  */
@@ -71,6 +75,9 @@ class BtaGattQueue {
     /* write-specific fields */
     tGATT_WRITE_TYPE write_type;
     std::vector<uint8_t> value;
+
+    /* don't merge this read with the following ones */
+    bool read_alone;
   };
 
  private:
@@ -88,8 +95,18 @@ class BtaGattQueue {
                                           tBTA_GATTC_MULTI& handle,
                                           uint16_t len, uint8_t* value,
                                           void* data);
+  static bool gatt_read_coalesce_supported(uint16_t conn_id);
+  static bool gatt_execute_coalesced_read(uint16_t conn_id,
+                                          std::list<gatt_operation>& gatt_ops);
+  static void gatt_read_coalesced_op_finished(uint16_t conn_id,
+                                              tGATT_STATUS status,
+                                              tBTA_GATTC_MULTI& handles,
+                                              uint16_t len, uint8_t* value,
+                                              void* data);
   // maps connection id to operations waiting for execution
   static std::unordered_map<uint16_t, std::list<gatt_operation>> gatt_op_queue;
   // contain connection ids that currently execute operations
   static std::unordered_set<uint16_t> gatt_op_queue_executing;
+  // contain connection ids whose peer rejected a coalesced read
+  static std::unordered_set<uint16_t> gatt_read_coalesce_disabled;
 };
@@ -48,11 +48,13 @@ typedef struct {
  * Parameters       dev_handle  - device handle
  *                  *p_rpt      - pointer to the report data
  *                  len         - length of report data
+ *                  rx_timestamp_us - boot time the report was received at
  *
  * Returns          void.
  *
  ******************************************************************************/
-void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len);
+void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
+                    uint64_t rx_timestamp_us);
 
 /*******************************************************************************
  *
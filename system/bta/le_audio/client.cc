@@ -1816,6 +1816,7 @@ class LeAudioClientImpl : public LeAudioClient {
         /* Changes in PAC record channel counts may change the strategy */
         group->InvalidateGroupStrategy();
         group->InvalidateCachedConfigurations();
+        group->InvalidateConfigurationSelectionCache();
       }
       if (notify) {
         btif_storage_leaudio_update_pacs_bin(leAudioDevice->address_);
@@ -1844,6 +1845,7 @@ class LeAudioClientImpl : public LeAudioClient {
         /* Changes in PAC record channel counts may change the strategy */
         group->InvalidateGroupStrategy();
         group->InvalidateCachedConfigurations();
+        group->InvalidateConfigurationSelectionCache();
       }
       if (notify) {
         btif_storage_leaudio_update_pacs_bin(leAudioDevice->address_);
@@ -1869,6 +1871,7 @@ class LeAudioClientImpl : public LeAudioClient {
       leAudioDevice->audio_directions_ |=
           bluetooth::le_audio::types::kLeAudioDirectionSink;
       leAudioDevice->snk_audio_locations_ = snk_audio_locations;
+      if (group) group->InvalidateConfigurationSelectionCache();
 
       callbacks_->OnSinkAudioLocationAvailable(leAudioDevice->address_,
                                                snk_audio_locations.to_ulong());
@@ -1900,6 +1903,7 @@ class LeAudioClientImpl : public LeAudioClient {
       leAudioDevice->audio_directions_ |=
           bluetooth::le_audio::types::kLeAudioDirectionSource;
       leAudioDevice->src_audio_locations_ = src_audio_locations;
+      if (group) group->InvalidateConfigurationSelectionCache();
 
       if (notify) {
         btif_storage_set_leaudio_audio_location(
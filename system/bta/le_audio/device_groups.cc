@@ -21,6 +21,8 @@
 #include <bluetooth/log.h>
 
 #include <optional>
+#include <string>
+#include <type_traits>
 
 #include "bta/include/bta_gatt_api.h"
 #include "bta_csis_api.h"
@@ -882,10 +884,12 @@ LeAudioDeviceGroup::GetAudioSetConfigurationRequirements(
 bool LeAudioDeviceGroup::UpdateAudioSetConfigurationCache(
     LeAudioContextType ctx_type) const {
   auto requirements = GetAudioSetConfigurationRequirements(ctx_type);
+  auto fingerprint = GetCapabilityFingerprint();
   auto new_conf = CodecManager::GetInstance()->GetCodecConfig(
       requirements,
-      std::bind(&LeAudioDeviceGroup::FindFirstSupportedConfiguration, this,
-                std::placeholders::_1, std::placeholders::_2));
+      std::bind(&LeAudioDeviceGroup::FindFirstSupportedConfigurationCached,
+                this, std::cref(fingerprint), std::placeholders::_1,
+                std::placeholders::_2));
   auto update_config = true;
 
   if (context_to_configuration_cache_map.count(ctx_type) != 0) {
@@ -915,6 +919,65 @@ void LeAudioDeviceGroup::InvalidateCachedConfigurations(void) {
   context_to_configuration_cache_map.clear();
 }
 
+void LeAudioDeviceGroup::InvalidateConfigurationSelectionCache(void) {
+  log::debug("Group id: {}, entries: {}", group_id_,
+             configuration_selection_cache_.size());
+  configuration_selection_cache_.clear();
+}
+
+/* Serializes everything FindFirstSupportedConfiguration() depends on, apart
+ * from the requested context type and the candidate configurations. It does
+ * not depend on the requested context type, so it is the same for all the
+ * configuration lookups until the group or its members change.
+ */
+std::string LeAudioDeviceGroup::GetCapabilityFingerprint(void) const {
+  std::string fingerprint;
+  auto append = [&fingerprint](auto value) {
+    static_assert(std::is_integral_v<decltype(value)> ||
+                  std::is_enum_v<decltype(value)>);
+    fingerprint.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto append_pacs = [&](const types::PublishedAudioCapabilities& pacs) {
+    for (auto const& [_, pac_records] : pacs) {
+      append(pac_records.size());
+      for (auto const& pac : pac_records) {
+        append(pac.codec_id.coding_format);
+        append(pac.codec_id.vendor_company_id);
+        append(pac.codec_id.vendor_codec_id);
+        auto caps = pac.codec_spec_caps.RawPacket();
+        append(caps.size());
+        fingerprint.append(caps.begin(), caps.end());
+        append(pac.codec_spec_caps_raw.size());
+        fingerprint.append(pac.codec_spec_caps_raw.begin(),
+                           pac.codec_spec_caps_raw.end());
+      }
+    }
+  };
+
+  append(DesiredSize());
+  append(GetGroupSinkStrategy());
+  append(CodecManager::GetInstance()->GetCodecLocation());
+  append(CodecManager::GetInstance()->IsDualBiDirSwbSupported());
+
+  for (auto* device = GetFirstDevice(); device != nullptr;
+       device = GetNextDevice(device)) {
+    fingerprint.append(reinterpret_cast<const char*>(device->address_.address),
+                       sizeof(device->address_.address));
+    append(device->conn_id_ != GATT_INVALID_CONN_ID &&
+           device->GetConnectionState() == DeviceConnectState::CONNECTED);
+    for (auto direction :
+         {types::kLeAudioDirectionSink, types::kLeAudioDirectionSource}) {
+      append(device->GetAseCount(direction));
+      append(device->GetAvailableContexts(direction).value());
+    }
+    append(device->snk_audio_locations_.to_ulong());
+    append(device->src_audio_locations_.to_ulong());
+    append_pacs(device->snk_pacs_);
+    append_pacs(device->src_pacs_);
+  }
+  return fingerprint;
+}
+
 types::BidirectionalPair<AudioContexts>
 LeAudioDeviceGroup::GetLatestAvailableContexts() const {
   types::BidirectionalPair<AudioContexts> contexts;
@@ -1937,6 +2000,7 @@ LeAudioDeviceGroup::FindFirstSupportedConfiguration(
   /* Filter out device set for each end every scenario */
   for (const auto& conf : *confs) {
     log::assert_that(conf != nullptr, "confs should not be null");
+    num_of_configuration_checks_++;
     if (IsAudioSetConfigurationSupported(requirements, conf)) {
       log::debug("found: {}", conf->name);
       return conf;
@@ -1946,6 +2010,51 @@ LeAudioDeviceGroup::FindFirstSupportedConfiguration(
   return nullptr;
 }
 
+const set_configurations::AudioSetConfiguration*
+LeAudioDeviceGroup::FindFirstSupportedConfigurationCached(
+    const std::string& capability_fingerprint,
+    const CodecManager::UnicastConfigurationRequirements& requirements,
+    const set_configurations::AudioSetConfigurations* confs) const {
+  log::assert_that(confs != nullptr, "confs should not be null");
+
+  /* The candidates are keyed by their names, which are unique within the
+   * configuration provider, rather than by their addresses, which a provider
+   * reloading its configurations could free and reuse. The cached result is
+   * an index into |confs|, so the returned pointer always comes from the
+   * current list.
+   */
+  std::string key = capability_fingerprint;
+  auto context_type = requirements.audio_context_type;
+  key.append(reinterpret_cast<const char*>(&context_type),
+             sizeof(context_type));
+  for (const auto* conf : *confs) {
+    log::assert_that(conf != nullptr, "confs should not be null");
+    auto name_size = conf->name.size();
+    key.append(reinterpret_cast<const char*>(&name_size), sizeof(name_size));
+    key.append(conf->name);
+  }
+
+  auto it = configuration_selection_cache_.find(key);
+  if (it != configuration_selection_cache_.end()) {
+    auto conf = it->second < confs->size() ? confs->at(it->second) : nullptr;
+    log::debug("context type: {}, cached: {}",
+               bluetooth::common::ToString(context_type),
+               conf ? conf->name.c_str() : "(none)");
+    return conf;
+  }
+
+  auto conf = FindFirstSupportedConfiguration(requirements, confs);
+  if (configuration_selection_cache_.size() >=
+      kMaxConfigurationSelectionCacheSize) {
+    configuration_selection_cache_.clear();
+  }
+  configuration_selection_cache_.emplace(
+      std::move(key),
+      std::distance(confs->begin(),
+                    std::find(confs->begin(), confs->end(), conf)));
+  return conf;
+}
+
 /* This method should choose aproperiate ASEs to be active and set a cached
  * configuration for codec and qos.
  */
@@ -2080,7 +2189,11 @@ void LeAudioDeviceGroup::Dump(int fd, int active_group_id) const {
          << "      num of sources(connected): "
          << stream_conf.stream_params.source.num_of_devices << "("
          << stream_conf.stream_params.source.stream_locations.size() << ")\n"
-         << "      allocated CISes: " << static_cast<int>(cig.cises.size());
+         << "      allocated CISes: " << static_cast<int>(cig.cises.size())
+         << "\n"
+         << "      configuration checks: " << num_of_configuration_checks_
+         << ",\tselection cache entries: "
+         << configuration_selection_cache_.size();
 
   if (cig.cises.size() > 0) {
     stream << "\n\t == CISes == ";
@@ -28,6 +28,8 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <utility>  // for std::pair
 #include <vector>
 
@@ -227,6 +229,11 @@ class LeAudioDeviceGroup {
   std::shared_ptr<const set_configurations::AudioSetConfiguration>
   GetCachedConfiguration(types::LeAudioContextType ctx_type) const;
   void InvalidateCachedConfigurations(void);
+  void InvalidateConfigurationSelectionCache(void);
+  std::string GetCapabilityFingerprint(void) const;
+  size_t GetNumOfConfigurationChecks(void) const {
+    return num_of_configuration_checks_;
+  }
   void SetPendingConfiguration(void);
   void ClearPendingConfiguration(void);
   void AddToAllowListNotConnectedGroupMembers(int gatt_if);
@@ -428,6 +435,9 @@ class LeAudioDeviceGroup {
       const set_configurations::AudioSetConfigurations* confs) const;
 
  private:
+  /* Maximum number of entries in the configuration selection cache */
+  static constexpr size_t kMaxConfigurationSelectionCacheSize = 64;
+
   bool is_enabled_;
 
   uint32_t transport_latency_mtos_us_;
@@ -443,6 +453,11 @@ class LeAudioDeviceGroup {
       const CodecManager::UnicastConfigurationRequirements& requirements,
       const set_configurations::AudioSetConfiguration* audio_set_configuration)
       const;
+  const set_configurations::AudioSetConfiguration*
+  FindFirstSupportedConfigurationCached(
+      const std::string& capability_fingerprint,
+      const CodecManager::UnicastConfigurationRequirements& requirements,
+      const set_configurations::AudioSetConfigurations* confs) const;
   uint32_t GetTransportLatencyUs(uint8_t direction) const;
   bool IsCisPartOfCurrentStream(uint16_t cis_conn_hdl) const;
 
@@ -478,6 +493,21 @@ class LeAudioDeviceGroup {
                           set_configurations::AudioSetConfiguration>>>
       context_to_configuration_cache_map;
 
+  /* Configuration selection cache - maps the group capability fingerprint,
+   * the requested context type and the candidate configuration names to the
+   * index of the configuration chosen by FindFirstSupportedConfiguration()
+   * (past the end if none is supported). Unlike the cache above it is not
+   * cleared when the group conditions change, so going back to an already
+   * seen group state (i.e. a member reconnecting, or a context switching back
+   * and forth) does not match all the candidates against all the PAC records
+   * again. Cleared on PAC and location changes.
+   */
+  mutable std::unordered_map<std::string, size_t>
+      configuration_selection_cache_;
+
+  /* Number of candidate configurations matched against the group */
+  mutable size_t num_of_configuration_checks_ = 0;
+
   types::AseState target_state_;
   types::AseState current_state_;
   bool in_transition_;
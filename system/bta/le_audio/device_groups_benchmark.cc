@@ -0,0 +1,247 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "btm_api_mock.h"
+#include "device_groups.h"
+#include "devices.h"
+#include "hci/controller_interface_mock.h"
+#include "le_audio_set_configuration_provider.h"
+#include "le_audio_types.h"
+#include "mock_codec_manager.h"
+#include "mock_csis_client.h"
+#include "stack/btm/btm_int_types.h"
+#include "test/mock/mock_main_shim_entry.h"
+
+tACL_CONN* btm_bda_to_acl(const RawAddress& bda, tBT_TRANSPORT transport) {
+  return nullptr;
+}
+
+using ::benchmark::State;
+using bluetooth::le_audio::AudioSetConfigurationProvider;
+using bluetooth::le_audio::CodecManager;
+using bluetooth::le_audio::DeviceConnectState;
+using bluetooth::le_audio::LeAudioDevice;
+using bluetooth::le_audio::LeAudioDeviceGroup;
+using bluetooth::le_audio::set_configurations::AudioSetConfiguration;
+using bluetooth::le_audio::set_configurations::AudioSetConfigurations;
+using bluetooth::le_audio::set_configurations::CodecConfigSetting;
+using bluetooth::le_audio::types::acs_ac_record;
+using bluetooth::le_audio::types::AudioContexts;
+using bluetooth::le_audio::types::kLeAudioContextAllTypes;
+using bluetooth::le_audio::types::LeAudioContextType;
+using bluetooth::le_audio::types::LeAudioLtvMap;
+using bluetooth::le_audio::types::PublishedAudioCapabilities;
+using namespace bluetooth::le_audio::codec_spec_caps;
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace codec_spec_conf = bluetooth::le_audio::codec_spec_conf;
+namespace types = bluetooth::le_audio::types;
+
+namespace {
+
+constexpr int kGroupId = 1;
+
+// The configuration supported by the group members. It is found late in the
+// candidate list of the media context, so most of the candidates are matched
+// against the group before it.
+constexpr char kSupportedConfiguration[] =
+    "Two-OneChan-SnkAse-Lc3_16_2-One-OneChan-SrcAse-Lc3_16_2_Low_Latency";
+
+// A PAC record supporting exactly |setting| on one channel
+acs_ac_record PacRecord(const CodecConfigSetting& setting) {
+  auto config = setting.params.GetAsCoreCodecConfig();
+  uint32_t octets_per_frame = *config.octets_per_codec_frame;
+  LeAudioLtvMap caps;
+  caps.Add(kLeAudioLtvTypeSupportedSamplingFrequencies,
+           SamplingFreqConfig2Capability(*config.sampling_frequency))
+      .Add(kLeAudioLtvTypeSupportedFrameDurations,
+           FrameDurationConfig2Capability(*config.frame_duration))
+      .Add(kLeAudioLtvTypeSupportedAudioChannelCounts,
+           kLeAudioCodecChannelCountSingleChannel)
+      .Add(kLeAudioLtvTypeSupportedOctetsPerCodecFrame,
+           octets_per_frame | (octets_per_frame << 16))
+      .Add(kLeAudioLtvTypeSupportedMaxCodecFramesPerSdu, (uint8_t)1);
+  return acs_ac_record({.codec_id = setting.id,
+                        .codec_spec_caps = caps,
+                        .codec_spec_caps_raw = caps.RawPacket(),
+                        .metadata = std::vector<uint8_t>(0)});
+}
+
+// The audio locations of the group members, alternating between left and right
+constexpr uint32_t kMemberLocations[] = {
+    codec_spec_conf::kLeAudioLocationFrontLeft,
+    codec_spec_conf::kLeAudioLocationFrontRight,
+    codec_spec_conf::kLeAudioLocationBackLeft,
+    codec_spec_conf::kLeAudioLocationBackRight,
+    codec_spec_conf::kLeAudioLocationSideLeft,
+    codec_spec_conf::kLeAudioLocationSideRight,
+    codec_spec_conf::kLeAudioLocationFrontLeftOfCenter,
+    codec_spec_conf::kLeAudioLocationFrontRightOfCenter,
+};
+
+const AudioSetConfiguration* FindConfiguration(const char* name,
+                                               LeAudioContextType context) {
+  for (auto const* conf :
+       *AudioSetConfigurationProvider::Get()->GetConfigurations(context)) {
+    if (conf->name == name) return conf;
+  }
+  return nullptr;
+}
+
+// A connected group of |size| members, such as a pair of earbuds, with the
+// codec manager offering the configurations of the provider to the group.
+class GroupFixture {
+ public:
+  explicit GroupFixture(uint8_t size) : group_(kGroupId) {
+    bluetooth::manager::SetMockBtmInterface(&btm_interface_);
+    bluetooth::hci::testing::mock_controller_ = &controller_interface_;
+    AudioSetConfigurationProvider::Initialize(types::CodecLocation::HOST);
+
+    MockCsisClient::SetMockInstanceForTesting(&csis_client_);
+    ON_CALL(csis_client_, Get()).WillByDefault(Return(&csis_client_));
+    ON_CALL(csis_client_, IsCsisClientRunning()).WillByDefault(Return(true));
+    ON_CALL(csis_client_, GetDesiredSize(_)).WillByDefault(Return(size));
+
+    codec_manager_ = CodecManager::GetInstance();
+    codec_manager_->Start({});
+    auto* mock_codec_manager = MockCodecManager::GetInstance();
+    ON_CALL(*mock_codec_manager, GetCodecLocation())
+        .WillByDefault(Return(types::CodecLocation::HOST));
+    ON_CALL(*mock_codec_manager, GetCodecConfig)
+        .WillByDefault(Invoke(
+            [](const CodecManager::UnicastConfigurationRequirements&
+                   requirements,
+               CodecManager::UnicastConfigurationVerifier verifier) {
+              AudioSetConfigurations confs =
+                  *AudioSetConfigurationProvider::Get()->GetConfigurations(
+                      requirements.audio_context_type);
+              auto conf = verifier(requirements, &confs);
+              return conf ? std::make_unique<AudioSetConfiguration>(*conf)
+                          : nullptr;
+            }));
+
+    auto supported = FindConfiguration(kSupportedConfiguration,
+                                       LeAudioContextType::CONVERSATIONAL);
+    PublishedAudioCapabilities snk_pacs, src_pacs;
+    if (supported != nullptr) {
+      snk_pacs.emplace_back(
+          types::hdl_pair(),
+          std::vector<acs_ac_record>{
+              PacRecord(supported->confs.sink.front().codec)});
+      src_pacs.emplace_back(
+          types::hdl_pair(),
+          std::vector<acs_ac_record>{
+              PacRecord(supported->confs.source.front().codec)});
+    }
+
+    for (uint8_t index = 1; index <= size; index++) {
+      auto device = std::make_shared<LeAudioDevice>(
+          RawAddress({0xC0, 0xDE, 0xC0, 0xDE, 0x00, index}),
+          DeviceConnectState::DISCONNECTED);
+      group_.AddNode(device);
+      devices_.push_back(device);
+
+      uint8_t ase_id = 1;
+      device->ases_.emplace_back(0x0000, 0x0000, types::kLeAudioDirectionSink,
+                                 ase_id++);
+      device->ases_.emplace_back(0x0000, 0x0000, types::kLeAudioDirectionSource,
+                                 ase_id++);
+      device->snk_pacs_ = snk_pacs;
+      device->src_pacs_ = src_pacs;
+      device->SetSupportedContexts(
+          {.sink = AudioContexts(kLeAudioContextAllTypes),
+           .source = AudioContexts(kLeAudioContextAllTypes)});
+      device->SetAvailableContexts(
+          {.sink = AudioContexts(kLeAudioContextAllTypes),
+           .source = AudioContexts(kLeAudioContextAllTypes)});
+      auto location = kMemberLocations[(index - 1) %
+                                       std::size(kMemberLocations)];
+      device->snk_audio_locations_ = location;
+      device->src_audio_locations_ = location;
+      device->conn_id_ = index;
+      device->SetConnectionState(DeviceConnectState::CONNECTED);
+    }
+    group_.ReloadAudioDirections();
+    group_.ReloadAudioLocations();
+  }
+
+  ~GroupFixture() {
+    devices_.clear();
+    codec_manager_->Stop();
+    AudioSetConfigurationProvider::Cleanup();
+    MockCsisClient::SetMockInstanceForTesting(nullptr);
+    bluetooth::hci::testing::mock_controller_ = nullptr;
+    bluetooth::manager::SetMockBtmInterface(nullptr);
+  }
+
+  LeAudioDeviceGroup& group() { return group_; }
+
+ private:
+  NiceMock<bluetooth::manager::MockBtmInterface> btm_interface_;
+  NiceMock<bluetooth::hci::testing::MockControllerInterface>
+      controller_interface_;
+  NiceMock<MockCsisClient> csis_client_;
+  CodecManager* codec_manager_ = nullptr;
+  std::vector<std::shared_ptr<LeAudioDevice>> devices_;
+  LeAudioDeviceGroup group_;
+};
+
+// The selection done on each context switch before the selection cache
+void BM_SelectConfigurationUncached(State& state) {
+  GroupFixture fixture(state.range(0));
+  auto& group = fixture.group();
+  for (auto _ : state) {
+    for (auto context :
+         {LeAudioContextType::MEDIA, LeAudioContextType::CONVERSATIONAL}) {
+      group.InvalidateConfigurationSelectionCache();
+      group.InvalidateCachedConfigurations();
+      benchmark::DoNotOptimize(group.GetConfiguration(context));
+    }
+  }
+  state.counters["checks"] = benchmark::Counter(
+      group.GetNumOfConfigurationChecks(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SelectConfigurationUncached)->Arg(2)->Arg(4)->Arg(8);
+
+// Switching back and forth between the contexts of an unchanged group
+void BM_SelectConfigurationCached(State& state) {
+  GroupFixture fixture(state.range(0));
+  auto& group = fixture.group();
+  for (auto _ : state) {
+    for (auto context :
+         {LeAudioContextType::MEDIA, LeAudioContextType::CONVERSATIONAL}) {
+      group.InvalidateCachedConfigurations();
+      benchmark::DoNotOptimize(group.GetConfiguration(context));
+    }
+  }
+  state.counters["checks"] = benchmark::Counter(
+      group.GetNumOfConfigurationChecks(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SelectConfigurationCached)->Arg(2)->Arg(4)->Arg(8);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -2447,6 +2447,102 @@ TEST_P(LeAudioAseConfigurationTest, test_config_support) {
   ASSERT_TRUE(right->IsAudioSetConfigurationSupported(test_config));
 }
 
+TEST_P(LeAudioAseConfigurationTest, test_configuration_selection_cache) {
+  LeAudioDevice* left = AddTestDevice(2, 1);
+  LeAudioDevice* right = AddTestDevice(2, 1);
+
+  /* Change location as by default it is stereo */
+  left->snk_audio_locations_ =
+      ::bluetooth::le_audio::codec_spec_conf::kLeAudioLocationFrontLeft;
+  left->src_audio_locations_ =
+      ::bluetooth::le_audio::codec_spec_conf::kLeAudioLocationFrontLeft;
+  right->snk_audio_locations_ =
+      ::bluetooth::le_audio::codec_spec_conf::kLeAudioLocationFrontRight;
+  right->src_audio_locations_ =
+      ::bluetooth::le_audio::codec_spec_conf::kLeAudioLocationFrontRight;
+  group_->ReloadAudioLocations();
+
+  auto fingerprint = group_->GetCapabilityFingerprint();
+  ASSERT_EQ(fingerprint, group_->GetCapabilityFingerprint());
+
+  /* Going back to an already seen group state gives the same fingerprint */
+  right->SetConnectionState(DeviceConnectState::DISCONNECTED);
+  ASSERT_NE(fingerprint, group_->GetCapabilityFingerprint());
+  right->SetConnectionState(DeviceConnectState::CONNECTED);
+  ASSERT_EQ(fingerprint, group_->GetCapabilityFingerprint());
+
+  /* The vendor codec configuration is not matched by the group */
+  if (codec_coding_format_ != kLeAudioCodingFormatLC3) return;
+
+  /* Nothing matches without the PACs */
+  ASSERT_EQ(nullptr, group_->GetConfiguration(LeAudioContextType::MEDIA));
+
+  /* Put the PACS - the result cached without them must not be used */
+  auto conversational_configuration = getSpecificConfiguration(
+      "Two-OneChan-SnkAse-Lc3_16_2-One-OneChan-SrcAse-Lc3_16_2_Low_Latency",
+      LeAudioContextType::CONVERSATIONAL);
+  auto media_configuration =
+      getSpecificConfiguration("One-TwoChan-SnkAse-Lc3_48_4_High_Reliability",
+                               LeAudioContextType::MEDIA);
+  ASSERT_NE(nullptr, conversational_configuration);
+  ASSERT_NE(nullptr, media_configuration);
+
+  PublishedAudioCapabilitiesBuilder snk_pac_builder, src_pac_builder;
+  for (auto const& cfg : {conversational_configuration, media_configuration}) {
+    for (const auto& entry : cfg->confs.sink) {
+      snk_pac_builder.Add(entry.codec, 1);
+    }
+    for (const auto& entry : cfg->confs.source) {
+      src_pac_builder.Add(entry.codec, 1);
+    }
+  }
+  left->snk_pacs_ = snk_pac_builder.Get();
+  left->src_pacs_ = src_pac_builder.Get();
+  right->snk_pacs_ = snk_pac_builder.Get();
+  right->src_pacs_ = src_pac_builder.Get();
+  group_->InvalidateGroupStrategy();
+  group_->InvalidateCachedConfigurations();
+  ASSERT_NE(fingerprint, group_->GetCapabilityFingerprint());
+
+  auto num_of_checks = group_->GetNumOfConfigurationChecks();
+  auto config = group_->GetConfiguration(LeAudioContextType::MEDIA);
+  ASSERT_NE(nullptr, config);
+  ASSERT_LT(num_of_checks, group_->GetNumOfConfigurationChecks());
+
+  /* The same configuration is chosen from the cache, without matching any
+   * candidate against the group
+   */
+  num_of_checks = group_->GetNumOfConfigurationChecks();
+  group_->InvalidateCachedConfigurations();
+  auto cached_config = group_->GetConfiguration(LeAudioContextType::MEDIA);
+  ASSERT_NE(nullptr, cached_config);
+  ASSERT_EQ(config->name, cached_config->name);
+  ASSERT_EQ(num_of_checks, group_->GetNumOfConfigurationChecks());
+
+  /* ...and matched again after the cache is cleared */
+  group_->InvalidateConfigurationSelectionCache();
+  group_->InvalidateCachedConfigurations();
+  auto new_config = group_->GetConfiguration(LeAudioContextType::MEDIA);
+  ASSERT_NE(nullptr, new_config);
+  ASSERT_EQ(config->name, new_config->name);
+  ASSERT_LT(num_of_checks, group_->GetNumOfConfigurationChecks());
+
+  /* A member reconnecting goes back to the cached group state */
+  num_of_checks = group_->GetNumOfConfigurationChecks();
+  right->SetConnectionState(DeviceConnectState::DISCONNECTED);
+  group_->InvalidateCachedConfigurations();
+  group_->GetConfiguration(LeAudioContextType::MEDIA);
+  ASSERT_LT(num_of_checks, group_->GetNumOfConfigurationChecks());
+
+  num_of_checks = group_->GetNumOfConfigurationChecks();
+  right->SetConnectionState(DeviceConnectState::CONNECTED);
+  group_->InvalidateCachedConfigurations();
+  auto reconnected_config = group_->GetConfiguration(LeAudioContextType::MEDIA);
+  ASSERT_NE(nullptr, reconnected_config);
+  ASSERT_EQ(config->name, reconnected_config->name);
+  ASSERT_EQ(num_of_checks, group_->GetNumOfConfigurationChecks());
+}
+
 TEST_P(LeAudioAseConfigurationTest,
        test_vendor_codec_configure_incomplete_group) {
   // A group of two earbuds
@@ -608,10 +608,14 @@ void bta_pan_write_buf(tBTA_PAN_SCB* p_scb, tBTA_PAN_DATA* p_data) {
   if ((bta_pan_cb.flow_mask & BTA_PAN_RX_MASK) == BTA_PAN_RX_PUSH_BUF) {
     bta_pan_pm_conn_busy(p_scb);
 
-    PAN_WriteBuf(p_scb->handle, ((tBTA_PAN_DATA_PARAMS*)p_data)->dst,
-                 ((tBTA_PAN_DATA_PARAMS*)p_data)->src,
-                 ((tBTA_PAN_DATA_PARAMS*)p_data)->protocol, (BT_HDR*)p_data,
-                 ((tBTA_PAN_DATA_PARAMS*)p_data)->ext);
+    if (PAN_WriteBuf(p_scb->handle, ((tBTA_PAN_DATA_PARAMS*)p_data)->dst,
+                     ((tBTA_PAN_DATA_PARAMS*)p_data)->src,
+                     ((tBTA_PAN_DATA_PARAMS*)p_data)->protocol,
+                     (BT_HDR*)p_data,
+                     ((tBTA_PAN_DATA_PARAMS*)p_data)->ext) ==
+        PAN_Q_SIZE_EXCEEDED) {
+      osi_free(p_data);
+    }
     bta_pan_pm_conn_idle(p_scb);
   }
 }
@@ -22,6 +22,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <future>
 #include <string>
 
 #include "bta/dm/bta_dm_device_search_int.h"
@@ -29,8 +30,10 @@
 #include "bta/dm/bta_dm_int.h"
 #include "bta/dm/bta_dm_pm.cc"
 #include "bta/dm/bta_dm_sec_int.h"
+#include "bta/gatt/bta_gattc_int.h"
 #include "bta/hf_client/bta_hf_client_int.h"
 #include "bta/include/bta_api.h"
+#include "bta/include/bta_gatt_api.h"
 #include "bta/test/bta_test_fixtures.h"
 #include "stack/include/btm_status.h"
 #include "test/common/main_handler.h"
@@ -40,6 +43,7 @@
 #include "test/mock/mock_osi_properties.h"
 #include "test/mock/mock_stack_acl.h"
 #include "test/mock/mock_stack_btm_interface.h"
+#include "test/mock/mock_stack_gatt_api.h"
 
 #define TEST_BT com::android::bluetooth::flags
 
@@ -466,6 +470,47 @@ TEST_F(BtaDmTest, bta_dm_disc_start__false) { bta_dm_disc_start(false); }
 
 TEST_F(BtaDmTest, bta_dm_disc_stop) { bta_dm_disc_stop(); }
 
+TEST_F(BtaDmTest, commit_le_list_updates_after_queued_opens) {
+  constexpr tGATT_IF kGattIf = 5;
+  bta_gattc_cb.cl_rcb[0].in_use = true;
+  bta_gattc_cb.cl_rcb[0].client_if = kGattIf;
+
+  int commits_before_connect = -1;
+  test::mock::stack_gatt_api::GATT_Connect.body =
+      [&commits_before_connect](tGATT_IF, const RawAddress&, tBLE_ADDR_TYPE,
+                                bool, tBT_TRANSPORT, bool, uint8_t) {
+        commits_before_connect =
+            get_func_call_count("ACL_CommitLeListUpdates");
+        return true;
+      };
+
+  /* A profile restoring its device from storage on the main thread adds it to
+   * the accept list with BTA_GATTC_Open, which queues the request behind the
+   * commit. */
+  std::promise<void> queued;
+  do_in_main_thread(FROM_HERE,
+                    base::BindOnce(
+                        [](std::shared_future<void> queued) {
+                          queued.wait();
+                          BTA_GATTC_Open(kGattIf, kRawAddress,
+                                         BTM_BLE_BKG_CONNECT_ALLOW_LIST, false);
+                        },
+                        queued.get_future().share()));
+  BTA_DmBeginLeListUpdates();
+  BTA_DmCommitLeListUpdates();
+  queued.set_value();
+  sync_main_handler();
+  sync_main_handler();
+
+  ASSERT_EQ(1, get_func_call_count("GATT_Connect"));
+  ASSERT_EQ(0, commits_before_connect);
+  ASSERT_EQ(1, get_func_call_count("ACL_CommitLeListUpdates"));
+
+  test::mock::stack_gatt_api::GATT_Connect = {};
+  bta_gattc_cb.cl_rcb[0] = {};
+  bta_gattc_cb.bg_track[0] = {};
+}
+
 TEST_F(BtaDmCustomAlarmTest, bta_dm_sniff_cback) {
   // Setup a connected device
   const tBT_TRANSPORT transport{BT_TRANSPORT_BR_EDR};
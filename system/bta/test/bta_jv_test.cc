@@ -66,6 +66,7 @@ class FakeSdp {
                        tSDP_DISC_CMPL_CB> /* complete_callback */) {
                   return true;
                 },
+            .SDP_ReadCachedRecords = nullptr,
         },
         .db =
             {
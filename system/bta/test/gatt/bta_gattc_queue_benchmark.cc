@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Profile setup through BtaGattQueue against a fake server that answers each
+// request after one connection round trip. Reports the simulated time it takes
+// to read the initial values and enable notifications, with and without EATT
+// (and thus Read Multiple Variable Length) support on the peer.
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <vector>
+
+#include "bta/include/bta_gatt_api.h"
+#include "bta/include/bta_gatt_queue.h"
+#include "stack/include/gatt_api.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr uint16_t kConnId = 0x0001;
+constexpr uint16_t kMtu = 247;
+constexpr int kCharacteristics = 30;
+constexpr int kNotifications = 6;
+constexpr uint16_t kValueLen = 12;
+
+// Each characteristic takes a declaration, a value and a CCC handle.
+uint16_t value_handle(int i) { return 0x0010 + i * 3; }
+
+struct FakeServer {
+  bool eatt_supported = false;
+  int round_trips = 0;
+  std::vector<std::function<void()>> pending;
+
+  // Completes the requests one round trip at a time, as BTA GATTC sends the
+  // next one only after the previous one completed.
+  void Run() {
+    while (!pending.empty()) {
+      auto response = std::move(pending.front());
+      pending.erase(pending.begin());
+      round_trips++;
+      response();
+    }
+  }
+};
+
+FakeServer* server;
+std::vector<uint8_t> read_value(kValueLen, 0x5a);
+int values_read;
+
+void on_read(uint16_t /* conn_id */, tGATT_STATUS status, uint16_t /* handle */,
+             uint16_t len, uint8_t* /* value */, void* /* data */) {
+  if (status == GATT_SUCCESS && len == kValueLen) values_read++;
+}
+
+void on_write(uint16_t /* conn_id */, tGATT_STATUS /* status */,
+              uint16_t /* handle */, uint16_t /* len */,
+              const uint8_t* /* value */, void* /* data */) {}
+
+void SetupProfile() {
+  for (int i = 0; i < kCharacteristics; i++) {
+    BtaGattQueue::ReadCharacteristic(kConnId, value_handle(i), on_read,
+                                     nullptr);
+  }
+  for (int i = 0; i < kNotifications; i++) {
+    BtaGattQueue::WriteDescriptor(kConnId, value_handle(i) + 1, {0x01, 0x00},
+                                  GATT_WRITE, on_write, nullptr);
+  }
+  server->Run();
+}
+
+}  // namespace
+
+bool gatt_profile_get_eatt_support(const RawAddress& /* remote_bda */) {
+  return server->eatt_supported;
+}
+
+bool GATT_GetConnectionInfor(uint16_t /* conn_id */, tGATT_IF* p_gatt_if,
+                             RawAddress& bd_addr, tBT_TRANSPORT* p_transport) {
+  *p_gatt_if = 1;
+  bd_addr = RawAddress::kEmpty;
+  *p_transport = BT_TRANSPORT_LE;
+  return true;
+}
+
+void BTA_GATTC_ReadCharacteristic(uint16_t conn_id, uint16_t handle,
+                                  tGATT_AUTH_REQ /* auth_req */,
+                                  GATT_READ_OP_CB callback, void* cb_data) {
+  server->pending.push_back([=]() {
+    callback(conn_id, GATT_SUCCESS, handle, read_value.size(),
+             read_value.data(), cb_data);
+  });
+}
+
+void BTA_GATTC_ReadCharDescr(uint16_t conn_id, uint16_t handle,
+                             tGATT_AUTH_REQ auth_req, GATT_READ_OP_CB callback,
+                             void* cb_data) {
+  BTA_GATTC_ReadCharacteristic(conn_id, handle, auth_req, callback, cb_data);
+}
+
+void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
+                              tGATT_WRITE_TYPE /* write_type */,
+                              std::vector<uint8_t> value,
+                              tGATT_AUTH_REQ /* auth_req */,
+                              GATT_WRITE_OP_CB callback, void* cb_data) {
+  server->pending.push_back([=]() {
+    callback(conn_id, GATT_SUCCESS, handle, value.size(), value.data(),
+             cb_data);
+  });
+}
+
+void BTA_GATTC_WriteCharDescr(uint16_t conn_id, uint16_t handle,
+                              std::vector<uint8_t> value,
+                              tGATT_AUTH_REQ auth_req,
+                              GATT_WRITE_OP_CB callback, void* cb_data) {
+  BTA_GATTC_WriteCharValue(conn_id, handle, GATT_WRITE, std::move(value),
+                           auth_req, callback, cb_data);
+}
+
+void BTA_GATTC_ConfigureMTU(uint16_t conn_id, uint16_t /* mtu */,
+                            GATT_CONFIGURE_MTU_OP_CB callback, void* cb_data) {
+  server->pending.push_back(
+      [=]() { callback(conn_id, GATT_SUCCESS, cb_data); });
+}
+
+// Builds the Read Multiple Variable Length response, truncated to the MTU.
+void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI& p_read_multi,
+                            bool /* variable_len */,
+                            tGATT_AUTH_REQ /* auth_req */,
+                            GATT_READ_MULTI_OP_CB callback, void* cb_data) {
+  tBTA_GATTC_MULTI handles = p_read_multi;
+  server->pending.push_back([=]() mutable {
+    std::vector<uint8_t> response;
+    for (uint8_t i = 0; i < handles.num_attr; i++) {
+      response.push_back(kValueLen & 0xff);
+      response.push_back(kValueLen >> 8);
+      response.insert(response.end(), read_value.begin(), read_value.end());
+    }
+    if (response.size() > kMtu - 1) response.resize(kMtu - 1);
+    callback(conn_id, GATT_SUCCESS, handles, response.size(), response.data(),
+             cb_data);
+  });
+}
+
+static void BM_ProfileSetup(State& state) {
+  FakeServer fake_server;
+  fake_server.eatt_supported = state.range(1);
+  server = &fake_server;
+
+  for (auto _ : state) {
+    values_read = 0;
+    fake_server.round_trips = 0;
+    SetupProfile();
+    BtaGattQueue::Clean(kConnId);
+  }
+
+  if (values_read != kCharacteristics) {
+    state.SkipWithError("characteristic values were not all read");
+  }
+  double rtt_ms = state.range(0) / 1000.0;
+  state.counters["round_trips"] = fake_server.round_trips;
+  state.counters["setup_ms"] = fake_server.round_trips * rtt_ms;
+  server = nullptr;
+}
+// Round trip time in microseconds, for 7.5 ms and 30 ms connection intervals,
+// and peer EATT support.
+BENCHMARK(BM_ProfileSetup)->ArgsProduct({{7500, 30000}, {0, 1}});
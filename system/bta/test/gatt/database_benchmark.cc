@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gatt/database.h"
+#include "gatt/database_builder.h"
+#include "types/bluetooth/uuid.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+using gatt::Characteristic;
+using gatt::Database;
+using gatt::DatabaseBuilder;
+using gatt::Descriptor;
+using gatt::Service;
+
+namespace {
+
+constexpr int kCharacteristicsPerService = 8;
+constexpr int kHandlesPerCharacteristic = 4;
+constexpr int kHandlesPerService =
+    1 + kCharacteristicsPerService * kHandlesPerCharacteristic;
+
+const Uuid kCccUuid = Uuid::From16Bit(0x2902);
+const Uuid kUserDescriptionUuid = Uuid::From16Bit(0x2901);
+
+// A database of |num_services| services, each with characteristics that have
+// a CCC and a user description descriptor.
+Database BuildDatabase(int num_services) {
+  DatabaseBuilder builder;
+  for (int s = 0; s < num_services; s++) {
+    uint16_t handle = 1 + s * kHandlesPerService;
+    builder.AddService(handle, handle + kHandlesPerService - 1,
+                       Uuid::From16Bit(0x1800 + s), true);
+    for (int c = 0; c < kCharacteristicsPerService; c++) {
+      uint16_t declaration_handle = handle + 1 + c * kHandlesPerCharacteristic;
+      builder.AddCharacteristic(declaration_handle, declaration_handle + 1,
+                                Uuid::From16Bit(0x2a00 + c), 0x12);
+      builder.AddDescriptor(declaration_handle + 2, kCccUuid);
+      builder.AddDescriptor(declaration_handle + 3, kUserDescriptionUuid);
+    }
+  }
+  return builder.Build();
+}
+
+// Value handles of notifying characteristics, in random order.
+std::vector<uint16_t> NotificationHandles(const Database& db) {
+  std::vector<uint16_t> handles;
+  for (const Service& service : db.Services()) {
+    for (const Characteristic& c : service.characteristics) {
+      handles.push_back(c.value_handle);
+    }
+  }
+  std::shuffle(handles.begin(), handles.end(), std::mt19937(42));
+  return handles;
+}
+
+// The lookup done for each notification before the handle index.
+const Characteristic* FindCharacteristicByWalking(const Database& db,
+                                                  uint16_t handle) {
+  for (const Service& service : db.Services()) {
+    if (handle < service.handle || handle > service.end_handle) continue;
+    for (const Characteristic& c : service.characteristics) {
+      if (c.value_handle == handle) return &c;
+    }
+    return nullptr;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+// Notification dispatch resolves the value handle to its characteristic and
+// service, as bta_gattc_process_indicate() does.
+static void BM_NotificationLookup(State& state) {
+  Database db = BuildDatabase(state.range(0));
+  std::vector<uint16_t> handles = NotificationHandles(db);
+  size_t i = 0;
+  for (auto _ : state) {
+    uint16_t handle = handles[i++ % handles.size()];
+    const Characteristic* c = db.FindCharacteristic(handle);
+    benchmark::DoNotOptimize(c);
+    benchmark::DoNotOptimize(db.FindService(c->value_handle));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["attributes"] = state.range(0) * kHandlesPerService;
+}
+BENCHMARK(BM_NotificationLookup)->RangeMultiplier(4)->Range(1, 64);
+
+static void BM_NotificationLookupByWalking(State& state) {
+  Database db = BuildDatabase(state.range(0));
+  std::vector<uint16_t> handles = NotificationHandles(db);
+  size_t i = 0;
+  for (auto _ : state) {
+    uint16_t handle = handles[i++ % handles.size()];
+    const Characteristic* c = FindCharacteristicByWalking(db, handle);
+    benchmark::DoNotOptimize(c);
+    for (const Service& service : db.Services()) {
+      if (c->value_handle >= service.handle &&
+          c->value_handle <= service.end_handle) {
+        benchmark::DoNotOptimize(&service);
+        break;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["attributes"] = state.range(0) * kHandlesPerService;
+}
+BENCHMARK(BM_NotificationLookupByWalking)->RangeMultiplier(4)->Range(1, 64);
+
+// Descriptor writes (e.g. enabling CCCs) resolve the descriptor and its
+// owning characteristic.
+static void BM_DescriptorLookup(State& state) {
+  Database db = BuildDatabase(state.range(0));
+  std::vector<uint16_t> handles = NotificationHandles(db);
+  size_t i = 0;
+  for (auto _ : state) {
+    uint16_t handle = handles[i++ % handles.size()] + 1;
+    const Descriptor* d = db.FindDescriptor(handle);
+    benchmark::DoNotOptimize(d);
+    benchmark::DoNotOptimize(db.FindOwningCharacteristic(handle));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DescriptorLookup)->RangeMultiplier(4)->Range(1, 64);
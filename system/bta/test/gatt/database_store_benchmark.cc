@@ -0,0 +1,185 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cold connect cache lookup: loading the database of a known peer from one
+// cache file per device, as done before the GATT database store, and from the
+// store.
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gatt/database.h"
+#include "gatt/database_builder.h"
+#include "gatt/database_store.h"
+#include "types/bluetooth/uuid.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+using gatt::Database;
+using gatt::DatabaseBuilder;
+using gatt::DatabaseStore;
+using gatt::StoredAttribute;
+
+namespace {
+
+constexpr uint16_t kLegacyCacheVersion = 6;
+constexpr int kServices = 12;
+constexpr int kCharacteristicsPerService = 4;
+
+std::string temp_path(const std::string& name) {
+  return "/tmp/gatt_db_store_benchmark." + std::to_string(getpid()) + "." +
+         name;
+}
+
+RawAddress peer_address(int i) {
+  return RawAddress({0x00, 0x11, 0x22, 0x33, (uint8_t)(i >> 8), (uint8_t)i});
+}
+
+Octet16 peer_hash(int i) {
+  Octet16 hash{};
+  hash[0] = i & 0xff;
+  hash[1] = i >> 8;
+  return hash;
+}
+
+Database make_database(int seed) {
+  DatabaseBuilder builder;
+  uint16_t handle = 1;
+  for (int s = 0; s < kServices; s++) {
+    uint16_t end_handle = handle + kCharacteristicsPerService * 3;
+    builder.AddService(handle, end_handle, Uuid::From16Bit(0x1800 + s + seed),
+                       true);
+    for (int c = 0; c < kCharacteristicsPerService; c++) {
+      uint16_t declaration_handle = handle + 1 + c * 3;
+      builder.AddCharacteristic(declaration_handle, declaration_handle + 1,
+                                Uuid::From16Bit(0x2a00 + c), 0x12);
+      builder.AddDescriptor(declaration_handle + 2, Uuid::From16Bit(0x2902));
+    }
+    handle = end_handle + 1;
+  }
+  return builder.Build();
+}
+
+// Per device cache file, as written by bta_gattc_store_db()
+std::string legacy_file_name(int i) {
+  return temp_path("gatt_cache_" + peer_address(i).ToString());
+}
+
+void write_legacy_file(int i, const Database& db) {
+  std::vector<StoredAttribute> attributes = db.Serialize();
+  std::vector<uint8_t> bytes;
+  for (const StoredAttribute& attribute : attributes) {
+    StoredAttribute::SerializeStoredAttribute(attribute, bytes);
+  }
+  FILE* fd = fopen(legacy_file_name(i).c_str(), "wb");
+  uint16_t version = kLegacyCacheVersion;
+  uint16_t num_attr = attributes.size();
+  fwrite(&version, sizeof(version), 1, fd);
+  fwrite(&num_attr, sizeof(num_attr), 1, fd);
+  fwrite(bytes.data(), 1, bytes.size(), fd);
+  fclose(fd);
+}
+
+// As bta_gattc_load_db() did
+Database load_legacy_file(int i) {
+  FILE* fd = fopen(legacy_file_name(i).c_str(), "rb");
+  if (!fd) return Database();
+  uint16_t version = 0;
+  uint16_t num_attr = 0;
+  if (fread(&version, sizeof(version), 1, fd) != 1 ||
+      version != kLegacyCacheVersion ||
+      fread(&num_attr, sizeof(num_attr), 1, fd) != 1) {
+    fclose(fd);
+    return Database();
+  }
+  std::vector<StoredAttribute> attributes(num_attr);
+  size_t read = fread(attributes.data(), sizeof(StoredAttribute), num_attr, fd);
+  fclose(fd);
+  if (read != num_attr) return Database();
+  bool success = false;
+  Database result = Database::Deserialize(attributes, &success);
+  return success ? result : Database();
+}
+
+void fill_store(DatabaseStore& store, int num_peers) {
+  for (int i = 0; i < num_peers; i++) {
+    store.Write(peer_hash(i), make_database(i));
+    store.Link(peer_address(i), peer_hash(i));
+  }
+}
+
+}  // namespace
+
+static void BM_LegacyCacheFileLoad(State& state) {
+  int num_peers = state.range(0);
+  for (int i = 0; i < num_peers; i++) write_legacy_file(i, make_database(i));
+
+  int i = 0;
+  for (auto _ : state) {
+    Database db = load_legacy_file(i++ % num_peers);
+    if (db.IsEmpty()) state.SkipWithError("load failed");
+    benchmark::DoNotOptimize(db);
+  }
+
+  for (int i = 0; i < num_peers; i++) unlink(legacy_file_name(i).c_str());
+}
+BENCHMARK(BM_LegacyCacheFileLoad)->Arg(16)->Arg(256);
+
+static void BM_DatabaseStoreLoad(State& state) {
+  int num_peers = state.range(0);
+  std::string path = temp_path("store");
+  unlink(path.c_str());
+  DatabaseStore store;
+  store.Open(path);
+  fill_store(store, num_peers);
+
+  int i = 0;
+  for (auto _ : state) {
+    Database db = store.Load(peer_address(i++ % num_peers));
+    if (db.IsEmpty()) state.SkipWithError("load failed");
+    benchmark::DoNotOptimize(db);
+  }
+
+  store.Close();
+  unlink(path.c_str());
+}
+BENCHMARK(BM_DatabaseStoreLoad)->Arg(16)->Arg(256);
+
+// One time cost of indexing the store when the stack starts
+static void BM_DatabaseStoreOpen(State& state) {
+  int num_peers = state.range(0);
+  std::string path = temp_path("store");
+  unlink(path.c_str());
+  {
+    DatabaseStore store;
+    store.Open(path);
+    fill_store(store, num_peers);
+  }
+
+  for (auto _ : state) {
+    DatabaseStore store;
+    store.Open(path);
+    benchmark::DoNotOptimize(store.DatabaseCount());
+  }
+
+  unlink(path.c_str());
+}
+BENCHMARK(BM_DatabaseStoreOpen)->Arg(16)->Arg(256);
@@ -0,0 +1,211 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "gatt/database_store.h"
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "gatt/database_builder.h"
+#include "types/bluetooth/uuid.h"
+
+using bluetooth::Uuid;
+
+namespace gatt {
+
+namespace {
+
+const RawAddress kAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddress2({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+
+Octet16 make_hash(uint8_t seed) {
+  Octet16 hash;
+  hash.fill(seed);
+  return hash;
+}
+
+Database make_database(uint16_t num_services) {
+  DatabaseBuilder builder;
+  for (uint16_t s = 0; s < num_services; s++) {
+    uint16_t handle = 1 + s * 4;
+    builder.AddService(handle, handle + 3, Uuid::From16Bit(0x1800 + s), true);
+    builder.AddCharacteristic(handle + 1, handle + 2, Uuid::From16Bit(0x2a00),
+                              0x12);
+    builder.AddDescriptor(handle + 3, Uuid::From16Bit(0x2902));
+  }
+  return builder.Build();
+}
+
+class DatabaseStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = ::testing::TempDir() + "gatt_db_store_test." +
+            std::to_string(getpid());
+    unlink(path_.c_str());
+    ASSERT_TRUE(store_.Open(path_));
+  }
+
+  void TearDown() override {
+    store_.Close();
+    unlink(path_.c_str());
+  }
+
+  off_t FileSize() {
+    struct stat st;
+    return stat(path_.c_str(), &st) == 0 ? st.st_size : -1;
+  }
+
+  std::string path_;
+  DatabaseStore store_;
+};
+
+}  // namespace
+
+TEST_F(DatabaseStoreTest, write_load_link) {
+  Database db = make_database(3);
+  ASSERT_TRUE(store_.Write(make_hash(1), db));
+  EXPECT_TRUE(store_.Load(kAddress1).IsEmpty());
+
+  ASSERT_TRUE(store_.Link(kAddress1, make_hash(1)));
+  EXPECT_EQ(store_.Load(make_hash(1)).ToString(), db.ToString());
+  EXPECT_EQ(store_.Load(kAddress1).ToString(), db.ToString());
+  EXPECT_TRUE(store_.Load(make_hash(2)).IsEmpty());
+
+  EXPECT_FALSE(store_.Link(kAddress2, make_hash(2)));
+
+  store_.Unlink(kAddress1);
+  EXPECT_TRUE(store_.Load(kAddress1).IsEmpty());
+  EXPECT_FALSE(store_.Load(make_hash(1)).IsEmpty());
+}
+
+TEST_F(DatabaseStoreTest, loaded_database_is_indexed) {
+  ASSERT_TRUE(store_.Write(make_hash(1), make_database(4)));
+  Database db = store_.Load(make_hash(1));
+  ASSERT_NE(db.FindCharacteristic(0x000b), nullptr);
+  EXPECT_EQ(db.FindService(0x000b)->handle, 0x0009);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x000c)->value_handle, 0x000b);
+}
+
+TEST_F(DatabaseStoreTest, survives_reopen) {
+  Database db1 = make_database(2);
+  Database db2 = make_database(5);
+  ASSERT_TRUE(store_.Write(make_hash(1), db1));
+  ASSERT_TRUE(store_.Write(make_hash(2), db2));
+  ASSERT_TRUE(store_.Link(kAddress1, make_hash(1)));
+  ASSERT_TRUE(store_.Link(kAddress2, make_hash(1)));
+  ASSERT_TRUE(store_.Link(kAddress2, make_hash(2)));
+  store_.Unlink(kAddress1);
+
+  DatabaseStore reopened;
+  ASSERT_TRUE(reopened.Open(path_));
+  EXPECT_EQ(reopened.DatabaseCount(), 2u);
+  EXPECT_TRUE(reopened.Load(kAddress1).IsEmpty());
+  EXPECT_EQ(reopened.Load(kAddress2).ToString(), db2.ToString());
+  EXPECT_EQ(reopened.Load(make_hash(1)).ToString(), db1.ToString());
+}
+
+TEST_F(DatabaseStoreTest, torn_record_is_dropped) {
+  Database db = make_database(2);
+  ASSERT_TRUE(store_.Write(make_hash(1), db));
+  ASSERT_TRUE(store_.Link(kAddress1, make_hash(1)));
+  off_t intact_size = FileSize();
+  ASSERT_TRUE(store_.Write(make_hash(2), make_database(6)));
+  store_.Close();
+
+  // Cut the last record in the middle, as a crash during the write would
+  ASSERT_EQ(truncate(path_.c_str(), intact_size + 40), 0);
+
+  ASSERT_TRUE(store_.Open(path_));
+  EXPECT_EQ(FileSize(), intact_size);
+  EXPECT_FALSE(store_.Contains(make_hash(2)));
+  EXPECT_EQ(store_.Load(kAddress1).ToString(), db.ToString());
+
+  // The store keeps working after the torn record
+  ASSERT_TRUE(store_.Write(make_hash(2), make_database(6)));
+  DatabaseStore reopened;
+  ASSERT_TRUE(reopened.Open(path_));
+  EXPECT_TRUE(reopened.Contains(make_hash(2)));
+}
+
+TEST_F(DatabaseStoreTest, corrupted_record_is_dropped) {
+  ASSERT_TRUE(store_.Write(make_hash(1), make_database(2)));
+  off_t intact_size = FileSize();
+  ASSERT_TRUE(store_.Write(make_hash(2), make_database(2)));
+  store_.Close();
+
+  FILE* fp = fopen(path_.c_str(), "r+b");
+  ASSERT_NE(fp, nullptr);
+  fseek(fp, intact_size + 64, SEEK_SET);
+  fputc(0xff, fp);
+  fclose(fp);
+
+  ASSERT_TRUE(store_.Open(path_));
+  EXPECT_TRUE(store_.Contains(make_hash(1)));
+  EXPECT_FALSE(store_.Contains(make_hash(2)));
+  EXPECT_EQ(FileSize(), intact_size);
+}
+
+TEST_F(DatabaseStoreTest, unknown_file_is_reset) {
+  store_.Close();
+  FILE* fp = fopen(path_.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  fputs("not a database store", fp);
+  fclose(fp);
+
+  ASSERT_TRUE(store_.Open(path_));
+  EXPECT_EQ(store_.DatabaseCount(), 0u);
+  ASSERT_TRUE(store_.Write(make_hash(1), make_database(1)));
+  EXPECT_TRUE(store_.Contains(make_hash(1)));
+}
+
+TEST_F(DatabaseStoreTest, evicts_unlinked_databases) {
+  ASSERT_TRUE(store_.Write(make_hash(0), make_database(1)));
+  ASSERT_TRUE(store_.Link(kAddress1, make_hash(0)));
+  for (uint8_t i = 1; i < DatabaseStore::kMaxDatabases + 5; i++) {
+    ASSERT_TRUE(store_.Write(make_hash(i), make_database(1)));
+    EXPECT_LE(store_.DatabaseCount(), DatabaseStore::kMaxDatabases);
+  }
+  // The linked database is never evicted, the others oldest first
+  EXPECT_TRUE(store_.Contains(make_hash(0)));
+  EXPECT_FALSE(store_.Contains(make_hash(1)));
+  EXPECT_TRUE(store_.Contains(make_hash(DatabaseStore::kMaxDatabases + 4)));
+}
+
+TEST_F(DatabaseStoreTest, compacts_obsolete_records) {
+  Database db = make_database(2);
+  ASSERT_TRUE(store_.Write(make_hash(1), db));
+  for (int i = 0; i < 1200; i++) {
+    ASSERT_TRUE(store_.Link(kAddress1, make_hash(1)));
+    store_.Unlink(kAddress1);
+  }
+  ASSERT_TRUE(store_.Link(kAddress2, make_hash(1)));
+
+  // Without compaction, the links would take over 75 kB
+  EXPECT_LT(FileSize(), 64 * 1024);
+  EXPECT_EQ(FileSize(), store_.FileSize());
+
+  DatabaseStore reopened;
+  ASSERT_TRUE(reopened.Open(path_));
+  EXPECT_TRUE(reopened.Load(kAddress1).IsEmpty());
+  EXPECT_EQ(reopened.Load(kAddress2).ToString(), db.ToString());
+}
+
+}  // namespace gatt
@@ -553,4 +553,90 @@ TEST(GattDatabaseTest, serialized_hash_test) {
   EXPECT_EQ(db_from_disk.Hash(), db_from_serialized.Hash());
 }
 
+/* Handle lookups resolve through the handle index, also on copies and on
+ * deserialized databases. */
+TEST(GattDatabaseTest, handle_lookup_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0010, 0x001f, SERVICE_2_UUID, false);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x12);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddCharacteristic(0x0011, 0x0012, SERVICE_1_CHAR_1_UUID, 0x02);
+
+  Database built = builder.Build();
+  bool success = false;
+  Database deserialized = Database::Deserialize(built.Serialize(), &success);
+  ASSERT_TRUE(success);
+  Database copy;
+  copy = built;
+
+  for (const Database* db : {&built, &deserialized, &copy}) {
+    EXPECT_EQ(db->FindService(0x0000), nullptr);
+    EXPECT_EQ(db->FindService(0x0001)->handle, 0x0001);
+    EXPECT_EQ(db->FindService(0x000f)->handle, 0x0001);
+    EXPECT_EQ(db->FindService(0x0015)->handle, 0x0010);
+    EXPECT_EQ(db->FindService(0x0020), nullptr);
+
+    const Characteristic* characteristic = db->FindCharacteristic(0x0004);
+    ASSERT_NE(characteristic, nullptr);
+    EXPECT_EQ(characteristic->declaration_handle, 0x0003);
+    EXPECT_EQ(db->FindCharacteristic(0x0012)->declaration_handle, 0x0011);
+    EXPECT_EQ(db->FindCharacteristic(0x0003), nullptr);
+    EXPECT_EQ(db->FindCharacteristic(0x0005), nullptr);
+
+    const Descriptor* descriptor = db->FindDescriptor(0x0005);
+    ASSERT_NE(descriptor, nullptr);
+    EXPECT_EQ(descriptor->uuid, SERVICE_1_CHAR_1_DESC_1_UUID);
+    EXPECT_EQ(db->FindDescriptor(0x0004), nullptr);
+    EXPECT_EQ(db->FindOwningCharacteristic(0x0005), characteristic);
+    EXPECT_EQ(db->FindOwningCharacteristic(0x0004), nullptr);
+  }
+
+  built.Clear();
+  EXPECT_EQ(built.FindService(0x0001), nullptr);
+  EXPECT_EQ(built.FindCharacteristic(0x0004), nullptr);
+}
+
+/* Handles spread over the whole handle range are looked up too. */
+TEST(GattDatabaseTest, handle_lookup_sparse_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0005, SERVICE_1_UUID, true);
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x12);
+  builder.AddDescriptor(0x0004, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddService(0xfff0, 0xffff, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0xfffd, 0xfffe, SERVICE_1_CHAR_1_UUID, 0x12);
+  builder.AddDescriptor(0xffff, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database db = builder.Build();
+  EXPECT_EQ(db.FindCharacteristic(0x0003)->declaration_handle, 0x0002);
+  EXPECT_EQ(db.FindCharacteristic(0xfffe)->declaration_handle, 0xfffd);
+  EXPECT_EQ(db.FindCharacteristic(0x8000), nullptr);
+  EXPECT_EQ(db.FindOwningCharacteristic(0xffff)->declaration_handle, 0xfffd);
+  EXPECT_EQ(db.FindService(0xffff)->handle, 0xfff0);
+  EXPECT_EQ(db.FindService(0x8000), nullptr);
+}
+
+/* Lookups still work on databases that can't be indexed. */
+TEST(GattDatabaseTest, handle_lookup_overlapping_services_test) {
+  std::vector<StoredAttribute> attributes = {
+      {.handle = 0x0001,
+       .type = PRIMARY_SERVICE,
+       .value = {.service = {.uuid = SERVICE_1_UUID, .end_handle = 0x0010}}},
+      {.handle = 0x0005,
+       .type = PRIMARY_SERVICE,
+       .value = {.service = {.uuid = SERVICE_2_UUID, .end_handle = 0x0008}}},
+      {.handle = 0x0002,
+       .type = CHARACTERISTIC,
+       .value = {.characteristic = {.properties = 0x02,
+                                    .value_handle = 0x0003,
+                                    .uuid = SERVICE_1_CHAR_1_UUID}}},
+  };
+
+  bool success = false;
+  Database db = Database::Deserialize(attributes, &success);
+  ASSERT_TRUE(success);
+  EXPECT_EQ(db.FindService(0x0006)->handle, 0x0001);
+  EXPECT_EQ(db.FindCharacteristic(0x0003)->declaration_handle, 0x0002);
+}
+
 }  // namespace gatt
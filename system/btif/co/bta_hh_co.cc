@@ -21,17 +21,27 @@
 #include <com_android_bluetooth_flags.h>
 #include <fcntl.h>
 #include <linux/uhid.h>
-#include <poll.h>
 #include <pthread.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "bta_hh_api.h"
+#include "btif_common.h"
 #include "btif_hh.h"
+#include "common/time_util.h"
 #include "hci/controller_interface.h"
+#include "main/shim/dumpsys.h"
 #include "main/shim/entry.h"
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
@@ -46,18 +56,17 @@ const char* dev_path = "/dev/uhid";
 static tBTA_HH_RPT_CACHE_ENTRY sReportCache[BTA_HH_NV_LOAD_MAX];
 #define BTA_HH_CACHE_REPORT_VERSION 1
 #define THREAD_NORMAL_PRIORITY 0
-#define BT_HH_THREAD_PREFIX "bt_hh_"
-#define BTA_HH_UHID_POLL_PERIOD_MS 50
-/* Max number of polling interrupt allowed */
-#define BTA_HH_UHID_INTERRUPT_COUNT_MAX 100
+#define BT_HH_THREAD_NAME "bt_hh_uhid"
+/* Max number of events read from one UHID device per wakeup */
+#define BTA_HH_UHID_EVENTS_PER_WAKEUP 16
+/* Number of input reports the latency percentiles are computed over */
+#define BTA_HH_INPUT_LATENCY_SAMPLES 1024
 
 using namespace bluetooth;
 
 static const bthh_report_type_t map_rtype_uhid_hh[] = {
     BTHH_FEATURE_REPORT, BTHH_OUTPUT_REPORT, BTHH_INPUT_REPORT};
 
-static void* btif_hh_poll_event_thread(void* arg);
-
 void uhid_set_non_blocking(int fd) {
   int opts = fcntl(fd, F_GETFL);
   if (opts < 0) log::error("Getting flags failed ({})", strerror(errno));
@@ -154,6 +163,9 @@ static int uhid_read_event(btif_hh_uhid_t* p_uhid) {
   if (ret == 0) {
     log::error("Read HUP on uhid-cdev {}", strerror(errno));
     return -EFAULT;
+  } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    /* All pending events were read */
+    return -EAGAIN;
   } else if (ret < 0) {
     log::error("Cannot read uhid-cdev: {}", strerror(errno));
     return -errno;
@@ -239,31 +251,6 @@ static int uhid_read_event(btif_hh_uhid_t* p_uhid) {
   return 0;
 }
 
-/*******************************************************************************
- *
- * Function create_thread
- *
- * Description creat a select loop
- *
- * Returns pthread_t
- *
- ******************************************************************************/
-static inline pthread_t create_thread(void* (*start_routine)(void*),
-                                      void* arg) {
-  log::verbose("create_thread: entered");
-  pthread_attr_t thread_attr;
-
-  pthread_attr_init(&thread_attr);
-  pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
-  pthread_t thread_id = -1;
-  if (pthread_create(&thread_id, &thread_attr, start_routine, arg) != 0) {
-    log::error("pthread_create : {}", strerror(errno));
-    return -1;
-  }
-  log::verbose("create_thread: thread created successfully");
-  return thread_id;
-}
-
 /* Internal function to close the UHID driver*/
 static void uhid_fd_close(btif_hh_uhid_t* p_uhid) {
   if (p_uhid->fd >= 0) {
@@ -276,130 +263,284 @@ static void uhid_fd_close(btif_hh_uhid_t* p_uhid) {
   }
 }
 
-/* Internal function to open the UHID driver*/
-static bool uhid_fd_open(btif_hh_device_t* p_dev) {
-  if (p_dev->uhid.fd < 0) {
-    p_dev->uhid.fd = open(dev_path, O_RDWR | O_CLOEXEC);
-    if (p_dev->uhid.fd < 0) {
-      log::error("Failed to open uhid, err:{}", strerror(errno));
+/* Closes the UHID driver of a device whose fd failed, unless the device was
+ * closed or its driver reopened since. Runs on the btif thread. */
+static void uhid_fd_close_failed(uint8_t dev_handle, int fd) {
+  btif_hh_device_t* p_dev = btif_hh_find_dev_by_handle(dev_handle);
+  if (p_dev == nullptr || p_dev->uhid.fd != fd ||
+      p_dev->uhid.hh_keep_polling) {
+    return;
+  }
+  uhid_fd_close(&p_dev->uhid);
+}
+
+namespace {
+
+/* Single thread serving the UHID fds of all the connected HID devices.
+ *
+ * The fds are non-blocking and waited on with one epoll set, so that idle
+ * devices cost no wakeup. All the events pending on a device are handled in
+ * one wakeup. Devices are added when their connection opens and removed, with
+ * their fd closed, when it closes; the thread stops with the last device. */
+class UhidDispatcher {
+ public:
+  ~UhidDispatcher() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    devices_.clear();
+    Stop(lock);
+  }
+
+  bool Add(btif_hh_uhid_t* p_uhid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (epoll_fd_ < 0 && !Start()) {
       return false;
     }
+
+    uhid_set_non_blocking(p_uhid->fd);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = p_uhid->fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, p_uhid->fd, &event) < 0) {
+      log::error("Cannot watch uhid fd={}: {}", p_uhid->fd, strerror(errno));
+      return false;
+    }
+
+    devices_[p_uhid->fd] = p_uhid;
+    p_uhid->hh_keep_polling = 1;
+    return true;
   }
 
-  if (p_dev->uhid.hh_keep_polling == 0) {
-    p_dev->uhid.hh_keep_polling = 1;
-    p_dev->hh_poll_thread_id =
-        create_thread(btif_hh_poll_event_thread, &p_dev->uhid);
+  /* Stop serving |p_uhid| and close its fd. Called on the btif thread, which
+   * owns |p_uhid|. When this returns, the thread no longer accesses |p_uhid|.
+   */
+  void Remove(btif_hh_uhid_t* p_uhid) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (p_uhid->hh_keep_polling) {
+      Unwatch(p_uhid);
+    }
+    uhid_fd_close(p_uhid);
+
+    if (devices_.empty()) {
+      Stop(lock);
+    }
   }
-  return true;
-}
 
-static int uhid_fd_poll(btif_hh_uhid_t* p_uhid,
-                        std::array<struct pollfd, 1>& pfds) {
-  int ret = 0;
-  int counter = 0;
+ private:
+  bool Start() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+      log::error("Cannot create uhid epoll set: {}", strerror(errno));
+      CloseFds();
+      return false;
+    }
 
-  do {
-    if (com::android::bluetooth::flags::break_uhid_polling_early() &&
-        !p_uhid->hh_keep_polling) {
-      log::debug("Polling stopped");
-      return -1;
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeup_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) < 0) {
+      log::error("Cannot watch uhid wakeup fd: {}", strerror(errno));
+      CloseFds();
+      return false;
     }
 
-    if (counter++ > BTA_HH_UHID_INTERRUPT_COUNT_MAX) {
-      log::error("Polling interrupted consecutively {} times",
-                 BTA_HH_UHID_INTERRUPT_COUNT_MAX);
-      return -1;
+    stopping_ = false;
+    thread_ = std::thread(&UhidDispatcher::Run, this);
+    return true;
+  }
+
+  void Stop(std::unique_lock<std::mutex>& lock) {
+    if (epoll_fd_ < 0) {
+      return;
     }
 
-    ret = poll(pfds.data(), pfds.size(), BTA_HH_UHID_POLL_PERIOD_MS);
-  } while (ret == -1 && errno == EINTR);
+    stopping_ = true;
+    uint64_t value = 1;
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(wakeup_fd_, &value, sizeof(value)));
+    if (ret != sizeof(value)) {
+      log::error("Cannot wake up uhid thread: {}", strerror(errno));
+    }
 
-  if (!com::android::bluetooth::flags::break_uhid_polling_early()) {
-    if (ret == 0) {
-      log::verbose("Polling timed out, attempt to read (old behavior)");
-      return 1;
+    std::thread thread = std::move(thread_);
+    lock.unlock();
+    if (thread.joinable()) {
+      thread.join();
     }
+    lock.lock();
+    CloseFds();
   }
 
-  return ret;
-}
+  void CloseFds() {
+    if (epoll_fd_ >= 0) {
+      close(epoll_fd_);
+      epoll_fd_ = -1;
+    }
+    if (wakeup_fd_ >= 0) {
+      close(wakeup_fd_);
+      wakeup_fd_ = -1;
+    }
+  }
 
-static void uhid_start_polling(btif_hh_uhid_t* p_uhid) {
-  std::array<struct pollfd, 1> pfds = {};
-  pfds[0].fd = p_uhid->fd;
-  pfds[0].events = POLLIN;
+  void Unwatch(btif_hh_uhid_t* p_uhid) {
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, p_uhid->fd, nullptr) < 0) {
+      log::warn("Cannot unwatch uhid fd={}: {}", p_uhid->fd, strerror(errno));
+    }
+    devices_.erase(p_uhid->fd);
+    p_uhid->hh_keep_polling = 0;
+  }
+
+  static void ConfigureThread() {
+    // This thread is created by bt_main_thread with RT priority. Lower the
+    // thread priority here since the tasks in this thread is not timing
+    // critical.
+    struct sched_param sched_params;
+    sched_params.sched_priority = THREAD_NORMAL_PRIORITY;
+    if (sched_setscheduler(gettid(), SCHED_OTHER, &sched_params)) {
+      log::error("Failed to set thread priority to normal: {}",
+                 strerror(errno));
+    }
+    pthread_setname_np(pthread_self(), BT_HH_THREAD_NAME);
+  }
 
-  while (p_uhid->hh_keep_polling) {
-    int ret = uhid_fd_poll(p_uhid, pfds);
+  void Run() {
+    ConfigureThread();
+    log::debug("Host hid uhid thread started");
 
-    if (ret < 0) {
-      log::error("Cannot poll for fds: {}\n", strerror(errno));
-      break;
-    } else if (ret == 0) {
-      /* Poll timeout, poll again */
-      continue;
-    }
+    std::array<struct epoll_event, BTIF_HH_MAX_HID + 1> events;
+    while (true) {
+      int ret;
+      OSI_NO_INTR(ret = epoll_wait(epoll_fd_, events.data(), events.size(),
+                                   -1));
+      if (ret < 0) {
+        log::error("Cannot wait for uhid events: {}", strerror(errno));
+        break;
+      }
 
-    /* At least one of the fd is ready */
-    if (pfds[0].revents & POLLIN) {
-      log::verbose("POLLIN");
-      int result = uhid_read_event(p_uhid);
-      if (result != 0) {
-        log::error("Unhandled UHID event, error: {}", result);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
         break;
       }
+      for (int i = 0; i < ret; i++) {
+        if (events[i].data.fd != wakeup_fd_) {
+          HandleEvents(events[i].data.fd, events[i].events);
+        }
+      }
     }
+
+    log::debug("Host hid uhid thread stopped");
   }
-}
 
-static bool uhid_configure_thread(btif_hh_uhid_t* p_uhid) {
-  pid_t pid = gettid();
-  // This thread is created by bt_main_thread with RT priority. Lower the thread
-  // priority here since the tasks in this thread is not timing critical.
-  struct sched_param sched_params;
-  sched_params.sched_priority = THREAD_NORMAL_PRIORITY;
-  if (sched_setscheduler(pid, SCHED_OTHER, &sched_params)) {
-    log::error("Failed to set thread priority to normal: {}", strerror(errno));
-    return false;
+  void HandleEvents(int fd, uint32_t revents) {
+    auto it = devices_.find(fd);
+    if (it == devices_.end()) {
+      /* Removed since the events were returned */
+      return;
+    }
+    btif_hh_uhid_t* p_uhid = it->second;
+
+    int result = 0;
+    if (revents & EPOLLIN) {
+      for (int i = 0; i < BTA_HH_UHID_EVENTS_PER_WAKEUP && result == 0; i++) {
+        result = uhid_read_event(p_uhid);
+      }
+      if (result == -EAGAIN) {
+        result = 0;
+      }
+    } else if (revents & (EPOLLERR | EPOLLHUP)) {
+      result = -EPIPE;
+    }
+
+    if (result != 0) {
+      /* Todo: Disconnect if the device failed */
+      log::error("Unhandled UHID event, error: {}, stopping device {}", result,
+                 p_uhid->link_spec);
+      Unwatch(p_uhid);
+      /* The btif thread may still be writing to the fd: it closes it */
+      do_in_jni_thread(
+          base::BindOnce(uhid_fd_close_failed, p_uhid->dev_handle, fd));
+    }
+  }
+
+  std::mutex mutex_;
+  /* Devices by UHID fd */
+  std::map<int, btif_hh_uhid_t*> devices_;
+  int epoll_fd_{-1};
+  int wakeup_fd_{-1};
+  bool stopping_{false};
+  std::thread thread_;
+};
+
+UhidDispatcher uhid_dispatcher;
+
+#define DUMPSYS_TAG "shim::legacy::hid"
+
+/* Latency of the last input reports, from their reception by BTA to their
+ * write to UHID */
+class InputLatencyTrace {
+ public:
+  void Record(uint64_t latency_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples_us_[count_ % samples_us_.size()] =
+        std::min<uint64_t>(latency_us, UINT32_MAX);
+    count_++;
+  }
+
+  void Dump(int fd) {
+    std::vector<uint32_t> samples;
+    uint64_t count;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      count = count_;
+      samples.assign(samples_us_.begin(),
+                     samples_us_.begin() +
+                         std::min<uint64_t>(count_, samples_us_.size()));
+    }
+
+    if (samples.empty()) {
+      LOG_DUMPSYS(fd, "input report latency: no report");
+      return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](size_t p) {
+      return samples[(samples.size() - 1) * p / 100];
+    };
+    LOG_DUMPSYS(fd,
+                "input report latency (us) reports:%llu p50:%u p90:%u p99:%u "
+                "max:%u",
+                (unsigned long long)count, percentile(50), percentile(90),
+                percentile(99), samples.back());
   }
 
-  // Change the name of thread
-  char thread_name[16] = {};
-  sprintf(thread_name, BT_HH_THREAD_PREFIX "%02x:%02x",
-          p_uhid->link_spec.addrt.bda.address[4],
-          p_uhid->link_spec.addrt.bda.address[5]);
-  pthread_setname_np(pthread_self(), thread_name);
-  log::debug("Host hid polling thread created name:{} pid:{} fd:{}",
-             thread_name, pid, p_uhid->fd);
+ private:
+  std::mutex mutex_;
+  std::array<uint32_t, BTA_HH_INPUT_LATENCY_SAMPLES> samples_us_{};
+  uint64_t count_{0};
+};
 
-  // Set the uhid fd as non-blocking to ensure we never block the BTU thread
-  uhid_set_non_blocking(p_uhid->fd);
+InputLatencyTrace input_latency_trace;
 
-  return true;
-}
+#undef DUMPSYS_TAG
 
-/*******************************************************************************
- *
- * Function btif_hh_poll_event_thread
- *
- * Description the polling thread which polls for event from UHID driver
- *
- * Returns void
- *
- ******************************************************************************/
-static void* btif_hh_poll_event_thread(void* arg) {
-  btif_hh_uhid_t* p_uhid = (btif_hh_uhid_t*)arg;
+}  // namespace
 
-  if (uhid_configure_thread(p_uhid)) {
-    uhid_start_polling(p_uhid);
+/* Internal function to open the UHID driver*/
+static bool uhid_fd_open(btif_hh_device_t* p_dev) {
+  if (p_dev->uhid.fd < 0) {
+    p_dev->uhid.fd = open(dev_path, O_RDWR | O_CLOEXEC);
+    if (p_dev->uhid.fd < 0) {
+      log::error("Failed to open uhid, err:{}", strerror(errno));
+      return false;
+    }
   }
 
-  /* Todo: Disconnect if loop exited due to a failure */
-  log::info("Polling thread stopped for device {}", p_uhid->link_spec);
-  p_uhid->hh_keep_polling = 0;
-  uhid_fd_close(p_uhid);
-  return 0;
+  if (p_dev->uhid.hh_keep_polling == 0) {
+    if (!uhid_dispatcher.Add(&p_dev->uhid)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 int bta_hh_co_write(int fd, uint8_t* rpt, uint16_t len) {
@@ -514,13 +655,8 @@ void bta_hh_co_close(btif_hh_device_t* p_dev) {
   p_dev->uhid.set_rpt_id_queue = nullptr;
 #endif  // ENABLE_UHID_SET_REPORT
 
-  /* Stop the polling thread */
-  if (p_dev->uhid.hh_keep_polling) {
-    p_dev->uhid.hh_keep_polling = 0;
-    pthread_join(p_dev->hh_poll_thread_id, NULL);
-    p_dev->hh_poll_thread_id = -1;
-  }
-  /* UHID file descriptor is closed by the polling thread */
+  /* Stop serving the device and close its UHID file descriptor */
+  uhid_dispatcher.Remove(&p_dev->uhid);
 }
 
 /*******************************************************************************
@@ -533,10 +669,12 @@ void bta_hh_co_close(btif_hh_device_t* p_dev) {
  * Parameters       dev_handle  - device handle
  *                  *p_rpt      - pointer to the report data
  *                  len         - length of report data
+ *                  rx_timestamp_us - boot time the report was received at
  *
  * Returns          void
  ******************************************************************************/
-void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len) {
+void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
+                    uint64_t rx_timestamp_us) {
   btif_hh_device_t* p_dev;
 
   log::verbose("dev_handle = {}", dev_handle);
@@ -559,13 +697,27 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len) {
 
   // Send the HID data to the kernel.
   if ((p_dev->uhid.fd >= 0) && p_dev->uhid.ready_for_data) {
-    bta_hh_co_write(p_dev->uhid.fd, p_rpt, len);
+    if (bta_hh_co_write(p_dev->uhid.fd, p_rpt, len) == 0) {
+      input_latency_trace.Record(bluetooth::common::time_get_os_boottime_us() -
+                                 rx_timestamp_us);
+    }
   } else {
     log::warn("Error: fd = {}, ready {}, len = {}", p_dev->uhid.fd,
               p_dev->uhid.ready_for_data, len);
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_dump
+ *
+ * Description      Dump the latency percentiles of the input reports written
+ *                  to UHID.
+ *
+ * Returns          void
+ ******************************************************************************/
+void bta_hh_co_dump(int fd) { input_latency_trace.Dump(fd); }
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_send_hid_info
@@ -629,8 +781,7 @@ void bta_hh_co_send_hid_info(btif_hh_device_t* p_dev, const char* dev_name,
     log::warn("Error: failed to send DSCP, result = {}", result);
 
     /* The HID report descriptor is corrupted. Close the driver. */
-    close(p_dev->uhid.fd);
-    p_dev->uhid.fd = -1;
+    uhid_dispatcher.Remove(&p_dev->uhid);
   }
 }
 
@@ -39,6 +39,15 @@ void btif_a2dp_command_ack(tA2DP_CTRL_ACK status);
 // |bytes_read| is the number of bytes to increment by.
 void btif_a2dp_control_log_bytes_read(uint32_t bytes_read);
 
+// Read the audio data written by the audio HAL, from the PCM ring if the HAL
+// requested one, otherwise from the UIPC data channel.
+// |p_buf| is the buffer for the data and |len| the number of bytes to read.
+// Returns the number of bytes read.
+uint32_t btif_a2dp_control_read_audio(uint8_t* p_buf, uint32_t len);
+
+// Drop the audio data written by the audio HAL and not read yet.
+void btif_a2dp_control_flush_audio(void);
+
 // Set the audio delay reported to the audio HAL in uints of 1/10ms.
 // |delay| is the audio delay to set.
 void btif_a2dp_control_set_audio_delay(uint16_t delay);
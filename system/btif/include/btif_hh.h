@@ -106,7 +106,6 @@ typedef struct {
   tBTA_HH_ATTR_MASK attr_mask;
   uint8_t sub_class;
   uint8_t app_id;
-  pthread_t hh_poll_thread_id;
   alarm_t* vup_timer;
   bool local_vup;  // Indicated locally initiated VUP
   btif_hh_uhid_t uhid;
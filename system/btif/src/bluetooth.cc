@@ -45,6 +45,7 @@
 #include <hardware/bt_sdp.h>
 #include <hardware/bt_sock.h>
 #include <hardware/bt_vc.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -94,6 +95,7 @@
 #include "internal_include/bt_target.h"
 #include "main/shim/dumpsys.h"
 #include "os/parameter_provider.h"
+#include "os/stats.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocator.h"
 #include "osi/include/stack_power_telemetry.h"
@@ -111,6 +113,7 @@
 #include "stack/include/hidh_api.h"
 #include "stack/include/main_thread.h"
 #include "stack/include/pan_api.h"
+#include "stack/include/sdp_api.h"
 #include "storage/config_keys.h"
 #include "types/raw_address.h"
 
@@ -806,6 +809,24 @@ static int set_event_filter_connection_setup_all_devices() {
   return BT_STATUS_SUCCESS;
 }
 
+static void stats_dump(int fd) {
+  auto& registry = bluetooth::os::StatsRegistry::Get();
+  if (registry.GetFd() >= 0) {
+    dprintf(fd, "\nStack stats (page /proc/%d/fd/%d):\n", getpid(),
+            registry.GetFd());
+  } else {
+    dprintf(fd, "\nStack stats (not published):\n");
+  }
+  for (const auto& stat : registry.Read()) {
+    if (stat.type == bluetooth::os::StatsType::kGauge) {
+      dprintf(fd, "  %-40s %" PRId64 "\n", stat.name.c_str(),
+              static_cast<int64_t>(stat.value));
+    } else {
+      dprintf(fd, "  %-40s %" PRIu64 "\n", stat.name.c_str(), stat.value);
+    }
+  }
+}
+
 static void dump(int fd, const char** arguments) {
   log::debug("Started bluetooth dumpsys");
   btif_debug_conn_dump(fd);
@@ -833,10 +854,12 @@ static void dump(int fd, const char** arguments) {
   connection_manager::dump(fd);
   bluetooth::bqr::DebugDump(fd);
   PAN_Dumpsys(fd);
+  SDP_Dumpsys(fd);
   DumpsysHid(fd);
   DumpsysBtaDm(fd);
   bluetooth::shim::Dump(fd, arguments);
   power_telemetry::GetInstance().Dumpsys(fd);
+  stats_dump(fd);
   log::debug("Finished bluetooth dumpsys");
 }
 
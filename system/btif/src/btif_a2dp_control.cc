@@ -25,6 +25,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <memory>
+#include <mutex>
+
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
 #include "btif_a2dp_sink.h"
 #include "btif_a2dp_source.h"
@@ -32,6 +35,7 @@
 #include "btif_av_co.h"
 #include "btif_hf.h"
 #include "types/raw_address.h"
+#include "udrv/include/pcm_ring.h"
 #include "udrv/include/uipc.h"
 
 #define A2DP_DATA_READ_POLL_MS 10
@@ -60,6 +64,21 @@ static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static tA2DP_CTRL_CMD a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
 std::unique_ptr<tUIPC_STATE> a2dp_uipc = nullptr;
 
+/* PCM ring requested by the audio HAL, replacing the data channel for the
+ * audio data. Set on the UIPC thread, read from the media task. */
+static std::mutex pcm_ring_mutex;
+static std::shared_ptr<tPCM_RING> pcm_ring;
+
+static std::shared_ptr<tPCM_RING> btif_a2dp_control_get_pcm_ring() {
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  return pcm_ring;
+}
+
+static void btif_a2dp_control_set_pcm_ring(std::shared_ptr<tPCM_RING> ring) {
+  std::lock_guard<std::mutex> lock(pcm_ring_mutex);
+  pcm_ring = std::move(ring);
+}
+
 void btif_a2dp_control_init(void) {
   a2dp_uipc = UIPC_Init();
   UIPC_Open(*a2dp_uipc, UIPC_CH_ID_AV_CTRL, btif_a2dp_ctrl_cb, A2DP_CTRL_PATH);
@@ -70,6 +89,7 @@ void btif_a2dp_control_cleanup(void) {
   if (a2dp_uipc != nullptr) {
     UIPC_Close(*a2dp_uipc, UIPC_CH_ID_ALL);
   }
+  btif_a2dp_control_set_pcm_ring(nullptr);
 }
 
 static tA2DP_CTRL_ACK btif_a2dp_control_on_check_ready() {
@@ -250,6 +270,25 @@ static void btif_a2dp_control_on_get_presentation_position() {
   UIPC_Send(*a2dp_uipc, UIPC_CH_ID_AV_CTRL, 0, (uint8_t*)&nsec, sizeof(nsec));
 }
 
+static void btif_a2dp_control_on_get_pcm_ring() {
+  std::shared_ptr<tPCM_RING> ring =
+      PCM_RING_Create(AUDIO_STREAM_OUTPUT_BUFFER_SZ);
+  if (ring == nullptr) {
+    btif_a2dp_command_ack(A2DP_CTRL_ACK_FAILURE);
+    return;
+  }
+
+  btif_a2dp_command_ack(A2DP_CTRL_ACK_SUCCESS);
+  uint8_t msg = 0;
+  int fds[] = {ring->mem_fd, ring->data_fd};
+  if (!UIPC_SendFds(*a2dp_uipc, UIPC_CH_ID_AV_CTRL, &msg, sizeof(msg), fds,
+                    2)) {
+    log::error("Error sending the PCM ring to audio HAL");
+    return;
+  }
+  btif_a2dp_control_set_pcm_ring(std::move(ring));
+}
+
 static void btif_a2dp_recv_ctrl_data(void) {
   tA2DP_CTRL_CMD cmd = A2DP_CTRL_CMD_NONE;
   int n;
@@ -307,6 +346,10 @@ static void btif_a2dp_recv_ctrl_data(void) {
       btif_a2dp_control_on_get_presentation_position();
       break;
 
+    case A2DP_CTRL_GET_PCM_RING:
+      btif_a2dp_control_on_get_pcm_ring();
+      break;
+
     default:
       log::error("UNSUPPORTED CMD ({})", cmd);
       btif_a2dp_command_ack(A2DP_CTRL_ACK_FAILURE);
@@ -336,6 +379,8 @@ static void btif_a2dp_ctrl_cb(tUIPC_CH_ID /* ch_id */, tUIPC_EVENT event) {
       break;
 
     case UIPC_CLOSE_EVT:
+      /* the audio HAL is gone along with its end of the PCM ring */
+      btif_a2dp_control_set_pcm_ring(nullptr);
       /* restart ctrl server unless we are shutting down */
       if (btif_a2dp_source_media_task_is_running())
         UIPC_Open(*a2dp_uipc, UIPC_CH_ID_AV_CTRL, btif_a2dp_ctrl_cb,
@@ -431,3 +476,19 @@ void btif_a2dp_control_reset_audio_delay(void) {
   delay_report_stats.total_bytes_read = 0;
   delay_report_stats.timestamp = {};
 }
+
+uint32_t btif_a2dp_control_read_audio(uint8_t* p_buf, uint32_t len) {
+  std::shared_ptr<tPCM_RING> ring = btif_a2dp_control_get_pcm_ring();
+  if (ring != nullptr) {
+    return PCM_RING_Read(*ring, p_buf, len, A2DP_DATA_READ_POLL_MS);
+  }
+  return UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, p_buf, len);
+}
+
+void btif_a2dp_control_flush_audio(void) {
+  std::shared_ptr<tPCM_RING> ring = btif_a2dp_control_get_pcm_ring();
+  if (ring != nullptr) {
+    PCM_RING_Flush(*ring);
+  }
+  UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, nullptr);
+}
@@ -31,7 +31,9 @@
 #include <string.h>
 
 #include <algorithm>
+#include <deque>
 #include <future>
+#include <mutex>
 
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
 #include "audio_hal_interface/a2dp_encoding.h"
@@ -46,6 +48,7 @@
 #include "common/repeating_timer.h"
 #include "common/time_util.h"
 #include "os/log.h"
+#include "os/stats.h"
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/wakelock.h"
@@ -69,6 +72,11 @@ extern std::unique_ptr<tUIPC_STATE> a2dp_uipc;
  */
 #define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 
+static bluetooth::os::StatsCounter stats_tx_frames("a2dp.tx_frames");
+static bluetooth::os::StatsCounter stats_tx_dropped_packets(
+    "a2dp.tx_dropped_packets");
+static bluetooth::os::StatsGauge stats_tx_queue_length("a2dp.tx_queue_length");
+
 class SchedulingStats {
  public:
   SchedulingStats() { Reset(); }
@@ -139,6 +147,12 @@ class BtifMediaStats {
     media_read_total_underflow_bytes = 0;
     media_read_total_underflow_count = 0;
     media_read_last_underflow_us = 0;
+    media_read_total_time_us = 0;
+    media_read_max_time_us = 0;
+    encode_total_time_us = 0;
+    encode_max_time_us = 0;
+    tx_queue_total_length = 0;
+    tx_queue_max_length = 0;
     codec_index = -1;
   }
 
@@ -169,6 +183,16 @@ class BtifMediaStats {
   size_t media_read_total_underflow_count;
   uint64_t media_read_last_underflow_us;
 
+  // Time spent reading PCM and encoding it, per encoder tick
+  uint64_t media_read_total_time_us;
+  uint64_t media_read_max_time_us;
+  uint64_t encode_total_time_us;
+  uint64_t encode_max_time_us;
+
+  // Length of the TX queue, at each encoder tick
+  size_t tx_queue_total_length;
+  size_t tx_queue_max_length;
+
   int codec_index = -1;
 };
 
@@ -187,11 +211,13 @@ class BtifA2dpSource {
         sw_audio_is_encoding(false),
         encoder_interface(nullptr),
         encoder_interval_ms(0),
+        media_read_time_us(0),
         state_(kStateOff) {}
 
   void Reset() {
     fixed_queue_free(tx_audio_queue, nullptr);
     tx_audio_queue = nullptr;
+    tx_audio_queue_times_us.clear();
     tx_flush = false;
     media_alarm.CancelAndWait();
     wakelock_release();
@@ -219,11 +245,16 @@ class BtifA2dpSource {
   void SetState(BtifA2dpSource::RunState state) { state_ = state; }
 
   fixed_queue_t* tx_audio_queue;
+  // When the buffers of tx_audio_queue were enqueued, in the same order. Taken
+  // with the queue on the media thread, and on the main thread that reads it.
+  std::mutex tx_audio_queue_mutex;
+  std::deque<uint64_t> tx_audio_queue_times_us;
   bool tx_flush; /* Discards any outgoing data when true */
   bool sw_audio_is_encoding;
   RepeatingTimer media_alarm;
   const tA2DP_ENCODER_INTERFACE* encoder_interface;
   uint64_t encoder_interval_ms; /* Local copy of the encoder interval */
+  uint64_t media_read_time_us;  /* PCM read time of the current tick */
   BtifMediaStats stats;
   BtifMediaStats accumulated_stats;
 
@@ -320,6 +351,15 @@ void btif_a2dp_source_accumulate_stats(BtifMediaStats* src,
   dst->media_read_total_underflow_count +=
       src->media_read_total_underflow_count;
   dst->media_read_last_underflow_us = src->media_read_last_underflow_us;
+  dst->media_read_total_time_us += src->media_read_total_time_us;
+  dst->media_read_max_time_us =
+      std::max(dst->media_read_max_time_us, src->media_read_max_time_us);
+  dst->encode_total_time_us += src->encode_total_time_us;
+  dst->encode_max_time_us =
+      std::max(dst->encode_max_time_us, src->encode_max_time_us);
+  dst->tx_queue_total_length += src->tx_queue_total_length;
+  dst->tx_queue_max_length =
+      std::max(dst->tx_queue_max_length, src->tx_queue_max_length);
   if (dst->codec_index < 0) dst->codec_index = src->codec_index;
   btif_a2dp_source_accumulate_scheduling_stats(&src->tx_queue_enqueue_stats,
                                                &dst->tx_queue_enqueue_stats);
@@ -514,8 +554,12 @@ static void btif_a2dp_source_shutdown_delayed(
   } else {
     btif_a2dp_control_cleanup();
   }
-  fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
-  btif_a2dp_source_cb.tx_audio_queue = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_audio_queue_mutex);
+    fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
+    btif_a2dp_source_cb.tx_audio_queue = nullptr;
+    btif_a2dp_source_cb.tx_audio_queue_times_us.clear();
+  }
 
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateOff);
 
@@ -859,7 +903,7 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
         bluetooth::audio::a2dp::read(p_buf, sizeof(p_buf)));
   } else if (a2dp_uipc != nullptr) {
     btif_a2dp_control_log_bytes_read(
-        UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, p_buf, sizeof(p_buf)));
+        btif_a2dp_control_read_audio(p_buf, sizeof(p_buf)));
   }
 
   /* Stop the timer first */
@@ -920,8 +964,23 @@ static void btif_a2dp_source_audio_handle_timer(void) {
     btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length(
         transmit_queue_length);
   }
+  btif_a2dp_source_cb.media_read_time_us = 0;
+  uint64_t encode_start_us = bluetooth::common::time_get_os_boottime_us();
   btif_a2dp_source_cb.encoder_interface->send_frames(timestamp_us);
+  uint64_t media_read_time_us = btif_a2dp_source_cb.media_read_time_us;
+  uint64_t encode_time_us = bluetooth::common::time_get_os_boottime_us() -
+                            encode_start_us - media_read_time_us;
   bta_av_ci_src_data_ready(BTA_AV_CHNL_AUDIO);
+
+  BtifMediaStats& stats = btif_a2dp_source_cb.stats;
+  stats.media_read_total_time_us += media_read_time_us;
+  stats.media_read_max_time_us =
+      std::max(stats.media_read_max_time_us, media_read_time_us);
+  stats.encode_total_time_us += encode_time_us;
+  stats.encode_max_time_us = std::max(stats.encode_max_time_us, encode_time_us);
+  stats.tx_queue_total_length += transmit_queue_length;
+  stats.tx_queue_max_length =
+      std::max(stats.tx_queue_max_length, transmit_queue_length);
   update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_enqueue_stats,
                           stats_timestamp_us,
                           btif_a2dp_source_cb.encoder_interval_ms * 1000);
@@ -929,12 +988,15 @@ static void btif_a2dp_source_audio_handle_timer(void) {
 
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
   uint32_t bytes_read = 0;
+  uint64_t read_start_us = bluetooth::common::time_get_os_boottime_us();
 
   if (bluetooth::audio::a2dp::is_hal_enabled()) {
     bytes_read = bluetooth::audio::a2dp::read(p_buf, len);
   } else if (a2dp_uipc != nullptr) {
-    bytes_read = UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, p_buf, len);
+    bytes_read = btif_a2dp_control_read_audio(p_buf, len);
   }
+  btif_a2dp_source_cb.media_read_time_us +=
+      bluetooth::common::time_get_os_boottime_us() - read_start_us;
 
   if (btif_a2dp_source_cb.sw_audio_is_encoding && bytes_read < len) {
     log::warn("UNDERFLOW: ONLY READ {} BYTES OUT OF {}", bytes_read, len);
@@ -966,10 +1028,12 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
   if (btif_a2dp_source_cb.tx_flush) {
     log::verbose("tx suspended, discarded frame");
 
+    std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_audio_queue_mutex);
     btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
         fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
     btif_a2dp_source_cb.stats.tx_queue_last_flushed_us = now_us;
     fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+    btif_a2dp_source_cb.tx_audio_queue_times_us.clear();
 
     osi_free(p_buf);
     return false;
@@ -987,13 +1051,16 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
 
     // Flush all queued buffers
+    std::unique_lock<std::mutex> lock(btif_a2dp_source_cb.tx_audio_queue_mutex);
     size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
     btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages = std::max(
         drop_n, btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages);
     int num_dropped_encoded_bytes = 0;
     int num_dropped_encoded_frames = 0;
+    btif_a2dp_source_cb.tx_audio_queue_times_us.clear();
     while (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue)) {
       btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
+      stats_tx_dropped_packets.Increment();
       void* p_data =
           fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
       if (p_data != nullptr) {
@@ -1003,6 +1070,7 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
         osi_free(p_data);
       }
     }
+    lock.unlock();
     log_a2dp_audio_overrun_event(
         btif_av_source_active_peer(), btif_a2dp_source_cb.encoder_interval_ms,
         drop_n, num_dropped_encoded_frames, num_dropped_encoded_bytes);
@@ -1043,7 +1111,14 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
       btif_a2dp_source_cb.encoder_interface != nullptr,
       "assert failed: btif_a2dp_source_cb.encoder_interface != nullptr");
 
-  fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
+  {
+    std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_audio_queue_mutex);
+    fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
+    btif_a2dp_source_cb.tx_audio_queue_times_us.push_back(now_us);
+  }
+  stats_tx_frames.Increment(frames_n);
+  stats_tx_queue_length.Set(
+      fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue));
 
   return true;
 }
@@ -1056,14 +1131,18 @@ static void btif_a2dp_source_audio_tx_flush_event(void) {
   if (btif_a2dp_source_cb.encoder_interface != nullptr)
     btif_a2dp_source_cb.encoder_interface->feeding_flush();
 
-  btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-      fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
-  btif_a2dp_source_cb.stats.tx_queue_last_flushed_us =
-      bluetooth::common::time_get_os_boottime_us();
-  fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+  {
+    std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_audio_queue_mutex);
+    btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
+        fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+    btif_a2dp_source_cb.stats.tx_queue_last_flushed_us =
+        bluetooth::common::time_get_os_boottime_us();
+    fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+    btif_a2dp_source_cb.tx_audio_queue_times_us.clear();
+  }
 
   if (!bluetooth::audio::a2dp::is_hal_enabled() && a2dp_uipc != nullptr) {
-    UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, nullptr);
+    btif_a2dp_control_flush_audio();
   }
 }
 
@@ -1077,6 +1156,7 @@ static bool btif_a2dp_source_audio_tx_flush_req(void) {
 
 BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_audio_queue_mutex);
   BT_HDR* p_buf =
       (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
 
@@ -1084,6 +1164,16 @@ BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   btif_a2dp_source_cb.stats.tx_queue_last_readbuf_us = now_us;
   if (p_buf != nullptr) {
     // Update the statistics
+    auto& times_us = btif_a2dp_source_cb.tx_audio_queue_times_us;
+    if (!times_us.empty()) {
+      uint64_t queueing_time_us = now_us - times_us.front();
+      times_us.pop_front();
+      btif_a2dp_source_cb.stats.tx_queue_total_queueing_time_us +=
+          queueing_time_us;
+      btif_a2dp_source_cb.stats.tx_queue_max_queueing_time_us =
+          std::max(btif_a2dp_source_cb.stats.tx_queue_max_queueing_time_us,
+                   queueing_time_us);
+    }
     update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_dequeue_stats,
                             now_us,
                             btif_a2dp_source_cb.encoder_interval_ms * 1000);
@@ -1184,6 +1274,25 @@ void btif_a2dp_source_debug_dump(int fd) {
           accumulated_stats->tx_queue_total_frames,
           accumulated_stats->tx_queue_max_frames_per_packet, ave_size);
 
+  ave_size = 0;
+  if (enqueue_stats->total_updates != 0)
+    ave_size =
+        accumulated_stats->tx_queue_total_length / enqueue_stats->total_updates;
+  dprintf(fd,
+          "  Length (max/ave)                                        : %zu / "
+          "%zu\n",
+          accumulated_stats->tx_queue_max_length, ave_size);
+
+  ave_time_us = 0;
+  if (dequeue_stats->total_updates != 0)
+    ave_time_us = accumulated_stats->tx_queue_total_queueing_time_us /
+                  dequeue_stats->total_updates;
+  dprintf(fd,
+          "  Queueing time in us (max/ave)                           : %llu / "
+          "%llu\n",
+          (unsigned long long)accumulated_stats->tx_queue_max_queueing_time_us,
+          (unsigned long long)ave_time_us);
+
   dprintf(fd,
           "  Counts (flushed/dropped/dropouts)                       : %zu / "
           "%zu / %zu\n",
@@ -1227,6 +1336,29 @@ void btif_a2dp_source_debug_dump(int fd) {
                     1000
               : 0);
 
+  //
+  // Encoder tick stats
+  //
+  ave_time_us = 0;
+  if (enqueue_stats->total_updates != 0)
+    ave_time_us = accumulated_stats->media_read_total_time_us /
+                  enqueue_stats->total_updates;
+  dprintf(fd,
+          "  PCM read time per tick in us (max/ave)                  : %llu / "
+          "%llu\n",
+          (unsigned long long)accumulated_stats->media_read_max_time_us,
+          (unsigned long long)ave_time_us);
+
+  ave_time_us = 0;
+  if (enqueue_stats->total_updates != 0)
+    ave_time_us =
+        accumulated_stats->encode_total_time_us / enqueue_stats->total_updates;
+  dprintf(fd,
+          "  Encode time per tick in us (max/ave)                    : %llu / "
+          "%llu\n",
+          (unsigned long long)accumulated_stats->encode_max_time_us,
+          (unsigned long long)ave_time_us);
+
   //
   // TxQueue enqueue stats
   //
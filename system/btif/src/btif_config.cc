@@ -38,6 +38,7 @@
 #include "main/shim/config.h"
 #include "main/shim/shim.h"
 #include "os/log.h"
+#include "os/trace.h"
 #include "raw_address.h"
 #include "storage/config_keys.h"
 
@@ -159,6 +160,7 @@ static future_t* init(void) {
                    "assert failed: bluetooth::shim::is_gd_stack_started_up()");
   // TODO (b/158035889) Migrate metrics module to GD
   read_or_set_metrics_salt();
+  bluetooth::os::ScopedTrace trace("btif", "init_metric_id_allocator");
   init_metric_id_allocator();
   return future_new_immediate(FUTURE_SUCCESS);
 }
@@ -56,6 +56,7 @@
 #include "main/shim/entry.h"
 #include "main/shim/helpers.h"
 #include "os/log.h"
+#include "os/trace.h"
 #include "osi/include/allocator.h"
 #include "osi/include/future.h"
 #include "osi/include/properties.h"
@@ -158,6 +159,7 @@ void btif_init_ok() {
  ******************************************************************************/
 bt_status_t btif_init_bluetooth() {
   log::info("entered");
+  bluetooth::os::ScopedTrace trace("btif", "btif_init_bluetooth");
   exit_manager = new base::AtExitManager();
   jni_thread_startup();
   GetInterfaceToProfiles()->events->invoke_thread_evt_cb(ASSOCIATE_JVM);
@@ -177,6 +179,8 @@ bt_status_t btif_init_bluetooth() {
  ******************************************************************************/
 
 void btif_enable_bluetooth_evt() {
+  bluetooth::os::ScopedTrace trace("btif", "btif_enable_bluetooth_evt");
+
   /* Fetch the local BD ADDR */
   RawAddress local_bd_addr = bluetooth::ToRawAddress(
       bluetooth::shim::GetController()->GetMacAddress());
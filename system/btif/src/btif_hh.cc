@@ -157,6 +157,7 @@ void bta_hh_co_send_hid_info(btif_hh_device_t* p_dev, const char* dev_name,
                              uint16_t version, uint8_t ctry_code, int dscp_len,
                              uint8_t* p_dscp);
 void bta_hh_co_write(int fd, uint8_t* rpt, uint16_t len);
+void bta_hh_co_dump(int fd);
 static void bte_hh_evt(tBTA_HH_EVT event, tBTA_HH* p_data);
 void btif_dm_hh_open_failed(RawAddress* bdaddr);
 void btif_hd_service_registration();
@@ -2221,12 +2222,12 @@ void DumpsysHid(int fd) {
   for (unsigned i = 0; i < BTIF_HH_MAX_HID; i++) {
     const btif_hh_device_t* p_dev = &btif_hh_cb.devices[i];
     if (p_dev->link_spec.addrt.bda != RawAddress::kEmpty) {
-      LOG_DUMPSYS(
-          fd, "  %u: addr:%s fd:%d state:%s ready:%s thread_id:%d handle:%d", i,
-          p_dev->link_spec.ToRedactedStringForLogging().c_str(), p_dev->uhid.fd,
-          bthh_connection_state_text(p_dev->dev_status).c_str(),
-          (p_dev->uhid.ready_for_data) ? ("T") : ("F"),
-          static_cast<int>(p_dev->hh_poll_thread_id), p_dev->dev_handle);
+      LOG_DUMPSYS(fd, "  %u: addr:%s fd:%d state:%s ready:%s handle:%d", i,
+                  p_dev->link_spec.ToRedactedStringForLogging().c_str(),
+                  p_dev->uhid.fd,
+                  bthh_connection_state_text(p_dev->dev_status).c_str(),
+                  (p_dev->uhid.ready_for_data) ? ("T") : ("F"),
+                  p_dev->dev_handle);
     }
   }
   for (unsigned i = 0; i < BTIF_HH_MAX_ADDED_DEV; i++) {
@@ -2237,6 +2238,7 @@ void DumpsysHid(int fd) {
                   p_dev->reconnect_allowed ? "T" : "F");
     }
   }
+  bta_hh_co_dump(fd);
 }
 
 namespace bluetooth {
@@ -36,10 +36,12 @@
 #include <linux/if_ether.h>
 #include <linux/if_tun.h>
 #include <net/if.h>
-#include <poll.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#include <deque>
+#include <vector>
+
 #include "bta/include/bta_pan_api.h"
 #include "btif/include/btif_common.h"
 #include "btif/include/btif_pan_internal.h"
@@ -71,8 +73,6 @@
     if (!(s)) log::error("btif_pan: ## assert {} failed ##", #s); \
   } while (0)
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-
 using namespace bluetooth;
 
 btpan_cb_t btpan_cb;
@@ -92,7 +92,10 @@ static void btpan_tap_fd_signaled(int fd, int type, int flags,
                                   uint32_t user_id);
 static void btpan_cleanup_conn(btpan_conn_t* conn);
 static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data);
-static void btu_exec_tap_fd_read(const int fd);
+static void btpan_tap_read_frames(int fd);
+static void btu_exec_tap_frames(int fd, std::vector<BT_HDR*> frames);
+static void btu_forward_tap_frames(int fd);
+static void btu_drop_tap_frames();
 
 static btpan_interface_t pan_if = {
     sizeof(pan_if), btpan_jni_init,   nullptr,          btpan_get_local_role,
@@ -350,9 +353,10 @@ void btpan_set_flow_control(bool enable) {
 
   btpan_cb.flow = enable;
   if (enable) {
-    btsock_thread_add_fd(pan_pth, btpan_cb.tap_fd, 0, SOCK_THREAD_FD_RD, 0);
+    // Frames held back while the flow was off go first, then the TAP fd is
+    // monitored again
     do_in_main_thread(FROM_HERE,
-                      base::BindOnce(btu_exec_tap_fd_read, btpan_cb.tap_fd));
+                      base::BindOnce(btu_forward_tap_frames, btpan_cb.tap_fd));
   }
 }
 
@@ -421,6 +425,7 @@ int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
 int btpan_tap_close(int fd) {
   if (tap_if_down(TAP_IF_NAME) == 0) close(fd);
   if (pan_pth >= 0) btsock_thread_wakeup(pan_pth);
+  do_in_main_thread(FROM_HERE, base::BindOnce(btu_drop_tap_frames));
   return 0;
 }
 
@@ -643,89 +648,109 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data) {
                         sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
-static void btu_exec_tap_fd_read(int fd) {
-  struct pollfd ufd;
+// Frames read from the TAP driver and not forwarded yet because the outbound
+// data flow is off. Only accessed from the main thread.
+static std::deque<BT_HDR*> tap_frames;
 
-  if (fd == INVALID_FD || fd != btpan_cb.tap_fd) return;
+// Reads the frames the TAP driver has queued, up to PAN_BUF_MAX, and hands them
+// to the main thread in a single task. Runs on the PAN thread. Each frame is
+// read into the buffer that goes down to BNEP, after room for the BNEP and
+// L2CAP headers, so that it isn't copied again.
+static void btpan_tap_read_frames(int fd) {
+  std::vector<BT_HDR*> frames;
+  BT_HDR* buffer = NULL;
 
-  // Don't occupy BTU context too long, avoid buffer overruns and
-  // give other profiles a chance to run by limiting the amount of memory
-  // PAN can use.
-  for (int i = 0; i < PAN_BUF_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
-    BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+  while (frames.size() < PAN_BUF_MAX) {
+    if (buffer == NULL) buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
     buffer->offset = PAN_MINIMUM_OFFSET;
-    buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
-
-    uint8_t* packet = (uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset;
-
-    // If we don't have an undelivered packet left over, pull one from the TAP
-    // driver.
-    // We save it in the congest_packet right away in case we can't deliver it
-    // in this
-    // attempt.
-    if (!btpan_cb.congest_packet_size) {
-      ssize_t ret;
-      OSI_NO_INTR(ret = read(fd, btpan_cb.congest_packet,
-                             sizeof(btpan_cb.congest_packet)));
-      switch (ret) {
-        case -1:
-          log::error("unable to read from driver: {}", strerror(errno));
-          osi_free(buffer);
-          // add fd back to monitor thread to try it again later
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        case 0:
-          log::warn("end of file reached.");
-          osi_free(buffer);
-          // add fd back to monitor thread to process the exception
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        default:
-          btpan_cb.congest_packet_size = ret;
-          break;
+    uint8_t* packet = (uint8_t*)(buffer + 1) + buffer->offset;
+
+    // The fd is non-blocking: stop once the driver has no frame left
+    ssize_t ret;
+    OSI_NO_INTR(ret = read(fd, packet,
+                           PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset));
+    if (ret < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        log::error("unable to read from driver: {}", strerror(errno));
       }
+      break;
+    }
+    if (ret == 0) {
+      log::warn("end of file reached.");
+      break;
     }
 
-    memcpy(packet, btpan_cb.congest_packet,
-           MIN(btpan_cb.congest_packet_size, buffer->len));
-    buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
-
-    if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR*)packet)) {
-      // Extract the ethernet header from the buffer since the PAN_WriteBuf
-      // inside
-      // forward_bnep can't handle two pointers that point inside the same GKI
-      // buffer.
-      tETH_HDR hdr;
-      memcpy(&hdr, packet, sizeof(tETH_HDR));
-
-      // Skip the ethernet header.
-      buffer->len -= sizeof(tETH_HDR);
-      buffer->offset += sizeof(tETH_HDR);
-      if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-        btpan_cb.congest_packet_size = 0;
-    } else {
-      log::warn("dropping packet of length {}", buffer->len);
-      btpan_cb.congest_packet_size = 0;
-      osi_free(buffer);
+    // Dropped frames leave their buffer to the next read
+    if ((size_t)ret <= sizeof(tETH_HDR) || !should_forward((tETH_HDR*)packet)) {
+      log::warn("dropping packet of length {}", ret);
+      continue;
     }
+    buffer->len = ret;
+    frames.push_back(buffer);
+    buffer = NULL;
+  }
+  osi_free(buffer);
 
-    // Bail out of the loop if reading from the TAP fd would block.
-    ufd.fd = fd;
-    ufd.events = POLLIN;
-    ufd.revents = 0;
+  // The main thread adds the fd back to the PAN thread once the frames are
+  // forwarded, so no more than one batch is in flight
+  do_in_main_thread(FROM_HERE,
+                    base::BindOnce(btu_exec_tap_frames, fd, std::move(frames)));
+}
 
-    int ret;
-    OSI_NO_INTR(ret = poll(&ufd, 1, 0));
-    if (ret <= 0 || IS_EXCEPTION(ufd.revents)) break;
+static void btu_exec_tap_frames(int fd, std::vector<BT_HDR*> frames) {
+  tap_frames.insert(tap_frames.end(), frames.begin(), frames.end());
+  btu_forward_tap_frames(fd);
+}
+
+// Forwards the frames read from the TAP driver while the outbound data flow is
+// on, then monitors the fd again. The frames left over when the flow goes off
+// wait for btpan_set_flow_control() to turn it back on.
+static void btu_forward_tap_frames(int fd) {
+  if (fd == INVALID_FD || fd != btpan_cb.tap_fd) {
+    btu_drop_tap_frames();
+    return;
   }
 
-  if (btpan_cb.flow) {
+  while (!tap_frames.empty() && btpan_cb.flow) {
+    BT_HDR* buffer = tap_frames.front();
+    tap_frames.pop_front();
+    if (!btif_is_enabled()) {
+      osi_free(buffer);
+      continue;
+    }
+
+    // Extract the ethernet header from the buffer since the PAN_WriteBuf
+    // inside forward_bnep can't handle two pointers that point inside the
+    // same buffer.
+    uint8_t* packet = (uint8_t*)(buffer + 1) + buffer->offset;
+    tETH_HDR hdr;
+    memcpy(&hdr, packet, sizeof(tETH_HDR));
+
+    // Skip the ethernet header.
+    buffer->len -= sizeof(tETH_HDR);
+    buffer->offset += sizeof(tETH_HDR);
+    if (forward_bnep(&hdr, buffer) == FORWARD_CONGEST) {
+      // BNEP left the frame to us: it goes first once L2CAP isn't congested
+      // anymore, and btpan_set_flow_control() turns the flow back on
+      buffer->len += sizeof(tETH_HDR);
+      buffer->offset -= sizeof(tETH_HDR);
+      tap_frames.push_front(buffer);
+      btpan_cb.flow = false;
+      break;
+    }
+  }
+
+  if (btpan_cb.flow && tap_frames.empty()) {
     // add fd back to monitor thread when the flow is on
     btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
   }
 }
 
+static void btu_drop_tap_frames() {
+  for (BT_HDR* frame : tap_frames) osi_free(frame);
+  tap_frames.clear();
+}
+
 static void btif_pan_close_all_conns() {
   if (!stack_initialized) return;
 
@@ -750,6 +775,6 @@ static void btpan_tap_fd_signaled(int fd, int type, int flags,
     btpan_tap_close(fd);
     btif_pan_close_all_conns();
   } else if (flags & SOCK_THREAD_FD_RD) {
-    do_in_main_thread(FROM_HERE, base::BindOnce(btu_exec_tap_fd_read, fd));
+    btpan_tap_read_frames(fd);
   }
 }
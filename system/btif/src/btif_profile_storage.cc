@@ -28,6 +28,7 @@
 
 #include <vector>
 
+#include "bta_api.h"
 #include "bta_csis_api.h"
 #include "bta_groups.h"
 #include "bta_has_api.h"
@@ -281,6 +282,8 @@ static void btif_storage_load_bonded_hogp_device(const tAclLinkSpec link_spec) {
  *
  ******************************************************************************/
 bt_status_t btif_storage_load_bonded_hid_info(void) {
+  /* Restore the accept list entries of all the devices in one go */
+  BTA_DmBeginLeListUpdates();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
     tAclLinkSpec link_spec = {};
@@ -305,6 +308,7 @@ bt_status_t btif_storage_load_bonded_hid_info(void) {
       btif_storage_load_bonded_hogp_device(link_spec);
     }
   }
+  BTA_DmCommitLeListUpdates();
   return BT_STATUS_SUCCESS;
 }
 
@@ -486,6 +490,7 @@ void btif_storage_add_hearing_aid(const HearingDevice& dev_info) {
 
 /** Loads information about bonded hearing aid devices */
 void btif_storage_load_bonded_hearing_aids() {
+  BTA_DmBeginLeListUpdates();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     const std::string& name = bd_addr.ToString();
 
@@ -588,6 +593,7 @@ void btif_storage_load_bonded_hearing_aids() {
                            render_delay, preparation_delay),
              is_acceptlisted));
   }
+  BTA_DmCommitLeListUpdates();
 }
 
 /** Deletes the bonded hearing aid device info from NVRAM */
@@ -774,6 +780,7 @@ void btif_storage_set_leaudio_supported_context_types(
 
 /** Loads information about bonded Le Audio devices */
 void btif_storage_load_bonded_leaudio() {
+  BTA_DmBeginLeListUpdates();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
 
@@ -864,6 +871,7 @@ void btif_storage_load_bonded_leaudio() {
              std::move(handles), std::move(sink_pacs), std::move(source_pacs),
              std::move(ases)));
   }
+  BTA_DmCommitLeListUpdates();
 }
 
 void btif_storage_leaudio_clear_service_data(const RawAddress& address) {
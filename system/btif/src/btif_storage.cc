@@ -41,6 +41,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "bta/include/bta_api.h"
 #include "btif/include/stack_manager_t.h"
 #include "btif_api.h"
 #include "btif_config.h"
@@ -457,6 +458,9 @@ static bt_status_t btif_in_fetch_bonded_devices(
   bool bt_linkkey_file_found = false;
   int device_type;
 
+  /* Add the resolving list entries of all the devices in one go */
+  if (add) BTA_DmBeginLeListUpdates();
+
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
 
@@ -499,6 +503,8 @@ static bt_status_t btif_in_fetch_bonded_devices(
       log::verbose("No link key or ble key found for device:{}", bd_addr);
     }
   }
+
+  if (add) BTA_DmCommitLeListUpdates();
   return BT_STATUS_SUCCESS;
 }
 
@@ -35,6 +35,7 @@
 #include "core_callbacks.h"
 #include "main/shim/shim.h"
 #include "os/log.h"
+#include "os/trace.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/btm_client_interface.h"
 #include "stack/include/main_thread.h"
@@ -234,14 +235,22 @@ static void init_stack_internal(bluetooth::core::CoreInterface* interface) {
   // all callbacks out of libbluetooth-core happen via this interface
   interfaceToProfiles = interface;
 
+  bluetooth::os::ScopedTrace trace("stack", "init_stack");
+
   module_management_start();
 
   main_thread_start_up();
 
   module_init(get_local_module(DEVICE_IOT_CONFIG_MODULE));
   module_init(get_local_module(OSI_MODULE));
-  module_start_up(get_local_module(GD_SHIM_MODULE));
-  module_init(get_local_module(BTIF_CONFIG_MODULE));
+  {
+    bluetooth::os::ScopedTrace trace("stack", "gd_shim_start_up");
+    module_start_up(get_local_module(GD_SHIM_MODULE));
+  }
+  {
+    bluetooth::os::ScopedTrace trace("stack", "btif_config_init");
+    module_init(get_local_module(BTIF_CONFIG_MODULE));
+  }
   btif_init_bluetooth();
 
   module_init(get_local_module(INTEROP_MODULE));
@@ -288,43 +297,62 @@ static void event_start_up_stack(bluetooth::core::CoreInterface* interface,
   ensure_stack_is_initialized(interface);
 
   log::info("is bringing up the stack");
+  bluetooth::os::ScopedTrace trace("stack", "start_up_stack");
   future_t* local_hack_future = future_new();
   hack_future = local_hack_future;
 
   log::info("Gd shim module enabled");
   get_btm_client_interface().lifecycle.btm_init();
-  module_start_up(get_local_module(BTIF_CONFIG_MODULE));
+  {
+    bluetooth::os::ScopedTrace trace("stack", "btif_config_start_up");
+    module_start_up(get_local_module(BTIF_CONFIG_MODULE));
+  }
 
-  l2c_init();
-  sdp_init();
-  gatt_init();
-  SMP_Init(get_btm_client_interface().security.BTM_GetSecurityMode());
-  get_btm_client_interface().lifecycle.btm_ble_init();
+  {
+    bluetooth::os::ScopedTrace trace("stack", "stack_init");
+    l2c_init();
+    sdp_init();
+    gatt_init();
+    SMP_Init(get_btm_client_interface().security.BTM_GetSecurityMode());
+    get_btm_client_interface().lifecycle.btm_ble_init();
 
-  RFCOMM_Init();
-  GAP_Init();
+    RFCOMM_Init();
+    GAP_Init();
+  }
 
-  startProfiles();
+  {
+    bluetooth::os::ScopedTrace trace("stack", "start_profiles");
+    startProfiles();
+  }
 
-  bta_sys_init();
+  {
+    bluetooth::os::ScopedTrace trace("stack", "bta_init");
+    bta_sys_init();
 
-  btif_init_ok();
-  BTA_dm_init();
-  bta_dm_enable(btif_dm_sec_evt, btif_dm_acl_evt);
+    btif_init_ok();
+    BTA_dm_init();
+    bta_dm_enable(btif_dm_sec_evt, btif_dm_acl_evt);
 
-  btm_acl_device_down();
-  BTM_reset_complete();
+    btm_acl_device_down();
+    BTM_reset_complete();
+  }
 
-  BTA_dm_on_hw_on();
+  {
+    bluetooth::os::ScopedTrace trace("stack", "hw_on");
+    BTA_dm_on_hw_on();
 
-  if (future_await(local_hack_future) != FUTURE_SUCCESS) {
-    log::error("failed to start up the stack");
-    stack_is_running = true;  // So stack shutdown actually happens
-    event_shut_down_stack(stopProfiles);
-    return;
+    if (future_await(local_hack_future) != FUTURE_SUCCESS) {
+      log::error("failed to start up the stack");
+      stack_is_running = true;  // So stack shutdown actually happens
+      event_shut_down_stack(stopProfiles);
+      return;
+    }
   }
 
-  module_start_up(get_local_module(RUST_MODULE));
+  {
+    bluetooth::os::ScopedTrace trace("stack", "rust_start_up");
+    module_start_up(get_local_module(RUST_MODULE));
+  }
   if (com::android::bluetooth::flags::channel_sounding_in_stack()) {
     bluetooth::ras::GetRasServer()->Initialize();
     bluetooth::ras::GetRasClient()->Initialize();
@@ -343,6 +371,7 @@ static void event_shut_down_stack(ProfileStopCallback stopProfiles) {
   }
 
   log::info("is bringing down the stack");
+  bluetooth::os::ScopedTrace trace("stack", "shut_down_stack");
   future_t* local_hack_future = future_new();
   hack_future = local_hack_future;
   stack_is_running = false;
@@ -352,13 +381,19 @@ static void event_shut_down_stack(ProfileStopCallback stopProfiles) {
   do_in_main_thread(FROM_HERE, base::BindOnce(&btm_ble_scanner_cleanup));
 
   btif_dm_on_disable();
-  stopProfiles();
+  {
+    bluetooth::os::ScopedTrace trace("stack", "stop_profiles");
+    stopProfiles();
+  }
 
   do_in_main_thread(FROM_HERE, base::BindOnce(bta_dm_disable));
 
   btif_dm_cleanup();
 
-  future_await(local_hack_future);
+  {
+    bluetooth::os::ScopedTrace trace("stack", "bta_dm_disable");
+    future_await(local_hack_future);
+  }
   local_hack_future = future_new();
   hack_future = local_hack_future;
 
@@ -368,7 +403,10 @@ static void event_shut_down_stack(ProfileStopCallback stopProfiles) {
   module_shut_down(get_local_module(BTIF_CONFIG_MODULE));
   module_shut_down(get_local_module(DEVICE_IOT_CONFIG_MODULE));
 
-  future_await(local_hack_future);
+  {
+    bluetooth::os::ScopedTrace trace("stack", "hw_off");
+    future_await(local_hack_future);
+  }
 
   gatt_free();
   sdp_free();
@@ -393,6 +431,7 @@ static void ensure_stack_is_not_running(ProfileStopCallback stopProfiles) {
 // Synchronous function to clean up the stack
 static void event_clean_up_stack(std::promise<void> promise,
                                  ProfileStopCallback stopProfiles) {
+  bluetooth::os::ScopedTrace trace("stack", "clean_up_stack");
   if (!stack_is_initialized) {
     log::info("found the stack already in a clean state");
     goto cleanup;
@@ -413,7 +452,10 @@ static void event_clean_up_stack(std::promise<void> promise,
 
   module_clean_up(get_local_module(OSI_MODULE));
   log::info("Gd shim module disabled");
-  module_shut_down(get_local_module(GD_SHIM_MODULE));
+  {
+    bluetooth::os::ScopedTrace trace("stack", "gd_shim_shut_down");
+    module_shut_down(get_local_module(GD_SHIM_MODULE));
+  }
 
   main_thread_shut_down();
 
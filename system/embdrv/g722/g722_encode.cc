@@ -434,4 +434,392 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     return g722_bytes;
 }
 /*- End of function --------------------------------------------------------*/
+
+/* Dual channel encoder.
+ *
+ * The left and right channels are encoded in lockstep, with the QMF and the
+ * block 4 predictor of the four bands (left low, left high, right low, right
+ * high) computed on vectors of four 32 bit lanes. The quantizers and scale
+ * factor adaptation stay scalar. The output and the encoder states are the
+ * same as encoding each channel with g722_encode(). */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <smmintrin.h>
+
+#define G722_STEREO_SIMD 1
+#define G722_SIMD_TARGET __attribute__((target("sse4.1")))
+
+typedef __m128i g722_v4_t;
+
+#define V4_FN static __inline G722_SIMD_TARGET
+
+V4_FN g722_v4_t v4_set(int l0, int l1, int l2, int l3) { return _mm_setr_epi32(l0, l1, l2, l3); }
+V4_FN g722_v4_t v4_dup(int x) { return _mm_set1_epi32(x); }
+V4_FN g722_v4_t v4_load(const int *p) { return _mm_loadu_si128((const __m128i *) p); }
+V4_FN void v4_store(int *p, g722_v4_t v) { _mm_storeu_si128((__m128i *) p, v); }
+V4_FN g722_v4_t v4_add(g722_v4_t a, g722_v4_t b) { return _mm_add_epi32(a, b); }
+V4_FN g722_v4_t v4_sub(g722_v4_t a, g722_v4_t b) { return _mm_sub_epi32(a, b); }
+V4_FN g722_v4_t v4_mul(g722_v4_t a, g722_v4_t b) { return _mm_mullo_epi32(a, b); }
+V4_FN g722_v4_t v4_min(g722_v4_t a, g722_v4_t b) { return _mm_min_epi32(a, b); }
+V4_FN g722_v4_t v4_max(g722_v4_t a, g722_v4_t b) { return _mm_max_epi32(a, b); }
+V4_FN g722_v4_t v4_eq(g722_v4_t a, g722_v4_t b) { return _mm_cmpeq_epi32(a, b); }
+/* mask ? a : b, per lane */
+V4_FN g722_v4_t v4_select(g722_v4_t mask, g722_v4_t a, g722_v4_t b) { return _mm_blendv_epi8(b, a, mask); }
+/* {l1, l1, l3, l3} and {l0, l0, l2, l2} */
+V4_FN g722_v4_t v4_dup_odd(g722_v4_t v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 1, 1)); }
+V4_FN g722_v4_t v4_dup_even(g722_v4_t v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 0, 0)); }
+#define v4_sra(v, n) _mm_srai_epi32((v), (n))
+#define v4_sll(v, n) _mm_slli_epi32((v), (n))
+
+static int g722_stereo_simd_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+}
+
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+
+#define G722_STEREO_SIMD 1
+#define G722_SIMD_TARGET
+
+typedef int32x4_t g722_v4_t;
+
+#define V4_FN static __inline
+
+V4_FN g722_v4_t v4_set(int l0, int l1, int l2, int l3)
+{
+    int lanes[4] = {l0, l1, l2, l3};
+    return vld1q_s32(lanes);
+}
+V4_FN g722_v4_t v4_dup(int x) { return vdupq_n_s32(x); }
+V4_FN g722_v4_t v4_load(const int *p) { return vld1q_s32(p); }
+V4_FN void v4_store(int *p, g722_v4_t v) { vst1q_s32(p, v); }
+V4_FN g722_v4_t v4_add(g722_v4_t a, g722_v4_t b) { return vaddq_s32(a, b); }
+V4_FN g722_v4_t v4_sub(g722_v4_t a, g722_v4_t b) { return vsubq_s32(a, b); }
+V4_FN g722_v4_t v4_mul(g722_v4_t a, g722_v4_t b) { return vmulq_s32(a, b); }
+V4_FN g722_v4_t v4_min(g722_v4_t a, g722_v4_t b) { return vminq_s32(a, b); }
+V4_FN g722_v4_t v4_max(g722_v4_t a, g722_v4_t b) { return vmaxq_s32(a, b); }
+V4_FN g722_v4_t v4_eq(g722_v4_t a, g722_v4_t b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+/* mask ? a : b, per lane */
+V4_FN g722_v4_t v4_select(g722_v4_t mask, g722_v4_t a, g722_v4_t b) { return vbslq_s32(vreinterpretq_u32_s32(mask), a, b); }
+/* {l1, l1, l3, l3} and {l0, l0, l2, l2} */
+V4_FN g722_v4_t v4_dup_odd(g722_v4_t v) { return vtrnq_s32(v, v).val[1]; }
+V4_FN g722_v4_t v4_dup_even(g722_v4_t v) { return vtrnq_s32(v, v).val[0]; }
+#define v4_sra(v, n) vshrq_n_s32((v), (n))
+#define v4_sll(v, n) vshlq_n_s32((v), (n))
+
+static int g722_stereo_simd_supported(void)
+{
+    return TRUE;
+}
+
+#endif
+
+#if defined(G722_STEREO_SIMD)
+V4_FN g722_v4_t v4_saturate(g722_v4_t v)
+{
+    return v4_max(v4_min(v, v4_dup(32767)), v4_dup(-32768));
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Index of the first q6 decision level above wd, as the QUANTL loop of
+   g722_encode() finds it. The levels grow with the index, so a binary search
+   gives the same result. */
+static __inline int quantl_index(int wd, int det)
+{
+    int lo = 1;
+    int hi = 30;
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) >> 1;
+
+        if (wd < ((q6[mid]*det) >> 12))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Blocks 1 to 3 of both bands of one channel, returning the G.722 code.
+   Lanes 0 and 1 of el_eh, d, nb and det are the low and high band. */
+static __inline int quantize_channel(const int el_eh[2], int d[2], int nb[2],
+                                     int det[2])
+{
+    int el = el_eh[0];
+    int eh = el_eh[1];
+    int wd;
+    int wd1;
+    int wd2;
+    int wd3;
+    int i;
+    int ilow;
+    int ihigh;
+    int ril;
+    int mih;
+
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
+    i = quantl_index(wd, det[0]);
+    ilow = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = ilow >> 2;
+    d[0] = (det[0]*qm4[ril]) >> 15;
+
+    /* Block 3L, LOGSCL */
+    wd = ((nb[0]*127) >> 7) + wl[rl42[ril]];
+    if (wd < 0)
+        wd = 0;
+    else if (wd > 18432)
+        wd = 18432;
+    nb[0] = wd;
+
+    /* Block 3L, SCALEL */
+    wd1 = (nb[0] >> 6) & 31;
+    wd2 = 8 - (nb[0] >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    det[0] = wd3 << 2;
+
+    /* Block 1H, QUANTH */
+    wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+    wd1 = (564*det[1]) >> 12;
+    mih = (wd >= wd1)  ?  2  :  1;
+    ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+    /* Block 2H, INVQAH */
+    d[1] = (det[1]*qm2[ihigh]) >> 15;
+
+    /* Block 3H, LOGSCH */
+    wd = ((nb[1]*127) >> 7) + wh[rh2[ihigh]];
+    if (wd < 0)
+        wd = 0;
+    else if (wd > 22528)
+        wd = 22528;
+    nb[1] = wd;
+
+    /* Block 3H, SCALEH */
+    wd1 = (nb[1] >> 6) & 31;
+    wd2 = 10 - (nb[1] >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    det[1] = wd3 << 2;
+
+    return (ihigh << 6) | ilow;
+}
+/*- End of function --------------------------------------------------------*/
+
+#define BAND_LOAD(field) \
+    v4_set(band[0]->field, band[1]->field, band[2]->field, band[3]->field)
+#define BAND_STORE(field, v) \
+    do \
+    { \
+        v4_store(lanes, (v)); \
+        for (k = 0;  k < 4;  k++) \
+            band[k]->field = lanes[k]; \
+    } while (0)
+
+G722_SIMD_TARGET
+static int g722_encode_stereo_simd(g722_encode_state_t *left,
+                                   g722_encode_state_t *right,
+                                   uint8_t left_data[], uint8_t right_data[],
+                                   const int16_t left_amp[],
+                                   const int16_t right_amp[], int len)
+{
+    g722_band_t *band[4] = {&left->band[0], &left->band[1],
+                            &right->band[0], &right->band[1]};
+    /* QMF history, x[2i] and x[2i + 1] of both channels */
+    g722_v4_t x[12];
+    g722_v4_t qmf[12];
+    g722_v4_t s, sp, sz, r[3], a[3], p[3], d[7], b[7], bp[7];
+    g722_v4_t ap1, ap2;
+    g722_v4_t zero = v4_dup(0);
+    int lanes[4];
+    int nb[4];
+    int det[4];
+    int dq[4];
+    int g722_bytes;
+    int i;
+    int j;
+    int k;
+
+    for (i = 0;  i < 12;  i++)
+    {
+        x[i] = v4_set(left->x[2*i], left->x[2*i + 1], right->x[2*i],
+                      right->x[2*i + 1]);
+        qmf[i] = v4_set(qmf_coeffs[i], qmf_coeffs[11 - i], qmf_coeffs[i],
+                        qmf_coeffs[11 - i]);
+    }
+    s = BAND_LOAD(s);
+    sp = BAND_LOAD(sp);
+    sz = BAND_LOAD(sz);
+    for (i = 0;  i < 3;  i++)
+    {
+        r[i] = BAND_LOAD(r[i]);
+        a[i] = BAND_LOAD(a[i]);
+        p[i] = BAND_LOAD(p[i]);
+    }
+    for (i = 0;  i < 7;  i++)
+    {
+        d[i] = BAND_LOAD(d[i]);
+        b[i] = BAND_LOAD(b[i]);
+    }
+    for (k = 0;  k < 4;  k++)
+    {
+        nb[k] = band[k]->nb;
+        det[k] = band[k]->det;
+    }
+
+    g722_bytes = 0;
+    for (j = 0;  j < len;  j += 2)
+    {
+        g722_v4_t acc;
+        g722_v4_t xband;
+        g722_v4_t wd1, wd2, wd3, sg0, same01, sgd;
+
+        /* Apply the transmit QMF, the low and high band of both channels */
+        for (i = 0;  i < 11;  i++)
+            x[i] = x[i + 1];
+        x[11] = v4_set(left_amp[j], left_amp[j + 1], right_amp[j],
+                       right_amp[j + 1]);
+        acc = zero;
+        for (i = 0;  i < 12;  i++)
+            acc = v4_add(acc, v4_mul(x[i], qmf[i]));
+        /* (sumeven + sumodd) >> 14 and (sumeven - sumodd) >> 14 */
+        xband = v4_add(v4_dup_odd(acc),
+                       v4_mul(v4_dup_even(acc), v4_set(1, -1, 1, -1)));
+        xband = v4_sra(xband, 14);
+
+        /* Block 1L and 1H, SUBTRA */
+        v4_store(lanes, v4_saturate(v4_sub(xband, s)));
+
+        /* Blocks 1 to 3 */
+        left_data[g722_bytes] =
+            (uint8_t) quantize_channel(&lanes[0], &dq[0], &nb[0], &det[0]);
+        right_data[g722_bytes] =
+            (uint8_t) quantize_channel(&lanes[2], &dq[2], &nb[2], &det[2]);
+        g722_bytes++;
+        d[0] = v4_load(dq);
+
+        /* Block 4, RECONS */
+        r[0] = v4_saturate(v4_add(s, d[0]));
+
+        /* Block 4, PARREC */
+        p[0] = v4_saturate(v4_add(sz, d[0]));
+
+        /* Block 4, UPPOL2 */
+        sg0 = v4_sra(p[0], 15);
+        same01 = v4_eq(sg0, v4_sra(p[1], 15));
+        wd1 = v4_saturate(v4_sll(a[1], 2));
+        wd2 = v4_select(same01, v4_sub(zero, wd1), wd1);
+        wd2 = v4_min(wd2, v4_dup(32767));
+        ap2 = v4_add(v4_sra(wd2, 7),
+                     v4_select(v4_eq(sg0, v4_sra(p[2], 15)), v4_dup(128),
+                               v4_dup(-128)));
+        ap2 = v4_add(ap2, v4_sra(v4_mul(a[2], v4_dup(32512)), 15));
+        ap2 = v4_max(v4_min(ap2, v4_dup(12288)), v4_dup(-12288));
+
+        /* Block 4, UPPOL1 */
+        wd1 = v4_select(same01, v4_dup(192), v4_dup(-192));
+        wd2 = v4_sra(v4_mul(a[1], v4_dup(32640)), 15);
+        ap1 = v4_saturate(v4_add(wd1, wd2));
+        wd3 = v4_saturate(v4_sub(v4_dup(15360), ap2));
+        ap1 = v4_max(v4_min(ap1, wd3), v4_sub(zero, wd3));
+
+        /* Block 4, UPZERO */
+        /* Block 4, FILTEZ */
+        wd1 = v4_select(v4_eq(d[0], zero), zero, v4_dup(128));
+        sgd = v4_sra(d[0], 15);
+        for (i = 1;  i < 7;  i++)
+        {
+            wd2 = v4_select(v4_eq(v4_sra(d[i], 15), sgd), wd1,
+                            v4_sub(zero, wd1));
+            wd3 = v4_sra(v4_mul(b[i], v4_dup(32640)), 15);
+            bp[i] = v4_saturate(v4_add(wd2, wd3));
+        }
+
+        /* Block 4, DELAYA */
+        sz = zero;
+        for (i = 6;  i > 0;  i--)
+        {
+            d[i] = d[i - 1];
+            b[i] = bp[i];
+            wd1 = v4_saturate(v4_add(d[i], d[i]));
+            sz = v4_add(sz, v4_sra(v4_mul(b[i], wd1), 15));
+        }
+        r[2] = r[1];
+        r[1] = r[0];
+        p[2] = p[1];
+        p[1] = p[0];
+        a[2] = ap2;
+        a[1] = ap1;
+
+        /* Block 4, FILTEP */
+        wd1 = v4_sra(v4_mul(a[1], v4_saturate(v4_add(r[1], r[1]))), 15);
+        wd2 = v4_sra(v4_mul(a[2], v4_saturate(v4_add(r[2], r[2]))), 15);
+        sp = v4_saturate(v4_add(wd1, wd2));
+
+        /* Block 4, PREDIC */
+        s = v4_saturate(v4_add(sp, sz));
+    }
+
+    for (i = 0;  i < 12;  i++)
+    {
+        v4_store(lanes, x[i]);
+        left->x[2*i] = lanes[0];
+        left->x[2*i + 1] = lanes[1];
+        right->x[2*i] = lanes[2];
+        right->x[2*i + 1] = lanes[3];
+    }
+    BAND_STORE(s, s);
+    BAND_STORE(sp, sp);
+    BAND_STORE(sz, sz);
+    for (i = 0;  i < 3;  i++)
+    {
+        BAND_STORE(r[i], r[i]);
+        BAND_STORE(p[i], p[i]);
+    }
+    for (i = 1;  i < 3;  i++)
+    {
+        BAND_STORE(a[i], a[i]);
+        BAND_STORE(ap[i], a[i]);
+    }
+    for (i = 0;  i < 7;  i++)
+        BAND_STORE(d[i], d[i]);
+    for (i = 1;  i < 7;  i++)
+    {
+        BAND_STORE(b[i], b[i]);
+        BAND_STORE(bp[i], b[i]);
+    }
+    for (k = 0;  k < 4;  k++)
+    {
+        band[k]->nb = nb[k];
+        band[k]->det = det[k];
+    }
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[],
+                       const int16_t left_amp[], const int16_t right_amp[],
+                       int len)
+{
+#if defined(G722_STEREO_SIMD)
+    /* The ITU test mode and odd lengths are left to the single channel
+       encoder */
+    if (!left->itu_test_mode && !right->itu_test_mode && (len & 1) == 0 &&
+        g722_stereo_simd_supported())
+    {
+        return g722_encode_stereo_simd(left, right, left_data, right_data,
+                                       left_amp, right_amp, len);
+    }
+#endif
+    g722_encode(left, left_data, left_amp, len);
+    return g722_encode(right, right_data, right_amp, len);
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../../g722/g722_enc_dec.h"
+
+namespace {
+
+// g722_encode_stereo() must produce the same codes, and leave the encoders in
+// the same state, as g722_encode() on each channel.
+class LibG722EncStereoTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (g722_encode_state_t* state :
+         {&left_, &right_, &ref_left_, &ref_right_}) {
+      ASSERT_NE(g722_encode_init(state, 64000, 0), nullptr);
+    }
+  }
+
+  void Encode(const std::vector<int16_t>& left_pcm,
+              const std::vector<int16_t>& right_pcm, size_t chunk) {
+    ASSERT_EQ(left_pcm.size(), right_pcm.size());
+    std::vector<uint8_t> left(chunk), right(chunk);
+    std::vector<uint8_t> ref_left(chunk), ref_right(chunk);
+
+    for (size_t i = 0; i < left_pcm.size(); i += chunk) {
+      int len = std::min(chunk, left_pcm.size() - i);
+      int ref_bytes =
+          g722_encode(&ref_left_, ref_left.data(), &left_pcm[i], len);
+      ASSERT_EQ(g722_encode(&ref_right_, ref_right.data(), &right_pcm[i], len),
+                ref_bytes);
+      ASSERT_EQ(
+          g722_encode_stereo(&left_, &right_, left.data(), right.data(),
+                             &left_pcm[i], &right_pcm[i], len),
+          ref_bytes);
+      ASSERT_EQ(memcmp(left.data(), ref_left.data(), ref_bytes), 0)
+          << "left channel differs at sample " << i;
+      ASSERT_EQ(memcmp(right.data(), ref_right.data(), ref_bytes), 0)
+          << "right channel differs at sample " << i;
+      ASSERT_EQ(memcmp(&left_, &ref_left_, sizeof(left_)), 0);
+      ASSERT_EQ(memcmp(&right_, &ref_right_, sizeof(right_)), 0);
+    }
+  }
+
+  g722_encode_state_t left_, right_;
+  g722_encode_state_t ref_left_, ref_right_;
+};
+
+std::vector<int16_t> noise(size_t len, unsigned seed, int amplitude) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(-amplitude, amplitude - 1);
+  std::vector<int16_t> pcm(len);
+  for (int16_t& sample : pcm) sample = dist(gen);
+  return pcm;
+}
+
+std::vector<int16_t> sine(size_t len, double frequency, double amplitude) {
+  std::vector<int16_t> pcm(len);
+  for (size_t i = 0; i < len; i++) {
+    double sample = amplitude * std::sin(2 * M_PI * frequency * i / 16000);
+    pcm[i] = std::clamp<double>(sample, INT16_MIN, INT16_MAX);
+  }
+  return pcm;
+}
+
+}  // namespace
+
+TEST_F(LibG722EncStereoTest, full_scale_noise) {
+  Encode(noise(16000, 1, 32768), noise(16000, 2, 32768), 320);
+}
+
+TEST_F(LibG722EncStereoTest, quiet_noise) {
+  Encode(noise(16000, 3, 64), noise(16000, 4, 16), 320);
+}
+
+TEST_F(LibG722EncStereoTest, sine) {
+  // Clipped on the right channel
+  Encode(sine(16000, 440, 16000), sine(16000, 6000, 40000), 160);
+}
+
+TEST_F(LibG722EncStereoTest, silence_then_signal) {
+  std::vector<int16_t> left(8000, 0);
+  std::vector<int16_t> right = sine(8000, 1000, 8000);
+  Encode(left, right, 320);
+  Encode(right, left, 320);
+}
+
+TEST_F(LibG722EncStereoTest, small_chunks) {
+  Encode(noise(4000, 5, 4096), noise(4000, 6, 4096), 2);
+  Encode(noise(4002, 7, 4096), noise(4002, 8, 4096), 46);
+}
+
+TEST_F(LibG722EncStereoTest, itu_test_mode) {
+  left_.itu_test_mode = ref_left_.itu_test_mode = 1;
+  right_.itu_test_mode = ref_right_.itu_test_mode = 1;
+  Encode(noise(1600, 9, 32768), noise(1600, 10, 32768), 160);
+}
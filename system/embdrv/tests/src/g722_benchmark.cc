@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Encoding one 20 ms stereo frame for a pair of hearing aids: each channel on
+// its own, as done before the stereo encoder, and both channels at once.
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "../../g722/g722_enc_dec.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// 20 ms at 16 kHz
+constexpr int kFrameSamples = 320;
+
+std::vector<int16_t> sine(double frequency) {
+  std::vector<int16_t> pcm(kFrameSamples);
+  for (int i = 0; i < kFrameSamples; i++) {
+    pcm[i] = 12000 * std::sin(2 * M_PI * frequency * i / 16000);
+  }
+  return pcm;
+}
+
+}  // namespace
+
+static void BM_EncodeChannels(State& state) {
+  g722_encode_state_t left, right;
+  g722_encode_init(&left, 64000, 0);
+  g722_encode_init(&right, 64000, 0);
+  std::vector<int16_t> left_pcm = sine(440), right_pcm = sine(660);
+  uint8_t left_data[kFrameSamples], right_data[kFrameSamples];
+
+  for (auto _ : state) {
+    g722_encode(&left, left_data, left_pcm.data(), kFrameSamples);
+    g722_encode(&right, right_data, right_pcm.data(), kFrameSamples);
+    benchmark::DoNotOptimize(left_data);
+    benchmark::DoNotOptimize(right_data);
+  }
+}
+BENCHMARK(BM_EncodeChannels);
+
+static void BM_EncodeStereo(State& state) {
+  g722_encode_state_t left, right;
+  g722_encode_init(&left, 64000, 0);
+  g722_encode_init(&right, 64000, 0);
+  std::vector<int16_t> left_pcm = sine(440), right_pcm = sine(660);
+  uint8_t left_data[kFrameSamples], right_data[kFrameSamples];
+
+  for (auto _ : state) {
+    g722_encode_stereo(&left, &right, left_data, right_data, left_pcm.data(),
+                       right_pcm.data(), kFrameSamples);
+    benchmark::DoNotOptimize(left_data);
+    benchmark::DoNotOptimize(right_data);
+  }
+}
+BENCHMARK(BM_EncodeStereo);
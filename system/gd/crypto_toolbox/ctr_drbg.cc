@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/ctr_drbg.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "aes.h"
+
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr size_t kBlockLength = 16;
+
+// V = (V + 1) mod 2^128, V being big endian
+void increment(std::array<uint8_t, kBlockLength>& v) {
+  for (size_t i = kBlockLength; i-- > 0;) {
+    if (++v[i] != 0) break;
+  }
+}
+
+void xor_seed(CtrDrbg::Seed& seed, const CtrDrbg::Seed& data) {
+  for (size_t i = 0; i < CtrDrbg::kSeedLength; i++) seed[i] ^= data[i];
+}
+
+}  // namespace
+
+CtrDrbg::CtrDrbg(const Seed& entropy_input, const Seed& personalization_string) {
+  Seed seed_material = entropy_input;
+  xor_seed(seed_material, personalization_string);
+  key_.fill(0);
+  v_.fill(0);
+  Update(seed_material);
+  reseed_counter_ = 1;
+}
+
+void CtrDrbg::Reseed(const Seed& entropy_input, const Seed& additional_input) {
+  Seed seed_material = entropy_input;
+  xor_seed(seed_material, additional_input);
+  Update(seed_material);
+  reseed_counter_ = 1;
+}
+
+bool CtrDrbg::Generate(uint8_t* data, size_t len, const Seed* additional_input) {
+  if (len > kMaxRequestLength || reseed_counter_ > kReseedInterval) return false;
+
+  Seed additional = {};
+  if (additional_input != nullptr) {
+    additional = *additional_input;
+    Update(additional);
+  }
+
+  aes_context ctx;
+  aes_set_key(key_.data(), key_.size(), &ctx);
+  std::array<uint8_t, kBlockLength> block;
+  for (size_t offset = 0; offset < len; offset += kBlockLength) {
+    increment(v_);
+    aes_encrypt(v_.data(), block.data(), &ctx);
+    memcpy(data + offset, block.data(), std::min(kBlockLength, len - offset));
+  }
+
+  Update(additional);
+  reseed_counter_++;
+  return true;
+}
+
+void CtrDrbg::Update(const Seed& provided_data) {
+  aes_context ctx;
+  aes_set_key(key_.data(), key_.size(), &ctx);
+  Seed temp;
+  for (size_t offset = 0; offset < kSeedLength; offset += kBlockLength) {
+    increment(v_);
+    aes_encrypt(v_.data(), temp.data() + offset, &ctx);
+  }
+  xor_seed(temp, provided_data);
+  std::copy(temp.begin(), temp.begin() + kBlockLength, key_.begin());
+  std::copy(temp.begin() + kBlockLength, temp.end(), v_.begin());
+}
+
+}  // namespace crypto_toolbox
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace crypto_toolbox {
+
+// CTR_DRBG with AES-128 and no derivation function, as per NIST SP 800-90A Rev. 1 10.2.1. Not
+// thread safe.
+class CtrDrbg {
+ public:
+  // Key and V
+  static constexpr size_t kSeedLength = 32;
+  // Maximum number of Generate() calls between reseeds
+  static constexpr uint64_t kReseedInterval = 1ull << 48;
+  // Maximum number of bytes per Generate() call
+  static constexpr size_t kMaxRequestLength = 1 << 16;
+
+  using Seed = std::array<uint8_t, kSeedLength>;
+
+  // entropy_input must hold full entropy.
+  explicit CtrDrbg(const Seed& entropy_input, const Seed& personalization_string = {});
+
+  void Reseed(const Seed& entropy_input, const Seed& additional_input = {});
+
+  // Returns false, without output, if len is over kMaxRequestLength or a reseed is required.
+  bool Generate(uint8_t* data, size_t len, const Seed* additional_input = nullptr);
+
+  // Number of Generate() calls since the last reseed, plus one.
+  uint64_t ReseedCounter() const { return reseed_counter_; }
+
+ private:
+  void Update(const Seed& provided_data);
+
+  std::array<uint8_t, 16> key_{};
+  std::array<uint8_t, 16> v_{};
+  uint64_t reseed_counter_ = 0;
+};
+
+}  // namespace crypto_toolbox
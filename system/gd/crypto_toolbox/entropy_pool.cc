@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/entropy_pool.h"
+
+#include <bluetooth/log.h>
+#include <errno.h>
+#include <sys/random.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace crypto_toolbox {
+
+namespace {
+
+CtrDrbg::Seed host_random() {
+  CtrDrbg::Seed seed;
+  size_t offset = 0;
+  while (offset < seed.size()) {
+    ssize_t ret = getrandom(seed.data() + offset, seed.size() - offset, 0);
+    if (ret < 0 && errno == EINTR) continue;
+    bluetooth::log::assert_that(ret > 0, "getrandom failed: {}", strerror(errno));
+    offset += ret;
+  }
+  return seed;
+}
+
+}  // namespace
+
+EntropyPool::EntropyPool(uint64_t reseed_interval)
+    : reseed_interval_(reseed_interval), drbg_(host_random()) {}
+
+void EntropyPool::SetEntropySource(EntropySource source) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    source_ = source;
+    seed_requested_ = static_cast<bool>(source);
+    entropy_.clear();
+  }
+  if (source) source(CtrDrbg::kSeedLength);
+}
+
+void EntropyPool::AddEntropy(const uint8_t* data, size_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!seed_requested_) return;
+  entropy_.insert(entropy_.end(), data, data + len);
+  if (entropy_.size() < CtrDrbg::kSeedLength) return;
+
+  CtrDrbg::Seed entropy_input;
+  std::copy(entropy_.begin(), entropy_.begin() + CtrDrbg::kSeedLength, entropy_input.begin());
+  // The controller isn't trusted alone: the host contributes the additional input
+  drbg_.Reseed(entropy_input, host_random());
+  entropy_.clear();
+  seed_requested_ = false;
+  draws_since_reseed_ = 0;
+  num_reseeds_++;
+}
+
+void EntropyPool::Generate(uint8_t* data, size_t len) {
+  EntropySource source;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (len > 0) {
+      size_t chunk = std::min(len, CtrDrbg::kMaxRequestLength);
+      if (!drbg_.Generate(data, chunk)) {
+        drbg_.Reseed(host_random());
+        continue;
+      }
+      data += chunk;
+      len -= chunk;
+    }
+
+    if (++draws_since_reseed_ >= reseed_interval_ && !seed_requested_ && source_) {
+      seed_requested_ = true;
+      source = source_;
+    }
+  }
+  if (source) source(CtrDrbg::kSeedLength);
+}
+
+uint64_t EntropyPool::NumReseeds() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_reseeds_;
+}
+
+EntropyPool& GetEntropyPool() {
+  static EntropyPool* pool = new EntropyPool();
+  return *pool;
+}
+
+}  // namespace crypto_toolbox
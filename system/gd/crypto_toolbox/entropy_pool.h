@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "crypto_toolbox/ctr_drbg.h"
+
+namespace crypto_toolbox {
+
+// Random numbers for pairing, available without waiting for the controller.
+//
+// A CTR_DRBG instantiated from the host random source is reseeded with entropy read from the
+// controller (HCI LE Rand) in bulk: once when the source is set, then after every reseed_interval
+// draws. Draws never wait for a reseed. Thread safe.
+class EntropyPool {
+ public:
+  static constexpr uint64_t kDefaultReseedInterval = 256;
+
+  // Asks for len bytes of entropy, to be passed to AddEntropy(), possibly in several parts.
+  // Called without the pool locked, from the thread of the draw that makes a reseed due.
+  using EntropySource = std::function<void(size_t len)>;
+
+  explicit EntropyPool(uint64_t reseed_interval = kDefaultReseedInterval);
+  EntropyPool(const EntropyPool&) = delete;
+  EntropyPool& operator=(const EntropyPool&) = delete;
+
+  // Sets the source of entropy and asks it for a seed, or stops reseeding if source is empty.
+  void SetEntropySource(EntropySource source);
+
+  // Reseeds once CtrDrbg::kSeedLength bytes have been collected.
+  void AddEntropy(const uint8_t* data, size_t len);
+
+  void Generate(uint8_t* data, size_t len);
+
+  template <size_t SIZE>
+  std::array<uint8_t, SIZE> Generate() {
+    std::array<uint8_t, SIZE> ret;
+    Generate(ret.data(), ret.size());
+    return ret;
+  }
+
+  // Number of reseeds from the entropy source since construction.
+  uint64_t NumReseeds();
+
+ private:
+  std::mutex mutex_;
+  const uint64_t reseed_interval_;
+  CtrDrbg drbg_;
+  EntropySource source_;
+  bool seed_requested_ = false;
+  uint64_t draws_since_reseed_ = 0;
+  uint64_t num_reseeds_ = 0;
+  std::vector<uint8_t> entropy_;
+};
+
+// Shared by the SMP implementations. The stack owning the controller sets its entropy source.
+EntropyPool& GetEntropyPool();
+
+template <size_t SIZE>
+std::array<uint8_t, SIZE> GenerateRandom() {
+  return GetEntropyPool().Generate<SIZE>();
+}
+
+inline uint32_t GenerateRandom() {
+  uint32_t ret;
+  GetEntropyPool().Generate(reinterpret_cast<uint8_t*>(&ret), sizeof(ret));
+  return ret;
+}
+
+}  // namespace crypto_toolbox
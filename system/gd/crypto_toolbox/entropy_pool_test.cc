@@ -0,0 +1,273 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/entropy_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "crypto_toolbox/ctr_drbg.h"
+
+namespace crypto_toolbox {
+
+namespace {
+
+CtrDrbg::Seed make_seed(uint8_t start) {
+  CtrDrbg::Seed seed;
+  for (size_t i = 0; i < seed.size(); i++) seed[i] = start + i * 7;
+  return seed;
+}
+
+// Answers LE Rand on its own thread after a fixed latency, like a controller over UART
+class FakeController {
+ public:
+  using LeRandCallback = std::function<void(uint64_t)>;
+
+  explicit FakeController(std::chrono::microseconds latency) : latency_(latency) {
+    thread_ = std::thread([this] { Run(); });
+  }
+
+  ~FakeController() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    pending_.notify_all();
+    thread_.join();
+  }
+
+  void LeRand(LeRandCallback callback) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_commands_++;
+      commands_.push_back(std::move(callback));
+    }
+    pending_.notify_all();
+  }
+
+  int NumCommands() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_commands_;
+  }
+
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      pending_.wait(lock, [this] { return stopped_ || !commands_.empty(); });
+      if (stopped_) return;
+      LeRandCallback callback = std::move(commands_.front());
+      commands_.pop_front();
+      lock.unlock();
+      std::this_thread::sleep_for(latency_);
+      callback((uint64_t(random_()) << 32) | random_());
+      lock.lock();
+    }
+  }
+
+  const std::chrono::microseconds latency_;
+  std::mt19937 random_{1};
+  std::mutex mutex_;
+  std::condition_variable pending_;
+  std::deque<LeRandCallback> commands_;
+  int num_commands_ = 0;
+  bool stopped_ = false;
+  std::thread thread_;
+};
+
+// Synthetic list of the random values SMP draws for one LE Secure Connections passkey entry
+// pairing: passkey, 20 rounds of nonces and the DIV of the CSRK. The private key comes from the
+// P-256 key pair pool, which doesn't read LE Rand, so it isn't part of the list. This isn't an SMP
+// run: changes to the draws made by smp_sm_event must be reflected here by hand.
+std::vector<size_t> synthetic_passkey_pairing_draws() {
+  std::vector<size_t> draws = {8};
+  draws.insert(draws.end(), 20, 16);
+  draws.push_back(8);
+  return draws;
+}
+
+}  // namespace
+
+// NIST SP 800-90A CTR_DRBG, AES-128, no derivation function. Expected output from the OpenSSL
+// implementation.
+TEST(CtrDrbgTest, matches_reference_implementation) {
+  CtrDrbg drbg(make_seed(0x10), make_seed(0x50));
+
+  std::array<uint8_t, 64> output;
+  ASSERT_TRUE(drbg.Generate(output.data(), output.size()));
+  EXPECT_EQ(
+      output,
+      (std::array<uint8_t, 64>{
+          0x29, 0x0b, 0x13, 0xf8, 0x5d, 0x1c, 0xee, 0x54, 0xb1, 0xb4, 0xb6, 0x2d, 0x67,
+          0x34, 0x32, 0xc2, 0x32, 0x8a, 0xd6, 0xad, 0x4b, 0xb9, 0x84, 0x2f, 0xba, 0x7a,
+          0x8d, 0xfd, 0x8d, 0xbf, 0x18, 0x5f, 0x72, 0xf3, 0x47, 0x92, 0xbd, 0x83, 0x35,
+          0x4e, 0xd5, 0x99, 0xf2, 0x7c, 0xe2, 0x68, 0x91, 0xc5, 0x88, 0x9e, 0xd8, 0x26,
+          0x79, 0x2d, 0x5b, 0x3f, 0x27, 0x0f, 0xe4, 0x0d, 0x75, 0xf9, 0xc3, 0x15}));
+
+  // Partial last block, with additional input
+  std::array<uint8_t, 40> partial;
+  CtrDrbg::Seed additional_input = make_seed(0x90);
+  ASSERT_TRUE(drbg.Generate(partial.data(), partial.size(), &additional_input));
+  EXPECT_EQ(
+      partial,
+      (std::array<uint8_t, 40>{0x80, 0x4e, 0x22, 0x71, 0x57, 0xa3, 0xeb, 0x55, 0x3a, 0x93,
+                               0xb5, 0x0d, 0xf0, 0xe1, 0x0d, 0x21, 0x08, 0xb1, 0x1a, 0x2f,
+                               0xb7, 0xcb, 0x33, 0xd1, 0x1e, 0x63, 0x96, 0x27, 0xfb, 0x46,
+                               0xfa, 0x1e, 0x35, 0xaa, 0x98, 0xdc, 0x79, 0x87, 0x78, 0xc9}));
+  EXPECT_EQ(drbg.ReseedCounter(), 3u);
+
+  drbg.Reseed(make_seed(0xc0), make_seed(0x33));
+  EXPECT_EQ(drbg.ReseedCounter(), 1u);
+  std::array<uint8_t, 32> reseeded;
+  ASSERT_TRUE(drbg.Generate(reseeded.data(), reseeded.size()));
+  EXPECT_EQ(
+      reseeded,
+      (std::array<uint8_t, 32>{0x5b, 0xe6, 0x1c, 0x37, 0xca, 0x88, 0xb8, 0x31, 0x42, 0x60, 0xf9,
+                               0x6a, 0x8d, 0x6c, 0x32, 0x7c, 0xcd, 0x6d, 0x25, 0xe8, 0x42, 0x8f,
+                               0xbb, 0x18, 0x6e, 0x83, 0x08, 0xd9, 0x31, 0x4b, 0xda, 0xde}));
+}
+
+TEST(CtrDrbgTest, rejects_oversized_request) {
+  CtrDrbg drbg(make_seed(0));
+  std::vector<uint8_t> output(CtrDrbg::kMaxRequestLength + 1);
+  EXPECT_FALSE(drbg.Generate(output.data(), output.size()));
+  EXPECT_EQ(drbg.ReseedCounter(), 1u);
+  EXPECT_TRUE(drbg.Generate(output.data(), CtrDrbg::kMaxRequestLength));
+}
+
+TEST(EntropyPoolTest, generates_without_source) {
+  EntropyPool pool;
+  auto a = pool.Generate<16>();
+  auto b = pool.Generate<16>();
+  EXPECT_NE(a, b);
+
+  // Longer than a single CTR_DRBG request
+  std::vector<uint8_t> large(3 * CtrDrbg::kMaxRequestLength + 5);
+  pool.Generate(large.data(), large.size());
+  EXPECT_EQ(pool.NumReseeds(), 0u);
+}
+
+TEST(EntropyPoolTest, reseeds_from_source) {
+  EntropyPool pool(/* reseed_interval */ 4);
+  std::vector<size_t> requests;
+  pool.SetEntropySource([&](size_t len) { requests.push_back(len); });
+  ASSERT_EQ(requests, std::vector<size_t>{CtrDrbg::kSeedLength});
+
+  // Entropy in 8 byte parts, as returned by LE Rand
+  uint8_t part[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  for (int i = 0; i < 3; i++) pool.AddEntropy(part, sizeof(part));
+  EXPECT_EQ(pool.NumReseeds(), 0u);
+  pool.AddEntropy(part, sizeof(part));
+  EXPECT_EQ(pool.NumReseeds(), 1u);
+
+  // Entropy that wasn't asked for is dropped
+  for (int i = 0; i < 4; i++) pool.AddEntropy(part, sizeof(part));
+  EXPECT_EQ(pool.NumReseeds(), 1u);
+
+  for (int i = 0; i < 3; i++) pool.Generate<8>();
+  EXPECT_EQ(requests.size(), 1u);
+  pool.Generate<8>();
+  EXPECT_EQ(requests.size(), 2u);
+  // A single request while waiting for the controller
+  for (int i = 0; i < 8; i++) pool.Generate<8>();
+  EXPECT_EQ(requests.size(), 2u);
+
+  pool.SetEntropySource(nullptr);
+  for (int i = 0; i < 8; i++) pool.Generate<8>();
+  EXPECT_EQ(requests.size(), 2u);
+}
+
+TEST(EntropyPoolTest, generate_from_several_threads) {
+  EntropyPool pool(/* reseed_interval */ 16);
+  pool.SetEntropySource([&](size_t len) {
+    std::vector<uint8_t> entropy(len, 0x5a);
+    pool.AddEntropy(entropy.data(), entropy.size());
+  });
+
+  std::vector<std::thread> threads;
+  std::vector<std::array<uint8_t, 16>> values(4 * 64);
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 64; i++) values[t * 64 + i] = pool.Generate<16>();
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(std::adjacent_find(values.begin(), values.end()), values.end());
+  // Draws made while a reseed is being added count toward the next one
+  EXPECT_GT(pool.NumReseeds(), 1u);
+}
+
+// HCI commands sent for the synthetic draws of a pairing, reading each 8 bytes from the controller
+// as SMP did, and drawing from the pool. Only the commands are counted, so the controller answers
+// without latency.
+TEST(EntropyPoolTest, synthetic_pairing_draws_hci_commands) {
+  constexpr auto kLatency = std::chrono::microseconds(0);
+  constexpr int kNumPairings = 10;
+  std::vector<size_t> draws = synthetic_passkey_pairing_draws();
+
+  FakeController le_rand_controller(kLatency);
+  for (int pairing = 0; pairing < kNumPairings; pairing++) {
+    for (size_t len : draws) {
+      std::vector<uint8_t> value(len);
+      for (size_t offset = 0; offset < len; offset += sizeof(uint64_t)) {
+        std::promise<uint64_t> rand;
+        le_rand_controller.LeRand([&rand](uint64_t value) { rand.set_value(value); });
+        uint64_t part = rand.get_future().get();
+        memcpy(value.data() + offset, &part, sizeof(part));
+      }
+    }
+  }
+
+  EntropyPool pool;
+  FakeController pool_controller(kLatency);
+  pool.SetEntropySource([&](size_t len) {
+    for (size_t offset = 0; offset < len; offset += sizeof(uint64_t)) {
+      pool_controller.LeRand(
+          [&pool](uint64_t value) { pool.AddEntropy(reinterpret_cast<uint8_t*>(&value), sizeof(value)); });
+    }
+  });
+  for (int pairing = 0; pairing < kNumPairings; pairing++) {
+    for (size_t len : draws) {
+      std::vector<uint8_t> value(len);
+      pool.Generate(value.data(), value.size());
+    }
+  }
+
+  RecordProperty(
+      "synthetic_le_rand_hci_commands_per_pairing",
+      std::to_string(double(le_rand_controller.NumCommands()) / kNumPairings));
+  RecordProperty(
+      "synthetic_pool_hci_commands_per_pairing",
+      std::to_string(double(pool_controller.NumCommands()) / kNumPairings));
+
+  // Passkey, 20 nonces of 16 bytes and DIV, 8 bytes per LE Rand
+  EXPECT_EQ(le_rand_controller.NumCommands(), kNumPairings * 42);
+  // The initial seed only
+  EXPECT_EQ(pool_controller.NumCommands(), 4);
+}
+
+}  // namespace crypto_toolbox
@@ -0,0 +1,638 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/p256.h"
+
+#include <pthread.h>
+
+#include <vector>
+
+namespace crypto_toolbox {
+namespace p256 {
+
+namespace {
+
+// Four 64 bit limbs, least significant first
+using Fe = std::array<uint64_t, 4>;
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+constexpr Fe kP = {0xffffffffffffffff, 0x00000000ffffffff, 0x0000000000000000, 0xffffffff00000001};
+// Order of the base point
+constexpr Fe kN = {0xf3b9cac2fc632551, 0xbce6faada7179e84, 0xffffffffffffffff, 0xffffffff00000000};
+constexpr Fe kB = {0x3bce3c3e27d2604b, 0x651d06b0cc53b0f6, 0xb3ebbd55769886bc, 0x5ac635d8aa3a93e7};
+constexpr Fe kGx = {0xf4a13945d898c296, 0x77037d812deb33a0, 0xf8bce6e563a440f2, 0x6b17d1f2e12c4247};
+constexpr Fe kGy = {0xcbb6406837bf51f5, 0x2bce33576b315ece, 0x8ee7eb4a7c0f9e16, 0x4fe342e2fe1a7f9b};
+// 2^512 mod p, to enter the Montgomery domain
+constexpr Fe kR2 = {0x0000000000000003, 0xfffffffbffffffff, 0xfffffffffffffffe, 0x00000004fffffffd};
+
+/* Limb arithmetic */
+
+inline uint64_t add_carry(uint64_t a, uint64_t b, uint64_t carry_in, uint64_t* carry_out) {
+  uint64_t sum = a + b;
+  uint64_t result = sum + carry_in;
+  *carry_out = (sum < a) | (result < sum);
+  return result;
+}
+
+inline uint64_t sub_borrow(uint64_t a, uint64_t b, uint64_t borrow_in, uint64_t* borrow_out) {
+  uint64_t diff = a - b;
+  uint64_t result = diff - borrow_in;
+  *borrow_out = (a < b) | (diff < borrow_in);
+  return result;
+}
+
+// Returns the low half of a * b + c + d, and the high half in hi. It can't overflow.
+inline uint64_t mul_add(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 t = (unsigned __int128)a * b + c + d;
+  *hi = (uint64_t)(t >> 64);
+  return (uint64_t)t;
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t mid = (lo_lo >> 32) + (uint32_t)lo_hi + (uint32_t)hi_lo;
+  uint64_t lo = (mid << 32) | (uint32_t)lo_lo;
+  uint64_t high = a_hi * b_hi + (lo_hi >> 32) + (hi_lo >> 32) + (mid >> 32);
+  uint64_t carry;
+  lo = add_carry(lo, c, 0, &carry);
+  high += carry;
+  lo = add_carry(lo, d, 0, &carry);
+  *hi = high + carry;
+  return lo;
+#endif
+}
+
+// All ones if a is zero, zero otherwise
+inline uint64_t is_zero_mask(const Fe& a) {
+  uint64_t bits = a[0] | a[1] | a[2] | a[3];
+  return ((bits | (0 - bits)) >> 63) - 1;
+}
+
+// r = mask ? a : r
+inline void select(Fe& r, const Fe& a, uint64_t mask) {
+  for (int i = 0; i < 4; i++) r[i] ^= mask & (r[i] ^ a[i]);
+}
+
+// Returns 1 if a < b
+inline uint64_t less_than(const Fe& a, const Fe& b) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) sub_borrow(a[i], b[i], borrow, &borrow);
+  return borrow;
+}
+
+/* Field arithmetic, in the Montgomery domain */
+
+// r = (hi:t) mod p, for (hi:t) < 2p
+inline void reduce_once(Fe& r, const Fe& t, uint64_t hi) {
+  uint64_t borrow;
+  uint64_t s0 = sub_borrow(t[0], kP[0], 0, &borrow);
+  uint64_t s1 = sub_borrow(t[1], kP[1], borrow, &borrow);
+  uint64_t s2 = sub_borrow(t[2], kP[2], borrow, &borrow);
+  uint64_t s3 = sub_borrow(t[3], kP[3], borrow, &borrow);
+  // Keep t if (hi:t) - p borrowed
+  uint64_t keep = 0 - (borrow & (hi ^ 1));
+  r[0] = (t[0] & keep) | (s0 & ~keep);
+  r[1] = (t[1] & keep) | (s1 & ~keep);
+  r[2] = (t[2] & keep) | (s2 & ~keep);
+  r[3] = (t[3] & keep) | (s3 & ~keep);
+}
+
+inline void fe_add(Fe& r, const Fe& a, const Fe& b) {
+  uint64_t carry;
+  Fe t;
+  t[0] = add_carry(a[0], b[0], 0, &carry);
+  t[1] = add_carry(a[1], b[1], carry, &carry);
+  t[2] = add_carry(a[2], b[2], carry, &carry);
+  t[3] = add_carry(a[3], b[3], carry, &carry);
+  reduce_once(r, t, carry);
+}
+
+inline void fe_sub(Fe& r, const Fe& a, const Fe& b) {
+  uint64_t borrow, carry;
+  uint64_t d0 = sub_borrow(a[0], b[0], 0, &borrow);
+  uint64_t d1 = sub_borrow(a[1], b[1], borrow, &borrow);
+  uint64_t d2 = sub_borrow(a[2], b[2], borrow, &borrow);
+  uint64_t d3 = sub_borrow(a[3], b[3], borrow, &borrow);
+  // Add p back if it borrowed
+  uint64_t mask = 0 - borrow;
+  r[0] = add_carry(d0, kP[0] & mask, 0, &carry);
+  r[1] = add_carry(d1, kP[1] & mask, carry, &carry);
+  r[2] = add_carry(d2, kP[2] & mask, carry, &carry);
+  r[3] = add_carry(d3, kP[3] & mask, carry, &carry);
+}
+
+// One round of the Montgomery multiplication: t = (t + a * b_i + m * p) / 2^64, with m chosen to
+// clear the low limb. -p^-1 mod 2^64 is 1, so m is the low limb itself, and the shape of p leaves
+// two multiplications for m * p.
+inline void mul_round(
+    uint64_t& t0, uint64_t& t1, uint64_t& t2, uint64_t& t3, uint64_t& t4, const Fe& a, uint64_t b) {
+  uint64_t carry, t5;
+  t0 = mul_add(a[0], b, t0, 0, &carry);
+  t1 = mul_add(a[1], b, t1, carry, &carry);
+  t2 = mul_add(a[2], b, t2, carry, &carry);
+  t3 = mul_add(a[3], b, t3, carry, &carry);
+  t4 = add_carry(t4, carry, 0, &t5);
+
+  // m * p[0] + t0 = m * 2^64
+  uint64_t m = t0;
+  t0 = mul_add(m, kP[1], t1, m, &carry);
+  t1 = add_carry(t2, carry, 0, &carry);
+  t2 = mul_add(m, kP[3], t3, carry, &carry);
+  t3 = add_carry(t4, carry, 0, &carry);
+  t4 = t5 + carry;
+}
+
+// r = a * b / 2^256 mod p
+void fe_mul(Fe& r, const Fe& a, const Fe& b) {
+  uint64_t t0 = 0, t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+  mul_round(t0, t1, t2, t3, t4, a, b[0]);
+  mul_round(t0, t1, t2, t3, t4, a, b[1]);
+  mul_round(t0, t1, t2, t3, t4, a, b[2]);
+  mul_round(t0, t1, t2, t3, t4, a, b[3]);
+  reduce_once(r, Fe{t0, t1, t2, t3}, t4);
+}
+
+inline void fe_sqr(Fe& r, const Fe& a) {
+  fe_mul(r, a, a);
+}
+
+inline void fe_sqr_n(Fe& r, const Fe& a, int n) {
+  fe_sqr(r, a);
+  for (int i = 1; i < n; i++) fe_sqr(r, r);
+}
+
+// r = a^(p - 2) = a^-1, or zero if a is zero
+void fe_inv(Fe& r, const Fe& a) {
+  Fe x2, x3, x6, x12, x15, x30, x32, t;
+  // xk = a^(2^k - 1)
+  fe_sqr(t, a);
+  fe_mul(x2, t, a);
+  fe_sqr(t, x2);
+  fe_mul(x3, t, a);
+  fe_sqr_n(t, x3, 3);
+  fe_mul(x6, t, x3);
+  fe_sqr_n(t, x6, 6);
+  fe_mul(x12, t, x6);
+  fe_sqr_n(t, x12, 3);
+  fe_mul(x15, t, x3);
+  fe_sqr_n(t, x15, 15);
+  fe_mul(x30, t, x15);
+  fe_sqr_n(t, x30, 2);
+  fe_mul(x32, t, x2);
+
+  // p - 2 = ffffffff 00000001 00000000 00000000 00000000 ffffffff ffffffff fffffffd
+  fe_sqr_n(t, x32, 32);
+  fe_mul(t, t, a);
+  fe_sqr_n(t, t, 128);
+  fe_mul(t, t, x32);
+  fe_sqr_n(t, t, 32);
+  fe_mul(t, t, x32);
+  fe_sqr_n(t, t, 30);
+  fe_mul(t, t, x30);
+  fe_sqr_n(t, t, 2);
+  fe_mul(r, t, a);
+}
+
+inline void fe_to_mont(Fe& r, const Fe& a) {
+  fe_mul(r, a, kR2);
+}
+
+inline void fe_from_mont(Fe& r, const Fe& a) {
+  fe_mul(r, a, Fe{1, 0, 0, 0});
+}
+
+void fe_from_bytes(Fe& r, const uint8_t* bytes) {
+  for (int i = 0; i < 4; i++) {
+    r[i] = 0;
+    for (int j = 7; j >= 0; j--) r[i] = (r[i] << 8) | bytes[8 * i + j];
+  }
+}
+
+void fe_to_bytes(uint8_t* bytes, const Fe& a) {
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 8; j++) bytes[8 * i + j] = (uint8_t)(a[i] >> (8 * j));
+  }
+}
+
+/* Point arithmetic */
+
+// Jacobian coordinates, (X / Z^2, Y / Z^3). Z is zero for the point at infinity.
+struct JacobianPoint {
+  Fe x, y, z;
+};
+
+struct AffinePoint {
+  Fe x, y;
+};
+
+inline void point_select(JacobianPoint& r, const JacobianPoint& a, uint64_t mask) {
+  select(r.x, a.x, mask);
+  select(r.y, a.y, mask);
+  select(r.z, a.z, mask);
+}
+
+// dbl-2001-b, for a = -3. The point at infinity is its own double.
+void point_double(JacobianPoint& r, const JacobianPoint& p) {
+  Fe delta, gamma, beta, alpha, t1, t2;
+
+  fe_sqr(delta, p.z);
+  fe_sqr(gamma, p.y);
+  fe_mul(beta, p.x, gamma);
+
+  // alpha = 3 * (X - delta) * (X + delta)
+  fe_sub(t1, p.x, delta);
+  fe_add(t2, p.x, delta);
+  fe_mul(t1, t1, t2);
+  fe_add(alpha, t1, t1);
+  fe_add(alpha, alpha, t1);
+
+  // Z3 = (Y + Z)^2 - gamma - delta
+  fe_add(t1, p.y, p.z);
+  fe_sqr(t1, t1);
+  fe_sub(t1, t1, gamma);
+  fe_sub(r.z, t1, delta);
+
+  // X3 = alpha^2 - 8 * beta
+  fe_add(beta, beta, beta);
+  fe_add(beta, beta, beta);
+  fe_sqr(t1, alpha);
+  fe_add(t2, beta, beta);
+  fe_sub(r.x, t1, t2);
+
+  // Y3 = alpha * (4 * beta - X3) - 8 * gamma^2
+  fe_sub(t1, beta, r.x);
+  fe_mul(t1, alpha, t1);
+  fe_sqr(gamma, gamma);
+  fe_add(gamma, gamma, gamma);
+  fe_add(gamma, gamma, gamma);
+  fe_add(gamma, gamma, gamma);
+  fe_sub(r.y, t1, gamma);
+}
+
+// add-2007-bl. Either point may be the point at infinity, in constant time. Adding a point to
+// itself goes through point_double(): the multiplications below only get there with negligible
+// probability, so this branch doesn't leak the scalar.
+void point_add(JacobianPoint& r, const JacobianPoint& p, const JacobianPoint& q) {
+  Fe z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+  JacobianPoint sum;
+
+  fe_sqr(z1z1, p.z);
+  fe_sqr(z2z2, q.z);
+  fe_mul(u1, p.x, z2z2);
+  fe_mul(u2, q.x, z1z1);
+  fe_mul(s1, p.y, q.z);
+  fe_mul(s1, s1, z2z2);
+  fe_mul(s2, q.y, p.z);
+  fe_mul(s2, s2, z1z1);
+
+  fe_sub(h, u2, u1);
+  fe_sub(rr, s2, s1);
+  fe_add(rr, rr, rr);
+
+  uint64_t p_infinity = is_zero_mask(p.z);
+  uint64_t q_infinity = is_zero_mask(q.z);
+  if (is_zero_mask(h) & is_zero_mask(rr) & ~p_infinity & ~q_infinity) {
+    point_double(r, p);
+    return;
+  }
+
+  fe_add(i, h, h);
+  fe_sqr(i, i);
+  fe_mul(j, h, i);
+  fe_mul(v, u1, i);
+
+  // X3 = r^2 - J - 2 * V
+  fe_sqr(t, rr);
+  fe_sub(t, t, j);
+  fe_sub(t, t, v);
+  fe_sub(sum.x, t, v);
+
+  // Y3 = r * (V - X3) - 2 * S1 * J
+  fe_sub(t, v, sum.x);
+  fe_mul(t, rr, t);
+  fe_mul(s1, s1, j);
+  fe_add(s1, s1, s1);
+  fe_sub(sum.y, t, s1);
+
+  // Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) * H
+  fe_add(t, p.z, q.z);
+  fe_sqr(t, t);
+  fe_sub(t, t, z1z1);
+  fe_sub(t, t, z2z2);
+  fe_mul(sum.z, t, h);
+
+  point_select(sum, q, p_infinity);
+  point_select(sum, p, q_infinity);
+  r = sum;
+}
+
+// madd-2007-bl, adding an affine point. p may be the point at infinity, and q is ignored unless
+// q_mask is all ones, in constant time.
+void point_add_mixed(
+    JacobianPoint& r, const JacobianPoint& p, const AffinePoint& q, uint64_t q_mask, const Fe& one) {
+  Fe z1z1, u2, s2, h, hh, i, j, rr, v, t;
+  JacobianPoint sum;
+
+  fe_sqr(z1z1, p.z);
+  fe_mul(u2, q.x, z1z1);
+  fe_mul(s2, q.y, p.z);
+  fe_mul(s2, s2, z1z1);
+
+  fe_sub(h, u2, p.x);
+  fe_sub(rr, s2, p.y);
+  fe_add(rr, rr, rr);
+
+  uint64_t p_infinity = is_zero_mask(p.z);
+  if (is_zero_mask(h) & is_zero_mask(rr) & ~p_infinity & q_mask) {
+    point_double(r, p);
+    return;
+  }
+
+  fe_sqr(hh, h);
+  fe_add(i, hh, hh);
+  fe_add(i, i, i);
+  fe_mul(j, h, i);
+  fe_mul(v, p.x, i);
+
+  // X3 = r^2 - J - 2 * V
+  fe_sqr(t, rr);
+  fe_sub(t, t, j);
+  fe_sub(t, t, v);
+  fe_sub(sum.x, t, v);
+
+  // Y3 = r * (V - X3) - 2 * Y1 * J
+  fe_sub(t, v, sum.x);
+  fe_mul(t, rr, t);
+  fe_mul(j, p.y, j);
+  fe_add(j, j, j);
+  fe_sub(sum.y, t, j);
+
+  // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+  fe_add(t, p.z, h);
+  fe_sqr(t, t);
+  fe_sub(t, t, z1z1);
+  fe_sub(sum.z, t, hh);
+
+  JacobianPoint q_jacobian = {q.x, q.y, one};
+  point_select(sum, q_jacobian, p_infinity);
+  point_select(sum, p, ~q_mask);
+  r = sum;
+}
+
+// Returns false for the point at infinity
+bool point_to_affine(AffinePoint& r, const JacobianPoint& p) {
+  if (is_zero_mask(p.z)) return false;
+  Fe z_inv, z_inv2, z_inv3;
+  fe_inv(z_inv, p.z);
+  fe_sqr(z_inv2, z_inv);
+  fe_mul(z_inv3, z_inv2, z_inv);
+  fe_mul(r.x, p.x, z_inv2);
+  fe_mul(r.y, p.y, z_inv3);
+  return true;
+}
+
+// 4 bit digit i of the scalar
+inline unsigned scalar_digit(const Fe& k, int i) {
+  return (k[i / 16] >> (4 * (i % 16))) & 0xf;
+}
+
+/* Curve constants and base point table */
+
+// Base point multiplication uses a comb of 16 teeth, 16 bits apart: tooth b holds the multiples
+// 1 .. 15 of 2^(16 * b) * G. The digits 4 * b + a of the scalar, for a given a, are added from
+// the teeth, and four rounds of this are joined by 12 doublings in total.
+constexpr int kCombTeeth = 16;
+constexpr int kCombMultiples = 15;
+
+struct Curve {
+  Fe one;
+  Fe b;
+  AffinePoint g;
+  AffinePoint comb[kCombTeeth][kCombMultiples];
+
+  Curve() {
+    fe_to_mont(one, Fe{1, 0, 0, 0});
+    fe_to_mont(b, kB);
+    fe_to_mont(g.x, kGx);
+    fe_to_mont(g.y, kGy);
+
+    constexpr int kCount = kCombTeeth * kCombMultiples;
+    std::vector<JacobianPoint> flat(kCount);
+    JacobianPoint tooth = {g.x, g.y, one};
+    for (int t = 0; t < kCombTeeth; t++) {
+      JacobianPoint* points = &flat[t * kCombMultiples];
+      points[0] = tooth;
+      point_double(points[1], tooth);
+      for (int m = 2; m < kCombMultiples; m++) point_add(points[m], points[m - 1], tooth);
+      for (int i = 0; i < 16; i++) point_double(tooth, tooth);
+    }
+
+    // Convert to affine with a single inversion
+    std::vector<Fe> products(kCount);
+    products[0] = flat[0].z;
+    for (int i = 1; i < kCount; i++) fe_mul(products[i], products[i - 1], flat[i].z);
+    Fe inv;
+    fe_inv(inv, products[kCount - 1]);
+    for (int i = kCount - 1; i >= 0; i--) {
+      Fe z_inv = inv;
+      if (i > 0) {
+        fe_mul(z_inv, inv, products[i - 1]);
+        fe_mul(inv, inv, flat[i].z);
+      }
+      Fe z_inv2, z_inv3;
+      fe_sqr(z_inv2, z_inv);
+      fe_mul(z_inv3, z_inv2, z_inv);
+      AffinePoint& out = comb[i / kCombMultiples][i % kCombMultiples];
+      fe_mul(out.x, flat[i].x, z_inv2);
+      fe_mul(out.y, flat[i].y, z_inv3);
+    }
+  }
+};
+
+const Curve& curve() {
+  static const Curve* kCurve = new Curve();
+  return *kCurve;
+}
+
+// r = multiple digit of the tooth, reading every entry
+inline void comb_lookup(AffinePoint& r, const AffinePoint tooth[kCombMultiples], unsigned digit) {
+  r = tooth[0];
+  for (unsigned m = 1; m < kCombMultiples; m++) {
+    uint64_t mask = 0 - (uint64_t)((m + 1) == digit);
+    select(r.x, tooth[m].x, mask);
+    select(r.y, tooth[m].y, mask);
+  }
+}
+
+void base_point_mult(JacobianPoint& r, const Fe& k) {
+  const Curve& c = curve();
+  JacobianPoint acc = {c.one, c.one, Fe{0, 0, 0, 0}};
+  for (int a = 3; a >= 0; a--) {
+    if (a != 3) {
+      for (int i = 0; i < 4; i++) point_double(acc, acc);
+    }
+    for (int b = 0; b < kCombTeeth; b++) {
+      unsigned digit = scalar_digit(k, 4 * b + a);
+      AffinePoint t;
+      comb_lookup(t, c.comb[b], digit);
+      point_add_mixed(acc, acc, t, 0 - (uint64_t)(digit != 0), c.one);
+    }
+  }
+  r = acc;
+}
+
+// Fixed 4 bit window, from the most significant digit
+void point_mult(JacobianPoint& r, const AffinePoint& p, const Fe& k) {
+  const Curve& c = curve();
+  JacobianPoint table[16];
+  table[0] = {c.one, c.one, Fe{0, 0, 0, 0}};
+  table[1] = {p.x, p.y, c.one};
+  point_double(table[2], table[1]);
+  for (int i = 3; i < 16; i++) point_add(table[i], table[i - 1], table[1]);
+
+  JacobianPoint acc = table[0];
+  for (int i = 63; i >= 0; i--) {
+    if (i != 63) {
+      for (int d = 0; d < 4; d++) point_double(acc, acc);
+    }
+    unsigned digit = scalar_digit(k, i);
+    JacobianPoint t = table[0];
+    for (unsigned m = 1; m < 16; m++) point_select(t, table[m], 0 - (uint64_t)(m == digit));
+    point_add(acc, acc, t);
+  }
+  r = acc;
+}
+
+bool load_point(AffinePoint& r, const PublicKey& point) {
+  Fe x, y;
+  fe_from_bytes(x, point.x.data());
+  fe_from_bytes(y, point.y.data());
+  if (!less_than(x, kP) || !less_than(y, kP)) return false;
+
+  const Curve& c = curve();
+  fe_to_mont(r.x, x);
+  fe_to_mont(r.y, y);
+
+  // y^2 = x^3 - 3x + b
+  Fe lhs, rhs, t;
+  fe_sqr(lhs, r.y);
+  fe_sqr(rhs, r.x);
+  fe_mul(rhs, rhs, r.x);
+  fe_add(t, r.x, r.x);
+  fe_add(t, t, r.x);
+  fe_sub(rhs, rhs, t);
+  fe_add(rhs, rhs, c.b);
+  fe_sub(t, lhs, rhs);
+  return is_zero_mask(t) != 0;
+}
+
+void store_coordinate(std::array<uint8_t, kScalarLength>& bytes, const Fe& a) {
+  Fe t;
+  fe_from_mont(t, a);
+  fe_to_bytes(bytes.data(), t);
+}
+
+}  // namespace
+
+bool IsValidPoint(const PublicKey& point) {
+  AffinePoint p;
+  return load_point(p, point);
+}
+
+bool ComputePublicKey(const Scalar& private_key, PublicKey* public_key) {
+  Fe k;
+  fe_from_bytes(k, private_key.data());
+  JacobianPoint q;
+  base_point_mult(q, k);
+  AffinePoint result;
+  if (!point_to_affine(result, q)) return false;
+  store_coordinate(public_key->x, result.x);
+  store_coordinate(public_key->y, result.y);
+  return true;
+}
+
+bool ComputeDhKey(const Scalar& private_key, const PublicKey& peer_public_key, Scalar* dhkey) {
+  AffinePoint p;
+  if (!load_point(p, peer_public_key)) return false;
+  Fe k;
+  fe_from_bytes(k, private_key.data());
+  JacobianPoint q;
+  point_mult(q, p, k);
+  AffinePoint result;
+  if (!point_to_affine(result, q)) return false;
+  store_coordinate(*dhkey, result.x);
+  return true;
+}
+
+KeyPair GenerateKeyPair(const RandomSource& random) {
+  KeyPair key_pair;
+  Fe k;
+  do {
+    random(key_pair.private_key.data(), key_pair.private_key.size());
+    fe_from_bytes(k, key_pair.private_key.data());
+  } while (is_zero_mask(k) || !less_than(k, kN));
+  ComputePublicKey(key_pair.private_key, &key_pair.public_key);
+  return key_pair;
+}
+
+KeyPairPool::KeyPairPool(RandomSource random, size_t capacity)
+    : random_(std::move(random)), capacity_(capacity), thread_(&KeyPairPool::Run, this) {}
+
+KeyPairPool::~KeyPairPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  refill_.notify_one();
+  thread_.join();
+}
+
+KeyPair KeyPairPool::Take() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!key_pairs_.empty()) {
+      KeyPair key_pair = key_pairs_.front();
+      key_pairs_.pop_front();
+      refill_.notify_one();
+      return key_pair;
+    }
+  }
+  return GenerateKeyPair(random_);
+}
+
+size_t KeyPairPool::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return key_pairs_.size();
+}
+
+void KeyPairPool::Run() {
+  pthread_setname_np(pthread_self(), "bt_p256_keys");
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    refill_.wait(lock, [this] { return stopped_ || key_pairs_.size() < capacity_; });
+    if (stopped_) return;
+    lock.unlock();
+    KeyPair key_pair = GenerateKeyPair(random_);
+    lock.lock();
+    key_pairs_.push_back(key_pair);
+  }
+}
+
+}  // namespace p256
+}  // namespace crypto_toolbox
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// P-256 elliptic curve Diffie-Hellman, as per BT Spec 5.4 Vol 3, Part H 2.3.5.6.
+//
+// Field elements are 64 bit limbs in the Montgomery domain. Multiplications by the base point use
+// a precomputed table and the others a 4 bit window; both are constant time with regard to the
+// scalar.
+//
+// Integers are 32 bytes, least significant byte first, as in the Pairing Public Key and DHKey
+// Check PDUs.
+namespace crypto_toolbox {
+namespace p256 {
+
+constexpr size_t kScalarLength = 32;
+
+using Scalar = std::array<uint8_t, kScalarLength>;
+
+struct PublicKey {
+  std::array<uint8_t, kScalarLength> x;
+  std::array<uint8_t, kScalarLength> y;
+};
+
+struct KeyPair {
+  Scalar private_key;
+  PublicKey public_key;
+};
+
+// Fills data with len random bytes.
+using RandomSource = std::function<void(uint8_t* data, size_t len)>;
+
+// Returns true if the point lies on the curve.
+bool IsValidPoint(const PublicKey& point);
+
+// Computes private_key * G. Returns false if the private key is a multiple of the curve order.
+bool ComputePublicKey(const Scalar& private_key, PublicKey* public_key);
+
+// Computes the x coordinate of private_key * peer_public_key. Returns false if the peer public key
+// does not lie on the curve, or if the result is the point at infinity.
+bool ComputeDhKey(const Scalar& private_key, const PublicKey& peer_public_key, Scalar* dhkey);
+
+// Generates a key pair, with a private key in [1, n - 1].
+KeyPair GenerateKeyPair(const RandomSource& random);
+
+// Key pairs generated ahead of time on a worker thread, so that pairing doesn't wait for the
+// public key computation. Each key pair is handed out once.
+class KeyPairPool {
+ public:
+  static constexpr size_t kDefaultCapacity = 2;
+
+  // random is called from the worker thread as well as from Take().
+  explicit KeyPairPool(RandomSource random, size_t capacity = kDefaultCapacity);
+  KeyPairPool(const KeyPairPool&) = delete;
+  KeyPairPool& operator=(const KeyPairPool&) = delete;
+  ~KeyPairPool();
+
+  // Returns a pre-generated key pair, or generates one if the pool is empty.
+  KeyPair Take();
+
+  // Number of key pairs ready to be taken.
+  size_t Size();
+
+ private:
+  void Run();
+
+  const RandomSource random_;
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable refill_;
+  std::deque<KeyPair> key_pairs_;
+  bool stopped_ = false;
+  std::thread thread_;
+};
+
+}  // namespace p256
+}  // namespace crypto_toolbox
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The two P-256 operations of LE Secure Connections pairing, public key generation and DHKey
+// computation, with the 32 bit binary NAF implementation the stacks used before and with the
+// shared engine; and taking a key pair from the pool.
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <random>
+
+#include "crypto_toolbox/p256.h"
+#include "security/ecc/p_256_ecc_pp.h"
+
+using ::benchmark::State;
+using namespace crypto_toolbox::p256;
+namespace ecc = bluetooth::security::ecc;
+
+namespace {
+
+crypto_toolbox::p256::RandomSource seeded_random() {
+  auto generator = std::make_shared<std::mt19937>(1);
+  return [generator](uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) data[i] = (*generator)();
+  };
+}
+
+}  // namespace
+
+static void BM_ReferencePublicKey(State& state) {
+  KeyPair key_pair = GenerateKeyPair(seeded_random());
+  for (auto _ : state) {
+    uint32_t private_key[8];
+    memcpy(private_key, key_pair.private_key.data(), sizeof(private_key));
+    ecc::Point public_key;
+    ecc::ECC_PointMult(&public_key, &ecc::curve_p256.G, private_key);
+    benchmark::DoNotOptimize(public_key);
+  }
+}
+BENCHMARK(BM_ReferencePublicKey);
+
+static void BM_ReferenceDhKey(State& state) {
+  RandomSource random = seeded_random();
+  KeyPair local = GenerateKeyPair(random);
+  KeyPair peer = GenerateKeyPair(random);
+  for (auto _ : state) {
+    uint32_t private_key[8];
+    memcpy(private_key, local.private_key.data(), sizeof(private_key));
+    ecc::Point peer_public_key = {}, dhkey;
+    memcpy(peer_public_key.x, peer.public_key.x.data(), 32);
+    memcpy(peer_public_key.y, peer.public_key.y.data(), 32);
+    peer_public_key.z[0] = 1;
+    ecc::ECC_PointMult(&dhkey, &peer_public_key, private_key);
+    benchmark::DoNotOptimize(dhkey);
+  }
+}
+BENCHMARK(BM_ReferenceDhKey);
+
+static void BM_PublicKey(State& state) {
+  KeyPair key_pair = GenerateKeyPair(seeded_random());
+  for (auto _ : state) {
+    PublicKey public_key;
+    ComputePublicKey(key_pair.private_key, &public_key);
+    benchmark::DoNotOptimize(public_key);
+  }
+}
+BENCHMARK(BM_PublicKey);
+
+static void BM_DhKey(State& state) {
+  RandomSource random = seeded_random();
+  KeyPair local = GenerateKeyPair(random);
+  KeyPair peer = GenerateKeyPair(random);
+  for (auto _ : state) {
+    Scalar dhkey;
+    ComputeDhKey(local.private_key, peer.public_key, &dhkey);
+    benchmark::DoNotOptimize(dhkey);
+  }
+}
+BENCHMARK(BM_DhKey);
+
+// A pairing every 10 ms, leaving time for the pool to refill
+static void BM_KeyPairPoolTake(State& state) {
+  KeyPairPool pool(seeded_random());
+  for (auto _ : state) {
+    state.PauseTiming();
+    while (pool.Size() < KeyPairPool::kDefaultCapacity) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(pool.Take());
+  }
+}
+BENCHMARK(BM_KeyPairPoolTake)->Iterations(200);
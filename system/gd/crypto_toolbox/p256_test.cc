@@ -0,0 +1,210 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/p256.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+namespace crypto_toolbox {
+namespace p256 {
+
+namespace {
+
+// BT Spec 5.4 | Vol 3, Part H D.2, with the integers least significant byte first
+const Scalar kPrivateKeyA = {0x3e, 0xc8, 0x2a, 0x32, 0xb3, 0x75, 0x76, 0xba, 0x7d, 0xb8, 0xb4,
+                             0x7b, 0xa0, 0x8a, 0xa3, 0xc3, 0xf2, 0x03, 0x1a, 0x53, 0xf6, 0x52,
+                             0x26, 0x32, 0xb6, 0xae, 0x57, 0x3f, 0x13, 0x15, 0x29, 0x51};
+const PublicKey kPublicKeyA = {
+    .x = {0xdc, 0x88, 0xd0, 0xe5, 0x59, 0x73, 0xf2, 0x41, 0x88, 0x6c, 0xb4, 0x45, 0x8b, 0x61, 0x3b, 0x10,
+          0xf5, 0xd4, 0xd2, 0x5b, 0x4e, 0xa1, 0x7f, 0x94, 0xe3, 0xa9, 0x38, 0xf8, 0x84, 0xd4, 0x98, 0x10},
+    .y = {0x3d, 0x13, 0x76, 0x4f, 0xd1, 0x29, 0x6e, 0xec, 0x8d, 0xf6, 0x70, 0x33, 0x8b, 0xa7, 0x18, 0xea,
+          0x84, 0x15, 0xe8, 0x8c, 0x4a, 0xc8, 0x76, 0x45, 0x90, 0x98, 0xba, 0x52, 0x8b, 0x00, 0x69, 0xaf}};
+const Scalar kPrivateKeyB = {0xdd, 0x53, 0x84, 0x91, 0xc8, 0xfa, 0x4b, 0x45, 0xb2, 0xff, 0xc0,
+                             0x53, 0x89, 0x64, 0x16, 0x7b, 0x67, 0x30, 0xce, 0x5d, 0x82, 0xf4,
+                             0x8f, 0x38, 0xa2, 0xe6, 0x78, 0xb6, 0xfb, 0xa1, 0x07, 0xd8};
+const PublicKey kPublicKeyB = {
+    .x = {0x23, 0x1a, 0xec, 0xfe, 0x7d, 0xc1, 0x20, 0x2f, 0x03, 0x3e, 0x9a, 0xaa, 0x99, 0x55, 0x78, 0x86,
+          0x58, 0xcb, 0x37, 0x68, 0x7d, 0xe1, 0xff, 0x19, 0x33, 0xf8, 0xcb, 0x7a, 0x17, 0xab, 0x0b, 0x73},
+    .y = {0x4c, 0x25, 0xe2, 0x42, 0x3c, 0x69, 0x0e, 0x3b, 0xc0, 0xef, 0x94, 0x09, 0x4d, 0x3f, 0x96, 0xbb,
+          0x18, 0xf2, 0x55, 0x81, 0x71, 0x5a, 0xde, 0xc4, 0x3e, 0xf9, 0x6f, 0xa9, 0xaf, 0x04, 0x4e, 0x86}};
+const Scalar kDhKey = {0x3b, 0xf8, 0xdf, 0x33, 0x99, 0x94, 0x66, 0x55, 0x4f, 0x2c, 0x4a,
+                       0x78, 0x2b, 0x51, 0xd1, 0x49, 0x0f, 0xf1, 0x96, 0x63, 0x51, 0x75,
+                       0x9e, 0x65, 0x7f, 0x3c, 0xfe, 0x77, 0xb4, 0x3f, 0x7a, 0x93};
+
+// Order of the curve minus one
+const Scalar kOrderMinusOne = {0x50, 0x25, 0x63, 0xfc, 0xc2, 0xca, 0xb9, 0xf3, 0x84, 0x9e, 0x17,
+                               0xa7, 0xad, 0xfa, 0xe6, 0xbc, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                               0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff};
+
+const PublicKey kBasePoint = {
+    .x = {0x96, 0xc2, 0x98, 0xd8, 0x45, 0x39, 0xa1, 0xf4, 0xa0, 0x33, 0xeb, 0x2d, 0x81, 0x7d, 0x03, 0x77,
+          0xf2, 0x40, 0xa4, 0x63, 0xe5, 0xe6, 0xbc, 0xf8, 0x47, 0x42, 0x2c, 0xe1, 0xf2, 0xd1, 0x17, 0x6b},
+    .y = {0xf5, 0x51, 0xbf, 0x37, 0x68, 0x40, 0xb6, 0xcb, 0xce, 0x5e, 0x31, 0x6b, 0x57, 0x33, 0xce, 0x2b,
+          0x16, 0x9e, 0x0f, 0x7c, 0x4a, 0xeb, 0xe7, 0x8e, 0x9b, 0x7f, 0x1a, 0xfe, 0xe2, 0x42, 0xe3, 0x4f}};
+
+RandomSource seeded_random(unsigned seed) {
+  auto generator = std::make_shared<std::mt19937>(seed);
+  return [generator](uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) data[i] = (*generator)();
+  };
+}
+
+}  // namespace
+
+TEST(P256Test, public_key_of_spec_sample) {
+  PublicKey public_key;
+  ASSERT_TRUE(ComputePublicKey(kPrivateKeyA, &public_key));
+  EXPECT_EQ(public_key.x, kPublicKeyA.x);
+  EXPECT_EQ(public_key.y, kPublicKeyA.y);
+  ASSERT_TRUE(ComputePublicKey(kPrivateKeyB, &public_key));
+  EXPECT_EQ(public_key.x, kPublicKeyB.x);
+  EXPECT_EQ(public_key.y, kPublicKeyB.y);
+}
+
+TEST(P256Test, dhkey_of_spec_sample) {
+  Scalar dhkey;
+  ASSERT_TRUE(ComputeDhKey(kPrivateKeyA, kPublicKeyB, &dhkey));
+  EXPECT_EQ(dhkey, kDhKey);
+  ASSERT_TRUE(ComputeDhKey(kPrivateKeyB, kPublicKeyA, &dhkey));
+  EXPECT_EQ(dhkey, kDhKey);
+}
+
+TEST(P256Test, validate_points) {
+  EXPECT_TRUE(IsValidPoint(kPublicKeyA));
+  EXPECT_TRUE(IsValidPoint(kPublicKeyB));
+  EXPECT_TRUE(IsValidPoint(kBasePoint));
+
+  PublicKey point = {};
+  EXPECT_FALSE(IsValidPoint(point));
+  point.x = kPublicKeyA.x;
+  EXPECT_FALSE(IsValidPoint(point));
+  point.y = kPublicKeyA.y;
+  point.y[0]--;
+  EXPECT_FALSE(IsValidPoint(point));
+
+  // Coordinates not reduced modulo p
+  point.x.fill(0xff);
+  point.y.fill(0xff);
+  EXPECT_FALSE(IsValidPoint(point));
+}
+
+TEST(P256Test, dhkey_rejects_invalid_peer_key) {
+  PublicKey peer_public_key = kPublicKeyB;
+  peer_public_key.y[0] ^= 1;
+  Scalar dhkey = {};
+  EXPECT_FALSE(ComputeDhKey(kPrivateKeyA, peer_public_key, &dhkey));
+  EXPECT_EQ(dhkey, Scalar{});
+}
+
+TEST(P256Test, edge_scalars) {
+  PublicKey public_key;
+  EXPECT_FALSE(ComputePublicKey(Scalar{}, &public_key));
+
+  Scalar one = {1};
+  ASSERT_TRUE(ComputePublicKey(one, &public_key));
+  EXPECT_EQ(public_key.x, kBasePoint.x);
+  EXPECT_EQ(public_key.y, kBasePoint.y);
+
+  // (n - 1) * G = -G
+  ASSERT_TRUE(ComputePublicKey(kOrderMinusOne, &public_key));
+  EXPECT_EQ(public_key.x, kBasePoint.x);
+  EXPECT_NE(public_key.y, kBasePoint.y);
+  EXPECT_TRUE(IsValidPoint(public_key));
+
+  Scalar dhkey;
+  ASSERT_TRUE(ComputeDhKey(kOrderMinusOne, kBasePoint, &dhkey));
+  EXPECT_EQ(dhkey, kBasePoint.x);
+  EXPECT_FALSE(ComputeDhKey(Scalar{}, kBasePoint, &dhkey));
+}
+
+// The base point table and the variable base multiplication must agree
+TEST(P256Test, fixed_and_variable_base_agree) {
+  RandomSource random = seeded_random(1);
+  for (int i = 0; i < 64; i++) {
+    Scalar private_key;
+    random(private_key.data(), private_key.size());
+    PublicKey public_key;
+    Scalar dhkey;
+    ASSERT_TRUE(ComputePublicKey(private_key, &public_key));
+    ASSERT_TRUE(IsValidPoint(public_key));
+    ASSERT_TRUE(ComputeDhKey(private_key, kBasePoint, &dhkey));
+    EXPECT_EQ(dhkey, public_key.x);
+  }
+}
+
+TEST(P256Test, generated_key_pairs_agree) {
+  RandomSource random = seeded_random(2);
+  for (int i = 0; i < 16; i++) {
+    KeyPair a = GenerateKeyPair(random);
+    KeyPair b = GenerateKeyPair(random);
+    ASSERT_NE(a.private_key, b.private_key);
+    Scalar dhkey_a, dhkey_b;
+    ASSERT_TRUE(ComputeDhKey(a.private_key, b.public_key, &dhkey_a));
+    ASSERT_TRUE(ComputeDhKey(b.private_key, a.public_key, &dhkey_b));
+    EXPECT_EQ(dhkey_a, dhkey_b);
+  }
+}
+
+TEST(P256KeyPairPoolTest, refills_in_background) {
+  KeyPairPool pool(seeded_random(3));
+  for (int i = 0; i < 100 && pool.Size() < KeyPairPool::kDefaultCapacity; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(pool.Size(), KeyPairPool::kDefaultCapacity);
+
+  KeyPair a = pool.Take();
+  KeyPair b = pool.Take();
+  // Generated on the spot if the worker hasn't refilled the pool yet
+  KeyPair c = pool.Take();
+  EXPECT_NE(a.private_key, b.private_key);
+  EXPECT_NE(b.private_key, c.private_key);
+  for (const KeyPair& key_pair : {a, b, c}) {
+    PublicKey public_key;
+    ASSERT_TRUE(ComputePublicKey(key_pair.private_key, &public_key));
+    EXPECT_EQ(public_key.x, key_pair.public_key.x);
+    EXPECT_EQ(public_key.y, key_pair.public_key.y);
+  }
+}
+
+TEST(P256KeyPairPoolTest, take_from_several_threads) {
+  std::mutex random_mutex;
+  RandomSource random = seeded_random(4);
+  KeyPairPool pool([&](uint8_t* data, size_t len) {
+    std::lock_guard<std::mutex> lock(random_mutex);
+    random(data, len);
+  });
+
+  std::atomic<int> valid = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 8; i++) {
+        KeyPair key_pair = pool.Take();
+        if (IsValidPoint(key_pair.public_key)) valid++;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(valid, 32);
+}
+
+}  // namespace p256
+}  // namespace crypto_toolbox
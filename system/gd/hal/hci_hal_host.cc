@@ -22,12 +22,17 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <csignal>
 #include <mutex>
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "common/init_flags.h"
 #include "hal/hci_hal.h"
@@ -37,6 +42,7 @@
 #include "metrics/counter_metrics.h"
 #include "os/log.h"
 #include "os/reactor.h"
+#include "os/system_properties.h"
 #include "os/thread.h"
 
 namespace {
@@ -55,6 +61,16 @@ constexpr uint8_t kHciEvtHeaderSize = 2;
 constexpr uint8_t kHciIsoHeaderSize = 4;
 constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
 
+// In batched I/O mode, packets are exchanged with the HCI socket in batches of
+// up to kMaxIoBatch messages per sendmmsg()/recvmmsg() call.
+constexpr char kBatchedIoProperty[] = "bluetooth.hal.host.batched_io.enabled";
+constexpr size_t kMaxIoBatch = 16;
+
+constexpr uint8_t kHciCommandCompleteEvent = 0x0e;
+constexpr uint16_t kHciReadBufferSizeOpcode = 0x1005;
+constexpr uint16_t kHciLeReadBufferSizeOpcode = 0x2002;
+constexpr uint16_t kHciLeReadBufferSizeV2Opcode = 0x2060;
+
 constexpr uint8_t BTPROTO_HCI = 1;
 constexpr uint16_t HCI_CHANNEL_USER = 1;
 constexpr uint16_t HCI_CHANNEL_CONTROL = 3;
@@ -252,8 +268,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(command);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    packet.insert(packet.cbegin(), kH4Command);
-    write_to_fd(packet);
+    write_to_fd(kH4Command, std::move(packet));
   }
 
   void sendAclData(HciPacket data) override {
@@ -261,8 +276,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
-    packet.insert(packet.cbegin(), kH4Acl);
-    write_to_fd(packet);
+    write_to_fd(kH4Acl, std::move(packet));
   }
 
   void sendScoData(HciPacket data) override {
@@ -270,8 +284,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    packet.insert(packet.cbegin(), kH4Sco);
-    write_to_fd(packet);
+    write_to_fd(kH4Sco, std::move(packet));
   }
 
   void sendIsoData(HciPacket data) override {
@@ -279,8 +292,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
-    packet.insert(packet.cbegin(), kH4Iso);
-    write_to_fd(packet);
+    write_to_fd(kH4Iso, std::move(packet));
   }
 
   uint16_t getMsftOpcode() override {
@@ -297,7 +309,10 @@ class HciHalHost : public HciHal {
   void Start() override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     log::assert_that(sock_fd_ == INVALID_FD, "assert failed: sock_fd_ == INVALID_FD");
-    sock_fd_ = ConnectToSocket();
+    sock_fd_ = HciHalHostUserChannelConfig::Get()->TakeSocketForTesting();
+    if (sock_fd_ == INVALID_FD) {
+      sock_fd_ = ConnectToSocket();
+    }
 
     // We don't want to crash when the chipset is broken.
     if (sock_fd_ == INVALID_FD) {
@@ -306,6 +321,13 @@ class HciHalHost : public HciHal {
       return;
     }
 
+    batched_io_ = os::GetSystemPropertyBool(kBatchedIoProperty, false);
+    if (batched_io_) {
+      for (auto& buffer : rx_pool_) {
+        buffer.resize(rx_buffer_size_);
+      }
+    }
+
     reactable_ = hci_incoming_thread_.GetReactor()->Register(
         sock_fd_,
         common::Bind(&HciHalHost::incoming_packet_received, common::Unretained(this)),
@@ -313,7 +335,7 @@ class HciHalHost : public HciHal {
     hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_ONLY);
     link_clocker_ = GetDependency<LinkClocker>();
     btsnoop_logger_ = GetDependency<SnoopLogger>();
-    log::info("HAL opened successfully");
+    log::info("HAL opened successfully, batched I/O: {}", batched_io_);
   }
 
   void Stop() override {
@@ -350,13 +372,21 @@ class HciHalHost : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  // Outgoing packets are queued without their H4 type byte, which is sent
+  // from a separate iovec to avoid moving the whole payload.
+  std::queue<std::pair<uint8_t, HciPacket>> hci_outgoing_queue_;
   SnoopLogger* btsnoop_logger_ = nullptr;
   LinkClocker* link_clocker_ = nullptr;
 
-  void write_to_fd(HciPacket packet) {
+  bool batched_io_ = false;
+  // Only accessed from hci_incoming_thread_
+  size_t rx_buffer_size_ = kBufSize;
+  size_t pending_rx_buffer_size_ = kBufSize;
+  std::array<std::vector<uint8_t>, kMaxIoBatch> rx_pool_;
+
+  void write_to_fd(uint8_t h4_type, HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    hci_outgoing_queue_.emplace(h4_type, std::move(packet));
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_WRITE);
     }
@@ -365,17 +395,105 @@ class HciHalHost : public HciHal {
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(api_mutex_);
     if (hci_outgoing_queue_.empty()) return;
-    auto packet_to_send = hci_outgoing_queue_.front();
-    auto bytes_written = write(sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    hci_outgoing_queue_.pop();
-    if (bytes_written == -1) {
-      abort();
+    if (batched_io_) {
+      send_packet_batch();
+    } else {
+      auto& [h4_type, packet_to_send] = hci_outgoing_queue_.front();
+      struct iovec iov[] = {
+          {.iov_base = &h4_type, .iov_len = kH4HeaderSize},
+          {.iov_base = packet_to_send.data(), .iov_len = packet_to_send.size()},
+      };
+      ssize_t bytes_written;
+      RUN_NO_INTR(bytes_written = writev(sock_fd_, iov, 2));
+      hci_outgoing_queue_.pop();
+      if (bytes_written == -1) {
+        abort();
+      }
     }
     if (hci_outgoing_queue_.empty()) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_ONLY);
     }
   }
 
+  // The user channel keeps message boundaries, so each queued packet is sent as
+  // its own message, up to kMaxIoBatch of them with a single system call.
+  void send_packet_batch() {
+    std::array<struct mmsghdr, kMaxIoBatch> msgs = {};
+    std::array<struct iovec, 2 * kMaxIoBatch> iovs;
+
+    // std::queue does not allow iterating, so the batch is staged here.
+    std::array<std::pair<uint8_t, HciPacket>, kMaxIoBatch> batch;
+    size_t batch_size = std::min(hci_outgoing_queue_.size(), kMaxIoBatch);
+    for (size_t i = 0; i < batch_size; i++) {
+      batch[i] = std::move(hci_outgoing_queue_.front());
+      hci_outgoing_queue_.pop();
+
+      iovs[2 * i] = {.iov_base = &batch[i].first, .iov_len = kH4HeaderSize};
+      iovs[2 * i + 1] = {.iov_base = batch[i].second.data(), .iov_len = batch[i].second.size()};
+      msgs[i].msg_hdr.msg_iov = &iovs[2 * i];
+      msgs[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    size_t sent = 0;
+    while (sent < batch_size) {
+      int ret;
+      RUN_NO_INTR(ret = sendmmsg(sock_fd_, msgs.data() + sent, batch_size - sent, 0));
+      if (ret == -1) {
+        abort();
+      }
+      sent += ret;
+    }
+  }
+
+  // Records the receive buffer size needed to fit the ACL and ISO data packet
+  // lengths reported by the controller. The pool is only resized once the
+  // batch holding the event has been dispatched, see apply_rx_buffer_size().
+  void update_rx_buffer_size(const HciPacket& event) {
+    // Event code, length, number of packets, opcode, status
+    constexpr size_t kCommandCompleteHeaderSize = 6;
+    if (event.size() < kCommandCompleteHeaderSize + 2 || event[0] != kHciCommandCompleteEvent ||
+        event[5] != 0 /* status */) {
+      return;
+    }
+
+    uint16_t opcode = event[3] | (event[4] << 8);
+    const uint8_t* params = event.data() + kCommandCompleteHeaderSize;
+    size_t acl_length = 0;
+    size_t iso_length = 0;
+    switch (opcode) {
+      case kHciReadBufferSizeOpcode:
+      case kHciLeReadBufferSizeOpcode:
+        acl_length = params[0] | (params[1] << 8);
+        break;
+      case kHciLeReadBufferSizeV2Opcode:
+        acl_length = params[0] | (params[1] << 8);
+        if (event.size() >= kCommandCompleteHeaderSize + 5) {
+          iso_length = params[3] | (params[4] << 8);
+        }
+        break;
+      default:
+        return;
+    }
+
+    pending_rx_buffer_size_ = std::max(
+        {pending_rx_buffer_size_,
+         kH4HeaderSize + kHciAclHeaderSize + acl_length,
+         kH4HeaderSize + kHciIsoHeaderSize + iso_length});
+  }
+
+  // Grows the receive buffers to the size recorded by update_rx_buffer_size().
+  // Resizing may reallocate them, so this must not run while packets of the
+  // pool are being dispatched.
+  void apply_rx_buffer_size() {
+    if (pending_rx_buffer_size_ == rx_buffer_size_) return;
+
+    log::info("Receive buffer size changed from {} to {}", rx_buffer_size_, pending_rx_buffer_size_);
+    rx_buffer_size_ = pending_rx_buffer_size_;
+    for (auto& buffer : rx_pool_) {
+      buffer.resize(rx_buffer_size_);
+    }
+  }
+
   void incoming_packet_received() {
     {
       std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -384,6 +502,12 @@ class HciHalHost : public HciHal {
         return;
       }
     }
+
+    if (batched_io_) {
+      incoming_packet_batch_received();
+      return;
+    }
+
     uint8_t buf[kBufSize] = {};
 
     ssize_t received_size;
@@ -405,6 +529,49 @@ class HciHalHost : public HciHal {
       return;
     }
 
+    dispatch_h4_packet(buf, received_size, kBufSize);
+  }
+
+  void incoming_packet_batch_received() {
+    std::array<struct mmsghdr, kMaxIoBatch> msgs = {};
+    std::array<struct iovec, kMaxIoBatch> iovs;
+    for (size_t i = 0; i < kMaxIoBatch; i++) {
+      iovs[i] = {.iov_base = rx_pool_[i].data(), .iov_len = rx_pool_[i].size()};
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received;
+    RUN_NO_INTR(received = recvmmsg(sock_fd_, msgs.data(), kMaxIoBatch, MSG_DONTWAIT, nullptr));
+
+    if (received == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+      // we don't want crash when the chipset is broken.
+      log::error("Can't receive from socket: {}", strerror(errno));
+      close(sock_fd_);
+      raise(SIGINT);
+      return;
+    }
+
+    for (int i = 0; i < received; i++) {
+      ssize_t received_size = msgs[i].msg_len;
+      if (received_size == 0) {
+        log::warn("Can't read H4 header. EOF received");
+        // First close sock fd before raising sigint
+        close(sock_fd_);
+        raise(SIGINT);
+        return;
+      }
+      if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        log::error("Dropping packet larger than the receive buffer ({} bytes)", rx_buffer_size_);
+        continue;
+      }
+      dispatch_h4_packet(rx_pool_[i].data(), received_size, rx_pool_[i].size());
+    }
+    apply_rx_buffer_size();
+  }
+
+  void dispatch_h4_packet(const uint8_t* buf, ssize_t received_size, size_t buf_size) {
     if (buf[0] == kH4Event) {
       log::assert_that(
           received_size >= kH4HeaderSize + kHciEvtHeaderSize,
@@ -421,6 +588,9 @@ class HciHalHost : public HciHal {
       HciPacket receivedHciPacket;
       receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + payload_size);
       link_clocker_->OnHciEvent(receivedHciPacket);
+      if (batched_io_) {
+        update_rx_buffer_size(receivedHciPacket);
+      }
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -430,6 +600,7 @@ class HciHalHost : public HciHal {
         }
         incoming_packet_callback_->hciEventReceived(receivedHciPacket);
       }
+      return;
     }
 
     if (buf[0] == kH4Acl) {
@@ -445,7 +616,7 @@ class HciHalHost : public HciHal {
           payload_size,
           hci_acl_data_total_length);
       log::assert_that(
-          hci_acl_data_total_length <= kBufSize - kH4HeaderSize - kHciAclHeaderSize,
+          hci_acl_data_total_length <= buf_size - kH4HeaderSize - kHciAclHeaderSize,
           "packet too long");
 
       HciPacket receivedHciPacket;
@@ -513,7 +684,6 @@ class HciHalHost : public HciHal {
         incoming_packet_callback_->isoDataReceived(receivedHciPacket);
       }
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
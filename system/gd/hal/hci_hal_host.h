@@ -56,5 +56,31 @@ class HciHalHostRootcanalConfig {
   std::string server_address_ = "127.0.0.1";  // Default server address
 };
 
+// Singleton object to store runtime configuration for the HCI user channel
+class HciHalHostUserChannelConfig {
+ public:
+  static HciHalHostUserChannelConfig* Get() {
+    static HciHalHostUserChannelConfig instance;
+    return &instance;
+  }
+
+  // Take the socket set by SetSocketForTesting, or -1 if none was set
+  int TakeSocketForTesting() {
+    int fd = socket_for_testing_;
+    socket_for_testing_ = -1;
+    return fd;
+  }
+
+  // Make the next HAL start use |fd|, a connected SOCK_SEQPACKET socket, in
+  // place of the HCI user channel. The HAL closes it when stopped.
+  void SetSocketForTesting(int fd) {
+    socket_for_testing_ = fd;
+  }
+
+ private:
+  HciHalHostUserChannelConfig() = default;
+  int socket_for_testing_ = -1;
+};
+
 }  // namespace hal
 }  // namespace bluetooth
@@ -20,12 +20,18 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <csignal>
+#include <cstring>
 #include <mutex>
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "hal/hci_hal.h"
 #include "hal/hci_hal_host.h"
@@ -33,6 +39,7 @@
 #include "metrics/counter_metrics.h"
 #include "os/log.h"
 #include "os/reactor.h"
+#include "os/system_properties.h"
 #include "os/thread.h"
 
 namespace {
@@ -51,6 +58,47 @@ constexpr uint8_t kHciEvtHeaderSize = 2;
 constexpr uint8_t kHciIsoHeaderSize = 4;
 constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
 
+// In batched I/O mode, up to kMaxIoBatch outgoing packets are written with a
+// single writev(), and incoming packets are parsed out of a kRxBufferSize
+// stream buffer filled by a single recv().
+constexpr char kBatchedIoProperty[] = "bluetooth.hal.host.batched_io.enabled";
+constexpr size_t kMaxIoBatch = 16;
+constexpr size_t kRxBufferSize = kMaxIoBatch * kBufSize;
+
+// Returns the size of the HCI header following the H4 type byte, or 0 if the
+// packet type is unknown.
+size_t HciHeaderSize(uint8_t h4_type) {
+  switch (h4_type) {
+    case kH4Event:
+      return kHciEvtHeaderSize;
+    case kH4Acl:
+      return kHciAclHeaderSize;
+    case kH4Sco:
+      return kHciScoHeaderSize;
+    case kH4Iso:
+      return kHciIsoHeaderSize;
+    default:
+      return 0;
+  }
+}
+
+// Returns the payload size of an H4 packet of a known type, read from its HCI
+// header.
+size_t HciPayloadSize(const uint8_t* h4_packet) {
+  switch (h4_packet[0]) {
+    case kH4Event:
+      return h4_packet[2];
+    case kH4Acl:
+      return (h4_packet[4] << 8) + h4_packet[3];
+    case kH4Sco:
+      return h4_packet[3];
+    case kH4Iso:
+      return ((h4_packet[4] & 0x3f) << 8) + h4_packet[3];
+    default:
+      return 0;
+  }
+}
+
 int ConnectToSocket() {
   auto* config = bluetooth::hal::HciHalHostRootcanalConfig::Get();
   const std::string& server = config->GetServerAddress();
@@ -127,8 +175,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(command);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    packet.insert(packet.cbegin(), kH4Command);
-    write_to_fd(packet);
+    write_to_fd(kH4Command, std::move(packet));
   }
 
   void sendAclData(HciPacket data) override {
@@ -136,8 +183,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
-    packet.insert(packet.cbegin(), kH4Acl);
-    write_to_fd(packet);
+    write_to_fd(kH4Acl, std::move(packet));
   }
 
   void sendScoData(HciPacket data) override {
@@ -145,8 +191,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    packet.insert(packet.cbegin(), kH4Sco);
-    write_to_fd(packet);
+    write_to_fd(kH4Sco, std::move(packet));
   }
 
   void sendIsoData(HciPacket data) override {
@@ -154,8 +199,7 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
-    packet.insert(packet.cbegin(), kH4Iso);
-    write_to_fd(packet);
+    write_to_fd(kH4Iso, std::move(packet));
   }
 
  protected:
@@ -169,13 +213,18 @@ class HciHalHost : public HciHal {
     log::assert_that(sock_fd_ == INVALID_FD, "assert failed: sock_fd_ == INVALID_FD");
     sock_fd_ = ConnectToSocket();
     log::assert_that(sock_fd_ != INVALID_FD, "assert failed: sock_fd_ != INVALID_FD");
+    batched_io_ = os::GetSystemPropertyBool(kBatchedIoProperty, false);
+    if (batched_io_) {
+      rx_buffer_.resize(kRxBufferSize);
+      rx_buffer_len_ = 0;
+    }
     reactable_ = hci_incoming_thread_.GetReactor()->Register(
         sock_fd_,
         common::Bind(&HciHalHost::incoming_packet_received, common::Unretained(this)),
         common::Bind(&HciHalHost::send_packet_ready, common::Unretained(this)));
     hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_ONLY);
     btsnoop_logger_ = GetDependency<SnoopLogger>();
-    log::info("HAL opened successfully");
+    log::info("HAL opened successfully, batched I/O: {}", batched_io_);
   }
 
   void Stop() override {
@@ -212,12 +261,19 @@ class HciHalHost : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  // Outgoing packets are queued without their H4 type byte, which is sent
+  // from a separate iovec to avoid moving the whole payload.
+  std::queue<std::pair<uint8_t, HciPacket>> hci_outgoing_queue_;
   SnoopLogger* btsnoop_logger_ = nullptr;
 
-  void write_to_fd(HciPacket packet) {
+  bool batched_io_ = false;
+  // Only accessed from hci_incoming_thread_
+  std::vector<uint8_t> rx_buffer_;
+  size_t rx_buffer_len_ = 0;
+
+  void write_to_fd(uint8_t h4_type, HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    hci_outgoing_queue_.emplace(h4_type, std::move(packet));
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_WRITE);
     }
@@ -226,17 +282,60 @@ class HciHalHost : public HciHal {
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(api_mutex_);
     if (hci_outgoing_queue_.empty()) return;
-    auto packet_to_send = hci_outgoing_queue_.front();
-    auto bytes_written = write(sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    hci_outgoing_queue_.pop();
-    if (bytes_written == -1) {
-      abort();
+    if (batched_io_) {
+      send_packet_batch();
+    } else {
+      auto& [h4_type, packet_to_send] = hci_outgoing_queue_.front();
+      struct iovec iov[] = {
+          {.iov_base = &h4_type, .iov_len = kH4HeaderSize},
+          {.iov_base = packet_to_send.data(), .iov_len = packet_to_send.size()},
+      };
+      ssize_t bytes_written;
+      RUN_NO_INTR(bytes_written = writev(sock_fd_, iov, 2));
+      hci_outgoing_queue_.pop();
+      if (bytes_written == -1) {
+        abort();
+      }
     }
     if (hci_outgoing_queue_.empty()) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_ONLY);
     }
   }
 
+  void send_packet_batch() {
+    // std::queue does not allow iterating, so the batch is staged here.
+    std::array<std::pair<uint8_t, HciPacket>, kMaxIoBatch> batch;
+    std::array<struct iovec, 2 * kMaxIoBatch> iovs;
+    size_t batch_size = std::min(hci_outgoing_queue_.size(), kMaxIoBatch);
+    for (size_t i = 0; i < batch_size; i++) {
+      batch[i] = std::move(hci_outgoing_queue_.front());
+      hci_outgoing_queue_.pop();
+
+      iovs[2 * i] = {.iov_base = &batch[i].first, .iov_len = kH4HeaderSize};
+      iovs[2 * i + 1] = {.iov_base = batch[i].second.data(), .iov_len = batch[i].second.size()};
+    }
+
+    struct iovec* iov = iovs.data();
+    size_t iov_count = 2 * batch_size;
+    while (iov_count > 0) {
+      ssize_t bytes_written;
+      RUN_NO_INTR(bytes_written = writev(sock_fd_, iov, iov_count));
+      if (bytes_written == -1) {
+        abort();
+      }
+      // Resume a short write from the first byte not yet sent.
+      while (iov_count > 0 && static_cast<size_t>(bytes_written) >= iov->iov_len) {
+        bytes_written -= iov->iov_len;
+        iov++;
+        iov_count--;
+      }
+      if (iov_count > 0) {
+        iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + bytes_written;
+        iov->iov_len -= bytes_written;
+      }
+    }
+  }
+
   bool socketRecvAll(void* buffer, int bufferLen) {
     auto buf = static_cast<char*>(buffer);
     while (bufferLen > 0) {
@@ -259,6 +358,12 @@ class HciHalHost : public HciHal {
         return;
       }
     }
+
+    if (batched_io_) {
+      incoming_packet_batch_received();
+      return;
+    }
+
     uint8_t buf[kBufSize] = {};
 
     ssize_t received_size;
@@ -270,21 +375,69 @@ class HciHalHost : public HciHal {
       return;
     }
 
-    if (buf[0] == kH4Event) {
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize, kHciEvtHeaderSize),
-          "Can't receive from socket: {}",
-          strerror(errno));
+    size_t header_size = HciHeaderSize(buf[0]);
+    if (header_size == 0) return;
 
-      uint8_t hci_evt_parameter_total_length = buf[2];
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize + kHciEvtHeaderSize, hci_evt_parameter_total_length),
-          "Can't receive from socket: {}",
-          strerror(errno));
+    log::assert_that(
+        socketRecvAll(buf + kH4HeaderSize, header_size),
+        "Can't receive from socket: {}",
+        strerror(errno));
+
+    size_t payload_size = HciPayloadSize(buf);
+    log::assert_that(
+        kH4HeaderSize + header_size + payload_size <= kBufSize,
+        "packet too long");
+    log::assert_that(
+        socketRecvAll(buf + kH4HeaderSize + header_size, payload_size),
+        "Can't receive from socket: {}",
+        strerror(errno));
 
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + hci_evt_parameter_total_length);
+    dispatch_h4_packet(buf, kH4HeaderSize + header_size + payload_size);
+  }
+
+  // Reads whatever the socket has available and dispatches every complete
+  // packet, keeping a trailing partial packet for the next read.
+  void incoming_packet_batch_received() {
+    ssize_t received_size;
+    RUN_NO_INTR(
+        received_size = recv(
+            sock_fd_,
+            rx_buffer_.data() + rx_buffer_len_,
+            rx_buffer_.size() - rx_buffer_len_,
+            MSG_DONTWAIT));
+    if (received_size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    log::assert_that(received_size != -1, "Can't receive from socket: {}", strerror(errno));
+    if (received_size == 0) {
+      log::warn("Can't read H4 header. EOF received");
+      raise(SIGINT);
+      return;
+    }
+    rx_buffer_len_ += received_size;
+
+    size_t offset = 0;
+    while (rx_buffer_len_ - offset >= kH4HeaderSize) {
+      const uint8_t* packet = rx_buffer_.data() + offset;
+      size_t header_size = HciHeaderSize(packet[0]);
+      log::assert_that(header_size != 0, "Unknown H4 packet type: {}", packet[0]);
+      if (rx_buffer_len_ - offset < kH4HeaderSize + header_size) break;
+
+      size_t packet_size = kH4HeaderSize + header_size + HciPayloadSize(packet);
+      log::assert_that(packet_size <= rx_buffer_.size(), "packet too long");
+      if (rx_buffer_len_ - offset < packet_size) break;
+
+      dispatch_h4_packet(packet, packet_size);
+      offset += packet_size;
+    }
+
+    rx_buffer_len_ -= offset;
+    memmove(rx_buffer_.data(), rx_buffer_.data() + offset, rx_buffer_len_);
+  }
+
+  void dispatch_h4_packet(const uint8_t* buf, size_t size) {
+    HciPacket receivedHciPacket;
+    receivedHciPacket.assign(buf + kH4HeaderSize, buf + size);
+
+    if (buf[0] == kH4Event) {
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -297,20 +450,6 @@ class HciHalHost : public HciHal {
     }
 
     if (buf[0] == kH4Acl) {
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize, kHciAclHeaderSize),
-          "Can't receive from socket: {}",
-          strerror(errno));
-
-      uint16_t hci_acl_data_total_length = (buf[4] << 8) + buf[3];
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize + kHciAclHeaderSize, hci_acl_data_total_length),
-          "Can't receive from socket: {}",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciAclHeaderSize + hci_acl_data_total_length);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -323,20 +462,6 @@ class HciHalHost : public HciHal {
     }
 
     if (buf[0] == kH4Sco) {
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize, kHciScoHeaderSize),
-          "Can't receive from socket: {}",
-          strerror(errno));
-
-      uint8_t hci_sco_data_total_length = buf[3];
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize + kHciScoHeaderSize, hci_sco_data_total_length),
-          "Can't receive from socket: {}",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciScoHeaderSize + hci_sco_data_total_length);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -349,20 +474,6 @@ class HciHalHost : public HciHal {
     }
 
     if (buf[0] == kH4Iso) {
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize, kHciIsoHeaderSize),
-          "Can't receive from socket: {}",
-          strerror(errno));
-
-      uint16_t hci_iso_data_total_length = ((buf[4] & 0x3f) << 8) + buf[3];
-      log::assert_that(
-          socketRecvAll(buf + kH4HeaderSize + kHciIsoHeaderSize, hci_iso_data_total_length),
-          "Can't receive from socket: {}",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciIsoHeaderSize + hci_iso_data_total_length);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ISO);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -373,7 +484,6 @@ class HciHalHost : public HciHal {
         incoming_packet_callback_->isoDataReceived(receivedHciPacket);
       }
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
@@ -26,6 +26,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <cstring>
 #include <queue>
 #include <thread>
@@ -35,6 +36,7 @@
 #include "hal/hci_hal.h"
 #include "hal/serialize_packet.h"
 #include "os/log.h"
+#include "os/system_properties.h"
 #include "os/thread.h"
 #include "os/utils.h"
 #include "packet/raw_builder.h"
@@ -47,6 +49,8 @@ namespace {
 
 uint16_t kTestPort = 6537;
 
+constexpr char kBatchedIoProperty[] = "bluetooth.hal.host.batched_io.enabled";
+
 constexpr uint8_t kH4Command = 0x01;
 constexpr uint8_t kH4Acl = 0x02;
 constexpr uint8_t kH4Sco = 0x03;
@@ -168,6 +172,14 @@ class HciHalRootcanalTest : public ::testing::Test {
     EXPECT_NE(ret, -1) << "Can't set accept fd to blocking";
   }
 
+  // Sends num_packets ACL packets through the HAL while reading them back on the
+  // fake server, and returns the achieved throughput.
+  double MeasureSendThroughput(int num_packets, uint16_t acl_payload_size);
+
+  // Writes num_packets ACL packets from the fake server, and returns the
+  // throughput at which they reach the HAL callbacks.
+  double MeasureReceiveThroughput(int num_packets, uint8_t acl_payload_size);
+
   FakeRootcanalDesktopHciServer* fake_server_ = nullptr;
   HciHal* hal_ = nullptr;
   ModuleRegistry fake_registry_;
@@ -176,6 +188,19 @@ class HciHalRootcanalTest : public ::testing::Test {
   Thread* thread_;
 };
 
+class HciHalRootcanalBatchedTest : public HciHalRootcanalTest {
+ protected:
+  void SetUp() override {
+    os::SetSystemProperty(kBatchedIoProperty, "true");
+    HciHalRootcanalTest::SetUp();
+  }
+
+  void TearDown() override {
+    HciHalRootcanalTest::TearDown();
+    os::ClearSystemPropertiesForHost();
+  }
+};
+
 void check_packet_equal(std::pair<uint8_t, HciPacket> hci_packet1_type_data_pair, H4Packet h4_packet2) {
   auto packet1_hci_size = hci_packet1_type_data_pair.second.size();
   ASSERT_EQ(packet1_hci_size + 1, h4_packet2.size());
@@ -248,6 +273,58 @@ size_t read_with_retry(int socket, uint8_t* data, size_t length) {
   return bytes_read;
 }
 
+double HciHalRootcanalTest::MeasureSendThroughput(int num_packets, uint16_t acl_payload_size) {
+  HciPacket acl_packet = make_sample_hci_acl_pkt(0);
+  acl_packet.resize(acl_packet.size() + acl_payload_size, 0x01);
+  acl_packet[2] = acl_payload_size & 0xff;
+  acl_packet[3] = acl_payload_size >> 8;
+  SetFakeServerSocketToBlocking();
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread reader([&]() {
+    H4Packet read_buf(1 + acl_packet.size());
+    for (int i = 0; i < num_packets; i++) {
+      auto size_read = read_with_retry(fake_server_socket_, read_buf.data(), read_buf.size());
+      ASSERT_EQ(size_read, 1 + acl_packet.size());
+      check_packet_equal({kH4Acl, acl_packet}, read_buf);
+    }
+  });
+  for (int i = 0; i < num_packets; i++) {
+    hal_->sendAclData(acl_packet);
+  }
+  reader.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return num_packets / elapsed.count();
+}
+
+double HciHalRootcanalTest::MeasureReceiveThroughput(int num_packets, uint8_t acl_payload_size) {
+  H4Packet incoming_packet = make_sample_h4_acl_pkt(acl_payload_size);
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < num_packets; i++) {
+    stream.insert(stream.end(), incoming_packet.begin(), incoming_packet.end());
+  }
+  SetFakeServerSocketToBlocking();
+
+  auto start = std::chrono::steady_clock::now();
+  size_t written = 0;
+  while (written < stream.size()) {
+    ssize_t ret = write(fake_server_socket_, stream.data() + written, stream.size() - written);
+    EXPECT_NE(ret, -1) << "Can't write to the HAL socket";
+    if (ret == -1) return 0;
+    written += ret;
+  }
+  while (incoming_packets_queue_.size() != (size_t)num_packets) {
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  for (int i = 0; i < num_packets; i++) {
+    auto packet = incoming_packets_queue_.front();
+    incoming_packets_queue_.pop();
+    check_packet_equal(packet, incoming_packet);
+  }
+  return num_packets / elapsed.count();
+}
+
 TEST_F(HciHalRootcanalTest, init_and_close) {}
 
 TEST_F(HciHalRootcanalTest, receive_hci_evt) {
@@ -414,6 +491,113 @@ TEST_F(HciHalRootcanalTest, send_multiple_acl_sequential) {
   }
 }
 
+TEST_F(HciHalRootcanalTest, send_acl_throughput) {
+  double packets_per_second = MeasureSendThroughput(10000, 1021);
+  log::info("Sent {:.0f} ACL packets/s", packets_per_second);
+}
+
+TEST_F(HciHalRootcanalTest, receive_acl_throughput) {
+  double packets_per_second = MeasureReceiveThroughput(10000, 251);
+  log::info("Received {:.0f} ACL packets/s", packets_per_second);
+}
+
+TEST_F(HciHalRootcanalBatchedTest, receive_hci_evt) {
+  H4Packet incoming_packet = make_sample_h4_evt_pkt(3);
+  write(fake_server_socket_, incoming_packet.data(), incoming_packet.size());
+  while (incoming_packets_queue_.size() != 1) {
+  }
+  auto packet = incoming_packets_queue_.front();
+  incoming_packets_queue_.pop();
+  check_packet_equal(packet, incoming_packet);
+}
+
+TEST_F(HciHalRootcanalBatchedTest, receive_all_packet_types) {
+  std::vector<H4Packet> incoming_packets = {
+      make_sample_h4_evt_pkt(3),
+      make_sample_h4_acl_pkt(5),
+      make_sample_h4_sco_pkt(7),
+      make_sample_h4_iso_pkt(9),
+  };
+  for (auto& incoming_packet : incoming_packets) {
+    write(fake_server_socket_, incoming_packet.data(), incoming_packet.size());
+  }
+  while (incoming_packets_queue_.size() != incoming_packets.size()) {
+  }
+  for (auto& incoming_packet : incoming_packets) {
+    auto packet = incoming_packets_queue_.front();
+    incoming_packets_queue_.pop();
+    check_packet_equal(packet, incoming_packet);
+  }
+}
+
+TEST_F(HciHalRootcanalBatchedTest, receive_split_acl) {
+  H4Packet incoming_packet = make_sample_h4_acl_pkt(200);
+  SetFakeServerSocketToBlocking();
+  // Deliver the packet one byte at a time to exercise partial reads.
+  for (auto byte : incoming_packet) {
+    write(fake_server_socket_, &byte, 1);
+    std::this_thread::sleep_for(std::chrono::microseconds(10));
+  }
+  while (incoming_packets_queue_.size() != 1) {
+  }
+  auto packet = incoming_packets_queue_.front();
+  incoming_packets_queue_.pop();
+  check_packet_equal(packet, incoming_packet);
+}
+
+TEST_F(HciHalRootcanalBatchedTest, receive_multiple_acl_batch) {
+  H4Packet incoming_packet = make_sample_h4_acl_pkt(5);
+  int num_packets = 1000;
+  for (int i = 0; i < num_packets; i++) {
+    write(fake_server_socket_, incoming_packet.data(), incoming_packet.size());
+  }
+  while (incoming_packets_queue_.size() != (size_t)num_packets) {
+  }
+  for (int i = 0; i < num_packets; i++) {
+    auto packet = incoming_packets_queue_.front();
+    incoming_packets_queue_.pop();
+    check_packet_equal(packet, incoming_packet);
+  }
+}
+
+TEST_F(HciHalRootcanalBatchedTest, send_hci_cmd) {
+  uint8_t hci_cmd_param_size = 2;
+  HciPacket hci_data = make_sample_hci_cmd_pkt(hci_cmd_param_size);
+  hal_->sendHciCommand(hci_data);
+  H4Packet read_buf(1 + 2 + 1 + hci_cmd_param_size);
+  SetFakeServerSocketToBlocking();
+  auto size_read = read_with_retry(fake_server_socket_, read_buf.data(), read_buf.size());
+
+  ASSERT_EQ(size_read, 1 + hci_data.size());
+  check_packet_equal({kH4Command, hci_data}, read_buf);
+}
+
+TEST_F(HciHalRootcanalBatchedTest, send_multiple_acl_batch) {
+  uint8_t acl_payload_size = 200;
+  int num_packets = 1000;
+  HciPacket acl_packet = make_sample_hci_acl_pkt(acl_payload_size);
+  for (int i = 0; i < num_packets; i++) {
+    hal_->sendAclData(acl_packet);
+  }
+  H4Packet read_buf(1 + 2 + 2 + acl_payload_size);
+  SetFakeServerSocketToBlocking();
+  for (int i = 0; i < num_packets; i++) {
+    auto size_read = read_with_retry(fake_server_socket_, read_buf.data(), read_buf.size());
+    ASSERT_EQ(size_read, 1 + acl_packet.size());
+    check_packet_equal({kH4Acl, acl_packet}, read_buf);
+  }
+}
+
+TEST_F(HciHalRootcanalBatchedTest, send_acl_throughput) {
+  double packets_per_second = MeasureSendThroughput(10000, 1021);
+  log::info("Sent {:.0f} ACL packets/s with batched I/O", packets_per_second);
+}
+
+TEST_F(HciHalRootcanalBatchedTest, receive_acl_throughput) {
+  double packets_per_second = MeasureReceiveThroughput(10000, 251);
+  log::info("Received {:.0f} ACL packets/s with batched I/O", packets_per_second);
+}
+
 TEST(HciHalHidlTest, serialize) {
   std::vector<uint8_t> bytes = {1, 2, 3, 4, 5, 6, 7, 8, 9};
   auto packet_bytes = hal::SerializePacket(std::unique_ptr<packet::BasePacketBuilder>(new packet::RawBuilder(bytes)));
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hal/hci_hal.h"
+#include "hal/hci_hal_host.h"
+#include "os/system_properties.h"
+#include "os/thread.h"
+
+using ::bluetooth::os::Thread;
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+constexpr char kBatchedIoProperty[] = "bluetooth.hal.host.batched_io.enabled";
+
+constexpr uint8_t kH4Acl = 0x02;
+constexpr uint8_t kH4Event = 0x04;
+
+using H4Packet = std::vector<uint8_t>;
+
+class TestHciHalCallbacks : public HciHalCallbacks {
+ public:
+  void hciEventReceived(HciPacket packet) override {
+    Push(kH4Event, std::move(packet));
+  }
+
+  void aclDataReceived(HciPacket packet) override {
+    Push(kH4Acl, std::move(packet));
+  }
+
+  void scoDataReceived(HciPacket /* packet */) override {}
+  void isoDataReceived(HciPacket /* packet */) override {}
+
+  // Waits for |count| packets to be received, and returns them
+  std::vector<std::pair<uint8_t, HciPacket>> Wait(size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (std::chrono::steady_clock::now() < deadline) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (packets_.size() >= count) return std::move(packets_);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::move(packets_);
+  }
+
+ private:
+  void Push(uint8_t type, HciPacket packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    packets_.emplace_back(type, std::move(packet));
+  }
+
+  std::mutex mutex_;
+  std::vector<std::pair<uint8_t, HciPacket>> packets_;
+};
+
+H4Packet make_read_buffer_size_complete(uint16_t acl_length) {
+  return {kH4Event, 0x0e, 0x0b, 0x01, 0x05, 0x10, 0x00, static_cast<uint8_t>(acl_length),
+          static_cast<uint8_t>(acl_length >> 8), 0x40, 0x08, 0x00, 0x00, 0x00};
+}
+
+H4Packet make_h4_acl_pkt(uint16_t payload_size) {
+  H4Packet pkt(1 + 2 + 2 + payload_size, 0x01);
+  pkt[0] = kH4Acl;
+  pkt[3] = payload_size & 0xff;
+  pkt[4] = payload_size >> 8;
+  return pkt;
+}
+
+// The HAL reads the HCI user channel, a socket of the kernel, with a
+// SOCK_SEQPACKET socket pair standing in for it.
+class HciHalHostUserChannelBatchedTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    os::SetSystemProperty(kBatchedIoProperty, "true");
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+    controller_fd_ = fds[0];
+    HciHalHostUserChannelConfig::Get()->SetSocketForTesting(fds[1]);
+    thread_ = new Thread("test_thread", Thread::Priority::NORMAL);
+  }
+
+  void TearDown() override {
+    if (hal_ != nullptr) {
+      hal_->unregisterIncomingPacketCallback();
+      registry_.StopAll();
+    }
+    close(controller_fd_);
+    delete thread_;
+    os::ClearSystemPropertiesForHost();
+  }
+
+  void StartHal() {
+    hal_ = registry_.Start<HciHal>(thread_);
+    hal_->registerIncomingPacketCallback(&callbacks_);
+  }
+
+  void Write(const H4Packet& packet) {
+    ASSERT_EQ(static_cast<ssize_t>(packet.size()), write(controller_fd_, packet.data(), packet.size()));
+  }
+
+  static void CheckPacketEqual(const std::pair<uint8_t, HciPacket>& received, const H4Packet& sent) {
+    ASSERT_EQ(sent[0], received.first);
+    ASSERT_EQ(H4Packet(sent.begin() + 1, sent.end()), received.second);
+  }
+
+  int controller_fd_ = -1;
+  HciHal* hal_ = nullptr;
+  ModuleRegistry registry_;
+  TestHciHalCallbacks callbacks_;
+  Thread* thread_ = nullptr;
+};
+
+TEST_F(HciHalHostUserChannelBatchedTest, buffer_size_event_in_a_batch) {
+  // Queued before the HAL starts, so that they are all read by one recvmmsg()
+  H4Packet buffer_size = make_read_buffer_size_complete(2048);
+  std::vector<H4Packet> batch = {make_h4_acl_pkt(16), buffer_size, make_h4_acl_pkt(600), make_h4_acl_pkt(1020)};
+  for (const auto& packet : batch) {
+    Write(packet);
+  }
+  StartHal();
+
+  auto received = callbacks_.Wait(batch.size());
+  ASSERT_EQ(batch.size(), received.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    CheckPacketEqual(received[i], batch[i]);
+  }
+
+  // The receive buffers grew once the batch was dispatched
+  H4Packet large_acl = make_h4_acl_pkt(2048);
+  Write(large_acl);
+  received = callbacks_.Wait(1);
+  ASSERT_EQ(1u, received.size());
+  CheckPacketEqual(received[0], large_acl);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -355,6 +355,14 @@ void AclManager::ClearResolvingList() {
   CallOn(pimpl_->le_impl_, &le_impl::clear_resolving_list);
 }
 
+void AclManager::BeginLeListUpdates() {
+  CallOn(pimpl_->le_impl_, &le_impl::begin_list_updates);
+}
+
+void AclManager::CommitLeListUpdates() {
+  CallOn(pimpl_->le_impl_, &le_impl::commit_list_updates);
+}
+
 void AclManager::CentralLinkKey(KeyFlag key_flag) {
   CallOn(pimpl_->classic_impl_, &classic_impl::central_link_key, key_flag);
 }
@@ -454,6 +462,11 @@ void AclManager::impl::Dump(
       (le_impl_ != nullptr) ? connectability_state_machine_text(le_impl_->connectability_state_) : "INDETERMINATE";
   const auto le_create_connection_timeout_alarms_count =
       (le_impl_ != nullptr) ? (int)le_impl_->create_connection_timeout_alarms_.size() : 0;
+  const auto* le_address_manager = (le_impl_ != nullptr) ? le_impl_->le_address_manager_ : nullptr;
+  const auto le_address_manager_pause_window_count =
+      (le_address_manager != nullptr) ? (int)le_address_manager->GetPauseWindowCount() : 0;
+  const auto le_address_manager_paused_time_ms =
+      (le_address_manager != nullptr) ? le_address_manager->GetTotalPausedTime().count() : 0;
 
   auto title = fb_builder->CreateString("----- Acl Manager Dumpsys -----");
   auto le_connectability_state = fb_builder->CreateString(le_connectability_state_text);
@@ -472,6 +485,8 @@ void AclManager::impl::Dump(
   builder.add_le_filter_accept_list(vecofstrings);
   builder.add_le_connectability_state(le_connectability_state);
   builder.add_le_create_connection_timeout_alarms_count(le_create_connection_timeout_alarms_count);
+  builder.add_le_address_manager_pause_window_count(le_address_manager_pause_window_count);
+  builder.add_le_address_manager_paused_time_ms(le_address_manager_paused_time_ms);
 
   flatbuffers::Offset<AclManagerData> dumpsys_data = builder.Finish();
   promise.set_value(dumpsys_data);
@@ -126,6 +126,11 @@ class AclManager : public Module {
   virtual void RemoveDeviceFromResolvingList(AddressWithType address_with_type);
   virtual void ClearResolvingList();
 
+  // LE filter accept list and resolving list updates made between these calls
+  // are sent together, pausing scanning, advertising and connections only once.
+  virtual void BeginLeListUpdates();
+  virtual void CommitLeListUpdates();
+
   virtual void CentralLinkKey(KeyFlag key_flag);
   virtual void SwitchRole(Address address, Role role);
   virtual uint16_t ReadDefaultLinkPolicySettings();
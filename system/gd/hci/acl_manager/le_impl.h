@@ -761,6 +761,14 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     }
   }
 
+  void begin_list_updates() {
+    le_address_manager_->BeginListUpdates();
+  }
+
+  void commit_list_updates() {
+    le_address_manager_->CommitListUpdates();
+  }
+
   void update_connectability_state_after_armed(const ErrorCode& status) {
     switch (connectability_state_) {
       case ConnectabilityState::DISARMED:
@@ -19,10 +19,16 @@
 #include <bluetooth/log.h>
 
 #include "hci/acl_manager/acl_fragmenter.h"
+#include "os/stats.h"
 namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
+static os::StatsCounter stats_classic_fragments_sent("acl.classic_fragments_sent");
+static os::StatsCounter stats_le_fragments_sent("acl.le_fragments_sent");
+static os::StatsGauge stats_classic_credits("acl.classic_credits");
+static os::StatsGauge stats_le_credits("acl.le_credits");
+
 RoundRobinScheduler::RoundRobinScheduler(
     os::Handler* handler, Controller* controller, common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end)
     : handler_(handler), controller_(controller), hci_queue_end_(hci_queue_end) {
@@ -203,9 +209,13 @@ std::unique_ptr<AclBuilder> RoundRobinScheduler::handle_enqueue_next_fragment()
   if (connection_type == ConnectionType::CLASSIC) {
     log::assert_that(acl_packet_credits_ > 0, "assert failed: acl_packet_credits_ > 0");
     acl_packet_credits_ -= 1;
+    stats_classic_fragments_sent.Increment();
+    stats_classic_credits.Set(acl_packet_credits_);
   } else {
     log::assert_that(le_acl_packet_credits_ > 0, "assert failed: le_acl_packet_credits_ > 0");
     le_acl_packet_credits_ -= 1;
+    stats_le_fragments_sent.Increment();
+    stats_le_credits.Set(le_acl_packet_credits_);
   }
 
   auto raw_pointer = fragments_to_send_.front().second.release();
@@ -249,6 +259,7 @@ void RoundRobinScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits
       acl_packet_credits_ = max_acl_packet_credits_;
       log::warn("acl packet credits overflow due to receive {} credits", credits);
     }
+    stats_classic_credits.Set(acl_packet_credits_);
   } else {
     if (le_acl_packet_credits_ == 0) {
       credit_was_zero = true;
@@ -258,6 +269,7 @@ void RoundRobinScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits
       le_acl_packet_credits_ = le_max_acl_packet_credits_;
       log::warn("le acl packet credits overflow due to receive {} credits", credits);
     }
+    stats_le_credits.Set(le_acl_packet_credits_);
   }
   if (credit_was_zero) {
     start_round_robin();
@@ -20,20 +20,27 @@
 #include <bluetooth/log.h>
 #include <com_android_bluetooth_flags.h>
 
+#include <chrono>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <utility>
 
+#include "common/bind.h"
 #include "common/init_flags.h"
 #include "dumpsys_data_generated.h"
 #include "hci/controller_interface.h"
+#include "hci/controller_snapshot.h"
 #include "hci/event_checkers.h"
 #include "hci/hci_layer.h"
 #include "hci_controller_generated.h"
 #include "os/log.h"
 #include "os/metrics.h"
+#include "os/files.h"
 #include "os/system_properties.h"
+#include "packet/raw_builder.h"
 #if TARGET_FLOSS
 #include "sysprops/sysprops_module.h"
 #endif
@@ -53,12 +60,16 @@ constexpr bool kDefaultErroneousDataReportingEnabled = true;
 static const std::string kPropertyErroneousDataReportingEnabled =
     "bluetooth.hci.erroneous_data_reporting.enabled";
 
+constexpr bool kDefaultSnapshotEnabled = true;
+static const std::string kPropertySnapshotEnabled = "bluetooth.hci.controller_snapshot.enabled";
+
 using os::Handler;
 
 struct Controller::impl {
   impl(Controller& module) : module_(module) {}
 
   void Start(hci::HciLayer* hci) {
+    auto start_time = std::chrono::steady_clock::now();
     hci_ = hci;
     Handler* handler = module_.GetHandler();
     hci_->RegisterEventHandler(
@@ -66,28 +77,51 @@ struct Controller::impl {
 
     set_event_mask(kDefaultEventMask);
     write_le_host_support(Enable::ENABLED, Enable::DISABLED);
-    hci_->EnqueueCommand(ReadLocalNameBuilder::Create(),
-                         handler->BindOnceOn(this, &Controller::impl::read_local_name_complete_handler));
+
+    // Identify the controller first, to know whether its snapshot applies
+    std::promise<void> identity_promise;
+    auto identity_future = identity_promise.get_future();
     hci_->EnqueueCommand(ReadLocalVersionInformationBuilder::Create(),
                          handler->BindOnceOn(this, &Controller::impl::read_local_version_information_complete_handler));
-    hci_->EnqueueCommand(ReadLocalSupportedCommandsBuilder::Create(),
-                         handler->BindOnceOn(this, &Controller::impl::read_local_supported_commands_complete_handler));
-
     hci_->EnqueueCommand(
+        ReadBdAddrBuilder::Create(),
+        handler->BindOnceOn(
+            this,
+            &Controller::impl::read_controller_mac_address_handler,
+            std::move(identity_promise)));
+    identity_future.wait();
+    load_snapshot();
+
+    // The host writes the local name, it is not a capability of the controller
+    hci_->EnqueueCommand(
+        ReadLocalNameBuilder::Create(),
+        handler->BindOnceOn(this, &Controller::impl::read_local_name_complete_handler));
+    read_capability(
+        ReadLocalSupportedCommandsBuilder::Create(),
+        common::BindOnce(
+            &Controller::impl::read_local_supported_commands_complete_handler,
+            common::Unretained(this)));
+
+    read_capability(
         LeReadLocalSupportedFeaturesBuilder::Create(),
-        handler->BindOnceOn(this, &Controller::impl::le_read_local_supported_features_handler));
+        common::BindOnce(
+            &Controller::impl::le_read_local_supported_features_handler, common::Unretained(this)));
 
-    hci_->EnqueueCommand(
+    read_capability(
         LeReadSupportedStatesBuilder::Create(),
-        handler->BindOnceOn(this, &Controller::impl::le_read_supported_states_handler));
+        common::BindOnce(
+            &Controller::impl::le_read_supported_states_handler, common::Unretained(this)));
 
     // Wait for all extended features read
     std::promise<void> features_promise;
     auto features_future = features_promise.get_future();
 
-    hci_->EnqueueCommand(ReadLocalExtendedFeaturesBuilder::Create(0x00),
-                         handler->BindOnceOn(this, &Controller::impl::read_local_extended_features_complete_handler,
-                                             std::move(features_promise)));
+    read_capability(
+        ReadLocalExtendedFeaturesBuilder::Create(0x00),
+        common::BindOnce(
+            &Controller::impl::read_local_extended_features_complete_handler,
+            common::Unretained(this),
+            std::move(features_promise)));
     features_future.wait();
 
     if (com::android::bluetooth::flags::channel_sounding_in_stack() &&
@@ -99,8 +133,11 @@ struct Controller::impl {
           MaskLeEventMask(local_version_information_.hci_version_, kDefaultLeEventMask));
     }
 
-    hci_->EnqueueCommand(ReadBufferSizeBuilder::Create(),
-                         handler->BindOnceOn(this, &Controller::impl::read_buffer_size_complete_handler));
+    // The buffer sizes set the ACL credits, so they are always read from the controller
+    read_live_capability(
+        ReadBufferSizeBuilder::Create(),
+        common::BindOnce(
+            &Controller::impl::read_buffer_size_complete_handler, common::Unretained(this)));
 
     if (common::init_flags::set_min_encryption_is_enabled() && is_supported(OpCode::SET_MIN_ENCRYPTION_KEY_SIZE)) {
       hci_->EnqueueCommand(
@@ -109,37 +146,44 @@ struct Controller::impl {
     }
 
     if (is_supported(OpCode::LE_READ_BUFFER_SIZE_V2)) {
-      hci_->EnqueueCommand(
+      read_live_capability(
           LeReadBufferSizeV2Builder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_buffer_size_v2_handler));
+          common::BindOnce(
+              &Controller::impl::le_read_buffer_size_v2_handler, common::Unretained(this)));
     } else {
-      hci_->EnqueueCommand(
+      read_live_capability(
           LeReadBufferSizeV1Builder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_buffer_size_handler));
+          common::BindOnce(
+              &Controller::impl::le_read_buffer_size_handler, common::Unretained(this)));
     }
 
     if (is_supported(OpCode::READ_LOCAL_SUPPORTED_CODECS_V1)) {
-      hci_->EnqueueCommand(
+      read_capability(
           ReadLocalSupportedCodecsV1Builder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::read_local_supported_codecs_v1_handler));
+          common::BindOnce(
+              &Controller::impl::read_local_supported_codecs_v1_handler, common::Unretained(this)));
     }
 
-    hci_->EnqueueCommand(
+    read_capability(
         LeReadFilterAcceptListSizeBuilder::Create(),
-        handler->BindOnceOn(this, &Controller::impl::le_read_accept_list_size_handler));
+        common::BindOnce(
+            &Controller::impl::le_read_accept_list_size_handler, common::Unretained(this)));
 
     if (is_supported(OpCode::LE_READ_RESOLVING_LIST_SIZE) && module_.SupportsBlePrivacy()) {
-      hci_->EnqueueCommand(
+      read_capability(
           LeReadResolvingListSizeBuilder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_resolving_list_size_handler));
+          common::BindOnce(
+              &Controller::impl::le_read_resolving_list_size_handler, common::Unretained(this)));
     } else {
       log::info("LE_READ_RESOLVING_LIST_SIZE not supported, defaulting to 0");
       le_resolving_list_size_ = 0;
     }
 
     if (is_supported(OpCode::LE_READ_MAXIMUM_DATA_LENGTH) && module_.SupportsBleDataPacketLengthExtension()) {
-      hci_->EnqueueCommand(LeReadMaximumDataLengthBuilder::Create(),
-                           handler->BindOnceOn(this, &Controller::impl::le_read_maximum_data_length_handler));
+      read_capability(
+          LeReadMaximumDataLengthBuilder::Create(),
+          common::BindOnce(
+              &Controller::impl::le_read_maximum_data_length_handler, common::Unretained(this)));
     } else {
       log::info("LE_READ_MAXIMUM_DATA_LENGTH not supported, defaulting to 0");
       le_maximum_data_length_.supported_max_rx_octets_ = 0;
@@ -156,19 +200,23 @@ struct Controller::impl {
           handler->BindOnceOn(
               this, &Controller::impl::write_secure_connections_host_support_complete_handler));
     }
+    // The host writes the suggested default data length, it is not a capability of the controller
     if (is_supported(OpCode::LE_READ_SUGGESTED_DEFAULT_DATA_LENGTH) && module_.SupportsBleDataPacketLengthExtension()) {
       hci_->EnqueueCommand(
           LeReadSuggestedDefaultDataLengthBuilder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_suggested_default_data_length_handler));
+          handler->BindOnceOn(
+              this, &Controller::impl::le_read_suggested_default_data_length_handler));
     } else {
       log::info("LE_READ_SUGGESTED_DEFAULT_DATA_LENGTH not supported, defaulting to 27 (0x1B)");
       le_suggested_default_data_length_ = 27;
     }
 
     if (is_supported(OpCode::LE_READ_MAXIMUM_ADVERTISING_DATA_LENGTH) && module_.SupportsBleExtendedAdvertising()) {
-      hci_->EnqueueCommand(
+      read_capability(
           LeReadMaximumAdvertisingDataLengthBuilder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_maximum_advertising_data_length_handler));
+          common::BindOnce(
+              &Controller::impl::le_read_maximum_advertising_data_length_handler,
+              common::Unretained(this)));
     } else {
       log::info("LE_READ_MAXIMUM_ADVERTISING_DATA_LENGTH not supported, defaulting to 31 (0x1F)");
       le_maximum_advertising_data_length_ = 31;
@@ -176,9 +224,11 @@ struct Controller::impl {
 
     if (is_supported(OpCode::LE_READ_NUMBER_OF_SUPPORTED_ADVERTISING_SETS) &&
         module_.SupportsBleExtendedAdvertising()) {
-      hci_->EnqueueCommand(
+      read_capability(
           LeReadNumberOfSupportedAdvertisingSetsBuilder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_number_of_supported_advertising_sets_handler));
+          common::BindOnce(
+              &Controller::impl::le_read_number_of_supported_advertising_sets_handler,
+              common::Unretained(this)));
     } else {
       log::info("LE_READ_NUMBER_OF_SUPPORTED_ADVERTISING_SETS not supported, defaulting to 1");
       le_number_supported_advertising_sets_ = 1;
@@ -186,9 +236,11 @@ struct Controller::impl {
 
     if (is_supported(OpCode::LE_READ_PERIODIC_ADVERTISER_LIST_SIZE) &&
         module_.SupportsBlePeriodicAdvertising()) {
-      hci_->EnqueueCommand(
+      read_capability(
           LeReadPeriodicAdvertiserListSizeBuilder::Create(),
-          handler->BindOnceOn(this, &Controller::impl::le_read_periodic_advertiser_list_size_handler));
+          common::BindOnce(
+              &Controller::impl::le_read_periodic_advertiser_list_size_handler,
+              common::Unretained(this)));
     } else {
       log::info("LE_READ_PERIODIC_ADVERTISER_LIST_SIZE not supported, defaulting to 0");
       le_periodic_advertiser_list_size_ = 0;
@@ -231,11 +283,11 @@ struct Controller::impl {
       // More commands can be enqueued from le_get_vendor_capabilities_handler
       std::promise<void> vendor_promise;
       auto vendor_future = vendor_promise.get_future();
-      hci_->EnqueueCommand(
+      read_capability(
           LeGetVendorCapabilitiesBuilder::Create(),
-          handler->BindOnceOn(
-              this,
+          common::BindOnce(
               &Controller::impl::le_get_vendor_capabilities_handler,
+              common::Unretained(this),
               std::move(vendor_promise)));
       vendor_future.wait();
     } else {
@@ -249,12 +301,203 @@ struct Controller::impl {
         ReadBdAddrBuilder::Create(),
         handler->BindOnceOn(this, &Controller::impl::read_controller_mac_address_handler, std::move(promise)));
     future.wait();
+
+    size_t snapshot_hits = finish_snapshot();
+    log::info(
+        "Controller ready in {} ms, {} capabilities replayed from its snapshot",
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time)
+            .count(),
+        snapshot_hits);
   }
 
   void Stop() {
+    // Ends the verification of the snapshot, which may still be waiting for the controller
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    stopping_ = true;
+    snapshot_.reset();
     hci_ = nullptr;
   }
 
+  // Starts recording the capabilities of the identified controller, and loads its snapshot
+  void load_snapshot() {
+    if (!os::GetSystemPropertyBool(kPropertySnapshotEnabled, kDefaultSnapshotEnabled)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    ControllerSnapshot::Identity identity{mac_address_, local_version_information_};
+    recording_.emplace(identity);
+    snapshot_hits_ = 0;
+    replayed_commands_.clear();
+    snapshot_stale_ = false;
+    snapshot_ = ControllerSnapshot::Load(ControllerSnapshotPath());
+    if (snapshot_.has_value() && !(snapshot_->GetIdentity() == identity)) {
+      log::info("Ignoring the snapshot of another controller");
+      snapshot_.reset();
+    }
+  }
+
+  // Reads a capability of the controller, or replays the response recorded in its snapshot on the
+  // module handler. After the first read that isn't in the snapshot, the following ones all go to
+  // the controller, so that their handlers still run in order.
+  void read_capability(
+      std::unique_ptr<CommandBuilder> command,
+      common::OnceCallback<void(CommandCompleteView)> on_complete) {
+    std::vector<uint8_t> bytes;
+    {
+      std::lock_guard<std::mutex> lock(snapshot_mutex_);
+      if (recording_.has_value()) {
+        bytes = ControllerSnapshot::SerializeCommand(*command);
+      }
+      if (snapshot_.has_value()) {
+        if (auto response = snapshot_->Find(bytes)) {
+          replayed_commands_.push_back(bytes);
+          recording_->Record(std::move(bytes), *response);
+          snapshot_hits_++;
+          module_.GetHandler()->Post(common::BindOnce(std::move(on_complete), *response));
+          return;
+        }
+        log::info(
+            "{} is not in the controller snapshot",
+            OpCodeText(static_cast<OpCode>(bytes[0] | bytes[1] << 8)));
+        snapshot_.reset();
+      }
+    }
+    hci_->EnqueueCommand(
+        std::move(command),
+        module_.GetHandler()->BindOnceOn(
+            this, &Controller::impl::on_capability_read, std::move(bytes), std::move(on_complete)));
+  }
+
+  void on_capability_read(
+      std::vector<uint8_t> command,
+      common::OnceCallback<void(CommandCompleteView)> on_complete,
+      CommandCompleteView view) {
+    {
+      std::lock_guard<std::mutex> lock(snapshot_mutex_);
+      if (recording_.has_value()) {
+        recording_->Record(std::move(command), view);
+      }
+    }
+    std::move(on_complete).Run(view);
+  }
+
+  // Reads a capability the session can't run with a stale value of, e.g. the buffer sizes that the
+  // ACL credits are set from, from the controller. Its answer is recorded for the next snapshot,
+  // and compared with the current one before Start() returns.
+  void read_live_capability(
+      std::unique_ptr<CommandBuilder> command,
+      common::OnceCallback<void(CommandCompleteView)> on_complete) {
+    std::vector<uint8_t> bytes;
+    {
+      std::lock_guard<std::mutex> lock(snapshot_mutex_);
+      if (recording_.has_value()) {
+        bytes = ControllerSnapshot::SerializeCommand(*command);
+      }
+    }
+    hci_->EnqueueCommand(
+        std::move(command),
+        module_.GetHandler()->BindOnceOn(
+            this,
+            &Controller::impl::on_live_capability_read,
+            std::move(bytes),
+            std::move(on_complete)));
+  }
+
+  void on_live_capability_read(
+      std::vector<uint8_t> command,
+      common::OnceCallback<void(CommandCompleteView)> on_complete,
+      CommandCompleteView view) {
+    {
+      std::lock_guard<std::mutex> lock(snapshot_mutex_);
+      if (snapshot_.has_value() && snapshot_->Find(command).has_value() &&
+          !snapshot_->Matches(command, view)) {
+        log::warn(
+            "Controller changed its answer to {}, discarding its snapshot",
+            OpCodeText(view.GetCommandOpCode()));
+        snapshot_stale_ = true;
+      }
+      if (recording_.has_value()) {
+        recording_->Record(std::move(command), view);
+      }
+    }
+    std::move(on_complete).Run(view);
+  }
+
+  // Saves the capabilities read from the controller, or verifies the snapshot they were all
+  // replayed from. Returns the number of capabilities replayed.
+  size_t finish_snapshot() {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    if (!recording_.has_value()) {
+      return 0;
+    }
+    if (snapshot_stale_) {
+      // The capabilities already replayed are kept for this session, the next one reads them all
+      os::RemoveFile(ControllerSnapshotPath());
+      snapshot_.reset();
+    } else if (snapshot_.has_value()) {
+      module_.GetHandler()->Post(common::BindOnce(
+          &Controller::impl::verify_snapshot,
+          common::Unretained(this),
+          std::move(replayed_commands_)));
+    } else if (!recording_->Save(ControllerSnapshotPath())) {
+      log::warn("Unable to save the controller snapshot");
+    }
+    recording_.reset();
+    return snapshot_hits_;
+  }
+
+  // Reads the replayed capabilities again, one at a time so that the commands of the other modules
+  // aren't held back. A controller that doesn't answer like its snapshot gets read in full at the
+  // next start.
+  void verify_snapshot(std::vector<std::vector<uint8_t>> commands) {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    if (stopping_ || !snapshot_.has_value()) {
+      return;
+    }
+    if (commands.empty()) {
+      log::info("Controller snapshot verified");
+      return;
+    }
+    std::vector<uint8_t> command = std::move(commands.back());
+    commands.pop_back();
+    auto view = CommandView::Create(packet::PacketView<packet::kLittleEndian>(
+        std::make_shared<std::vector<uint8_t>>(command)));
+    ASSERT(view.IsValid());
+    auto payload = view.GetPayload();
+    hci_->EnqueueCommand(
+        CommandBuilder::Create(
+            view.GetOpCode(),
+            std::make_unique<packet::RawBuilder>(
+                std::vector<uint8_t>(payload.begin(), payload.end()))),
+        module_.GetHandler()->BindOnceOn(
+            this,
+            &Controller::impl::on_snapshot_capability_verified,
+            std::move(command),
+            std::move(commands)));
+  }
+
+  void on_snapshot_capability_verified(
+      std::vector<uint8_t> command,
+      std::vector<std::vector<uint8_t>> remaining,
+      CommandCompleteView view) {
+    {
+      std::lock_guard<std::mutex> lock(snapshot_mutex_);
+      if (stopping_ || !snapshot_.has_value()) {
+        return;
+      }
+      if (!snapshot_->Matches(command, view)) {
+        log::error(
+            "Controller changed its answer to {}, discarding its snapshot",
+            OpCodeText(view.GetCommandOpCode()));
+        os::RemoveFile(ControllerSnapshotPath());
+        snapshot_.reset();
+        return;
+      }
+    }
+    verify_snapshot(std::move(remaining));
+  }
+
   void NumberOfCompletedPackets(EventView event) {
     if (!acl_credits_callback_) {
       log::warn("Received event when AclManager is not listening");
@@ -364,10 +607,12 @@ struct Controller::impl {
     // Query all extended features
     if (page_number < complete_view.GetMaximumPageNumber()) {
       page_number++;
-      hci_->EnqueueCommand(
+      read_capability(
           ReadLocalExtendedFeaturesBuilder::Create(page_number),
-          module_.GetHandler()->BindOnceOn(this, &Controller::impl::read_local_extended_features_complete_handler,
-                                           std::move(promise)));
+          common::BindOnce(
+              &Controller::impl::read_local_extended_features_complete_handler,
+              common::Unretained(this),
+              std::move(promise)));
     } else {
       promise.set_value();
     }
@@ -685,11 +930,11 @@ struct Controller::impl {
       }
 
       if (vendor_capabilities_.dynamic_audio_buffer_support_) {
-        hci_->EnqueueCommand(
+        read_capability(
             DabGetAudioBufferTimeCapabilityBuilder::Create(),
-            module_.GetHandler()->BindOnceOn(
-                this,
+            common::BindOnce(
                 &Controller::impl::le_get_dynamic_audio_buffer_support_handler,
+                common::Unretained(this),
                 std::move(vendor_promise)));
         return;
       }
@@ -700,11 +945,11 @@ struct Controller::impl {
         vendor_promise.set_value();
         return;
       }
-      hci_->EnqueueCommand(
+      read_capability(
           DabGetAudioBufferTimeCapabilityBuilder::Create(),
-          module_.GetHandler()->BindOnceOn(
-              this,
+          common::BindOnce(
               &Controller::impl::le_get_dynamic_audio_buffer_support_handler,
+              common::Unretained(this),
               std::move(vendor_promise)));
     }
   }
@@ -1228,6 +1473,19 @@ struct Controller::impl {
 
   HciLayer* hci_;
 
+  std::mutex snapshot_mutex_;
+  // Snapshot replayed while starting, dropped at the first capability it doesn't have
+  std::optional<ControllerSnapshot> snapshot_;
+  // Capabilities read while starting, for the next snapshot
+  std::optional<ControllerSnapshot> recording_;
+  size_t snapshot_hits_{};
+  // Commands answered from the snapshot, verified with the controller once started
+  std::vector<std::vector<uint8_t>> replayed_commands_;
+  // Whether a capability read from the controller while starting differs from the snapshot
+  bool snapshot_stale_{};
+  // Set by Stop(), once the snapshot must no longer be verified with the controller
+  bool stopping_{};
+
   CompletedAclPacketsCallback acl_credits_callback_{};
   CompletedAclPacketsCallback acl_monitor_credits_callback_{};
   LocalVersionInformation local_version_information_{};
@@ -1591,6 +1849,39 @@ std::string Controller::ToString() const {
   return "Controller";
 }
 
+static flatbuffers::Offset<LatencyHistogramData> DumpLatencyHistogram(
+    flatbuffers::FlatBufferBuilder* fb_builder, const HciCommandStats::LatencyHistogram& histogram) {
+  std::vector<uint32_t> buckets(histogram.buckets.begin(), histogram.buckets.end());
+  return CreateLatencyHistogramData(
+      *fb_builder, histogram.count, histogram.total_us, histogram.max_us, fb_builder->CreateVector(buckets));
+}
+
+static flatbuffers::Offset<CommandStatsData> DumpCommandStats(
+    flatbuffers::FlatBufferBuilder* fb_builder, const HciCommandStats& command_stats) {
+  auto snapshot = command_stats.GetSnapshot();
+
+  std::vector<uint32_t> bucket_upper_bounds(
+      HciCommandStats::kLatencyBucketUpperBoundsUs.begin(), HciCommandStats::kLatencyBucketUpperBoundsUs.end());
+  std::vector<flatbuffers::Offset<CommandLatencyData>> command_latencies;
+  for (const auto& [op_code, latency] : snapshot.latencies) {
+    command_latencies.push_back(CreateCommandLatencyData(
+        *fb_builder,
+        fb_builder->CreateString(OpCodeText(op_code)),
+        DumpLatencyHistogram(fb_builder, latency.status),
+        DumpLatencyHistogram(fb_builder, latency.complete)));
+  }
+
+  return CreateCommandStatsData(
+      *fb_builder,
+      fb_builder->CreateVector(bucket_upper_bounds),
+      fb_builder->CreateVector(command_latencies),
+      snapshot.credit_starvation_count,
+      snapshot.credit_starvation_total_us,
+      snapshot.max_queue_depth,
+      snapshot.timeouts,
+      fb_builder->CreateString(command_stats.ExportChromeTrace()));
+}
+
 void Controller::impl::Dump(
     std::promise<flatbuffers::Offset<ControllerData>> promise, flatbuffers::FlatBufferBuilder* fb_builder) const {
   ASSERT(fb_builder != nullptr);
@@ -1645,6 +1936,11 @@ void Controller::impl::Dump(
 
   auto extended_lmp_features_vector = fb_builder->CreateVector(extended_lmp_features_array_);
 
+  flatbuffers::Offset<CommandStatsData> command_stats_data;
+  if (hci_ != nullptr) {
+    command_stats_data = DumpCommandStats(fb_builder, hci_->GetCommandStats());
+  }
+
   // Create the root table
   ControllerDataBuilder builder(*fb_builder);
 
@@ -1670,6 +1966,7 @@ void Controller::impl::Dump(
   builder.add_le_local_supported_features(le_local_supported_features_);
   builder.add_le_supported_states(le_supported_states_);
   builder.add_vendor_capabilities(&vendor_capabilities_data);
+  builder.add_command_stats(command_stats_data);
 
   flatbuffers::Offset<ControllerData> dumpsys_data = builder.Finish();
   promise.set_value(dumpsys_data);
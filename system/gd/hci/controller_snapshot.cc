@@ -0,0 +1,237 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/controller_snapshot.h"
+
+#include <bluetooth/log.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "os/files.h"
+#include "os/parameter_provider.h"
+#include "packet/bit_inserter.h"
+#include "packet/packet_view.h"
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+constexpr char kMagic[] = {'B', 'T', 'C', 'S'};
+constexpr uint8_t kVersion = 1;
+constexpr char kSnapshotFileName[] = "bt_controller_snapshot";
+
+// Event code, parameter total length and Num_HCI_Command_Packets
+constexpr size_t kCommandCompleteHeaderSize = 3;
+
+void AppendUint8(std::string& data, uint8_t value) {
+  data.push_back(static_cast<char>(value));
+}
+
+void AppendUint16(std::string& data, uint16_t value) {
+  AppendUint8(data, value & 0xff);
+  AppendUint8(data, value >> 8);
+}
+
+void AppendBytes(std::string& data, const std::vector<uint8_t>& bytes) {
+  AppendUint16(data, bytes.size());
+  data.append(bytes.begin(), bytes.end());
+}
+
+// Reads little endian fields, failing on the first one past the end of the data
+class Reader {
+ public:
+  explicit Reader(const std::string& data) : data_(data) {}
+
+  bool ReadUint8(uint8_t* value) {
+    if (offset_ + 1 > data_.size()) return false;
+    *value = static_cast<uint8_t>(data_[offset_++]);
+    return true;
+  }
+
+  bool ReadUint16(uint16_t* value) {
+    uint8_t low, high;
+    if (!ReadUint8(&low) || !ReadUint8(&high)) return false;
+    *value = low | (high << 8);
+    return true;
+  }
+
+  bool ReadBytes(size_t length, uint8_t* bytes) {
+    if (offset_ + length > data_.size()) return false;
+    std::copy_n(data_.begin() + offset_, length, bytes);
+    offset_ += length;
+    return true;
+  }
+
+  bool ReadBytes(std::vector<uint8_t>* bytes) {
+    uint16_t length;
+    if (!ReadUint16(&length)) return false;
+    bytes->resize(length);
+    return ReadBytes(length, bytes->data());
+  }
+
+  bool AtEnd() const {
+    return offset_ == data_.size();
+  }
+
+ private:
+  const std::string& data_;
+  size_t offset_ = 0;
+};
+
+std::optional<CommandCompleteView> ToCommandComplete(const std::vector<uint8_t>& bytes) {
+  auto packet = packet::PacketView<packet::kLittleEndian>(
+      std::make_shared<std::vector<uint8_t>>(bytes));
+  auto view = CommandCompleteView::Create(EventView::Create(packet));
+  if (!view.IsValid()) {
+    return std::nullopt;
+  }
+  return view;
+}
+
+}  // namespace
+
+bool ControllerSnapshot::Identity::operator==(const Identity& other) const {
+  return address == other.address && version.hci_version_ == other.version.hci_version_ &&
+         version.hci_revision_ == other.version.hci_revision_ &&
+         version.lmp_version_ == other.version.lmp_version_ &&
+         version.manufacturer_name_ == other.version.manufacturer_name_ &&
+         version.lmp_subversion_ == other.version.lmp_subversion_;
+}
+
+std::optional<CommandCompleteView> ControllerSnapshot::Find(
+    const std::vector<uint8_t>& command) const {
+  auto record = records_.find(command);
+  if (record == records_.end()) {
+    return std::nullopt;
+  }
+  return ToCommandComplete(record->second);
+}
+
+void ControllerSnapshot::Record(std::vector<uint8_t> command, CommandCompleteView response) {
+  records_[std::move(command)] = std::vector<uint8_t>(response.begin(), response.end());
+}
+
+bool ControllerSnapshot::Matches(
+    const std::vector<uint8_t>& command, CommandCompleteView response) const {
+  auto record = records_.find(command);
+  if (record == records_.end()) {
+    return false;
+  }
+  const std::vector<uint8_t>& recorded = record->second;
+  std::vector<uint8_t> received(response.begin(), response.end());
+  if (recorded.size() != received.size() || recorded.size() < kCommandCompleteHeaderSize) {
+    return false;
+  }
+  return std::equal(
+      recorded.begin() + kCommandCompleteHeaderSize,
+      recorded.end(),
+      received.begin() + kCommandCompleteHeaderSize);
+}
+
+std::string ControllerSnapshot::Serialize() const {
+  std::string data(kMagic, sizeof(kMagic));
+  AppendUint8(data, kVersion);
+  data.append(identity_.address.address.begin(), identity_.address.address.end());
+  AppendUint8(data, static_cast<uint8_t>(identity_.version.hci_version_));
+  AppendUint16(data, identity_.version.hci_revision_);
+  AppendUint8(data, static_cast<uint8_t>(identity_.version.lmp_version_));
+  AppendUint16(data, identity_.version.manufacturer_name_);
+  AppendUint16(data, identity_.version.lmp_subversion_);
+  AppendUint16(data, records_.size());
+  for (const auto& [command, response] : records_) {
+    AppendBytes(data, command);
+    AppendBytes(data, response);
+  }
+  return data;
+}
+
+std::optional<ControllerSnapshot> ControllerSnapshot::Parse(const std::string& data) {
+  Reader reader(data);
+  char magic[sizeof(kMagic)];
+  uint8_t version;
+  if (!reader.ReadBytes(sizeof(magic), reinterpret_cast<uint8_t*>(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), kMagic) || !reader.ReadUint8(&version) ||
+      version != kVersion) {
+    return std::nullopt;
+  }
+
+  Identity identity;
+  uint8_t hci_version, lmp_version;
+  if (!reader.ReadBytes(Address::kLength, identity.address.address.data()) ||
+      !reader.ReadUint8(&hci_version) || !reader.ReadUint16(&identity.version.hci_revision_) ||
+      !reader.ReadUint8(&lmp_version) ||
+      !reader.ReadUint16(&identity.version.manufacturer_name_) ||
+      !reader.ReadUint16(&identity.version.lmp_subversion_)) {
+    return std::nullopt;
+  }
+  identity.version.hci_version_ = static_cast<HciVersion>(hci_version);
+  identity.version.lmp_version_ = static_cast<LmpVersion>(lmp_version);
+
+  ControllerSnapshot snapshot(identity);
+  uint16_t num_records;
+  if (!reader.ReadUint16(&num_records)) {
+    return std::nullopt;
+  }
+  for (uint16_t i = 0; i < num_records; i++) {
+    std::vector<uint8_t> command, response;
+    if (!reader.ReadBytes(&command) || !reader.ReadBytes(&response) ||
+        !ToCommandComplete(response).has_value()) {
+      return std::nullopt;
+    }
+    snapshot.records_[std::move(command)] = std::move(response);
+  }
+  if (!reader.AtEnd()) {
+    return std::nullopt;
+  }
+  return snapshot;
+}
+
+std::optional<ControllerSnapshot> ControllerSnapshot::Load(const std::string& path) {
+  if (!os::FileExists(path)) {
+    return std::nullopt;
+  }
+  auto data = os::ReadSmallFile(path);
+  if (!data.has_value()) {
+    return std::nullopt;
+  }
+  auto snapshot = Parse(*data);
+  if (!snapshot.has_value()) {
+    log::warn("Ignoring invalid controller snapshot {}", path);
+  }
+  return snapshot;
+}
+
+bool ControllerSnapshot::Save(const std::string& path) const {
+  return os::WriteToFile(path, Serialize());
+}
+
+std::vector<uint8_t> ControllerSnapshot::SerializeCommand(const CommandBuilder& command) {
+  std::vector<uint8_t> bytes;
+  bytes.reserve(command.size());
+  packet::BitInserter inserter(bytes);
+  command.Serialize(inserter);
+  return bytes;
+}
+
+std::string ControllerSnapshotPath() {
+  std::string config_path = os::ParameterProvider::ConfigFilePath();
+  return config_path.substr(0, config_path.rfind('/') + 1) + kSnapshotFileName;
+}
+
+}  // namespace hci
+}  // namespace bluetooth
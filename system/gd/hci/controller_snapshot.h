@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hci/address.h"
+#include "hci/hci_packets.h"
+
+namespace bluetooth {
+namespace hci {
+
+// Capabilities of a controller, kept as the Command Complete events of the commands that read
+// them, so that the controller module can start again without waiting for the reads.
+//
+// A snapshot only applies to the controller it was read from: the one with the same BD_ADDR and
+// local version information (HCI and LMP versions and subversions, manufacturer).
+class ControllerSnapshot {
+ public:
+  struct Identity {
+    Address address;
+    LocalVersionInformation version;
+
+    bool operator==(const Identity& other) const;
+  };
+
+  explicit ControllerSnapshot(Identity identity) : identity_(std::move(identity)) {}
+
+  const Identity& GetIdentity() const {
+    return identity_;
+  }
+
+  // Serialized commands, mapped to their Command Complete event
+  const std::map<std::vector<uint8_t>, std::vector<uint8_t>>& GetRecords() const {
+    return records_;
+  }
+
+  // Returns the response recorded for the serialized |command|
+  std::optional<CommandCompleteView> Find(const std::vector<uint8_t>& command) const;
+
+  void Record(std::vector<uint8_t> command, CommandCompleteView response);
+
+  // Whether |response| has the same op code and return parameters as the one recorded for
+  // |command|. The number of HCI command packets the controller allows isn't compared.
+  bool Matches(const std::vector<uint8_t>& command, CommandCompleteView response) const;
+
+  std::string Serialize() const;
+
+  // Returns std::nullopt if |data| isn't a snapshot of a known version
+  static std::optional<ControllerSnapshot> Parse(const std::string& data);
+
+  static std::optional<ControllerSnapshot> Load(const std::string& path);
+
+  bool Save(const std::string& path) const;
+
+  static std::vector<uint8_t> SerializeCommand(const CommandBuilder& command);
+
+ private:
+  Identity identity_;
+  std::map<std::vector<uint8_t>, std::vector<uint8_t>> records_;
+};
+
+// The snapshot is kept next to the config file
+std::string ControllerSnapshotPath();
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/controller_snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "packet/bit_inserter.h"
+#include "packet/packet_view.h"
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+const ControllerSnapshot::Identity kIdentity = {
+    Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06}),
+    LocalVersionInformation(HciVersion::V_5_3, 0x1234, LmpVersion::V_5_3, 0x000f, 0x5678),
+};
+
+CommandCompleteView ToView(std::unique_ptr<EventBuilder> event) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  packet::BitInserter inserter(*bytes);
+  event->Serialize(inserter);
+  auto view = CommandCompleteView::Create(
+      EventView::Create(packet::PacketView<packet::kLittleEndian>(bytes)));
+  EXPECT_TRUE(view.IsValid());
+  return view;
+}
+
+CommandCompleteView BufferSizeComplete(uint8_t num_hci_command_packets, uint16_t acl_buffers) {
+  return ToView(ReadBufferSizeCompleteBuilder::Create(
+      num_hci_command_packets, ErrorCode::SUCCESS, 1021, 64, acl_buffers, 8));
+}
+
+std::vector<uint8_t> ReadBufferSize() {
+  return ControllerSnapshot::SerializeCommand(*ReadBufferSizeBuilder::Create());
+}
+
+TEST(ControllerSnapshotTest, find_recorded_response) {
+  ControllerSnapshot snapshot(kIdentity);
+  snapshot.Record(ReadBufferSize(), BufferSizeComplete(1, 12));
+
+  auto response = snapshot.Find(ReadBufferSize());
+  ASSERT_TRUE(response.has_value());
+  auto complete_view = ReadBufferSizeCompleteView::Create(*response);
+  ASSERT_TRUE(complete_view.IsValid());
+  EXPECT_EQ(complete_view.GetTotalNumAclDataPackets(), 12);
+
+  EXPECT_FALSE(snapshot.Find(ControllerSnapshot::SerializeCommand(
+                                 *ReadLocalExtendedFeaturesBuilder::Create(0x01)))
+                   .has_value());
+}
+
+TEST(ControllerSnapshotTest, commands_differing_by_parameters) {
+  ControllerSnapshot snapshot(kIdentity);
+  auto page_0 = ControllerSnapshot::SerializeCommand(*ReadLocalExtendedFeaturesBuilder::Create(0));
+  auto page_1 = ControllerSnapshot::SerializeCommand(*ReadLocalExtendedFeaturesBuilder::Create(1));
+  snapshot.Record(page_0, ToView(ReadLocalExtendedFeaturesCompleteBuilder::Create(
+                              1, ErrorCode::SUCCESS, 0, 1, 0x875b3fd8fe8ffeff)));
+
+  EXPECT_TRUE(snapshot.Find(page_0).has_value());
+  EXPECT_FALSE(snapshot.Find(page_1).has_value());
+}
+
+TEST(ControllerSnapshotTest, matches_ignores_command_credits) {
+  ControllerSnapshot snapshot(kIdentity);
+  snapshot.Record(ReadBufferSize(), BufferSizeComplete(1, 12));
+
+  EXPECT_TRUE(snapshot.Matches(ReadBufferSize(), BufferSizeComplete(5, 12)));
+  EXPECT_FALSE(snapshot.Matches(ReadBufferSize(), BufferSizeComplete(1, 13)));
+  EXPECT_FALSE(snapshot.Matches(
+      ControllerSnapshot::SerializeCommand(*ReadLocalNameBuilder::Create()),
+      BufferSizeComplete(1, 12)));
+}
+
+TEST(ControllerSnapshotTest, serialize_and_parse) {
+  ControllerSnapshot snapshot(kIdentity);
+  snapshot.Record(ReadBufferSize(), BufferSizeComplete(1, 12));
+
+  auto parsed = ControllerSnapshot::Parse(snapshot.Serialize());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_TRUE(parsed->GetIdentity() == kIdentity);
+  EXPECT_EQ(parsed->GetRecords(), snapshot.GetRecords());
+}
+
+TEST(ControllerSnapshotTest, parse_invalid_data) {
+  ControllerSnapshot snapshot(kIdentity);
+  snapshot.Record(ReadBufferSize(), BufferSizeComplete(1, 12));
+  std::string data = snapshot.Serialize();
+
+  EXPECT_FALSE(ControllerSnapshot::Parse("").has_value());
+  EXPECT_FALSE(ControllerSnapshot::Parse(data.substr(0, data.size() - 1)).has_value());
+  EXPECT_FALSE(ControllerSnapshot::Parse(data + '\0').has_value());
+  std::string other_version = data;
+  other_version[4]++;
+  EXPECT_FALSE(ControllerSnapshot::Parse(other_version).has_value());
+}
+
+TEST(ControllerSnapshotTest, identity) {
+  ControllerSnapshot::Identity other_address = kIdentity;
+  other_address.address = Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x07});
+  ControllerSnapshot::Identity other_firmware = kIdentity;
+  other_firmware.version.lmp_subversion_++;
+
+  EXPECT_TRUE(kIdentity == kIdentity);
+  EXPECT_FALSE(kIdentity == other_address);
+  EXPECT_FALSE(kIdentity == other_firmware);
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
@@ -25,12 +25,15 @@
 #include <future>
 #include <memory>
 #include <sstream>
+#include <thread>
 
 #include "common/bind.h"
 #include "common/init_flags.h"
 #include "hci/address.h"
+#include "hci/controller_snapshot.h"
 #include "hci/hci_layer_fake.h"
 #include "module_dumper.h"
+#include "os/files.h"
 #include "os/thread.h"
 #include "packet/raw_builder.h"
 
@@ -93,7 +96,8 @@ class HciLayerFakeForController : public HciLayerFake {
     std::unique_ptr<packet::BasePacketBuilder> event_builder;
     switch (command.GetOpCode()) {
       case (OpCode::READ_LOCAL_NAME): {
-        std::array<uint8_t, 248> local_name = {'D', 'U', 'T', '\0'};
+        std::array<uint8_t, 248> local_name{};
+        std::copy(local_name_.begin(), local_name_.end(), local_name.begin());
         event_builder = ReadLocalNameCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, local_name);
       } break;
       case (OpCode::READ_LOCAL_VERSION_INFORMATION): {
@@ -142,7 +146,7 @@ class HciLayerFakeForController : public HciLayerFake {
             total_num_synchronous_data_packets);
       } break;
       case (OpCode::READ_BD_ADDR): {
-        event_builder = ReadBdAddrCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, Address::kAny);
+        event_builder = ReadBdAddrCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, bd_addr_);
       } break;
       case (OpCode::LE_READ_BUFFER_SIZE_V1): {
         LeBufferSize le_buffer_size;
@@ -167,6 +171,19 @@ class HciLayerFakeForController : public HciLayerFake {
         event_builder =
             LeReadMaximumDataLengthCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, le_maximum_data_length);
       } break;
+      case (OpCode::LE_READ_FILTER_ACCEPT_LIST_SIZE): {
+        event_builder =
+            LeReadFilterAcceptListSizeCompleteBuilder::Create(
+                num_packets, ErrorCode::SUCCESS, filter_accept_list_size_);
+      } break;
+      case (OpCode::LE_READ_RESOLVING_LIST_SIZE): {
+        event_builder =
+            LeReadResolvingListSizeCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, 0x10);
+      } break;
+      case (OpCode::LE_READ_SUGGESTED_DEFAULT_DATA_LENGTH): {
+        event_builder = LeReadSuggestedDefaultDataLengthCompleteBuilder::Create(
+            num_packets, ErrorCode::SUCCESS, 0xfb, 0x0848);
+      } break;
       case (OpCode::LE_READ_MAXIMUM_ADVERTISING_DATA_LENGTH): {
         event_builder =
             LeReadMaximumAdvertisingDataLengthCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, 0x0672);
@@ -271,9 +288,12 @@ class HciLayerFakeForController : public HciLayerFake {
   }
 
   std::unique_ptr<EventBuilder> vendor_capabilities_ = nullptr;
+  std::string local_name_ = "DUT";
+  Address bd_addr_ = Address::kAny;
+  uint8_t filter_accept_list_size_ = 0x20;
   constexpr static uint16_t acl_data_packet_length = 1024;
   constexpr static uint8_t synchronous_data_packet_length = 60;
-  constexpr static uint16_t total_num_acl_data_packets = 10;
+  uint16_t total_num_acl_data_packets = 10;
   constexpr static uint16_t total_num_synchronous_data_packets = 12;
   uint64_t event_mask = 0;
   uint64_t le_event_mask = 0;
@@ -285,6 +305,7 @@ class ControllerTest : public ::testing::Test {
   void SetUp() override {
     feature_spec_version = feature_spec_version_;
     bluetooth::common::InitFlags::SetAllForTesting();
+    RemoveSnapshot();
     test_hci_layer_ = new HciLayerFakeForController;
     test_hci_layer_->vendor_capabilities_ = std::move(vendor_capabilities_);
     vendor_capabilities_.reset();
@@ -296,6 +317,14 @@ class ControllerTest : public ::testing::Test {
 
   void TearDown() override {
     fake_registry_.StopAll();
+    RemoveSnapshot();
+  }
+
+  // The controllers of all tests have the same identity
+  static void RemoveSnapshot() {
+    if (os::FileExists(ControllerSnapshotPath())) {
+      os::RemoveFile(ControllerSnapshotPath());
+    }
   }
 
   TestModuleRegistry fake_registry_;
@@ -643,6 +672,67 @@ TEST_F(ControllerTest, leRandTest) {
   ASSERT_EQ(kRandomNumber, le_rand_set_future.get());
 }
 
+TEST_F(ControllerTest, start_from_snapshot) {
+  ASSERT_TRUE(os::FileExists(ControllerSnapshotPath()));
+
+  TestModuleRegistry registry;
+  auto hci_layer = new HciLayerFakeForController;
+  hci_layer->local_name_ = "Renamed";
+  registry.InjectTestModule(&HciLayer::Factory, hci_layer);
+  registry.Start<Controller>(&registry.GetTestThread());
+  auto controller = registry.GetModuleUnderTest<Controller>();
+
+  // The name is written by the host, it is always read from the controller
+  ASSERT_EQ(controller->GetLocalName(), "Renamed");
+  ASSERT_EQ(controller->GetNumAclPacketBuffers(), hci_layer->total_num_acl_data_packets);
+  ASSERT_EQ(controller->GetLeFilterAcceptListSize(), hci_layer->filter_accept_list_size_);
+
+  // Nothing changed, the verification in the background keeps the snapshot
+  registry.StopAll();
+  ASSERT_TRUE(os::FileExists(ControllerSnapshotPath()));
+}
+
+TEST_F(ControllerTest, snapshot_with_other_buffer_sizes) {
+  TestModuleRegistry registry;
+  auto hci_layer = new HciLayerFakeForController;
+  hci_layer->total_num_acl_data_packets = 4;
+  registry.InjectTestModule(&HciLayer::Factory, hci_layer);
+  registry.Start<Controller>(&registry.GetTestThread());
+
+  // The buffer sizes give the ACL credits, they are never replayed
+  ASSERT_EQ(registry.GetModuleUnderTest<Controller>()->GetNumAclPacketBuffers(), 4);
+  ASSERT_FALSE(os::FileExists(ControllerSnapshotPath()));
+  registry.StopAll();
+}
+
+TEST_F(ControllerTest, snapshot_with_other_capabilities) {
+  TestModuleRegistry registry;
+  auto hci_layer = new HciLayerFakeForController;
+  hci_layer->filter_accept_list_size_ = 0x10;
+  registry.InjectTestModule(&HciLayer::Factory, hci_layer);
+  registry.Start<Controller>(&registry.GetTestThread());
+
+  // Replayed from the snapshot, the verification in the background discards it
+  ASSERT_EQ(registry.GetModuleUnderTest<Controller>()->GetLeFilterAcceptListSize(), 0x20);
+  for (int i = 0; i < 100 && os::FileExists(ControllerSnapshotPath()); i++) {
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_FALSE(os::FileExists(ControllerSnapshotPath()));
+  registry.StopAll();
+}
+
+TEST_F(ControllerTest, snapshot_of_another_controller) {
+  TestModuleRegistry registry;
+  auto hci_layer = new HciLayerFakeForController;
+  hci_layer->local_name_ = "Other";
+  hci_layer->bd_addr_ = Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  registry.InjectTestModule(&HciLayer::Factory, hci_layer);
+  registry.Start<Controller>(&registry.GetTestThread());
+
+  ASSERT_EQ(registry.GetModuleUnderTest<Controller>()->GetLocalName(), "Other");
+  registry.StopAll();
+}
+
 TEST_F(ControllerTest, Dumpsys) {
   ModuleDumper dumper(STDOUT_FILENO, fake_registry_, title);
 
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/hci_command_stats.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+int64_t ToMicroseconds(HciCommandStats::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+int64_t ToMicroseconds(HciCommandStats::Clock::time_point time_point) {
+  return ToMicroseconds(time_point.time_since_epoch());
+}
+
+// Trace thread ids. Each opcode gets its own track so that pipelined commands
+// do not overlap.
+constexpr int kCreditsTid = 0x10000;
+constexpr int kQueueTid = 0x10001;
+
+}  // namespace
+
+void HciCommandStats::LatencyHistogram::Add(uint32_t latency_us) {
+  auto bucket = std::lower_bound(
+      kLatencyBucketUpperBoundsUs.begin(), kLatencyBucketUpperBoundsUs.end(), latency_us);
+  buckets[bucket - kLatencyBucketUpperBoundsUs.begin()]++;
+  count++;
+  total_us += latency_us;
+  max_us = std::max(max_us, latency_us);
+}
+
+void HciCommandStats::OnCommandSent(OpCode op_code, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  outstanding_commands_[op_code] = now;
+}
+
+void HciCommandStats::OnCommandResponse(OpCode op_code, bool is_status, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto command = outstanding_commands_.find(op_code);
+  if (command == outstanding_commands_.end()) {
+    return;
+  }
+  int64_t latency_us = std::max<int64_t>(ToMicroseconds(now - command->second), 0);
+  uint32_t clamped_latency_us =
+      static_cast<uint32_t>(std::min<int64_t>(latency_us, std::numeric_limits<uint32_t>::max()));
+  auto& latency = latencies_[op_code];
+  (is_status ? latency.status : latency.complete).Add(clamped_latency_us);
+  AddTimelineEvent(
+      is_status ? TimelineEventType::COMMAND_STATUS : TimelineEventType::COMMAND_COMPLETE,
+      op_code,
+      command->second,
+      latency_us);
+  outstanding_commands_.erase(command);
+}
+
+void HciCommandStats::OnCommandTimeout(OpCode op_code, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  timeouts_++;
+  AddTimelineEvent(TimelineEventType::COMMAND_TIMEOUT, op_code, now, 0);
+  outstanding_commands_.clear();
+}
+
+void HciCommandStats::OnQueueUpdate(bool starved_of_credits, size_t queue_depth, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (starved_of_credits && !starved_of_credits_) {
+    starvation_start_ = now;
+    credit_starvation_count_++;
+  } else if (!starved_of_credits && starved_of_credits_) {
+    int64_t starvation_us = std::max<int64_t>(ToMicroseconds(now - starvation_start_), 0);
+    credit_starvation_total_us_ += starvation_us;
+    AddTimelineEvent(TimelineEventType::CREDIT_STARVATION, OpCode::NONE, starvation_start_, starvation_us);
+  }
+  starved_of_credits_ = starved_of_credits;
+
+  if (queue_depth != queue_depth_) {
+    queue_depth_ = queue_depth;
+    max_queue_depth_ = std::max<uint32_t>(max_queue_depth_, queue_depth);
+    AddTimelineEvent(TimelineEventType::QUEUE_DEPTH, OpCode::NONE, now, queue_depth);
+  }
+}
+
+HciCommandStats::Snapshot HciCommandStats::GetSnapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Snapshot snapshot;
+  snapshot.latencies = latencies_;
+  snapshot.credit_starvation_count = credit_starvation_count_;
+  snapshot.credit_starvation_total_us = credit_starvation_total_us_;
+  if (starved_of_credits_) {
+    snapshot.credit_starvation_total_us += std::max<int64_t>(ToMicroseconds(Clock::now() - starvation_start_), 0);
+  }
+  snapshot.max_queue_depth = max_queue_depth_;
+  snapshot.timeouts = timeouts_;
+  return snapshot;
+}
+
+void HciCommandStats::AddTimelineEvent(
+    TimelineEventType type, OpCode op_code, Clock::time_point timestamp, int64_t value) {
+  TimelineEvent event{type, op_code, ToMicroseconds(timestamp), value};
+  if (timeline_.size() < kTimelineSize) {
+    timeline_.push_back(event);
+  } else {
+    timeline_[timeline_next_] = event;
+  }
+  timeline_next_ = (timeline_next_ + 1) % kTimelineSize;
+}
+
+std::string HciCommandStats::ExportChromeTrace() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::stringstream ss;
+  ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  size_t start = timeline_.size() < kTimelineSize ? 0 : timeline_next_;
+  for (size_t i = 0; i < timeline_.size(); i++) {
+    const TimelineEvent& event = timeline_[(start + i) % timeline_.size()];
+    if (!first) {
+      ss << ",";
+    }
+    first = false;
+    ss << "{\"pid\":1,\"ts\":" << event.timestamp_us << ",";
+    switch (event.type) {
+      case TimelineEventType::COMMAND_STATUS:
+      case TimelineEventType::COMMAND_COMPLETE:
+        ss << "\"ph\":\"X\",\"cat\":\"command\",\"name\":\"" << OpCodeText(event.op_code)
+           << "\",\"tid\":" << static_cast<uint16_t>(event.op_code) << ",\"dur\":" << event.value
+           << ",\"args\":{\"response\":\""
+           << (event.type == TimelineEventType::COMMAND_STATUS ? "status" : "complete") << "\"}";
+        break;
+      case TimelineEventType::COMMAND_TIMEOUT:
+        ss << "\"ph\":\"i\",\"s\":\"g\",\"cat\":\"command\",\"name\":\"timeout " << OpCodeText(event.op_code)
+           << "\",\"tid\":" << static_cast<uint16_t>(event.op_code);
+        break;
+      case TimelineEventType::CREDIT_STARVATION:
+        ss << "\"ph\":\"X\",\"cat\":\"credits\",\"name\":\"credit starvation\",\"tid\":" << kCreditsTid
+           << ",\"dur\":" << event.value;
+        break;
+      case TimelineEventType::QUEUE_DEPTH:
+        ss << "\"ph\":\"C\",\"cat\":\"queue\",\"name\":\"command queue\",\"tid\":" << kQueueTid
+           << ",\"args\":{\"depth\":" << event.value << "}";
+        break;
+    }
+    ss << "}";
+  }
+  ss << "]}";
+  return ss.str();
+}
+
+}  // namespace hci
+}  // namespace bluetooth
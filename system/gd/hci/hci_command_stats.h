@@ -0,0 +1,134 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "hci/hci_packets.h"
+
+namespace bluetooth {
+namespace hci {
+
+/// Records how long the controller takes to answer HCI commands, how long
+/// commands wait for Num_HCI_Command_Packets credits, and how deep the command
+/// queue gets. The latest events are also kept in a fixed size timeline that
+/// can be exported in the Chrome trace event format.
+///
+/// Updated from the HCI layer handler and read from the dumpsys thread.
+class HciCommandStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Upper bounds of the latency histogram buckets. The last bucket holds
+  /// everything above the last bound.
+  static constexpr std::array<uint32_t, 13> kLatencyBucketUpperBoundsUs = {
+      250, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 2000000};
+  static constexpr size_t kNumLatencyBuckets = kLatencyBucketUpperBoundsUs.size() + 1;
+
+  /// Number of events kept in the timeline.
+  static constexpr size_t kTimelineSize = 512;
+
+  struct LatencyHistogram {
+    std::array<uint32_t, kNumLatencyBuckets> buckets{};
+    uint32_t count{0};
+    uint64_t total_us{0};
+    uint32_t max_us{0};
+
+    void Add(uint32_t latency_us);
+  };
+
+  /// Latency from sending a command to its Command Status or Command Complete
+  /// event.
+  struct CommandLatency {
+    LatencyHistogram status;
+    LatencyHistogram complete;
+  };
+
+  struct Snapshot {
+    std::map<OpCode, CommandLatency> latencies;
+    uint32_t credit_starvation_count{0};
+    uint64_t credit_starvation_total_us{0};
+    uint32_t max_queue_depth{0};
+    uint32_t timeouts{0};
+  };
+
+  HciCommandStats() = default;
+  HciCommandStats(const HciCommandStats&) = delete;
+  HciCommandStats& operator=(const HciCommandStats&) = delete;
+
+  void OnCommandSent(OpCode op_code, Clock::time_point now = Clock::now());
+
+  /// Records the latency of |op_code| when it was sent and is now answered.
+  void OnCommandResponse(OpCode op_code, bool is_status, Clock::time_point now = Clock::now());
+
+  /// Forgets the outstanding commands after an HCI timeout.
+  void OnCommandTimeout(OpCode op_code, Clock::time_point now = Clock::now());
+
+  /// Updates the state of the command queue: whether queued commands are
+  /// waiting for credits from the controller, and how many are queued.
+  void OnQueueUpdate(bool starved_of_credits, size_t queue_depth, Clock::time_point now = Clock::now());
+
+  Snapshot GetSnapshot() const;
+
+  /// Returns the timeline as a Chrome trace event JSON document, which can be
+  /// loaded in chrome://tracing or Perfetto.
+  std::string ExportChromeTrace() const;
+
+ private:
+  enum class TimelineEventType : uint8_t {
+    COMMAND_STATUS,
+    COMMAND_COMPLETE,
+    COMMAND_TIMEOUT,
+    CREDIT_STARVATION,
+    QUEUE_DEPTH,
+  };
+
+  struct TimelineEvent {
+    TimelineEventType type;
+    OpCode op_code;
+    int64_t timestamp_us;
+    // Duration for commands and starvation, depth for the queue.
+    int64_t value;
+  };
+
+  void AddTimelineEvent(TimelineEventType type, OpCode op_code, Clock::time_point timestamp, int64_t value);
+
+  mutable std::mutex mutex_;
+  std::map<OpCode, CommandLatency> latencies_;
+  std::map<OpCode, Clock::time_point> outstanding_commands_;
+
+  bool starved_of_credits_{false};
+  Clock::time_point starvation_start_;
+  uint32_t credit_starvation_count_{0};
+  uint64_t credit_starvation_total_us_{0};
+
+  size_t queue_depth_{0};
+  uint32_t max_queue_depth_{0};
+  uint32_t timeouts_{0};
+
+  std::vector<TimelineEvent> timeline_;
+  size_t timeline_next_{0};
+};
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/hci_command_stats.h"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+const HciCommandStats::Clock::time_point kStart = HciCommandStats::Clock::time_point(1s);
+
+TEST(HciCommandStatsTest, histogram_buckets) {
+  HciCommandStats::LatencyHistogram histogram;
+  histogram.Add(0);
+  histogram.Add(250);
+  histogram.Add(251);
+  histogram.Add(3000000);
+
+  EXPECT_EQ(histogram.count, 4u);
+  EXPECT_EQ(histogram.total_us, 3000501u);
+  EXPECT_EQ(histogram.max_us, 3000000u);
+  EXPECT_EQ(histogram.buckets[0], 2u);
+  EXPECT_EQ(histogram.buckets[1], 1u);
+  EXPECT_EQ(histogram.buckets[HciCommandStats::kNumLatencyBuckets - 1], 1u);
+}
+
+TEST(HciCommandStatsTest, status_and_complete_latency) {
+  HciCommandStats stats;
+  stats.OnCommandSent(OpCode::READ_BD_ADDR, kStart);
+  stats.OnCommandSent(OpCode::LE_CREATE_CONNECTION, kStart + 100us);
+  stats.OnCommandResponse(OpCode::LE_CREATE_CONNECTION, true, kStart + 700us);
+  stats.OnCommandResponse(OpCode::READ_BD_ADDR, false, kStart + 1500us);
+
+  auto snapshot = stats.GetSnapshot();
+  ASSERT_EQ(snapshot.latencies.size(), 2u);
+
+  const auto& read_bd_addr = snapshot.latencies[OpCode::READ_BD_ADDR];
+  EXPECT_EQ(read_bd_addr.status.count, 0u);
+  EXPECT_EQ(read_bd_addr.complete.count, 1u);
+  EXPECT_EQ(read_bd_addr.complete.total_us, 1500u);
+
+  const auto& create_connection = snapshot.latencies[OpCode::LE_CREATE_CONNECTION];
+  EXPECT_EQ(create_connection.status.count, 1u);
+  EXPECT_EQ(create_connection.status.total_us, 600u);
+  EXPECT_EQ(create_connection.complete.count, 0u);
+}
+
+TEST(HciCommandStatsTest, response_without_command_is_ignored) {
+  HciCommandStats stats;
+  stats.OnCommandResponse(OpCode::RESET, false, kStart);
+
+  stats.OnCommandSent(OpCode::RESET, kStart);
+  stats.OnCommandTimeout(OpCode::RESET, kStart + 2s);
+  stats.OnCommandResponse(OpCode::RESET, false, kStart + 3s);
+
+  auto snapshot = stats.GetSnapshot();
+  EXPECT_TRUE(snapshot.latencies.empty());
+  EXPECT_EQ(snapshot.timeouts, 1u);
+}
+
+TEST(HciCommandStatsTest, credit_starvation_and_queue_depth) {
+  HciCommandStats stats;
+  stats.OnQueueUpdate(false, 1, kStart);
+  stats.OnQueueUpdate(true, 3, kStart + 1ms);
+  stats.OnQueueUpdate(true, 4, kStart + 2ms);
+  stats.OnQueueUpdate(false, 2, kStart + 5ms);
+  stats.OnQueueUpdate(true, 2, kStart + 6ms);
+  stats.OnQueueUpdate(false, 0, kStart + 7ms);
+
+  auto snapshot = stats.GetSnapshot();
+  EXPECT_EQ(snapshot.credit_starvation_count, 2u);
+  EXPECT_EQ(snapshot.credit_starvation_total_us, 5000u);
+  EXPECT_EQ(snapshot.max_queue_depth, 4u);
+}
+
+TEST(HciCommandStatsTest, chrome_trace) {
+  HciCommandStats stats;
+  stats.OnQueueUpdate(false, 1, kStart);
+  stats.OnCommandSent(OpCode::READ_BD_ADDR, kStart);
+  stats.OnCommandResponse(OpCode::READ_BD_ADDR, false, kStart + 800us);
+
+  std::string trace = stats.ExportChromeTrace();
+  EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+  EXPECT_NE(trace.find("\"name\":\"command queue\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"READ_BD_ADDR(0x1009)\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ts\":1000000,"), std::string::npos);
+  EXPECT_NE(trace.find("\"dur\":800"), std::string::npos);
+  EXPECT_EQ(trace.substr(trace.size() - 2), "]}");
+}
+
+TEST(HciCommandStatsTest, timeline_keeps_latest_events) {
+  HciCommandStats stats;
+  for (size_t i = 0; i < HciCommandStats::kTimelineSize + 10; i++) {
+    stats.OnQueueUpdate(false, i + 1, kStart + std::chrono::microseconds(i));
+  }
+
+  std::string trace = stats.ExportChromeTrace();
+  size_t events = 0;
+  for (size_t pos = trace.find("\"pid\""); pos != std::string::npos; pos = trace.find("\"pid\"", pos + 1)) {
+    events++;
+  }
+  EXPECT_EQ(events, HciCommandStats::kTimelineSize);
+  // The oldest events were dropped and the remaining ones are in order.
+  EXPECT_EQ(trace.find("\"depth\":10}"), std::string::npos);
+  EXPECT_LT(trace.find("\"depth\":11}"), trace.find("\"depth\":12}"));
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
@@ -21,6 +21,7 @@
 #endif
 #include <bluetooth/log.h>
 
+#include <algorithm>
 #include <map>
 #include <utility>
 
@@ -33,6 +34,8 @@
 #include "os/alarm.h"
 #include "os/metrics.h"
 #include "os/queue.h"
+#include "os/stats.h"
+#include "os/system_properties.h"
 #include "osi/include/stack_power_telemetry.h"
 #include "packet/raw_builder.h"
 #include "storage/storage_module.h"
@@ -57,6 +60,16 @@ using os::Alarm;
 using os::Handler;
 using std::unique_ptr;
 
+// When set above one, up to this many commands are kept in flight, within the
+// Num_HCI_Command_Packets credits advertised by the controller.
+static constexpr char kMaxOutstandingCommandsProperty[] = "bluetooth.hci.max_outstanding_commands";
+static constexpr uint32_t kMaxOutstandingCommandsLimit = 16;
+
+static os::StatsCounter stats_commands_sent("hci.commands_sent");
+static os::StatsCounter stats_events_received("hci.events_received");
+static os::StatsCounter stats_acl_packets_sent("hci.acl_packets_sent");
+static os::StatsCounter stats_acl_packets_received("hci.acl_packets_received");
+
 static void fail_if_reset_complete_not_success(CommandCompleteView complete) {
   auto reset_complete = ResetCompleteView::Create(complete);
   log::assert_that(reset_complete.IsValid(), "assert failed: reset_complete.IsValid()");
@@ -87,6 +100,7 @@ class CommandQueueEntry {
         on_status(std::move(on_status_function)) {}
 
   unique_ptr<CommandBuilder> command;
+  std::shared_ptr<std::vector<uint8_t>> command_bytes;
   unique_ptr<CommandView> command_view;
 
   bool waiting_for_status_;
@@ -112,6 +126,13 @@ class CommandQueueEntry {
 struct HciLayer::impl {
   impl(hal::HciHal* hal, HciLayer& module) : hal_(hal), module_(module) {
     hci_timeout_alarm_ = new Alarm(module.GetHandler());
+    max_outstanding_commands_ = std::clamp(
+        os::GetSystemPropertyUint32(kMaxOutstandingCommandsProperty, 1),
+        1u,
+        kMaxOutstandingCommandsLimit);
+    if (max_outstanding_commands_ > 1) {
+      log::info("Pipelining up to {} HCI commands", max_outstanding_commands_);
+    }
   }
 
   ~impl() {
@@ -137,6 +158,7 @@ struct HciLayer::impl {
     BitInserter bi(bytes);
     packet->Serialize(bi);
     hal_->sendAclData(bytes);
+    stats_acl_packets_sent.Increment();
   }
 
   void on_outbound_sco_ready() {
@@ -201,15 +223,28 @@ struct HciLayer::impl {
       common::StopWatch::DumpStopWatchLog();
       return;
     }
-    log::assert_that(
-        waiting_command_ == op_code,
-        "Waiting for {}, got {}",
-        OpCodeText(waiting_command_),
-        OpCodeText(op_code));
+    auto command = command_queue_.begin();
+    if (is_pipelining()) {
+      command = find_outstanding_command(op_code);
+      log::assert_that(
+          command != outstanding_commands_end(),
+          "Unexpected {} event with OpCode {}, {} commands outstanding",
+          logging_id,
+          OpCodeText(op_code),
+          commands_in_flight_);
+    } else {
+      log::assert_that(
+          waiting_command_ == op_code,
+          "Waiting for {}, got {}",
+          OpCodeText(waiting_command_),
+          OpCodeText(op_code));
+    }
+
+    module_.command_stats_.OnCommandResponse(op_code, is_status);
 
     bool is_vendor_specific = static_cast<int>(op_code) & (0x3f << 10);
     CommandStatusView status_view = CommandStatusView::Create(event);
-    if (is_vendor_specific && (is_status && !command_queue_.front().waiting_for_status_) &&
+    if (is_vendor_specific && (is_status && !command->waiting_for_status_) &&
         (status_view.IsValid() && status_view.GetStatus() == ErrorCode::UNKNOWN_HCI_COMMAND)) {
       // If this is a command status of a vendor specific command, and command complete is expected,
       // we can't treat this as hard failure since we have no way of probing this lack of support at
@@ -228,16 +263,15 @@ struct HciLayer::impl {
           CommandCompleteView::Create(EventView::Create(PacketView<kLittleEndian>(complete)));
       log::assert_that(
           command_complete_view.IsValid(), "assert failed: command_complete_view.IsValid()");
-      (*command_queue_.front().GetCallback<CommandCompleteView>())(command_complete_view);
+      (*command->GetCallback<CommandCompleteView>())(command_complete_view);
     } else {
-      if (command_queue_.front().waiting_for_status_ == is_status) {
-        (*command_queue_.front().GetCallback<TResponse>())(std::move(response_view));
+      if (command->waiting_for_status_ == is_status) {
+        (*command->GetCallback<TResponse>())(std::move(response_view));
       } else {
         CommandCompleteView command_complete_view = CommandCompleteView::Create(
             EventView::Create(PacketView<kLittleEndian>(
                 std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>()))));
-        (*command_queue_.front().GetCallback<CommandCompleteView>())(
-            std::move(command_complete_view));
+        (*command->GetCallback<CommandCompleteView>())(std::move(command_complete_view));
       }
     }
 
@@ -249,7 +283,7 @@ struct HciLayer::impl {
     // would return UNKNOWN_CONNECTION in some cases.
     if (op_code == OpCode::LE_READ_REMOTE_FEATURES && is_status && status_view.IsValid() &&
         status_view.GetStatus() == ErrorCode::UNKNOWN_CONNECTION) {
-      auto& command_view = *command_queue_.front().command_view;
+      auto& command_view = *command->command_view;
       auto le_read_features_view = bluetooth::hci::LeReadRemoteFeaturesView::Create(
           LeConnectionManagementCommandView::Create(AclCommandView::Create(command_view)));
       if (le_read_features_view.IsValid()) {
@@ -259,10 +293,17 @@ struct HciLayer::impl {
     }
 #endif
 
-    command_queue_.pop_front();
+    command_queue_.erase(command);
     waiting_command_ = OpCode::NONE;
+    if (is_pipelining()) {
+      commands_in_flight_--;
+    }
     if (hci_timeout_alarm_ != nullptr) {
       hci_timeout_alarm_->Cancel();
+      if (commands_in_flight_ > 0) {
+        // Restart the timeout for the oldest command still outstanding.
+        schedule_hci_timeout(command_queue_.front().command_view->GetOpCode());
+      }
       send_next_command();
     }
   }
@@ -272,12 +313,18 @@ struct HciLayer::impl {
     log::error("Timed out waiting for {}", OpCodeText(op_code));
 
     bluetooth::os::LogMetricHciTimeoutEvent(static_cast<uint32_t>(op_code));
+    module_.command_stats_.OnCommandTimeout(op_code);
 
     log::error("Flushing {} waiting commands", command_queue_.size());
     // Clear any waiting commands (there is an abort coming anyway)
     command_queue_.clear();
     command_credits_ = 1;
     waiting_command_ = OpCode::NONE;
+    // Responses to the other outstanding commands may still arrive, so go back
+    // to sending one command at a time to discard them while waiting for the
+    // debug info.
+    max_outstanding_commands_ = 1;
+    commands_in_flight_ = 0;
     // Ignore the response, since we don't know what might come back.
     enqueue_command(ControllerDebugInfoBuilder::Create(), module_.GetHandler()->BindOnce([](CommandCompleteView) {}));
     // Don't time out for this one;
@@ -295,6 +342,15 @@ struct HciLayer::impl {
   }
 
   void send_next_command() {
+    if (is_pipelining()) {
+      send_pipelined_commands();
+    } else {
+      send_one_command();
+    }
+    module_.command_stats_.OnQueueUpdate(is_starved_of_credits(), command_queue_.size());
+  }
+
+  void send_one_command() {
     if (command_credits_ == 0) {
       return;
     }
@@ -304,20 +360,106 @@ struct HciLayer::impl {
     if (command_queue_.size() == 0) {
       return;
     }
-    std::shared_ptr<std::vector<uint8_t>> bytes = std::make_shared<std::vector<uint8_t>>();
-    BitInserter bi(*bytes);
-    command_queue_.front().command->Serialize(bi);
-    hal_->sendHciCommand(*bytes);
-
-    auto cmd_view = CommandView::Create(PacketView<kLittleEndian>(bytes));
-    log::assert_that(cmd_view.IsValid(), "assert failed: cmd_view.IsValid()");
-    OpCode op_code = cmd_view.GetOpCode();
-    power_telemetry::GetInstance().LogHciCmdDetail();
-    command_queue_.front().command_view = std::make_unique<CommandView>(std::move(cmd_view));
-    log_link_layer_connection_command(command_queue_.front().command_view);
-    log_classic_pairing_command_status(command_queue_.front().command_view, ErrorCode::STATUS_UNKNOWN);
+    OpCode op_code = send_command(command_queue_.front());
     waiting_command_ = op_code;
     command_credits_ = 0;  // Only allow one outstanding command
+    schedule_hci_timeout(op_code);
+  }
+
+  // Sends queued commands in order while the controller has credits for them.
+  // The first commands_in_flight_ entries of command_queue_ are outstanding.
+  void send_pipelined_commands() {
+    while (command_credits_ > 0 && commands_in_flight_ < max_outstanding_commands_ &&
+           commands_in_flight_ < command_queue_.size()) {
+      auto& next = *outstanding_commands_end();
+      if (!can_send_with_outstanding_commands(serialize_command(next))) {
+        return;
+      }
+      OpCode op_code = send_command(next);
+      commands_in_flight_++;
+      command_credits_--;
+      if (commands_in_flight_ == 1) {
+        schedule_hci_timeout(op_code);
+      }
+    }
+  }
+
+  // Responses are matched by opcode, so two commands with the same opcode are
+  // never outstanding together. Reset and vendor specific commands, whose effect
+  // on other commands is unknown, are only sent when nothing else is.
+  bool can_send_with_outstanding_commands(OpCode op_code) const {
+    if (commands_in_flight_ == 0) {
+      return true;
+    }
+    if (is_serializing_command(op_code)) {
+      return false;
+    }
+    auto command = command_queue_.begin();
+    for (size_t i = 0; i < commands_in_flight_; i++, command++) {
+      OpCode outstanding_op_code = command->command_view->GetOpCode();
+      if (outstanding_op_code == op_code || is_serializing_command(outstanding_op_code)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether queued commands are waiting for the controller to return credits,
+  // rather than for the outstanding command when not pipelining.
+  bool is_starved_of_credits() const {
+    if (command_credits_ > 0) {
+      return false;
+    }
+    if (is_pipelining()) {
+      return command_queue_.size() > commands_in_flight_;
+    }
+    return waiting_command_ == OpCode::NONE && !command_queue_.empty();
+  }
+
+  static bool is_serializing_command(OpCode op_code) {
+    return op_code == OpCode::RESET || (static_cast<uint16_t>(op_code) >> 10) == 0x3f;
+  }
+
+  std::list<CommandQueueEntry>::iterator find_outstanding_command(OpCode op_code) {
+    auto command = command_queue_.begin();
+    for (size_t i = 0; i < commands_in_flight_; i++, command++) {
+      if (command->command_view->GetOpCode() == op_code) {
+        break;
+      }
+    }
+    return command;
+  }
+
+  std::list<CommandQueueEntry>::iterator outstanding_commands_end() {
+    return std::next(command_queue_.begin(), commands_in_flight_);
+  }
+
+  OpCode serialize_command(CommandQueueEntry& entry) {
+    if (entry.command_view == nullptr) {
+      entry.command_bytes = std::make_shared<std::vector<uint8_t>>();
+      BitInserter bi(*entry.command_bytes);
+      entry.command->Serialize(bi);
+      auto cmd_view = CommandView::Create(PacketView<kLittleEndian>(entry.command_bytes));
+      log::assert_that(cmd_view.IsValid(), "assert failed: cmd_view.IsValid()");
+      entry.command_view = std::make_unique<CommandView>(std::move(cmd_view));
+    }
+    return entry.command_view->GetOpCode();
+  }
+
+  OpCode send_command(CommandQueueEntry& entry) {
+    OpCode op_code = serialize_command(entry);
+    hal_->sendHciCommand(*entry.command_bytes);
+    entry.command_bytes.reset();
+    stats_commands_sent.Increment();
+    module_.command_stats_.OnCommandSent(op_code);
+
+    power_telemetry::GetInstance().LogHciCmdDetail();
+    log_link_layer_connection_command(entry.command_view);
+    log_classic_pairing_command_status(entry.command_view, ErrorCode::STATUS_UNKNOWN);
+    return op_code;
+  }
+
+  void schedule_hci_timeout(OpCode op_code) {
     if (hci_timeout_alarm_ != nullptr) {
       hci_timeout_alarm_->Schedule(BindOnce(&impl::on_hci_timeout, common::Unretained(this), op_code), kHciTimeoutMs);
     } else {
@@ -325,6 +467,10 @@ struct HciLayer::impl {
     }
   }
 
+  bool is_pipelining() const {
+    return max_outstanding_commands_ > 1;
+  }
+
   void register_event(EventCode event, ContextualCallback<void(EventView)> handler) {
     log::assert_that(
         event != EventCode::LE_META_EVENT,
@@ -425,7 +571,7 @@ struct HciLayer::impl {
       std::unique_ptr<CommandView> no_waiting_command{nullptr};
       log_hci_event(no_waiting_command, event, module_.GetDependency<storage::StorageModule>());
     } else {
-      log_hci_event(command_queue_.front().command_view, event, module_.GetDependency<storage::StorageModule>());
+      log_hci_event(command_view_for_event(event), event, module_.GetDependency<storage::StorageModule>());
     }
     power_telemetry::GetInstance().LogHciEvtDetail();
     EventCode event_code = event.GetEventCode();
@@ -467,6 +613,26 @@ struct HciLayer::impl {
     }
   }
 
+  // When pipelining, command responses are logged against the command they
+  // answer rather than the oldest outstanding one.
+  std::unique_ptr<CommandView>& command_view_for_event(EventView event) {
+    if (is_pipelining()) {
+      OpCode op_code = OpCode::NONE;
+      if (event.GetEventCode() == EventCode::COMMAND_COMPLETE) {
+        auto view = CommandCompleteView::Create(event);
+        op_code = view.IsValid() ? view.GetCommandOpCode() : OpCode::NONE;
+      } else if (event.GetEventCode() == EventCode::COMMAND_STATUS) {
+        auto view = CommandStatusView::Create(event);
+        op_code = view.IsValid() ? view.GetCommandOpCode() : OpCode::NONE;
+      }
+      auto command = find_outstanding_command(op_code);
+      if (op_code != OpCode::NONE && command != outstanding_commands_end()) {
+        return command->command_view;
+      }
+    }
+    return command_queue_.front().command_view;
+  }
+
   void on_hardware_error(EventView event) {
     HardwareErrorView event_view = HardwareErrorView::Create(event);
     log::assert_that(event_view.IsValid(), "assert failed: event_view.IsValid()");
@@ -515,6 +681,8 @@ struct HciLayer::impl {
 
   OpCode waiting_command_{OpCode::NONE};
   uint8_t command_credits_{1};  // Send reset first
+  uint32_t max_outstanding_commands_{1};
+  size_t commands_in_flight_{0};
   Alarm* hci_timeout_alarm_{nullptr};
   Alarm* hci_abort_alarm_{nullptr};
 
@@ -536,12 +704,14 @@ struct HciLayer::hal_callbacks : public hal::HciHalCallbacks {
   hal_callbacks(HciLayer& module) : module_(module) {}
 
   void hciEventReceived(hal::HciPacket event_bytes) override {
+    stats_events_received.Increment();
     auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(event_bytes));
     EventView event = EventView::Create(packet);
     module_.CallOn(module_.impl_, &impl::on_hci_event, std::move(event));
   }
 
   void aclDataReceived(hal::HciPacket data_bytes) override {
+    stats_acl_packets_received.Increment();
     auto packet = packet::PacketView<packet::kLittleEndian>(
         std::make_shared<std::vector<uint8_t>>(std::move(data_bytes)));
     auto acl = std::make_unique<AclView>(AclView::Create(packet));
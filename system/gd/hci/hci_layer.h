@@ -27,6 +27,7 @@
 #include "common/contextual_callback.h"
 #include "hci/acl_connection_interface.h"
 #include "hci/distance_measurement_interface.h"
+#include "hci/hci_command_stats.h"
 #include "hci/hci_interface.h"
 #include "hci/hci_packets.h"
 #include "hci/le_acl_connection_interface.h"
@@ -118,6 +119,11 @@ class HciLayer : public Module, public HciInterface {
     return "Hci Layer";
   }
 
+  // Command latency, credit and queue statistics, for dumpsys.
+  const HciCommandStats& GetCommandStats() const {
+    return command_stats_;
+  }
+
   static constexpr std::chrono::milliseconds kHciTimeoutMs = std::chrono::milliseconds(2000);
   static constexpr std::chrono::milliseconds kHciTimeoutRestartMs = std::chrono::milliseconds(5000);
 
@@ -156,6 +162,8 @@ class HciLayer : public Module, public HciInterface {
   void on_disconnection_complete(EventView event_view);
   void on_read_remote_version_complete(EventView event_view);
 
+  HciCommandStats command_stats_;
+
   common::ContextualCallback<void(Address bd_addr, ClassOfDevice cod)> on_acl_connection_request_{};
   common::ContextualCallback<void(
       Address bd_addr, ClassOfDevice cod, ConnectionRequestLinkType link_type)>
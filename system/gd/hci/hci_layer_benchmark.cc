@@ -0,0 +1,242 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hal/hci_hal.h"
+#include "hci/address.h"
+#include "hci/hci_layer.h"
+#include "hci/hci_packets.h"
+#include "module.h"
+#include "os/system_properties.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+using ::bluetooth::TestModuleRegistry;
+using ::bluetooth::hci::Address;
+using ::bluetooth::hci::CommandBuilder;
+using ::bluetooth::hci::CommandCompleteView;
+using ::bluetooth::hci::HciLayer;
+using ::bluetooth::hci::OpCode;
+
+namespace {
+
+// Number of commands the fake controller accepts before answering any.
+constexpr uint8_t kControllerCommandCredits = 8;
+
+// Answers every command with a successful Command Complete event, a fixed
+// latency after receiving it.
+class FakeController : public bluetooth::hal::HciHal {
+ public:
+  explicit FakeController(std::chrono::microseconds latency) : latency_(latency) {}
+
+  void registerIncomingPacketCallback(bluetooth::hal::HciHalCallbacks* callbacks) override {
+    callbacks_ = callbacks;
+  }
+
+  void unregisterIncomingPacketCallback() override {
+    callbacks_ = nullptr;
+  }
+
+  void sendHciCommand(bluetooth::hal::HciPacket command) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(
+        {std::chrono::steady_clock::now() + latency_,
+         static_cast<OpCode>(command[0] | (command[1] << 8))});
+    cv_.notify_one();
+  }
+
+  void sendAclData(bluetooth::hal::HciPacket /* data */) override {}
+  void sendScoData(bluetooth::hal::HciPacket /* data */) override {}
+  void sendIsoData(bluetooth::hal::HciPacket /* data */) override {}
+
+  std::string ToString() const override {
+    return std::string("FakeController");
+  }
+
+ protected:
+  void Start() override {
+    responder_ = std::thread(&FakeController::respond, this);
+  }
+
+  void Stop() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+      cv_.notify_one();
+    }
+    responder_.join();
+  }
+
+  void ListDependencies(bluetooth::ModuleList* /* list */) const override {}
+
+ private:
+  struct PendingCommand {
+    std::chrono::steady_clock::time_point deadline;
+    OpCode op_code;
+  };
+
+  void respond() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this] { return stopped_ || !pending_.empty(); });
+      if (stopped_) {
+        return;
+      }
+      auto deadline = pending_.front().deadline;
+      if (cv_.wait_until(lock, deadline, [this] { return stopped_; })) {
+        return;
+      }
+      OpCode op_code = pending_.front().op_code;
+      pending_.pop_front();
+      uint8_t credits = kControllerCommandCredits - pending_.size();
+      lock.unlock();
+
+      auto payload = std::make_unique<bluetooth::packet::RawBuilder>();
+      payload->AddOctets1(static_cast<uint8_t>(bluetooth::hci::ErrorCode::SUCCESS));
+      auto event = bluetooth::hci::CommandCompleteBuilder::Create(credits, op_code, std::move(payload));
+      callbacks_->hciEventReceived(event->SerializeToBytes());
+
+      lock.lock();
+    }
+  }
+
+  std::chrono::microseconds latency_;
+  bluetooth::hal::HciHalCallbacks* callbacks_ = nullptr;
+  std::thread responder_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<PendingCommand> pending_;
+  bool stopped_ = false;
+};
+
+// Controller bring-up: a chain of independent read commands.
+std::vector<std::unique_ptr<CommandBuilder>> ControllerInfoChain() {
+  std::vector<std::unique_ptr<CommandBuilder>> chain;
+  chain.push_back(bluetooth::hci::ReadLocalVersionInformationBuilder::Create());
+  chain.push_back(bluetooth::hci::ReadLocalSupportedCommandsBuilder::Create());
+  chain.push_back(bluetooth::hci::ReadLocalSupportedFeaturesBuilder::Create());
+  chain.push_back(bluetooth::hci::ReadBufferSizeBuilder::Create());
+  chain.push_back(bluetooth::hci::ReadBdAddrBuilder::Create());
+  chain.push_back(bluetooth::hci::ReadLocalNameBuilder::Create());
+  chain.push_back(bluetooth::hci::LeReadBufferSizeV1Builder::Create());
+  chain.push_back(bluetooth::hci::LeReadLocalSupportedFeaturesBuilder::Create());
+  chain.push_back(bluetooth::hci::LeReadFilterAcceptListSizeBuilder::Create());
+  chain.push_back(bluetooth::hci::LeReadResolvingListSizeBuilder::Create());
+  chain.push_back(bluetooth::hci::LeReadMaximumDataLengthBuilder::Create());
+  chain.push_back(bluetooth::hci::LeReadSuggestedDefaultDataLengthBuilder::Create());
+  return chain;
+}
+
+// Reconnection: the accept list is rebuilt one device at a time, so commands
+// sharing an opcode can not overlap.
+std::vector<std::unique_ptr<CommandBuilder>> AcceptListChain() {
+  std::vector<std::unique_ptr<CommandBuilder>> chain;
+  chain.push_back(bluetooth::hci::LeClearFilterAcceptListBuilder::Create());
+  for (uint8_t i = 0; i < 8; i++) {
+    chain.push_back(bluetooth::hci::LeAddDeviceToFilterAcceptListBuilder::Create(
+        bluetooth::hci::FilterAcceptListAddressType::RANDOM, Address({0xc0, 0x00, 0x00, 0x00, 0x00, i})));
+  }
+  chain.push_back(bluetooth::hci::ReadBdAddrBuilder::Create());
+  return chain;
+}
+
+class BM_HciCommandChain : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    bluetooth::os::SetSystemProperty(
+        "bluetooth.hci.max_outstanding_commands", std::to_string(st.range(1)));
+    controller_ = new FakeController(std::chrono::microseconds(st.range(0)));
+    registry_ = std::make_unique<TestModuleRegistry>();
+    registry_->InjectTestModule(&bluetooth::hal::HciHal::Factory, controller_);
+    registry_->Start<HciLayer>(&registry_->GetTestThread());
+    hci_ = registry_->GetModuleUnderTest<HciLayer>();
+    handler_ = registry_->GetTestModuleHandler(&HciLayer::Factory);
+    // Wait for the HCI Reset sent on start to complete.
+    RunChain({});
+  }
+
+  void TearDown(State& st) override {
+    registry_->StopAll();
+    registry_.reset();
+    bluetooth::os::ClearSystemPropertiesForHost();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Enqueues the commands back to back and returns once all of them
+  // completed. Commands are always answered in order, so waiting for the
+  // last one is enough.
+  void RunChain(std::vector<std::unique_ptr<CommandBuilder>> chain) {
+    chain.push_back(bluetooth::hci::ReadBdAddrBuilder::Create());
+    std::promise<void> done;
+    auto done_future = done.get_future();
+    for (size_t i = 0; i + 1 < chain.size(); i++) {
+      hci_->EnqueueCommand(std::move(chain[i]), handler_->BindOnce([](CommandCompleteView) {}));
+    }
+    hci_->EnqueueCommand(
+        std::move(chain.back()),
+        handler_->BindOnce([](std::promise<void>* done, CommandCompleteView) { done->set_value(); }, &done));
+    done_future.wait();
+  }
+
+  void Run(State& st, std::function<std::vector<std::unique_ptr<CommandBuilder>>()> make_chain) {
+    size_t commands = 0;
+    for (auto _ : st) {
+      st.PauseTiming();
+      auto chain = make_chain();
+      commands += chain.size() + 1;
+      st.ResumeTiming();
+      RunChain(std::move(chain));
+    }
+    st.SetItemsProcessed(commands);
+  }
+
+  FakeController* controller_ = nullptr;
+  std::unique_ptr<TestModuleRegistry> registry_;
+  HciLayer* hci_ = nullptr;
+  bluetooth::os::Handler* handler_ = nullptr;
+};
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(BM_HciCommandChain, ControllerInfo)(State& st) {
+  Run(st, ControllerInfoChain);
+}
+
+BENCHMARK_DEFINE_F(BM_HciCommandChain, AcceptList)(State& st) {
+  Run(st, AcceptListChain);
+}
+
+// Arguments: controller latency in microseconds, maximum outstanding commands.
+BENCHMARK_REGISTER_F(BM_HciCommandChain, ControllerInfo)
+    ->ArgsProduct({{0, 100, 1000}, {1, 4, 8}})
+    ->Unit(::benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK_REGISTER_F(BM_HciCommandChain, AcceptList)
+    ->ArgsProduct({{0, 100, 1000}, {1, 4, 8}})
+    ->Unit(::benchmark::kMicrosecond)
+    ->UseRealTime();
@@ -33,6 +33,7 @@
 #include "module.h"
 #include "os/fake_timer/fake_timerfd.h"
 #include "os/handler.h"
+#include "os/system_properties.h"
 #include "os/thread.h"
 #include "packet/raw_builder.h"
 
@@ -124,6 +125,35 @@ class HciLayerTest : public ::testing::Test {
 
 class HciLayerDeathTest : public HciLayerTest {};
 
+class HciLayerPipeliningTest : public HciLayerTest {
+ protected:
+  void SetUp() override {
+    os::SetSystemProperty("bluetooth.hci.max_outstanding_commands", "3");
+    HciLayerTest::SetUp();
+    FailIfResetNotSent();
+    hal_->InjectEvent(ResetCompleteBuilder::Create(3, ErrorCode::SUCCESS));
+    sync_handler();
+  }
+
+  void TearDown() override {
+    HciLayerTest::TearDown();
+    os::ClearSystemPropertiesForHost();
+  }
+
+  OpCode GetSentOpCode() {
+    auto sent_command = hal_->GetSentCommand();
+    log::assert_that(sent_command.has_value(), "assert failed: sent_command.has_value()");
+    return sent_command->GetOpCode();
+  }
+
+  bool NoCommandSent() {
+    sync_handler();
+    return !hal_->GetSentCommand(std::chrono::milliseconds(10)).has_value();
+  }
+};
+
+class HciLayerPipeliningDeathTest : public HciLayerPipeliningTest {};
+
 TEST_F(HciLayerTest, setup_teardown) {}
 
 TEST_F(HciLayerTest, reset_command_sent_on_start) {
@@ -521,5 +551,161 @@ TEST_F(HciLayerTest, command_status_callback_is_invoked_with_failure_status) {
   sync_handler();
 }
 
+TEST_F(HciLayerPipeliningTest, commands_sent_up_to_max_outstanding) {
+  hci_->EnqueueCommand(ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  hci_->EnqueueCommand(
+      ReadClockOffsetBuilder::Create(0x001), hci_handler_->BindOnce([](CommandStatusView) {}));
+  hci_->EnqueueCommand(ReadLocalNameBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  hci_->EnqueueCommand(ReadBufferSizeBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, GetSentOpCode());
+  ASSERT_EQ(OpCode::READ_LOCAL_NAME, GetSentOpCode());
+  ASSERT_TRUE(NoCommandSent());
+
+  hal_->InjectEvent(ReadBdAddrCompleteBuilder::Create(1, ErrorCode::SUCCESS, Address::kAny));
+  ASSERT_EQ(OpCode::READ_BUFFER_SIZE, GetSentOpCode());
+}
+
+TEST_F(HciLayerPipeliningTest, commands_sent_up_to_controller_credits) {
+  hci_->EnqueueCommand(ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+  hal_->InjectEvent(ReadBdAddrCompleteBuilder::Create(1, ErrorCode::SUCCESS, Address::kAny));
+  sync_handler();
+
+  hci_->EnqueueCommand(
+      ReadClockOffsetBuilder::Create(0x001), hci_handler_->BindOnce([](CommandStatusView) {}));
+  hci_->EnqueueCommand(ReadLocalNameBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, GetSentOpCode());
+  ASSERT_TRUE(NoCommandSent());
+
+  hal_->InjectEvent(ReadClockOffsetStatusBuilder::Create(ErrorCode::SUCCESS, 1));
+  ASSERT_EQ(OpCode::READ_LOCAL_NAME, GetSentOpCode());
+}
+
+TEST_F(HciLayerPipeliningTest, responses_matched_out_of_order) {
+  std::promise<OpCode> complete_promise;
+  auto complete_future = complete_promise.get_future();
+  std::promise<OpCode> status_promise;
+  auto status_future = status_promise.get_future();
+  hci_->EnqueueCommand(
+      ReadBdAddrBuilder::Create(),
+      hci_handler_->BindOnce(
+          [](std::promise<OpCode> promise, CommandCompleteView view) {
+            promise.set_value(view.GetCommandOpCode());
+          },
+          std::move(complete_promise)));
+  hci_->EnqueueCommand(
+      ReadClockOffsetBuilder::Create(0x001),
+      hci_handler_->BindOnce(
+          [](std::promise<OpCode> promise, CommandStatusView view) {
+            promise.set_value(view.GetCommandOpCode());
+          },
+          std::move(status_promise)));
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, GetSentOpCode());
+
+  hal_->InjectEvent(ReadClockOffsetStatusBuilder::Create(ErrorCode::SUCCESS, 2));
+  ASSERT_EQ(std::future_status::ready, status_future.wait_for(std::chrono::seconds(1)));
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, status_future.get());
+  ASSERT_NE(std::future_status::ready, complete_future.wait_for(std::chrono::milliseconds(10)));
+
+  hal_->InjectEvent(ReadBdAddrCompleteBuilder::Create(3, ErrorCode::SUCCESS, Address::kAny));
+  ASSERT_EQ(std::future_status::ready, complete_future.wait_for(std::chrono::seconds(1)));
+  ASSERT_EQ(OpCode::READ_BD_ADDR, complete_future.get());
+}
+
+TEST_F(HciLayerPipeliningTest, same_opcode_not_outstanding_twice) {
+  hci_->EnqueueCommand(
+      ReadClockOffsetBuilder::Create(0x001), hci_handler_->BindOnce([](CommandStatusView) {}));
+  hci_->EnqueueCommand(
+      ReadClockOffsetBuilder::Create(0x002), hci_handler_->BindOnce([](CommandStatusView) {}));
+  hci_->EnqueueCommand(ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, GetSentOpCode());
+  // Commands are never reordered, so READ_BD_ADDR waits behind the second READ_CLOCK_OFFSET.
+  ASSERT_TRUE(NoCommandSent());
+
+  hal_->InjectEvent(ReadClockOffsetStatusBuilder::Create(ErrorCode::SUCCESS, 3));
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, GetSentOpCode());
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+}
+
+TEST_F(HciLayerPipeliningTest, reset_and_vendor_commands_sent_alone) {
+  hci_->EnqueueCommand(ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  hci_->EnqueueCommand(
+      LeGetVendorCapabilitiesBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  hci_->EnqueueCommand(ReadLocalNameBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+  ASSERT_TRUE(NoCommandSent());
+
+  hal_->InjectEvent(ReadBdAddrCompleteBuilder::Create(3, ErrorCode::SUCCESS, Address::kAny));
+  ASSERT_EQ(OpCode::LE_GET_VENDOR_CAPABILITIES, GetSentOpCode());
+  ASSERT_TRUE(NoCommandSent());
+
+  hal_->InjectEvent(CommandCompleteBuilder::Create(
+      3, OpCode::LE_GET_VENDOR_CAPABILITIES, std::make_unique<RawBuilder>(std::vector<uint8_t>{0})));
+  ASSERT_EQ(OpCode::READ_LOCAL_NAME, GetSentOpCode());
+
+  hci_->EnqueueCommand(ResetBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  ASSERT_TRUE(NoCommandSent());
+}
+
+TEST_F(HciLayerPipeliningTest, command_stats) {
+  hci_->EnqueueCommand(ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  hci_->EnqueueCommand(
+      ReadClockOffsetBuilder::Create(0x001), hci_handler_->BindOnce([](CommandStatusView) {}));
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+  ASSERT_EQ(OpCode::READ_CLOCK_OFFSET, GetSentOpCode());
+
+  // The controller runs out of credits while a command is waiting.
+  hal_->InjectEvent(ReadClockOffsetStatusBuilder::Create(ErrorCode::SUCCESS, 0));
+  hci_->EnqueueCommand(ReadLocalNameBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  ASSERT_TRUE(NoCommandSent());
+
+  hal_->InjectEvent(ReadBdAddrCompleteBuilder::Create(1, ErrorCode::SUCCESS, Address::kAny));
+  ASSERT_EQ(OpCode::READ_LOCAL_NAME, GetSentOpCode());
+  sync_handler();
+
+  auto snapshot = hci_->GetCommandStats().GetSnapshot();
+  EXPECT_EQ(1u, snapshot.latencies[OpCode::RESET].complete.count);
+  EXPECT_EQ(1u, snapshot.latencies[OpCode::READ_BD_ADDR].complete.count);
+  EXPECT_EQ(1u, snapshot.latencies[OpCode::READ_CLOCK_OFFSET].status.count);
+  EXPECT_EQ(0u, snapshot.latencies[OpCode::READ_LOCAL_NAME].complete.count);
+  EXPECT_EQ(1u, snapshot.credit_starvation_count);
+  EXPECT_EQ(2u, snapshot.max_queue_depth);
+}
+
+TEST_F(HciLayerPipeliningTest, controller_debug_info_requested_on_hci_timeout) {
+  hci_->EnqueueCommand(ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  hci_->EnqueueCommand(ReadLocalNameBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+  ASSERT_EQ(OpCode::READ_BD_ADDR, GetSentOpCode());
+  ASSERT_EQ(OpCode::READ_LOCAL_NAME, GetSentOpCode());
+
+  FakeTimerAdvance(HciLayer::kHciTimeoutMs.count());
+  sync_handler();
+
+  auto sent_command = hal_->GetSentCommand();
+  ASSERT_TRUE(sent_command.has_value());
+  auto debug_info_view = ControllerDebugInfoView::Create(VendorCommandView::Create(*sent_command));
+  ASSERT_TRUE(debug_info_view.IsValid());
+
+  // Late responses to the outstanding commands are discarded.
+  hal_->InjectEvent(ReadBdAddrCompleteBuilder::Create(1, ErrorCode::SUCCESS, Address::kAny));
+  sync_handler();
+}
+
+TEST_F(HciLayerPipeliningDeathTest, abort_on_response_to_command_not_outstanding) {
+  ASSERT_DEATH(
+      {
+        hci_->EnqueueCommand(
+            ReadBdAddrBuilder::Create(), hci_handler_->BindOnce([](CommandCompleteView) {}));
+        hal_->InjectEvent(ReadClockOffsetStatusBuilder::Create(ErrorCode::SUCCESS, 1));
+        sync_handler();
+      },
+      "");
+}
+
 }  // namespace hci
 }  // namespace bluetooth
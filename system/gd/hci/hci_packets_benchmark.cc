@@ -0,0 +1,163 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "packet/packet_view.h"
+#include "packet/view.h"
+
+using ::benchmark::State;
+using ::bluetooth::packet::kLittleEndian;
+using ::bluetooth::packet::PacketView;
+using ::bluetooth::packet::View;
+
+namespace {
+
+// Events as seen during a connection with a bonded LE peripheral.
+const std::vector<std::vector<uint8_t>> kEventCorpus = {
+    // Command Complete: Read BD_ADDR.
+    {0x0e, 0x0a, 0x01, 0x09, 0x10, 0x00, 0x6f, 0x2b, 0x0e, 0x11, 0xc8, 0xf4},
+    // Command Status: LE Create Connection.
+    {0x0f, 0x04, 0x00, 0x01, 0x0d, 0x20},
+    // LE Connection Update Complete.
+    {0x3e, 0x0a, 0x03, 0x00, 0x40, 0x00, 0x24, 0x00, 0x00, 0x00, 0xf4, 0x01},
+    // Number Of Completed Packets, two handles.
+    {0x13, 0x09, 0x02, 0x40, 0x00, 0x01, 0x00, 0x41, 0x00, 0x03, 0x00},
+    // Disconnection Complete.
+    {0x05, 0x04, 0x00, 0x40, 0x00, 0x13},
+};
+
+// ACL packets of an LE link: ATT notifications, a fragmented write and its
+// continuation.
+const std::vector<std::vector<uint8_t>> kAclCorpus = {
+    {0x40, 0x20, 0x0b, 0x00, 0x07, 0x00, 0x04, 0x00, 0x1b, 0x2a, 0x00, 0x01, 0x02, 0x03, 0x04},
+    {0x40, 0x20, 0x09, 0x00, 0x05, 0x00, 0x04, 0x00, 0x1b, 0x2d, 0x00, 0x64},
+    {0x41, 0x20, 0x1b, 0x00, 0x1d, 0x00, 0x04, 0x00, 0x12, 0x31, 0x00, 0x00, 0x01, 0x02, 0x03,
+     0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13},
+    {0x41, 0x10, 0x06, 0x00, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19},
+};
+
+// Returns views of |corpus|, with the header and the rest of each packet in
+// separate fragments when |fragmented| is set, as after reassembly.
+std::vector<PacketView<kLittleEndian>> MakeViews(
+    const std::vector<std::vector<uint8_t>>& corpus, size_t header_size, bool fragmented) {
+  std::vector<PacketView<kLittleEndian>> views;
+  for (const auto& bytes : corpus) {
+    auto packet = std::make_shared<const std::vector<uint8_t>>(bytes);
+    if (fragmented) {
+      views.emplace_back(
+          std::forward_list<View>({View(packet, 0, header_size), View(packet, header_size, packet->size())}));
+    } else {
+      views.emplace_back(packet);
+    }
+  }
+  return views;
+}
+
+uint64_t ParseEvent(PacketView<kLittleEndian> packet) {
+  auto event = bluetooth::hci::EventView::Create(packet);
+  if (!event.IsValid()) {
+    return 0;
+  }
+  switch (event.GetEventCode()) {
+    case bluetooth::hci::EventCode::COMMAND_COMPLETE: {
+      auto complete = bluetooth::hci::CommandCompleteView::Create(event);
+      if (!complete.IsValid()) {
+        return 0;
+      }
+      auto read_bd_addr = bluetooth::hci::ReadBdAddrCompleteView::Create(complete);
+      if (!read_bd_addr.IsValid()) {
+        return 0;
+      }
+      return static_cast<uint64_t>(read_bd_addr.GetStatus()) + read_bd_addr.GetBdAddr().address[0];
+    }
+    case bluetooth::hci::EventCode::COMMAND_STATUS: {
+      auto status = bluetooth::hci::CommandStatusView::Create(event);
+      if (!status.IsValid()) {
+        return 0;
+      }
+      return static_cast<uint64_t>(status.GetCommandOpCode()) + status.GetNumHciCommandPackets();
+    }
+    case bluetooth::hci::EventCode::LE_META_EVENT: {
+      auto le_meta = bluetooth::hci::LeMetaEventView::Create(event);
+      if (!le_meta.IsValid()) {
+        return 0;
+      }
+      auto update = bluetooth::hci::LeConnectionUpdateCompleteView::Create(le_meta);
+      if (!update.IsValid()) {
+        return 0;
+      }
+      return update.GetConnectionHandle() + update.GetConnInterval() + update.GetSupervisionTimeout();
+    }
+    case bluetooth::hci::EventCode::NUMBER_OF_COMPLETED_PACKETS: {
+      auto completed = bluetooth::hci::NumberOfCompletedPacketsView::Create(event);
+      if (!completed.IsValid()) {
+        return 0;
+      }
+      uint64_t credits = 0;
+      for (const auto& entry : completed.GetCompletedPackets()) {
+        credits += entry.host_num_of_completed_packets_;
+      }
+      return credits;
+    }
+    case bluetooth::hci::EventCode::DISCONNECTION_COMPLETE: {
+      auto disconnection = bluetooth::hci::DisconnectionCompleteView::Create(event);
+      if (!disconnection.IsValid()) {
+        return 0;
+      }
+      return disconnection.GetConnectionHandle() + static_cast<uint64_t>(disconnection.GetReason());
+    }
+    default:
+      return 0;
+  }
+}
+
+uint64_t ParseAcl(PacketView<kLittleEndian> packet) {
+  auto acl = bluetooth::hci::AclView::Create(packet);
+  if (!acl.IsValid()) {
+    return 0;
+  }
+  return acl.GetHandle() + static_cast<uint64_t>(acl.GetPacketBoundaryFlag()) +
+         static_cast<uint64_t>(acl.GetBroadcastFlag()) + acl.GetPayload().size();
+}
+
+void Run(State& state, const std::vector<PacketView<kLittleEndian>>& views,
+         uint64_t (*parse)(PacketView<kLittleEndian>)) {
+  for (auto _ : state) {
+    for (const auto& view : views) {
+      ::benchmark::DoNotOptimize(parse(view));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * views.size());
+}
+
+}  // namespace
+
+static void BM_ParseHciEvent(State& state) {
+  Run(state, MakeViews(kEventCorpus, 2, state.range(0)), ParseEvent);
+}
+
+static void BM_ParseAcl(State& state) {
+  Run(state, MakeViews(kAclCorpus, 4, state.range(0)), ParseAcl);
+}
+
+// Argument: 0 for packets held in one buffer, 1 for fragmented packets.
+BENCHMARK(BM_ParseHciEvent)->Arg(0)->Arg(1);
+BENCHMARK(BM_ParseAcl)->Arg(0)->Arg(1);
@@ -19,6 +19,8 @@
 #include <bluetooth/log.h>
 #include <com_android_bluetooth_flags.h>
 
+#include <algorithm>
+
 #include "common/init_flags.h"
 #include "hci/octets.h"
 #include "include/macros.h"
@@ -296,6 +298,10 @@ void LeAddressManager::pause_registered_clients() {
         break;
       case ClientState::WAITING_FOR_RESUME:
       case ClientState::RESUMED:
+        if (!pause_start_.has_value()) {
+          pause_start_ = std::chrono::steady_clock::now();
+          pause_window_count_++;
+        }
         client.second = ClientState::WAITING_FOR_PAUSE;
         client.first->OnPause();
         break;
@@ -345,6 +351,12 @@ void LeAddressManager::resume_registered_clients() {
   }
 
   log::info("Resuming registered clients");
+  if (pause_start_.has_value()) {
+    total_paused_time_ms_ += std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - *pause_start_)
+                                 .count();
+    pause_start_.reset();
+  }
   for (auto& client : registered_clients_) {
     if (client.second != ClientState::PAUSED) {
       log::warn("client is not paused {}", ClientStateText(client.second));
@@ -527,8 +539,10 @@ void LeAddressManager::handle_next_command() {
 void LeAddressManager::AddDeviceToFilterAcceptList(
     FilterAcceptListAddressType accept_list_address_type, bluetooth::hci::Address address) {
   auto packet_builder = hci::LeAddDeviceToFilterAcceptListBuilder::Create(accept_list_address_type, address);
-  Command command = {CommandType::ADD_DEVICE_TO_ACCEPT_LIST, HCICommand{std::move(packet_builder)}};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command))();
+  ListUpdate update = {
+      CommandType::ADD_DEVICE_TO_ACCEPT_LIST, static_cast<uint8_t>(accept_list_address_type), address, {}};
+  update.commands.push_back({CommandType::ADD_DEVICE_TO_ACCEPT_LIST, HCICommand{std::move(packet_builder)}});
+  handler_->BindOnceOn(this, &LeAddressManager::update_accept_list, std::move(update))();
 }
 
 void LeAddressManager::AddDeviceToResolvingList(
@@ -540,40 +554,29 @@ void LeAddressManager::AddDeviceToResolvingList(
     return;
   }
 
-  // Disable Address resolution
-  auto disable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED);
-  Command disable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, HCICommand{std::move(disable_builder)}};
-  cached_commands_.push(std::move(disable));
-
+  ListUpdate update = {
+      CommandType::ADD_DEVICE_TO_RESOLVING_LIST,
+      static_cast<uint8_t>(peer_identity_address_type),
+      peer_identity_address,
+      {}};
   auto packet_builder = hci::LeAddDeviceToResolvingListBuilder::Create(
       peer_identity_address_type, peer_identity_address, peer_irk, local_irk);
-  Command command = {CommandType::ADD_DEVICE_TO_RESOLVING_LIST, HCICommand{std::move(packet_builder)}};
-  cached_commands_.push(std::move(command));
-
-  if (supports_ble_privacy_) {
-    auto packet_builder =
-        hci::LeSetPrivacyModeBuilder::Create(peer_identity_address_type, peer_identity_address, PrivacyMode::DEVICE);
-    Command command = {CommandType::LE_SET_PRIVACY_MODE, HCICommand{std::move(packet_builder)}};
-    cached_commands_.push(std::move(command));
-  }
+  update.commands.push_back({CommandType::ADD_DEVICE_TO_RESOLVING_LIST, HCICommand{std::move(packet_builder)}});
 
-  // Enable Address resolution
-  auto enable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED);
-  Command enable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, HCICommand{std::move(enable_builder)}};
-  cached_commands_.push(std::move(enable));
+  auto privacy_mode_builder =
+      hci::LeSetPrivacyModeBuilder::Create(peer_identity_address_type, peer_identity_address, PrivacyMode::DEVICE);
+  update.commands.push_back({CommandType::LE_SET_PRIVACY_MODE, HCICommand{std::move(privacy_mode_builder)}});
 
-  if (registered_clients_.empty()) {
-    handler_->BindOnceOn(this, &LeAddressManager::handle_next_command)();
-  } else {
-    handler_->BindOnceOn(this, &LeAddressManager::pause_registered_clients)();
-  }
+  handler_->BindOnceOn(this, &LeAddressManager::update_resolving_list, std::move(update))();
 }
 
 void LeAddressManager::RemoveDeviceFromFilterAcceptList(
     FilterAcceptListAddressType accept_list_address_type, bluetooth::hci::Address address) {
   auto packet_builder = hci::LeRemoveDeviceFromFilterAcceptListBuilder::Create(accept_list_address_type, address);
-  Command command = {CommandType::REMOVE_DEVICE_FROM_ACCEPT_LIST, HCICommand{std::move(packet_builder)}};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command))();
+  ListUpdate update = {
+      CommandType::REMOVE_DEVICE_FROM_ACCEPT_LIST, static_cast<uint8_t>(accept_list_address_type), address, {}};
+  update.commands.push_back({CommandType::REMOVE_DEVICE_FROM_ACCEPT_LIST, HCICommand{std::move(packet_builder)}});
+  handler_->BindOnceOn(this, &LeAddressManager::update_accept_list, std::move(update))();
 }
 
 void LeAddressManager::RemoveDeviceFromResolvingList(
@@ -582,32 +585,22 @@ void LeAddressManager::RemoveDeviceFromResolvingList(
     return;
   }
 
-  // Disable Address resolution
-  auto disable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED);
-  Command disable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, HCICommand{std::move(disable_builder)}};
-  cached_commands_.push(std::move(disable));
-
+  ListUpdate update = {
+      CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST,
+      static_cast<uint8_t>(peer_identity_address_type),
+      peer_identity_address,
+      {}};
   auto packet_builder =
       hci::LeRemoveDeviceFromResolvingListBuilder::Create(peer_identity_address_type, peer_identity_address);
-  Command command = {CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST, HCICommand{std::move(packet_builder)}};
-  cached_commands_.push(std::move(command));
-
-  // Enable Address resolution
-  auto enable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED);
-  Command enable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, HCICommand{std::move(enable_builder)}};
-  cached_commands_.push(std::move(enable));
-
-  if (registered_clients_.empty()) {
-    handler_->BindOnceOn(this, &LeAddressManager::handle_next_command)();
-  } else {
-    handler_->BindOnceOn(this, &LeAddressManager::pause_registered_clients)();
-  }
+  update.commands.push_back({CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST, HCICommand{std::move(packet_builder)}});
+  handler_->BindOnceOn(this, &LeAddressManager::update_resolving_list, std::move(update))();
 }
 
 void LeAddressManager::ClearFilterAcceptList() {
   auto packet_builder = hci::LeClearFilterAcceptListBuilder::Create();
-  Command command = {CommandType::CLEAR_ACCEPT_LIST, HCICommand{std::move(packet_builder)}};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command))();
+  ListUpdate update = {CommandType::CLEAR_ACCEPT_LIST, 0, Address::kEmpty, {}};
+  update.commands.push_back({CommandType::CLEAR_ACCEPT_LIST, HCICommand{std::move(packet_builder)}});
+  handler_->BindOnceOn(this, &LeAddressManager::update_accept_list, std::move(update))();
 }
 
 void LeAddressManager::ClearResolvingList() {
@@ -615,21 +608,128 @@ void LeAddressManager::ClearResolvingList() {
     return;
   }
 
-  // Disable Address resolution
+  auto packet_builder = hci::LeClearResolvingListBuilder::Create();
+  ListUpdate update = {CommandType::CLEAR_RESOLVING_LIST, 0, Address::kEmpty, {}};
+  update.commands.push_back({CommandType::CLEAR_RESOLVING_LIST, HCICommand{std::move(packet_builder)}});
+  handler_->BindOnceOn(this, &LeAddressManager::update_resolving_list, std::move(update))();
+}
+
+void LeAddressManager::BeginListUpdates() {
+  handler_->BindOnceOn(this, &LeAddressManager::begin_list_updates)();
+}
+
+void LeAddressManager::CommitListUpdates() {
+  handler_->BindOnceOn(this, &LeAddressManager::commit_list_updates)();
+}
+
+void LeAddressManager::update_accept_list(ListUpdate update) {
+  if (list_update_batch_depth_ > 0) {
+    stage_list_update(pending_accept_list_updates_, std::move(update));
+    return;
+  }
+  for (auto& command : update.commands) {
+    push_command(std::move(command));
+  }
+}
+
+void LeAddressManager::update_resolving_list(ListUpdate update) {
+  if (list_update_batch_depth_ > 0) {
+    stage_list_update(pending_resolving_list_updates_, std::move(update));
+    return;
+  }
+  push_resolving_list_commands(std::move(update.commands));
+}
+
+// The resolving list can only be modified while address resolution is disabled.
+void LeAddressManager::push_resolving_list_commands(std::vector<Command> commands) {
   auto disable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED);
   Command disable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, HCICommand{std::move(disable_builder)}};
   cached_commands_.push(std::move(disable));
 
-  auto packet_builder = hci::LeClearResolvingListBuilder::Create();
-  Command command = {CommandType::CLEAR_RESOLVING_LIST, HCICommand{std::move(packet_builder)}};
-  cached_commands_.push(std::move(command));
+  for (auto& command : commands) {
+    cached_commands_.push(std::move(command));
+  }
 
-  // Enable Address resolution
   auto enable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED);
   Command enable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, HCICommand{std::move(enable_builder)}};
   cached_commands_.push(std::move(enable));
 
-  handler_->BindOnceOn(this, &LeAddressManager::pause_registered_clients)();
+  if (registered_clients_.empty()) {
+    handle_next_command();
+  } else {
+    pause_registered_clients();
+  }
+}
+
+// Keeps only the updates that still matter once the batch is committed:
+// - clearing a list drops every update staged before it,
+// - a device added then removed in the same batch is only removed, in case it
+//   was already in the list,
+// - repeating an update for a device only keeps the latest one.
+void LeAddressManager::stage_list_update(std::vector<ListUpdate>& updates, ListUpdate update) {
+  auto is_clear = [](CommandType type) {
+    return type == CommandType::CLEAR_ACCEPT_LIST || type == CommandType::CLEAR_RESOLVING_LIST;
+  };
+  auto is_add = [](CommandType type) {
+    return type == CommandType::ADD_DEVICE_TO_ACCEPT_LIST || type == CommandType::ADD_DEVICE_TO_RESOLVING_LIST;
+  };
+
+  if (is_clear(update.command_type)) {
+    updates.clear();
+    updates.push_back(std::move(update));
+    return;
+  }
+
+  auto previous = std::find_if(updates.rbegin(), updates.rend(), [&update, &is_clear](const ListUpdate& staged) {
+    return !is_clear(staged.command_type) && staged.address_type == update.address_type &&
+           staged.address == update.address;
+  });
+  if (previous != updates.rend() &&
+      (previous->command_type == update.command_type || is_add(previous->command_type))) {
+    updates.erase(std::next(previous).base());
+  }
+  updates.push_back(std::move(update));
+}
+
+void LeAddressManager::begin_list_updates() {
+  list_update_batch_depth_++;
+}
+
+void LeAddressManager::commit_list_updates() {
+  if (list_update_batch_depth_ == 0) {
+    log::warn("No list update batch to commit");
+    return;
+  }
+  if (--list_update_batch_depth_ > 0) {
+    return;
+  }
+
+  auto accept_list_updates = std::move(pending_accept_list_updates_);
+  auto resolving_list_updates = std::move(pending_resolving_list_updates_);
+  pending_accept_list_updates_.clear();
+  pending_resolving_list_updates_.clear();
+  log::info(
+      "Committing {} accept list and {} resolving list updates",
+      accept_list_updates.size(),
+      resolving_list_updates.size());
+
+  for (auto& update : accept_list_updates) {
+    for (auto& command : update.commands) {
+      cached_commands_.push(std::move(command));
+    }
+  }
+
+  if (!resolving_list_updates.empty()) {
+    std::vector<Command> commands;
+    for (auto& update : resolving_list_updates) {
+      for (auto& command : update.commands) {
+        commands.push_back(std::move(command));
+      }
+    }
+    push_resolving_list_commands(std::move(commands));
+  } else if (!accept_list_updates.empty()) {
+    pause_registered_clients();
+  }
 }
 
 template <class View>
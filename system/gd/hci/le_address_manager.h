@@ -17,8 +17,12 @@
 
 #include <bluetooth/log.h>
 
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <optional>
 #include <variant>
+#include <vector>
 
 #include "common/callback.h"
 #include "hci/address_with_type.h"
@@ -96,6 +100,11 @@ class LeAddressManager {
   void RemoveDeviceFromResolvingList(PeerAddressType peer_identity_address_type, Address peer_identity_address);
   void ClearFilterAcceptList();
   void ClearResolvingList();
+  // Filter accept list and resolving list updates made between these calls are
+  // coalesced and sent within a single pause of the registered clients. Calls
+  // may be nested; the updates are sent by the outermost CommitListUpdates().
+  void BeginListUpdates();
+  void CommitListUpdates();
   void OnCommandComplete(CommandCompleteView view);
   std::chrono::milliseconds GetNextPrivateAddressIntervalMs();
 
@@ -104,6 +113,15 @@ class LeAddressManager {
     return cached_commands_.size();
   }
 
+  // Number of times the registered clients were paused, and the total time
+  // they spent paused, for dumpsys.
+  size_t GetPauseWindowCount() const {
+    return pause_window_count_;
+  }
+  std::chrono::milliseconds GetTotalPausedTime() const {
+    return std::chrono::milliseconds(total_paused_time_ms_);
+  }
+
  protected:
   AddressPolicy address_policy_ = AddressPolicy::POLICY_NOT_SET;
   std::chrono::milliseconds minimum_rotation_time_;
@@ -143,6 +161,15 @@ class LeAddressManager {
     std::variant<RotateRandomAddressCommand, UpdateIRKCommand, HCICommand> contents;
   };
 
+  // An update of the filter accept list or of the resolving list, for a single
+  // device unless it clears the list.
+  struct ListUpdate {
+    CommandType command_type;
+    uint8_t address_type;
+    Address address;
+    std::vector<Command> commands;
+  };
+
   void pause_registered_clients();
   void push_command(Command command);
   void ack_pause(LeAddressManagerCallback* callback);
@@ -160,6 +187,12 @@ class LeAddressManager {
   hci::Address generate_nrpa();
   void handle_next_command();
   void check_cached_commands();
+  void update_accept_list(ListUpdate update);
+  void update_resolving_list(ListUpdate update);
+  void push_resolving_list_commands(std::vector<Command> commands);
+  void stage_list_update(std::vector<ListUpdate>& updates, ListUpdate update);
+  void begin_list_updates();
+  void commit_list_updates();
   template <class View>
   void on_command_complete(CommandCompleteView view);
 
@@ -176,6 +209,14 @@ class LeAddressManager {
   uint8_t resolving_list_size_;
   std::queue<Command> cached_commands_;
   bool supports_ble_privacy_{false};
+
+  size_t list_update_batch_depth_{0};
+  std::vector<ListUpdate> pending_accept_list_updates_;
+  std::vector<ListUpdate> pending_resolving_list_updates_;
+
+  std::optional<std::chrono::steady_clock::time_point> pause_start_;
+  std::atomic<size_t> pause_window_count_{0};
+  std::atomic<int64_t> total_paused_time_ms_{0};
 };
 
 }  // namespace hci
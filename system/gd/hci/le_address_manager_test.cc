@@ -485,6 +485,90 @@ TEST_F(LeAddressManagerWithSingleClientTest, register_during_command_complete) {
   clients[1].get()->WaitForResume();
 }
 
+TEST_F(LeAddressManagerWithSingleClientTest, batched_accept_list_updates) {
+  Address address_a;
+  Address::FromString("01:02:03:04:05:06", address_a);
+  Address address_b;
+  Address::FromString("01:02:03:04:05:07", address_b);
+  size_t pause_windows = le_address_manager_->GetPauseWindowCount();
+
+  le_address_manager_->BeginListUpdates();
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  le_address_manager_->RemoveDeviceFromFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  sync_handler(handler_);
+  ASSERT_FALSE(clients[0].get()->paused);
+  le_address_manager_->CommitListUpdates();
+
+  {
+    auto packet = hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST);
+    auto packet_view = LeAddDeviceToFilterAcceptListView::Create(
+        LeConnectionManagementCommandView::Create(AclCommandView::Create(packet)));
+    ASSERT_TRUE(packet_view.IsValid());
+    ASSERT_EQ(address_b, packet_view.GetAddress());
+    hci_layer_->IncomingEvent(
+        LeAddDeviceToFilterAcceptListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  }
+  {
+    auto packet = hci_layer_->GetCommand(OpCode::LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST);
+    auto packet_view = LeRemoveDeviceFromFilterAcceptListView::Create(
+        LeConnectionManagementCommandView::Create(AclCommandView::Create(packet)));
+    ASSERT_TRUE(packet_view.IsValid());
+    ASSERT_EQ(address_a, packet_view.GetAddress());
+    hci_layer_->IncomingEvent(
+        LeRemoveDeviceFromFilterAcceptListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  }
+  clients[0].get()->WaitForResume();
+  sync_handler(handler_);
+  hci_layer_->AssertNoQueuedCommand();
+  ASSERT_EQ(pause_windows + 1, le_address_manager_->GetPauseWindowCount());
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, batched_clear_drops_earlier_updates) {
+  Address address_a;
+  Address::FromString("01:02:03:04:05:06", address_a);
+  Address address_b;
+  Address::FromString("01:02:03:04:05:07", address_b);
+
+  le_address_manager_->BeginListUpdates();
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  le_address_manager_->ClearFilterAcceptList();
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  le_address_manager_->CommitListUpdates();
+
+  hci_layer_->GetCommand(OpCode::LE_CLEAR_FILTER_ACCEPT_LIST);
+  hci_layer_->IncomingEvent(LeClearFilterAcceptListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  auto packet = hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST);
+  auto packet_view = LeAddDeviceToFilterAcceptListView::Create(
+      LeConnectionManagementCommandView::Create(AclCommandView::Create(packet)));
+  ASSERT_TRUE(packet_view.IsValid());
+  ASSERT_EQ(address_b, packet_view.GetAddress());
+  hci_layer_->IncomingEvent(
+      LeAddDeviceToFilterAcceptListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+  sync_handler(handler_);
+  hci_layer_->AssertNoQueuedCommand();
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, nested_batches_sent_by_outermost_commit) {
+  Address address;
+  Address::FromString("01:02:03:04:05:06", address);
+
+  le_address_manager_->BeginListUpdates();
+  le_address_manager_->BeginListUpdates();
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address);
+  le_address_manager_->CommitListUpdates();
+  sync_handler(handler_);
+  hci_layer_->AssertNoQueuedCommand();
+
+  le_address_manager_->CommitListUpdates();
+  hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST);
+  hci_layer_->IncomingEvent(
+      LeAddDeviceToFilterAcceptListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+}
+
 }  // namespace
 }  // namespace hci
 }  // namespace bluetooth
@@ -32,6 +32,7 @@
 #include "module.h"
 #include "os/handler.h"
 #include "os/log.h"
+#include "os/stats.h"
 #include "os/system_properties.h"
 #include "storage/storage_module.h"
 
@@ -58,6 +59,9 @@ constexpr uint8_t kScanResponseBit = 3;
 constexpr uint8_t kLegacyBit = 4;
 constexpr uint8_t kDataStatusBits = 5;
 
+static os::StatsCounter stats_advertising_reports("scan.advertising_reports");
+static os::StatsCounter stats_scan_results("scan.results");
+
 // system properties
 const std::string kLeRxPathLossCompProperty = "bluetooth.hardware.radio.le_rx_path_loss_comp_db";
 const std::string kPropertyDisableApcfExtendedFeatures = "bluetooth.le.disable_apcf_extended_features";
@@ -454,6 +458,8 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
       int8_t rssi,
       uint16_t periodic_advertising_interval,
       const std::vector<uint8_t>& advertising_data) {
+    stats_advertising_reports.Increment();
+
     // When using the vendor command Le Set Extended Params to
     // configure a filter accept list based e.g. on the service UUIDs
     // found in the report, we ignore the scan responses as we cannot be
@@ -486,6 +492,7 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
               ? processed_report->extended_event_type
               : event_type;
 
+      stats_scan_results.Increment();
       scanning_callbacks_->OnScanResult(
           result_event_type,
           address_type,
@@ -19,7 +19,14 @@
 
 #include <bluetooth/log.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <optional>
+#include <queue>
+#include <thread>
+
 #include "common/init_flags.h"
+#include "os/trace.h"
 
 using ::bluetooth::os::Handler;
 using ::bluetooth::os::Thread;
@@ -58,6 +65,7 @@ DumpsysDataFinisher Module::GetDumpsysData(flatbuffers::FlatBufferBuilder* /* bu
 }
 
 Module* ModuleRegistry::Get(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto instance = started_modules_.find(module);
   log::assert_that(
       instance != started_modules_.end(),
@@ -66,6 +74,7 @@ Module* ModuleRegistry::Get(const ModuleFactory* module) const {
 }
 
 bool ModuleRegistry::IsStarted(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   return started_modules_.find(module) != started_modules_.end();
 }
 
@@ -97,13 +106,185 @@ Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
   log::info("Finished starting dependencies and calling Start() of {}", instance->ToString());
 
   last_instance_ = "starting " + instance->ToString();
-  instance->Start();
+  {
+    os::ScopedTrace trace("module_start", instance->ToString());
+    instance->Start();
+  }
   start_order_.push_back(module);
   started_modules_[module] = instance;
   log::info("Started {}", instance->ToString());
   return instance;
 }
 
+void ModuleRegistry::StartInParallel(ModuleList* modules, Thread* thread, size_t max_parallel) {
+  struct Node {
+    const ModuleFactory* factory;
+    Module* instance;
+    std::vector<size_t> dependencies;
+    std::vector<size_t> dependents;
+    size_t pending_dependencies = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+  };
+  std::vector<Node> nodes;
+  std::map<const ModuleFactory*, size_t> node_index;
+
+  // Construct the modules that aren't started and their dependencies, into a dependency graph
+  std::function<std::optional<size_t>(const ModuleFactory*)> add_node =
+      [&](const ModuleFactory* module) -> std::optional<size_t> {
+    if (IsStarted(module)) {
+      return std::nullopt;
+    }
+    auto it = node_index.find(module);
+    if (it != node_index.end()) {
+      return it->second;
+    }
+    Module* instance = module->ctor_();
+    set_registry_and_handler(instance, thread);
+    instance->ListDependencies(&instance->dependencies_);
+    size_t index = nodes.size();
+    node_index[module] = index;
+    nodes.push_back(Node{.factory = module, .instance = instance});
+    for (auto dependency : instance->dependencies_.list_) {
+      auto dependency_index = add_node(dependency);
+      if (dependency_index.has_value()) {
+        nodes[index].dependencies.push_back(*dependency_index);
+        nodes[*dependency_index].dependents.push_back(index);
+        nodes[index].pending_dependencies++;
+      }
+    }
+    return index;
+  };
+  for (auto module : modules->list_) {
+    add_node(module);
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::queue<size_t> ready;
+  std::vector<size_t> completed;
+  size_t num_in_progress = 0;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (nodes[i].pending_dependencies == 0) {
+      ready.push(i);
+    }
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  auto start_modules = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (completed.size() < nodes.size()) {
+      if (ready.empty()) {
+        log::assert_that(num_in_progress > 0, "Circular dependency between modules");
+        cv.wait(lock);
+        continue;
+      }
+      Node& node = nodes[ready.front()];
+      ready.pop();
+      num_in_progress++;
+      lock.unlock();
+
+      log::info("Starting {}", node.instance->ToString());
+      {
+        std::lock_guard<std::mutex> registry_lock(mutex_);
+        last_instance_ = "starting " + node.instance->ToString();
+      }
+      auto start = std::chrono::steady_clock::now();
+      {
+        os::ScopedTrace trace("module_start", node.instance->ToString());
+        node.instance->Start();
+      }
+      auto end = std::chrono::steady_clock::now();
+      {
+        std::lock_guard<std::mutex> registry_lock(mutex_);
+        start_order_.push_back(node.factory);
+        started_modules_[node.factory] = node.instance;
+      }
+      log::info("Started {}", node.instance->ToString());
+
+      lock.lock();
+      node.start = start;
+      node.end = end;
+      num_in_progress--;
+      completed.push_back(node_index[node.factory]);
+      for (auto dependent : node.dependents) {
+        if (--nodes[dependent].pending_dependencies == 0) {
+          ready.push(dependent);
+        }
+      }
+      cv.notify_all();
+    }
+  };
+
+  size_t num_threads = std::max<size_t>(1, std::min(max_parallel, nodes.size()));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++) {
+    threads.emplace_back(start_modules);
+  }
+  start_modules();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto total = std::chrono::steady_clock::now() - begin;
+
+  // Modules complete after their dependencies, so the critical paths are computed in one pass
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  std::vector<microseconds> critical_path(nodes.size());
+  std::vector<std::optional<size_t>> critical_dependency(nodes.size());
+  std::vector<ModuleStartRecord> timeline;
+  for (auto i : completed) {
+    microseconds longest{0};
+    for (auto dependency : nodes[i].dependencies) {
+      if (critical_path[dependency] > longest) {
+        longest = critical_path[dependency];
+        critical_dependency[i] = dependency;
+      }
+    }
+    critical_path[i] = longest + duration_cast<microseconds>(nodes[i].end - nodes[i].start);
+    timeline.push_back(ModuleStartRecord{
+        .name = nodes[i].instance->ToString(),
+        .start = duration_cast<microseconds>(nodes[i].start - begin),
+        .duration = duration_cast<microseconds>(nodes[i].end - nodes[i].start),
+        .critical_path = critical_path[i],
+    });
+  }
+
+  microseconds critical_path_length{0};
+  std::string critical_path_modules;
+  auto last = std::max_element(critical_path.begin(), critical_path.end());
+  if (last != critical_path.end()) {
+    critical_path_length = *last;
+    std::optional<size_t> i = last - critical_path.begin();
+    for (; i.has_value(); i = critical_dependency[*i]) {
+      critical_path_modules = nodes[*i].instance->ToString() +
+                              (critical_path_modules.empty() ? "" : " -> ") + critical_path_modules;
+    }
+  }
+  log::info(
+      "Started {} modules in {} us on {} threads, critical path {} us: {}",
+      nodes.size(),
+      duration_cast<microseconds>(total).count(),
+      num_threads,
+      critical_path_length.count(),
+      critical_path_modules);
+  for (const auto& record : timeline) {
+    log::info(
+        "  {}: started at {} us, took {} us",
+        record.name,
+        record.start.count(),
+        record.duration.count());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  start_timeline_ = std::move(timeline);
+}
+
+std::vector<ModuleStartRecord> ModuleRegistry::GetStartTimeline() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return start_timeline_;
+}
+
 void ModuleRegistry::StopAll() {
   // Since modules were brought up in dependency order, it is safe to tear down by going in reverse order.
   for (auto it = start_order_.rbegin(); it != start_order_.rend(); it++) {
@@ -111,6 +292,7 @@ void ModuleRegistry::StopAll() {
     log::assert_that(
         instance != started_modules_.end(), "assert failed: instance != started_modules_.end()");
     last_instance_ = "stopping " + instance->second->ToString();
+    os::ScopedTrace trace("module_stop", instance->second->ToString());
 
     // Clear the handler before stopping the module to allow it to shut down gracefully.
     log::info("Stopping Handler of Module {}", instance->second->ToString());
@@ -133,6 +315,7 @@ void ModuleRegistry::StopAll() {
 }
 
 os::Handler* ModuleRegistry::GetModuleHandler(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto started_instance = started_modules_.find(module);
   if (started_instance != started_modules_.end()) {
     return started_instance->second->GetHandler();
@@ -23,6 +23,7 @@
 #include <functional>
 #include <future>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -133,6 +134,15 @@ class Module {
   const ModuleRegistry* registry_;
 };
 
+// How the start of a module went in ModuleRegistry::StartInParallel(), relative to the call
+struct ModuleStartRecord {
+  std::string name;
+  std::chrono::microseconds start;
+  std::chrono::microseconds duration;
+  // Longest chain of dependency start durations ending with this module
+  std::chrono::microseconds critical_path;
+};
+
 class ModuleRegistry {
  friend Module;
  friend ModuleDumper;
@@ -156,6 +166,14 @@ class ModuleRegistry {
 
   Module* Start(const ModuleFactory* id, ::bluetooth::os::Thread* thread);
 
+  // Start all the modules on this list and their dependencies, each as soon as its dependencies
+  // are started: modules that don't depend on each other start concurrently, on up to
+  // max_parallel threads. Module handlers are all on the given thread, as with Start().
+  void StartInParallel(ModuleList* modules, ::bluetooth::os::Thread* thread, size_t max_parallel);
+
+  // Start timeline of the modules started by the last StartInParallel(), in start order
+  std::vector<ModuleStartRecord> GetStartTimeline() const;
+
   // Stop all running modules in reverse order of start
   void StopAll();
 
@@ -166,9 +184,12 @@ class ModuleRegistry {
 
   os::Handler* GetModuleHandler(const ModuleFactory* module) const;
 
+  // Guards the members below while StartInParallel() runs
+  mutable std::mutex mutex_;
   std::map<const ModuleFactory*, Module*> started_modules_;
   std::vector<const ModuleFactory*> start_order_;
   std::string last_instance_;
+  std::vector<ModuleStartRecord> start_timeline_;
 };
 
 class TestModuleRegistry : public ModuleRegistry {
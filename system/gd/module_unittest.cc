@@ -18,9 +18,11 @@
 
 #include <unistd.h>
 
+#include <atomic>
 #include <functional>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include "dumpsys_data_generated.h"
 #include "gtest/gtest.h"
@@ -176,6 +178,65 @@ const ModuleFactory TestModuleTwoDependencies::Factory = ModuleFactory([]() {
   return new TestModuleTwoDependencies();
 });
 
+// Modules that can only start quickly when started together
+std::atomic<int> num_concurrent_starts = 0;
+
+template <int N>
+class TestModuleConcurrentStart : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+  bool started_concurrently_ = false;
+
+ protected:
+  void ListDependencies(ModuleList* /* list */) const {}
+
+  void Start() override {
+    num_concurrent_starts++;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (num_concurrent_starts < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    started_concurrently_ = num_concurrent_starts >= 2;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  void Stop() override {}
+
+  std::string ToString() const override {
+    return std::string("TestModuleConcurrentStart") + std::to_string(N);
+  }
+};
+
+template <int N>
+const ModuleFactory TestModuleConcurrentStart<N>::Factory =
+    ModuleFactory([]() { return new TestModuleConcurrentStart<N>(); });
+
+class TestModuleConcurrentDependencies : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) const {
+    list->add<TestModuleConcurrentStart<1>>();
+    list->add<TestModuleConcurrentStart<2>>();
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetDependency<TestModuleConcurrentStart<1>>()->started_concurrently_);
+    EXPECT_TRUE(GetDependency<TestModuleConcurrentStart<2>>()->started_concurrently_);
+  }
+
+  void Stop() override {}
+
+  std::string ToString() const override {
+    return std::string("TestModuleConcurrentDependencies");
+  }
+};
+
+const ModuleFactory TestModuleConcurrentDependencies::Factory =
+    ModuleFactory([]() { return new TestModuleConcurrentDependencies(); });
+
 // To generate module unittest flatbuffer headers:
 // $ flatc --cpp module_unittest.fbs
 class TestModuleDumpState : public Module {
@@ -275,6 +336,61 @@ TEST_F(ModuleTest, two_dependencies) {
   EXPECT_FALSE(registry_->IsStarted<TestModuleTwoDependencies>());
 }
 
+TEST_F(ModuleTest, start_in_parallel_in_dependency_order) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_, 4);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleTwoDependencies>());
+
+  auto timeline = registry_->GetStartTimeline();
+  ASSERT_EQ(timeline.size(), 4u);
+  EXPECT_EQ(timeline.back().name, "TestModuleTwoDependencies");
+  for (const auto& record : timeline) {
+    EXPECT_GE(record.critical_path, record.duration);
+  }
+
+  registry_->StopAll();
+
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleTwoDependencies>());
+}
+
+TEST_F(ModuleTest, start_in_parallel_skips_started_modules) {
+  ModuleList first;
+  first.add<TestModuleOneDependency>();
+  registry_->Start(&first, thread_);
+
+  ModuleList second;
+  second.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&second, thread_, 4);
+
+  auto timeline = registry_->GetStartTimeline();
+  ASSERT_EQ(timeline.size(), 2u);
+  EXPECT_EQ(timeline.back().name, "TestModuleTwoDependencies");
+
+  registry_->StopAll();
+}
+
+TEST_F(ModuleTest, start_in_parallel_starts_independent_modules_concurrently) {
+  num_concurrent_starts = 0;
+  ModuleList list;
+  list.add<TestModuleConcurrentDependencies>();
+  registry_->StartInParallel(&list, thread_, 2);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleConcurrentDependencies>());
+
+  // The critical path goes through only one of the concurrent modules
+  auto timeline = registry_->GetStartTimeline();
+  ASSERT_EQ(timeline.size(), 3u);
+  EXPECT_LT(timeline[2].critical_path, timeline[0].duration + timeline[1].duration);
+
+  registry_->StopAll();
+}
+
 void post_to_module_one_handler() {
   std::this_thread::sleep_for(std::chrono::milliseconds(100));
   test_module_one_dependency_handler->Post(common::BindOnce([] { FAIL(); }));
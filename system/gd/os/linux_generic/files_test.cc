@@ -73,6 +73,15 @@ TEST(FilesTest, overwrite_test) {
   EXPECT_TRUE(std::filesystem::remove(temp_file));
 }
 
+TEST(FilesTest, write_read_binary_data_test) {
+  auto temp_dir = std::filesystem::temp_directory_path();
+  auto temp_file = temp_dir / "file_1.bin";
+  std::string data("\x01\x00\x02\x00", 4);
+  ASSERT_TRUE(WriteToFile(temp_file.string(), data));
+  EXPECT_THAT(ReadSmallFile(temp_file.string()), Optional(Eq(data)));
+  EXPECT_TRUE(std::filesystem::remove(temp_file));
+}
+
 TEST(FilesTest, write_read_empty_string_test) {
   auto temp_dir = std::filesystem::temp_directory_path();
   auto temp_file = temp_dir / "file_1.txt";
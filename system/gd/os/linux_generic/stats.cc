@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/stats.h"
+
+#include <bluetooth/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+namespace bluetooth {
+namespace os {
+
+namespace {
+
+constexpr int kMaxReadAttempts = 8;
+
+uint64_t boottime_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+}  // namespace
+
+bool ReadStatsPage(const void* page, size_t size, std::vector<StatsValue>* values) {
+  if (size < sizeof(StatsPageHeader)) {
+    return false;
+  }
+  auto header = static_cast<const StatsPageHeader*>(page);
+  if (header->magic != StatsPageHeader::kMagic || header->version != StatsPageHeader::kVersion ||
+      header->entry_size != sizeof(StatsPageEntry)) {
+    return false;
+  }
+  auto entries = reinterpret_cast<const StatsPageEntry*>(header + 1);
+  size_t capacity = std::min<size_t>(
+      header->capacity, (size - sizeof(StatsPageHeader)) / sizeof(StatsPageEntry));
+
+  for (int attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+    uint32_t sequence = header->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      continue;
+    }
+    size_t num_entries =
+        std::min<size_t>(header->num_entries.load(std::memory_order_acquire), capacity);
+    values->clear();
+    values->reserve(num_entries);
+    for (size_t i = 0; i < num_entries; i++) {
+      const StatsPageEntry& entry = entries[i];
+      values->push_back(StatsValue{
+          .name = std::string(entry.name, strnlen(entry.name, sizeof(entry.name))),
+          .type = entry.type,
+          .value = entry.value.load(std::memory_order_relaxed),
+      });
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->sequence.load(std::memory_order_relaxed) == sequence) {
+      return true;
+    }
+  }
+  return false;
+}
+
+StatsRegistry& StatsRegistry::Get() {
+  static StatsRegistry* registry = new StatsRegistry();
+  return *registry;
+}
+
+StatsRegistry::StatsRegistry() {
+  void* page = MAP_FAILED;
+  fd_ = memfd_create("bt_stats", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd_ < 0) {
+    log::error("memfd_create failed ({})", strerror(errno));
+  } else if (ftruncate(fd_, kStatsPageSize) != 0) {
+    log::error("ftruncate failed ({})", strerror(errno));
+  } else {
+    page = mmap(nullptr, kStatsPageSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+  }
+  if (page == MAP_FAILED) {
+    // Keep counting, for dumpsys, without publishing
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    page = mmap(
+        nullptr, kStatsPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    log::assert_that(page != MAP_FAILED, "unable to map the stats page");
+  }
+
+  header_ = new (page) StatsPageHeader{
+      .magic = StatsPageHeader::kMagic,
+      .version = StatsPageHeader::kVersion,
+      .sequence = 0,
+      .num_entries = 0,
+      .capacity = kStatsPageCapacity,
+      .entry_size = sizeof(StatsPageEntry),
+      .created_ns = boottime_ns(),
+      .reserved = {},
+  };
+  entries_ = reinterpret_cast<StatsPageEntry*>(header_ + 1);
+}
+
+std::atomic<uint64_t>* StatsRegistry::Register(const char* name, StatsType type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t num_entries = header_->num_entries.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < num_entries; i++) {
+    if (strncmp(entries_[i].name, name, StatsPageEntry::kMaxNameLength) == 0) {
+      return &entries_[i].value;
+    }
+  }
+  if (num_entries == header_->capacity) {
+    log::warn("No room for {} in the stats page", name);
+    return &unpublished_;
+  }
+  if (strlen(name) > StatsPageEntry::kMaxNameLength) {
+    log::warn("Stats name {} truncated to {} characters", name, StatsPageEntry::kMaxNameLength);
+  }
+
+  uint32_t sequence = header_->sequence.load(std::memory_order_relaxed);
+  header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  StatsPageEntry* entry = new (&entries_[num_entries]) StatsPageEntry{};
+  strncpy(entry->name, name, StatsPageEntry::kMaxNameLength);
+  entry->type = type;
+  header_->num_entries.store(num_entries + 1, std::memory_order_release);
+
+  header_->sequence.store(sequence + 2, std::memory_order_release);
+  return &entry->value;
+}
+
+std::vector<StatsValue> StatsRegistry::Read() const {
+  std::vector<StatsValue> values;
+  ReadStatsPage(header_, kStatsPageSize, &values);
+  return values;
+}
+
+}  // namespace os
+}  // namespace bluetooth
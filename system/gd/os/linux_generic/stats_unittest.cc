@@ -0,0 +1,171 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/stats.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+std::optional<StatsValue> Find(const std::vector<StatsValue>& values, const std::string& name) {
+  for (const auto& value : values) {
+    if (value.name == name) return value;
+  }
+  return std::nullopt;
+}
+
+// Maps the page the way a monitoring process does, through /proc
+class StatsPageReader {
+ public:
+  StatsPageReader() {
+    int fd = StatsRegistry::Get().GetFd();
+    if (fd < 0) return;
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    int reader_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (reader_fd < 0) return;
+    void* page = mmap(nullptr, kStatsPageSize, PROT_READ, MAP_SHARED, reader_fd, 0);
+    close(reader_fd);
+    if (page != MAP_FAILED) page_ = page;
+  }
+
+  ~StatsPageReader() {
+    if (page_ != nullptr) munmap(page_, kStatsPageSize);
+  }
+
+  bool IsMapped() const {
+    return page_ != nullptr;
+  }
+
+  std::vector<StatsValue> Read() const {
+    std::vector<StatsValue> values;
+    EXPECT_TRUE(ReadStatsPage(page_, kStatsPageSize, &values));
+    return values;
+  }
+
+ private:
+  void* page_ = nullptr;
+};
+
+TEST(StatsTest, counter_is_published) {
+  StatsPageReader reader;
+  ASSERT_TRUE(reader.IsMapped());
+
+  static StatsCounter counter("test.counter_is_published");
+  counter.Increment();
+  counter.Increment(41);
+
+  auto value = Find(reader.Read(), "test.counter_is_published");
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->type, StatsType::kCounter);
+  EXPECT_EQ(value->value, 42u);
+}
+
+TEST(StatsTest, gauge_is_signed) {
+  static StatsGauge gauge("test.gauge_is_signed");
+  gauge.Set(3);
+  gauge.Add(-5);
+
+  auto value = Find(StatsRegistry::Get().Read(), "test.gauge_is_signed");
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->type, StatsType::kGauge);
+  EXPECT_EQ(static_cast<int64_t>(value->value), -2);
+}
+
+TEST(StatsTest, same_name_shares_the_cell) {
+  static StatsCounter first("test.same_name_shares_the_cell");
+  static StatsCounter second("test.same_name_shares_the_cell");
+  first.Increment();
+  second.Increment();
+
+  auto values = StatsRegistry::Get().Read();
+  int count = 0;
+  for (const auto& value : values) {
+    if (value.name == "test.same_name_shares_the_cell") {
+      EXPECT_EQ(value.value, 2u);
+      count++;
+    }
+  }
+  EXPECT_EQ(count, 1);
+}
+
+TEST(StatsTest, long_name_is_truncated) {
+  std::string name(StatsPageEntry::kMaxNameLength + 10, 'x');
+  StatsCounter counter(name.c_str());
+  counter.Increment();
+
+  auto truncated = name.substr(0, StatsPageEntry::kMaxNameLength);
+  EXPECT_TRUE(Find(StatsRegistry::Get().Read(), truncated).has_value());
+}
+
+TEST(StatsTest, concurrent_updates_and_reads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumIncrements = 100000;
+  static StatsCounter counter("test.concurrent_updates_and_reads");
+  StatsPageReader reader;
+  ASSERT_TRUE(reader.IsMapped());
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([i] {
+      // Registrations concurrent with the reads below
+      std::string name = "test.concurrent_updates_and_reads." + std::to_string(i);
+      StatsCounter registered(name.c_str());
+      registered.Increment();
+      for (int j = 0; j < kNumIncrements; j++) {
+        counter.Increment();
+      }
+    });
+  }
+  uint64_t last = 0;
+  for (int i = 0; i < 100; i++) {
+    auto value = Find(reader.Read(), "test.concurrent_updates_and_reads");
+    if (!value.has_value()) continue;
+    EXPECT_GE(value->value, last);
+    last = value->value;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto values = reader.Read();
+  EXPECT_EQ(Find(values, "test.concurrent_updates_and_reads")->value,
+            static_cast<uint64_t>(kNumThreads * kNumIncrements));
+  for (int i = 0; i < kNumThreads; i++) {
+    EXPECT_TRUE(
+        Find(values, "test.concurrent_updates_and_reads." + std::to_string(i)).has_value());
+  }
+}
+
+TEST(StatsTest, unknown_page_is_rejected) {
+  std::vector<uint8_t> page(kStatsPageSize, 0);
+  std::vector<StatsValue> values;
+  EXPECT_FALSE(ReadStatsPage(page.data(), page.size(), &values));
+  EXPECT_FALSE(ReadStatsPage(page.data(), sizeof(StatsPageHeader) - 1, &values));
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/trace.h"
+
+#include <bluetooth/log.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "os/files.h"
+
+namespace bluetooth {
+namespace os {
+
+namespace internal {
+std::atomic<bool> tracing{false};
+}  // namespace internal
+
+namespace {
+
+// Long enough for a name set with pthread_setname_np
+constexpr size_t kThreadNameSize = 16;
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  uint64_t timestamp_ns;
+  char phase;
+};
+
+// Only written by its thread. The exporter reads the first |count| events of the buffers recorded
+// during the current session.
+struct ThreadBuffer {
+  pid_t tid;
+  char thread_name[kThreadNameSize];
+  std::atomic<uint32_t> session{0};
+  std::atomic<size_t> count{0};
+  std::atomic<size_t> dropped{0};
+  TraceEvent events[kTraceBufferCapacity];
+};
+
+std::atomic<uint32_t> current_session{0};
+
+// Buffers outlive their threads, so that the events of a thread which exited are still exported
+std::mutex buffers_mutex;
+std::vector<ThreadBuffer*>& Buffers() {
+  static auto* buffers = new std::vector<ThreadBuffer*>();
+  return *buffers;
+}
+
+thread_local ThreadBuffer* thread_buffer = nullptr;
+
+ThreadBuffer* GetThreadBuffer() {
+  if (thread_buffer == nullptr) {
+    thread_buffer = new ThreadBuffer();
+    thread_buffer->tid = static_cast<pid_t>(syscall(SYS_gettid));
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    Buffers().push_back(thread_buffer);
+  }
+  return thread_buffer;
+}
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Record(const char* category, const char* name, char phase) {
+  if (!IsTracing()) {
+    return;
+  }
+  uint64_t timestamp_ns = now_ns();
+  ThreadBuffer* buffer = GetThreadBuffer();
+  uint32_t session = current_session.load(std::memory_order_acquire);
+  if (buffer->session.load(std::memory_order_relaxed) != session) {
+    // First event of this thread in the session: drop the events of the previous one
+    buffer->count.store(0, std::memory_order_relaxed);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+    if (pthread_getname_np(pthread_self(), buffer->thread_name, kThreadNameSize) != 0) {
+      buffer->thread_name[0] = '\0';
+    }
+    buffer->session.store(session, std::memory_order_release);
+  }
+  size_t count = buffer->count.load(std::memory_order_relaxed);
+  if (count == kTraceBufferCapacity) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer->events[count] = TraceEvent{category, name, timestamp_ns, phase};
+  buffer->count.store(count + 1, std::memory_order_release);
+}
+
+void AppendJsonString(std::stringstream& ss, const char* text) {
+  ss << '"';
+  for (const char* c = text; *c != '\0'; c++) {
+    switch (*c) {
+      case '"':
+        ss << "\\\"";
+        break;
+      case '\\':
+        ss << "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+          ss << escaped;
+        } else {
+          ss << *c;
+        }
+    }
+  }
+  ss << '"';
+}
+
+// Chrome trace timestamps are in microseconds
+void AppendTimestamp(std::stringstream& ss, uint64_t timestamp_ns) {
+  char timestamp[32];
+  snprintf(
+      timestamp,
+      sizeof(timestamp),
+      "%llu.%03llu",
+      static_cast<unsigned long long>(timestamp_ns / 1000),
+      static_cast<unsigned long long>(timestamp_ns % 1000));
+  ss << timestamp;
+}
+
+}  // namespace
+
+void StartTracing() {
+  current_session.fetch_add(1, std::memory_order_release);
+  internal::tracing.store(true, std::memory_order_relaxed);
+}
+
+void StopTracing() {
+  internal::tracing.store(false, std::memory_order_relaxed);
+}
+
+std::string ExportChromeTrace() {
+  uint32_t session = current_session.load(std::memory_order_acquire);
+  std::vector<ThreadBuffer*> buffers;
+  {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffers = Buffers();
+  }
+
+  std::stringstream ss;
+  ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  size_t dropped = 0;
+  int pid = getpid();
+  for (const ThreadBuffer* buffer : buffers) {
+    if (buffer->session.load(std::memory_order_acquire) != session) {
+      continue;
+    }
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+    if (!first) {
+      ss << ",";
+    }
+    first = false;
+    ss << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+       << ",\"args\":{\"name\":";
+    AppendJsonString(ss, buffer->thread_name);
+    ss << "}}";
+    for (size_t i = 0; i < count; i++) {
+      const TraceEvent& event = buffer->events[i];
+      ss << ",{\"ph\":\"" << event.phase << "\",";
+      if (event.phase == 'i') {
+        ss << "\"s\":\"t\",";
+      }
+      ss << "\"cat\":";
+      AppendJsonString(ss, event.category);
+      ss << ",\"name\":";
+      AppendJsonString(ss, event.name);
+      ss << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"ts\":";
+      AppendTimestamp(ss, event.timestamp_ns);
+      ss << "}";
+    }
+  }
+  ss << "],\"otherData\":{\"dropped_events\":\"" << dropped << "\"}}";
+  return ss.str();
+}
+
+bool WriteChromeTrace(const std::string& path) {
+  if (!WriteToFile(path, ExportChromeTrace())) {
+    log::error("Unable to write trace to {}", path);
+    return false;
+  }
+  return true;
+}
+
+void TraceBegin(const char* category, const char* name) {
+  Record(category, name, 'B');
+}
+
+void TraceEnd(const char* category, const char* name) {
+  Record(category, name, 'E');
+}
+
+void TraceInstant(const char* category, const char* name) {
+  Record(category, name, 'i');
+}
+
+const char* TraceName(const std::string& name) {
+  static std::mutex names_mutex;
+  static auto* names = new std::set<std::string>();
+  std::lock_guard<std::mutex> lock(names_mutex);
+  return names->insert(name).first->c_str();
+}
+
+}  // namespace os
+}  // namespace bluetooth
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/trace.h"
+
+#include <gtest/gtest.h>
+#include <pthread.h>
+
+#include <string>
+#include <thread>
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+size_t Count(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+class TraceTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    StopTracing();
+  }
+};
+
+TEST_F(TraceTest, nothing_recorded_when_not_tracing) {
+  StartTracing();
+  StopTracing();
+  { ScopedTrace trace("test", "not_traced"); }
+
+  std::string trace = ExportChromeTrace();
+  EXPECT_EQ(trace.find("not_traced"), std::string::npos);
+}
+
+TEST_F(TraceTest, scoped_trace) {
+  StartTracing();
+  {
+    ScopedTrace outer("test", "outer");
+    ScopedTrace inner("test", std::string("inner_") + "runtime");
+  }
+  StopTracing();
+
+  std::string trace = ExportChromeTrace();
+  EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+  EXPECT_NE(trace.find("\"ph\":\"B\",\"cat\":\"test\",\"name\":\"outer\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"E\",\"cat\":\"test\",\"name\":\"outer\""), std::string::npos);
+  EXPECT_NE(
+      trace.find("\"ph\":\"B\",\"cat\":\"test\",\"name\":\"inner_runtime\""), std::string::npos);
+  EXPECT_LT(
+      trace.find("\"name\":\"inner_runtime\""),
+      trace.find("\"ph\":\"E\",\"cat\":\"test\",\"name\":\"outer\""));
+  EXPECT_NE(trace.find("\"dropped_events\":\"0\""), std::string::npos);
+}
+
+TEST_F(TraceTest, new_session_drops_previous_events) {
+  StartTracing();
+  TraceInstant("test", "first_session");
+  StartTracing();
+  TraceInstant("test", "second_session");
+  StopTracing();
+
+  std::string trace = ExportChromeTrace();
+  EXPECT_EQ(trace.find("first_session"), std::string::npos);
+  EXPECT_NE(trace.find("second_session"), std::string::npos);
+}
+
+TEST_F(TraceTest, events_of_each_thread) {
+  StartTracing();
+  std::thread thread([] {
+    pthread_setname_np(pthread_self(), "trace_worker");
+    ScopedTrace trace("test", "worker");
+  });
+  thread.join();
+  { ScopedTrace trace("test", "main"); }
+  StopTracing();
+
+  std::string trace = ExportChromeTrace();
+  EXPECT_NE(trace.find("\"args\":{\"name\":\"trace_worker\"}"), std::string::npos);
+  EXPECT_EQ(Count(trace, "\"name\":\"thread_name\""), 2u);
+  EXPECT_EQ(Count(trace, "\"name\":\"worker\""), 2u);
+  EXPECT_EQ(Count(trace, "\"name\":\"main\""), 2u);
+}
+
+TEST_F(TraceTest, full_buffer_drops_events) {
+  StartTracing();
+  for (size_t i = 0; i < kTraceBufferCapacity + 3; i++) {
+    TraceInstant("test", "instant");
+  }
+  StopTracing();
+
+  std::string trace = ExportChromeTrace();
+  EXPECT_EQ(Count(trace, "\"name\":\"instant\""), kTraceBufferCapacity);
+  EXPECT_NE(trace.find("\"dropped_events\":\"3\""), std::string::npos);
+}
+
+TEST_F(TraceTest, escapes_names) {
+  StartTracing();
+  TraceInstant("test", "quote\" backslash\\ newline\n");
+  StopTracing();
+
+  std::string trace = ExportChromeTrace();
+  EXPECT_NE(trace.find("\"name\":\"quote\\\" backslash\\\\ newline\\u000a\""), std::string::npos);
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
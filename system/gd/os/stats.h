@@ -0,0 +1,164 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Counters and gauges of the stack, published in a memfd that a monitoring process maps read only.
+//
+// Updating a stat is a relaxed atomic operation on the shared mapping: stack threads never lock
+// nor make a syscall for it, and readers never touch the stack threads. Stats are registered on
+// first use, under a seqlock so that readers see a consistent list of names.
+//
+// Stats are declared where they are updated, with a constant name:
+//
+//   static os::StatsCounter acl_packets_sent("acl.packets_sent");
+//   acl_packets_sent.Increment();
+namespace bluetooth {
+namespace os {
+
+// Layout of the stats page, shared with the reading process.
+struct StatsPageHeader {
+  static constexpr uint32_t kMagic = 0x54534442;  // "BDST"
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  // Odd while a stat is being registered
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint32_t> num_entries;
+  uint32_t capacity;
+  uint32_t entry_size;
+  // CLOCK_BOOTTIME of the creation of the page
+  uint64_t created_ns;
+  uint8_t reserved[32];
+};
+static_assert(sizeof(StatsPageHeader) == 64);
+
+enum class StatsType : uint8_t { kCounter = 1, kGauge = 2 };
+
+struct StatsPageEntry {
+  static constexpr size_t kMaxNameLength = 54;
+
+  // NUL terminated
+  char name[kMaxNameLength + 1];
+  StatsType type;
+  // Counters are unsigned, gauges are two's complement signed
+  std::atomic<uint64_t> value;
+};
+static_assert(sizeof(StatsPageEntry) == 64);
+
+// Size of the memfd: header and entries
+constexpr size_t kStatsPageSize = 16 * 1024;
+constexpr size_t kStatsPageCapacity =
+    (kStatsPageSize - sizeof(StatsPageHeader)) / sizeof(StatsPageEntry);
+
+struct StatsValue {
+  std::string name;
+  StatsType type;
+  uint64_t value;
+};
+
+// Reads a consistent snapshot of a mapped stats page. Returns false if the page isn't a stats page
+// of a known version, or if it kept changing during the read.
+bool ReadStatsPage(const void* page, size_t size, std::vector<StatsValue>* values);
+
+class StatsRegistry {
+ public:
+  // The registry of the process.
+  static StatsRegistry& Get();
+
+  // File descriptor of the stats page, or -1 if it couldn't be created. Owned by the registry.
+  int GetFd() const {
+    return fd_;
+  }
+
+  // Returns the cell of the stat, registering it if needed. Stats that don't fit in the page get a
+  // cell that isn't published.
+  std::atomic<uint64_t>* Register(const char* name, StatsType type);
+
+  // Snapshot of the page, as seen by a reader.
+  std::vector<StatsValue> Read() const;
+
+ private:
+  StatsRegistry();
+
+  int fd_ = -1;
+  StatsPageHeader* header_ = nullptr;
+  StatsPageEntry* entries_ = nullptr;
+  std::mutex mutex_;
+  std::atomic<uint64_t> unpublished_;
+};
+
+namespace internal {
+
+// A stat resolved to its cell on first use.
+class StatsCell {
+ public:
+  constexpr StatsCell(const char* name, StatsType type) : name_(name), type_(type) {}
+  StatsCell(const StatsCell&) = delete;
+  StatsCell& operator=(const StatsCell&) = delete;
+
+ protected:
+  std::atomic<uint64_t>& cell() {
+    std::atomic<uint64_t>* cell = cell_.load(std::memory_order_acquire);
+    if (cell == nullptr) {
+      cell = StatsRegistry::Get().Register(name_, type_);
+      cell_.store(cell, std::memory_order_release);
+    }
+    return *cell;
+  }
+
+ private:
+  const char* const name_;
+  const StatsType type_;
+  std::atomic<std::atomic<uint64_t>*> cell_{nullptr};
+};
+
+}  // namespace internal
+
+// Monotonic count of events.
+class StatsCounter : public internal::StatsCell {
+ public:
+  constexpr explicit StatsCounter(const char* name) : StatsCell(name, StatsType::kCounter) {}
+
+  void Increment(uint64_t delta = 1) {
+    cell().fetch_add(delta, std::memory_order_relaxed);
+  }
+};
+
+// Current level of something, e.g. a queue depth.
+class StatsGauge : public internal::StatsCell {
+ public:
+  constexpr explicit StatsGauge(const char* name) : StatsCell(name, StatsType::kGauge) {}
+
+  void Set(int64_t value) {
+    cell().store(static_cast<uint64_t>(value), std::memory_order_relaxed);
+  }
+
+  void Add(int64_t delta) {
+    cell().fetch_add(static_cast<uint64_t>(delta), std::memory_order_relaxed);
+  }
+};
+
+}  // namespace os
+}  // namespace bluetooth
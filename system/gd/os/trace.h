@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+// Begin and end events of the phases of the stack, e.g. the steps of enabling and disabling it,
+// exported in the Chrome trace event format that chrome://tracing and the Perfetto UI open.
+//
+// Events are only recorded between StartTracing() and StopTracing(). Each thread records into its
+// own buffer without locking; events that don't fit are dropped and counted in the export. Tracing
+// a scope while tracing is off costs a relaxed load.
+//
+//   os::ScopedTrace trace("stack", "l2c_init");
+namespace bluetooth {
+namespace os {
+
+// Events kept per thread and tracing session
+constexpr size_t kTraceBufferCapacity = 2048;
+
+// Starts a new tracing session, discarding the events of the previous one.
+void StartTracing();
+
+void StopTracing();
+
+namespace internal {
+extern std::atomic<bool> tracing;
+}  // namespace internal
+
+inline bool IsTracing() {
+  return internal::tracing.load(std::memory_order_relaxed);
+}
+
+// Events of the current or last tracing session, as a Chrome trace event JSON document. Call it
+// while no new session starts.
+std::string ExportChromeTrace();
+
+// Writes ExportChromeTrace() to |path|
+bool WriteChromeTrace(const std::string& path);
+
+// |category| and |name| must outlive the tracing session, e.g. be string literals.
+void TraceBegin(const char* category, const char* name);
+void TraceEnd(const char* category, const char* name);
+void TraceInstant(const char* category, const char* name);
+
+// Returns a copy of |name| that lives until the process exits, for names built at run time.
+const char* TraceName(const std::string& name);
+
+// Traces the lifetime of the object, on the thread that creates and destroys it.
+class ScopedTrace {
+ public:
+  ScopedTrace(const char* category, const char* name) {
+    if (IsTracing()) {
+      Begin(category, name);
+    }
+  }
+
+  ScopedTrace(const char* category, const std::string& name) {
+    if (IsTracing()) {
+      Begin(category, TraceName(name));
+    }
+  }
+
+  ~ScopedTrace() {
+    if (name_ != nullptr) {
+      TraceEnd(category_, name_);
+    }
+  }
+
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+ private:
+  void Begin(const char* category, const char* name) {
+    category_ = category;
+    name_ = name;
+    TraceBegin(category, name);
+  }
+
+  const char* category_ = nullptr;
+  // Null if tracing was off when the scope began
+  const char* name_ = nullptr;
+};
+
+}  // namespace os
+}  // namespace bluetooth
@@ -29,11 +29,39 @@ PacketView<little_endian>::PacketView(const std::forward_list<class View> fragme
   for (auto fragment : fragments_) {
     length_ += fragment.size();
   }
+  UpdateContiguousData();
 }
 
 template <bool little_endian>
 PacketView<little_endian>::PacketView(std::shared_ptr<const std::vector<uint8_t>> packet)
-    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()) {}
+    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()) {
+  UpdateContiguousData();
+}
+
+template <bool little_endian>
+void PacketView<little_endian>::UpdateContiguousData() {
+  // Subviews may carry empty fragments, which do not break contiguity.
+  contiguous_data_ = nullptr;
+  if (fragments_.empty()) {
+    return;
+  }
+  const View* data_fragment = &fragments_.front();
+  for (const auto& fragment : fragments_) {
+    if (fragment.size() == 0) {
+      continue;
+    }
+    if (data_fragment->size() != 0 && data_fragment != &fragment) {
+      return;
+    }
+    data_fragment = &fragment;
+  }
+  contiguous_data_ = data_fragment->data();
+}
+
+template <bool little_endian>
+bool PacketView<little_endian>::IsContiguous() const {
+  return contiguous_data_ != nullptr;
+}
 
 template <bool little_endian>
 Iterator<little_endian> PacketView<little_endian>::begin() const {
@@ -116,6 +144,7 @@ void PacketView<little_endian>::Append(PacketView to_add) {
     insertion_point++;
   }
   length_ += to_add.length_;
+  UpdateContiguousData();
 }
 
 // Explicit instantiations for both types of PacketViews.
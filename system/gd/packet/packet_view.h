@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <forward_list>
+#include <type_traits>
 #include <vector>
 
 #include "packet/iterator.h"
@@ -51,12 +52,37 @@ class PacketView {
   PacketView<true> GetLittleEndianSubview(size_t begin, size_t end) const;
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
 
+  // True when the packet is held in a single fragment.
+  bool IsContiguous() const;
+
  protected:
   void Append(PacketView to_add);
 
+  // Returns the packet bytes when they are held in a single fragment, or
+  // nullptr when the packet must be read through iterators.
+  const uint8_t* GetContiguousData() const {
+    return contiguous_data_;
+  }
+
+  // Reads a T at |data| without going through an Iterator.
+  template <typename T>
+  static T ExtractContiguous(const uint8_t* data) {
+    static_assert(std::is_trivially_copyable<T>::value, "Contiguous extraction needs a trivial type");
+    T extracted_value{};
+    uint8_t* value_ptr = reinterpret_cast<uint8_t*>(&extracted_value);
+    for (size_t i = 0; i < sizeof(T); i++) {
+      size_t index = (little_endian ? i : sizeof(T) - i - 1);
+      value_ptr[index] = data[i];
+    }
+    return extracted_value;
+  }
+
  private:
   std::forward_list<View> fragments_;
   size_t length_;
+  const uint8_t* contiguous_data_;
+
+  void UpdateContiguousData();
 
   std::forward_list<View> GetSubviewList(size_t begin, size_t end) const;
 };
@@ -563,10 +563,22 @@ TEST_F(PacketViewMultiViewTest, arrayOperatorTest) {
   ASSERT_DEATH(multi_view[single_view.size()], "");
 }
 
+TEST_F(PacketViewMultiViewTest, contiguousTest) {
+  ASSERT_TRUE(single_view.IsContiguous());
+  ASSERT_FALSE(multi_view.IsContiguous());
+  ASSERT_TRUE(single_view.GetLittleEndianSubview(1, 5).IsContiguous());
+  ASSERT_TRUE(multi_view.GetLittleEndianSubview(0, count_1.size()).IsContiguous());
+  ASSERT_FALSE(multi_view.GetLittleEndianSubview(0, count_1.size() + 1).IsContiguous());
+}
+
 TEST_F(PacketViewMultiViewAppendTest, sizeTestAppend) {
   ASSERT_EQ(single_view.size(), multi_view.size());
 }
 
+TEST_F(PacketViewMultiViewAppendTest, contiguousTestAppend) {
+  ASSERT_FALSE(multi_view.IsContiguous());
+}
+
 TEST_F(PacketViewMultiViewAppendTest, dereferenceTestLittleEndianAppend) {
   auto single_itr = single_view.begin();
   auto multi_itr = multi_view.begin();
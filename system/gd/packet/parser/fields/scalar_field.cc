@@ -96,9 +96,37 @@ std::string ScalarField::GetGetterFunctionName() const {
   return ss.str();
 }
 
+void ScalarField::GenContiguousGetter(std::ostream& s, Size start_offset) const {
+  // Only fields at a static offset that fill the whole extract type can be
+  // read straight from the buffer; the others go through the iterators.
+  if (start_offset.empty() || start_offset.has_dynamic()) {
+    return;
+  }
+  int num_leading_bits = start_offset.bits() % 8;
+  int num_bits = GetSize().bits() + num_leading_bits;
+  int num_bytes = (num_bits + 7) / 8;
+  if (num_bytes != util::RoundSizeUp(num_bits) / 8) {
+    return;
+  }
+  std::string extract_type = util::GetTypeForSize(num_bits);
+  s << "if (const uint8_t* contiguous_data = GetContiguousData()) {";
+  s << "auto extracted_value = ExtractContiguous<" << extract_type << ">(contiguous_data + "
+    << start_offset.bits() / 8 << ");";
+  if (num_leading_bits != 0) {
+    s << "extracted_value >>= " << num_leading_bits << ";";
+  }
+  if (util::RoundSizeUp(GetSize().bits()) != GetSize().bits()) {
+    uint64_t mask = (static_cast<uint64_t>(1) << GetSize().bits()) - 1;
+    s << "extracted_value &= 0x" << std::hex << mask << std::dec << ";";
+  }
+  s << "return static_cast<" << GetDataType() << ">(extracted_value);";
+  s << "}";
+}
+
 void ScalarField::GenGetter(std::ostream& s, Size start_offset, Size end_offset) const {
   s << GetDataType() << " " << GetGetterFunctionName() << "() const {";
   s << "ASSERT(was_validated_);";
+  GenContiguousGetter(s, start_offset);
   s << "auto to_bound = begin();";
   int num_leading_bits = GenBounds(s, start_offset, end_offset, GetSize());
   s << GetDataType() << " " << GetName() << "_value{};";
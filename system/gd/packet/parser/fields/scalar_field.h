@@ -56,5 +56,9 @@ class ScalarField : public PacketField {
   }
 
  private:
+  // Emits a read straight from a single-fragment buffer, when the field's
+  // position allows it.
+  void GenContiguousGetter(std::ostream& s, Size start_offset) const;
+
   const int size_;
 };
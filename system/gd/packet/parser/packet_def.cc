@@ -89,7 +89,9 @@ void PacketDef::GenParserDefinition(std::ostream& s, bool generate_fuzzing, bool
   // Constructor from a View
   if (parent_ != nullptr) {
     s << "explicit " << name_ << "View(" << parent_->name_ << "View parent)";
-    s << " : " << parent_->name_ << "View(std::move(parent)) { was_validated_ = false; }";
+    s << " : " << parent_->name_ << "View(std::move(parent)) {";
+    s << "if (was_validated_) { validated_depth_ = " << GetAncestors().size() << "; }";
+    s << "was_validated_ = false; }";
   } else {
     s << "explicit " << name_ << "View(PacketView<" << (is_little_endian_ ? "" : "!") << "kLittleEndian> packet) ";
     s << " : PacketView<" << (is_little_endian_ ? "" : "!") << "kLittleEndian>(packet) { was_validated_ = false;}";
@@ -193,26 +195,34 @@ void PacketDef::GenValidator(std::ostream& s) const {
   }
 
   // Generate the public validator IsValid().
-  // The method only needs to be generated for the top most class.
-  if (parent_ == nullptr) {
+  // The method is generated for the top most class, and for the leaf classes
+  // where Validate() is final and can be called without virtual dispatch.
+  bool is_leaf = parent_ != nullptr && children_.empty();
+  if (parent_ == nullptr || is_leaf) {
     s << "bool IsValid() {" << std::endl;
     s << "  if (was_validated_) {" << std::endl;
     s << "    return true;" << std::endl;
     s << "  } else {" << std::endl;
     s << "    was_validated_ = true;" << std::endl;
-    s << "    return (was_validated_ = Validate());" << std::endl;
+    if (is_leaf) {
+      s << "    return (was_validated_ = " << name_ << "View::Validate());" << std::endl;
+    } else {
+      s << "    return (was_validated_ = Validate());" << std::endl;
+    }
     s << "  }" << std::endl;
     s << "}" << std::endl;
   }
 
   // Generate the private validator Validate().
-  // The method is overridden by all child classes.
+  // The method is overridden by all child classes. Ancestors that were
+  // already validated before the view was specialized are not checked again.
   s << "protected:" << std::endl;
   if (parent_ == nullptr) {
     s << "virtual bool Validate() const {" << std::endl;
   } else {
-    s << "bool Validate() const override {" << std::endl;
-    s << "  if (!" << parent_->name_ << "View::Validate()) {" << std::endl;
+    s << "bool Validate() const " << (is_leaf ? "final" : "override") << " {" << std::endl;
+    s << "  if (validated_depth_ < " << GetAncestors().size() << " && !" << parent_->name_ << "View::Validate()) {"
+      << std::endl;
     s << "    return false;" << std::endl;
     s << "  }" << std::endl;
   }
@@ -225,14 +235,14 @@ void PacketDef::GenValidator(std::ostream& s) const {
     parent_size = parent_->GetSize(true);
   }
 
-  s << "auto it = begin() + (" << parent_size << ") / 8;";
+  s << "size_t end_index = (" << parent_size << ") / 8;";
 
   // Check if you can extract the static fields.
   // At this point you know you can use the size getters without crashing
   // as long as they follow the instruction that size fields cant come before
   // their corrisponding variable length field.
-  s << "it += " << ((bits_size + 7) / 8) << " /* Total size of the fixed fields */;";
-  s << "if (it > end()) return false;";
+  s << "end_index += " << ((bits_size + 7) / 8) << " /* Total size of the fixed fields */;";
+  s << "if (end_index > size()) return false;";
 
   // For any variable length fields, use their size check.
   for (const auto& field : fields_) {
@@ -308,12 +318,12 @@ void PacketDef::GenValidator(std::ostream& s) const {
       s << "(begin() + (" << offset << ") / 8);";
 
       s << "if (!" << custom_size_var << ".has_value()) { return false; }";
-      s << "it += *" << custom_size_var << ";";
-      s << "if (it > end()) return false;";
+      s << "end_index += *" << custom_size_var << ";";
+      s << "if (end_index > size()) return false;";
       continue;
     } else {
-      s << "it += (" << field_size.dynamic_string() << ") / 8;";
-      s << "if (it > end()) return false;";
+      s << "end_index += (" << field_size.dynamic_string() << ") / 8;";
+      s << "if (end_index > size()) return false;";
     }
   }
 
@@ -343,6 +353,8 @@ void PacketDef::GenValidator(std::ostream& s) const {
   s << "}\n";
   if (parent_ == nullptr) {
     s << "bool was_validated_{false};\n";
+    s << "// Depth of the deepest ancestor known to be valid, the root being 1.\n";
+    s << "uint8_t validated_depth_{0};\n";
   }
 }
 
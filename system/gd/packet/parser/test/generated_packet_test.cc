@@ -252,6 +252,31 @@ TEST(GeneratedPacketTest, testMiddleFourBitsPacket) {
   ASSERT_EQ(high_two, view.GetHighTwo());
 }
 
+TEST(GeneratedPacketTest, testMiddleFourBitsPacketFragmented) {
+  auto packet_bytes = std::make_shared<std::vector<uint8_t>>(middle_four_bits);
+  std::forward_list<View> fragments = {View(packet_bytes, 0, 1), View(packet_bytes, 1, 2)};
+  PacketView<kLittleEndian> fragmented_view(fragments);
+  ASSERT_FALSE(fragmented_view.IsContiguous());
+
+  MiddleFourBitsView view = MiddleFourBitsView::Create(fragmented_view);
+  ASSERT_TRUE(view.IsValid());
+  ASSERT_EQ(TwoBits::ONE, view.GetLowTwo());
+  ASSERT_EQ(FourBits::FIVE, view.GetNextFour());
+  ASSERT_EQ(FourBits::TEN, view.GetStraddle());
+  ASSERT_EQ(FourBits::TWO, view.GetFourMore());
+  ASSERT_EQ(TwoBits::TWO, view.GetHighTwo());
+}
+
+TEST(GeneratedPacketTest, testChildOfInvalidParent) {
+  std::vector<uint8_t> too_small_bytes = {0x34};
+  auto too_small = std::make_shared<std::vector<uint8_t>>(too_small_bytes.begin(), too_small_bytes.end());
+
+  ParentWithSixBytesView invalid_parent = ParentWithSixBytesView::Create(PacketView<kLittleEndian>(too_small));
+  ASSERT_FALSE(invalid_parent.IsValid());
+  ChildWithSixBytesView invalid = ChildWithSixBytesView::Create(invalid_parent);
+  ASSERT_FALSE(invalid.IsValid());
+}
+
 TEST(GeneratedPacketTest, testChildWithSixBytes) {
   SixBytes six_bytes_a{{0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6}};
   SixBytes six_bytes_b{{0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6}};
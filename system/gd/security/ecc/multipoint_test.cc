@@ -17,7 +17,11 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <string.h>
 
+#include <random>
+
+#include "crypto_toolbox/p256.h"
 #include "security/ecc/p_256_ecc_pp.h"
 
 namespace bluetooth {
@@ -107,6 +111,40 @@ TEST(SmpEccValidationTest, test_invalid_points) {
   EXPECT_FALSE(ECC_ValidatePoint(p));
 }
 
+// The shared P-256 engine must give the same keys as this reference implementation
+TEST(SmpEccValidationTest, matches_p256_engine) {
+  std::mt19937 generator(1);
+  for (int i = 0; i < 32; i++) {
+    crypto_toolbox::p256::Scalar private_key;
+    for (uint8_t& byte : private_key) byte = generator();
+
+    Point public_key;
+    uint32_t k[KEY_LENGTH_DWORDS_P256];
+    memcpy(k, private_key.data(), sizeof(k));
+    ECC_PointMult(&public_key, &curve_p256.G, k);
+
+    crypto_toolbox::p256::PublicKey engine_public_key;
+    ASSERT_TRUE(crypto_toolbox::p256::ComputePublicKey(private_key, &engine_public_key));
+    EXPECT_EQ(memcmp(engine_public_key.x.data(), public_key.x, 32), 0);
+    EXPECT_EQ(memcmp(engine_public_key.y.data(), public_key.y, 32), 0);
+
+    crypto_toolbox::p256::Scalar peer_private_key;
+    for (uint8_t& byte : peer_private_key) byte = generator();
+    crypto_toolbox::p256::PublicKey peer_public_key;
+    ASSERT_TRUE(crypto_toolbox::p256::ComputePublicKey(peer_private_key, &peer_public_key));
+    Point peer_point = {}, dhkey;
+    memcpy(peer_point.x, peer_public_key.x.data(), 32);
+    memcpy(peer_point.y, peer_public_key.y.data(), 32);
+    peer_point.z[0] = 1;
+    memcpy(k, private_key.data(), sizeof(k));
+    ECC_PointMult(&dhkey, &peer_point, k);
+
+    crypto_toolbox::p256::Scalar engine_dhkey;
+    ASSERT_TRUE(crypto_toolbox::p256::ComputeDhKey(private_key, peer_public_key, &engine_dhkey));
+    EXPECT_EQ(memcmp(engine_dhkey.data(), dhkey.x, 32), 0);
+  }
+}
+
 }  // namespace ecc
 }  // namespace security
 }  // namespace bluetooth
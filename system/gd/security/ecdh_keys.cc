@@ -18,76 +18,50 @@
 
 #include "security/ecdh_keys.h"
 
-/**********************************************************************************************************************
- TODO: We should have random number management in separate file, and we
-       should honour all the random number requirements from the spec!!
-**********************************************************************************************************************/
-#include <string.h>
+#include <bluetooth/log.h>
 
-#include <cstdlib>
-#include <ctime>
+#include "crypto_toolbox/entropy_pool.h"
+#include "crypto_toolbox/p256.h"
 
-#include "security/ecc/p_256_ecc_pp.h"
+namespace p256 = crypto_toolbox::p256;
 
 namespace {
 
-static bool srand_initiated = false;
-
-template <size_t SIZE>
-static std::array<uint8_t, SIZE> GenerateRandom() {
-  if (!srand_initiated) {
-    srand_initiated = true;
-    // TODO:  We need a proper  random number generator here.
-    // use current time as seed for random generator
-    std::srand(std::time(nullptr));
-  }
+p256::KeyPairPool& key_pair_pool() {
+  static p256::KeyPairPool* pool = new p256::KeyPairPool(
+      [](uint8_t* data, size_t len) { crypto_toolbox::GetEntropyPool().Generate(data, len); });
+  return *pool;
+}
 
-  std::array<uint8_t, SIZE> r;
-  for (size_t i = 0; i < SIZE; i++) r[i] = std::rand();
-  return r;
+p256::PublicKey ToPublicKey(const bluetooth::security::EcdhPublicKey& pk) {
+  return p256::PublicKey{.x = pk.x, .y = pk.y};
 }
+
 }  // namespace
-/*********************************************************************************************************************/
 
 namespace bluetooth {
 namespace security {
 
 std::pair<std::array<uint8_t, 32>, EcdhPublicKey> GenerateECDHKeyPair() {
-  std::array<uint8_t, 32> private_key = GenerateRandom<32>();
-  std::array<uint8_t, 32> private_key_copy = private_key;
-  ecc::Point public_key;
-
-  ECC_PointMult(&public_key, &(ecc::curve_p256.G), (uint32_t*)private_key_copy.data());
+  p256::KeyPair key_pair = key_pair_pool().Take();
 
   EcdhPublicKey pk;
-  memcpy(pk.x.data(), public_key.x, 32);
-  memcpy(pk.y.data(), public_key.y, 32);
+  pk.x = key_pair.public_key.x;
+  pk.y = key_pair.public_key.y;
 
   /* private_key, public key pair */
-  return std::make_pair<std::array<uint8_t, 32>, EcdhPublicKey>(std::move(private_key), std::move(pk));
+  return std::make_pair(key_pair.private_key, pk);
 }
 
 bool ValidateECDHPoint(EcdhPublicKey pk) {
-  ecc::Point public_key;
-  memcpy(public_key.x, pk.x.data(), 32);
-  memcpy(public_key.y, pk.y.data(), 32);
-  memset(public_key.z, 0, 32);
-  return ECC_ValidatePoint(public_key);
+  return p256::IsValidPoint(ToPublicKey(pk));
 }
 
 std::array<uint8_t, 32> ComputeDHKey(std::array<uint8_t, 32> my_private_key, EcdhPublicKey remote_public_key) {
-  ecc::Point peer_publ_key, new_publ_key;
-  uint32_t private_key[8];
-  memcpy(private_key, my_private_key.data(), 32);
-  memcpy(peer_publ_key.x, remote_public_key.x.data(), 32);
-  memcpy(peer_publ_key.y, remote_public_key.y.data(), 32);
-  memset(peer_publ_key.z, 0, 32);
-  peer_publ_key.z[0] = 1;
-
-  ECC_PointMult(&new_publ_key, &peer_publ_key, (uint32_t*)private_key);
-
-  std::array<uint8_t, 32> dhkey;
-  memcpy(dhkey.data(), new_publ_key.x, 32);
+  std::array<uint8_t, 32> dhkey{};
+  if (!p256::ComputeDhKey(my_private_key, ToPublicKey(remote_public_key), &dhkey)) {
+    log::error("Invalid remote public key");
+  }
   return dhkey;
 }
 
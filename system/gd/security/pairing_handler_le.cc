@@ -20,8 +20,8 @@
 
 #include <bluetooth/log.h>
 
+#include "crypto_toolbox/entropy_pool.h"
 #include "hci/octets.h"
-#include "os/rand.h"
 
 namespace bluetooth {
 namespace security {
@@ -32,7 +32,7 @@ MyOobData PairingHandlerLe::GenerateOobData() {
   MyOobData data{};
   std::tie(data.private_key, data.public_key) = GenerateECDHKeyPair();
 
-  data.r = bluetooth::os::GenerateRandom<16>();
+  data.r = crypto_toolbox::GenerateRandom<16>();
   data.c = crypto_toolbox::f4(data.public_key.x.data(), data.public_key.x.data(), data.r, 0);
   return data;
 }
@@ -345,9 +345,9 @@ DistributedKeysOrFailure PairingHandlerLe::DistributeKeys(const InitialInformati
       keys_i_receive);
 
   // TODO: obtain actual values, and apply key_size to the LTK
-  Octet16 my_ltk = bluetooth::os::GenerateRandom<16>();
-  uint16_t my_ediv = bluetooth::os::GenerateRandom();
-  std::array<uint8_t, 8> my_rand = bluetooth::os::GenerateRandom<8>();
+  Octet16 my_ltk = crypto_toolbox::GenerateRandom<16>();
+  uint16_t my_ediv = crypto_toolbox::GenerateRandom();
+  std::array<uint8_t, 8> my_rand = crypto_toolbox::GenerateRandom<8>();
 
   Octet16 my_irk = i.my_identity_resolving_key;
   Address my_identity_address = i.my_identity_address.GetAddress();
@@ -18,11 +18,11 @@
 
 #include <bluetooth/log.h>
 
+#include "crypto_toolbox/entropy_pool.h"
 #include "hci/octets.h"
-#include "os/rand.h"
 #include "security/pairing_handler_le.h"
 
-using bluetooth::os::GenerateRandom;
+using crypto_toolbox::GenerateRandom;
 
 namespace bluetooth {
 namespace security {
@@ -19,11 +19,11 @@
 #include <bluetooth/log.h>
 
 #include "crypto_toolbox/crypto_toolbox.h"
+#include "crypto_toolbox/entropy_pool.h"
 #include "hci/octets.h"
-#include "os/rand.h"
 #include "security/pairing_handler_le.h"
 
-using bluetooth::os::GenerateRandom;
+using crypto_toolbox::GenerateRandom;
 
 namespace bluetooth {
 namespace security {
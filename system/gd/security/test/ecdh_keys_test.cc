@@ -27,7 +27,6 @@
 
 #include "hci/le_security_interface.h"
 #include "os/log.h"
-#include "security/ecc/p_256_ecc_pp.h"
 #include "security/test/mocks.h"
 
 using namespace std::chrono_literals;
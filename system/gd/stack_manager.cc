@@ -18,6 +18,7 @@
 
 #include <bluetooth/log.h>
 
+#include <algorithm>
 #include <chrono>
 #include <future>
 #include <queue>
@@ -36,6 +37,12 @@ using ::bluetooth::os::WakelockManager;
 
 namespace bluetooth {
 
+// Number of modules started at once, when their dependencies allow it. Module Start() bodies
+// are not audited for running concurrently with each other, so they run one at a time unless
+// the property asks for more.
+static constexpr char kStartParallelismProperty[] = "bluetooth.gd.start_parallelism";
+static constexpr uint32_t kDefaultStartParallelism = 1;
+
 void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
   management_thread_ = new Thread("management_thread", Thread::Priority::NORMAL);
   handler_ = new Handler(management_thread_);
@@ -63,7 +70,9 @@ void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
 }
 
 void StackManager::handle_start_up(ModuleList* modules, Thread* stack_thread, std::promise<void> promise) {
-  registry_.Start(modules, stack_thread);
+  auto parallelism =
+      os::GetSystemPropertyUint32(kStartParallelismProperty, kDefaultStartParallelism);
+  registry_.StartInParallel(modules, stack_thread, std::max<uint32_t>(parallelism, 1));
   promise.set_value();
 }
 
@@ -119,6 +119,7 @@
 #define BTIF_STORAGE_KEY_SDP_DI_MANUFACTURER "SdpDiManufacturer"
 #define BTIF_STORAGE_KEY_SDP_DI_MODEL "SdpDiModel"
 #define BTIF_STORAGE_KEY_SDP_DI_VENDOR_ID_SRC "SdpDiVendorIdSource"
+#define BTIF_STORAGE_KEY_SDP_RECORD_CACHE "SdpRecordCache"
 #define BTIF_STORAGE_KEY_SECURE_CONNECTIONS_SUPPORTED "SecureConnectionsSupported"
 #define BTIF_STORAGE_KEY_TIMESTAMP "Timestamp"
 #define BTIF_STORAGE_KEY_VENDOR_ID "VendorId"
@@ -1212,6 +1212,10 @@ struct shim::legacy::Acl::impl {
     shadow_address_resolution_list_.Clear();
   }
 
+  void BeginLeListUpdates() { GetAclManager()->BeginLeListUpdates(); }
+
+  void CommitLeListUpdates() { GetAclManager()->CommitLeListUpdates(); }
+
   void SetSystemSuspendState(bool suspended) {
     GetAclManager()->SetSystemSuspendState(suspended);
   }
@@ -1920,6 +1924,14 @@ void shim::legacy::Acl::ClearAddressResolution() {
   handler_->CallOn(pimpl_.get(), &Acl::impl::ClearResolvingList);
 }
 
+void shim::legacy::Acl::BeginLeListUpdates() {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::BeginLeListUpdates);
+}
+
+void shim::legacy::Acl::CommitLeListUpdates() {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::CommitLeListUpdates);
+}
+
 void shim::legacy::Acl::SetSystemSuspendState(bool suspended) {
   handler_->CallOn(pimpl_.get(), &Acl::impl::SetSystemSuspendState, suspended);
 }
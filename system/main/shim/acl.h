@@ -93,6 +93,10 @@ class Acl : public hci::acl_manager::ConnectionCallbacks,
       const hci::AddressWithType& address_with_type);
   void ClearAddressResolution();
 
+  // Accept and resolving list updates issued in between are sent together
+  void BeginLeListUpdates();
+  void CommitLeListUpdates();
+
   void LeSetDefaultSubrate(uint16_t subrate_min, uint16_t subrate_max,
                            uint16_t max_latency, uint16_t cont_num,
                            uint16_t sup_tout);
@@ -196,6 +196,14 @@ void bluetooth::shim::ACL_ClearAddressResolution() {
 void bluetooth::shim::ACL_ClearFilterAcceptList() {
   Stack::GetInstance()->GetAcl()->ClearFilterAcceptList();
 }
+
+void bluetooth::shim::ACL_BeginLeListUpdates() {
+  Stack::GetInstance()->GetAcl()->BeginLeListUpdates();
+}
+
+void bluetooth::shim::ACL_CommitLeListUpdates() {
+  Stack::GetInstance()->GetAcl()->CommitLeListUpdates();
+}
 void bluetooth::shim::ACL_LeSetDefaultSubrate(uint16_t subrate_min,
                                               uint16_t subrate_max,
                                               uint16_t max_latency,
@@ -57,6 +57,8 @@ void ACL_RemoveFromAddressResolution(
     const tBLE_BD_ADDR& legacy_address_with_type);
 void ACL_ClearAddressResolution();
 void ACL_ClearFilterAcceptList();
+void ACL_BeginLeListUpdates();
+void ACL_CommitLeListUpdates();
 void ACL_LeSetDefaultSubrate(uint16_t subrate_min, uint16_t subrate_max,
                              uint16_t max_latency, uint16_t cont_num,
                              uint16_t sup_tout);
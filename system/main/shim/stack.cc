@@ -48,6 +48,7 @@
 #include "main/shim/le_scanning_manager.h"
 #include "metrics/counter_metrics.h"
 #include "os/log.h"
+#include "os/trace.h"
 #include "shim/dumpsys.h"
 #include "storage/storage_module.h"
 #if TARGET_FLOSS
@@ -75,6 +76,7 @@ void Stack::StartEverything() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
   log::assert_that(!is_running_, "Gd stack already running");
   log::info("Starting Gd stack");
+  os::ScopedTrace trace("gd", "start_everything");
   ModuleList modules;
 
   modules.add<metrics::CounterMetrics>();
@@ -96,7 +98,10 @@ void Stack::StartEverything() {
 #endif
   modules.add<hci::LeScanningManager>();
   modules.add<hci::DistanceMeasurementManager>();
-  Start(&modules);
+  {
+    os::ScopedTrace trace("gd", "start_modules");
+    Start(&modules);
+  }
   is_running_ = true;
   // Make sure the leaf modules are started
   log::assert_that(
@@ -106,6 +111,7 @@ void Stack::StartEverything() {
   log::assert_that(
       stack_manager_.GetInstance<shim::Dumpsys>() != nullptr,
       "assert failed: stack_manager_.GetInstance<shim::Dumpsys>() != nullptr");
+  os::ScopedTrace shim_trace("gd", "start_shim");
   if (stack_manager_.IsStarted<hci::Controller>()) {
     pimpl_->acl_ = new legacy::Acl(stack_handler_, legacy::GetAclInterface(),
                                    GetController()->GetLeFilterAcceptListSize(),
@@ -149,6 +155,7 @@ void Stack::Start(ModuleList* modules) {
 
 void Stack::Stop() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+  os::ScopedTrace trace("gd", "stop");
   bluetooth::shim::hci_on_shutting_down();
 
   // Make sure gd acl flag is enabled and we started it up
@@ -163,7 +170,10 @@ void Stack::Stop() {
 
   stack_handler_->Clear();
 
-  stack_manager_.ShutDown();
+  {
+    os::ScopedTrace trace("gd", "stop_modules");
+    stack_manager_.ShutDown();
+  }
 
   delete stack_handler_;
   stack_handler_ = nullptr;
@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef LIB_OSI_INTERNAL
+#error "Please do not include this outside of osi."
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarchical timing wheel with millisecond resolution. Each level has 64
+// slots; level N slots span 64^N ms. Entries are intrusive, so inserting and
+// removing an entry is O(1) and never allocates. An entry moves to a lower
+// level at most once per level as the wheel time approaches its deadline.
+//
+// The wheel is not thread safe; callers must provide their own locking.
+
+struct timing_wheel_t;
+typedef struct timing_wheel_t timing_wheel_t;
+
+// Entry embedded in the object being scheduled. It must be zero initialized
+// before its first use. |data| is not used by the wheel.
+typedef struct timing_wheel_entry_t {
+  struct timing_wheel_entry_t* prev;
+  struct timing_wheel_entry_t* next;
+  uint64_t deadline_ms;
+  void* data;
+  uint8_t level;
+  uint8_t slot;
+} timing_wheel_entry_t;
+
+// Creates a new wheel whose time starts at |now_ms|. Returns NULL on failure.
+// The returned object must be released with |timing_wheel_free|.
+timing_wheel_t* timing_wheel_new(uint64_t now_ms);
+
+// Frees a wheel allocated with |timing_wheel_new|. Entries still in the wheel
+// are unlinked but not otherwise touched. |wheel| may be NULL.
+void timing_wheel_free(timing_wheel_t* wheel);
+
+// Inserts |entry| to expire at |deadline_ms|. |entry| must not already be in
+// a wheel. A deadline at or before the wheel time expires immediately.
+void timing_wheel_insert(timing_wheel_t* wheel, timing_wheel_entry_t* entry,
+                         uint64_t deadline_ms);
+
+// Removes |entry| from |wheel|. Does nothing if |entry| is not in the wheel.
+void timing_wheel_remove(timing_wheel_t* wheel, timing_wheel_entry_t* entry);
+
+// Returns true if |entry| is currently in a wheel.
+bool timing_wheel_contains(const timing_wheel_entry_t* entry);
+
+// Returns the number of entries in |wheel|, expired ones included.
+size_t timing_wheel_size(const timing_wheel_t* wheel);
+
+// Returns true and sets |deadline_ms| to the earliest deadline in |wheel|, or
+// returns false if the wheel is empty. This is O(1) unless the earliest entry
+// is still on an upper level, in which case that single slot is scanned.
+bool timing_wheel_next_deadline(const timing_wheel_t* wheel,
+                                uint64_t* deadline_ms);
+
+// Advances the wheel time to |now_ms| and removes and returns the first entry
+// whose deadline is at or before it, or NULL if there is none. Entries are
+// returned in deadline order and entries sharing a deadline in the order they
+// were inserted. Entries inserted with an expired deadline come after the
+// expired entries already in the wheel.
+timing_wheel_entry_t* timing_wheel_pop_expired(timing_wheel_t* wheel,
+                                               uint64_t now_ms);
+
+// Calls |callback| for every entry in |wheel|, in no particular order.
+// |callback| must not modify the wheel.
+typedef void (*timing_wheel_iter_cb)(timing_wheel_entry_t* entry,
+                                     void* context);
+void timing_wheel_foreach(const timing_wheel_t* wheel,
+                          timing_wheel_iter_cb callback, void* context);
@@ -31,14 +31,15 @@
 #include <time.h>
 
 #include <mutex>
+#include <vector>
 
 #include "os/log.h"
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
 #include "osi/include/thread.h"
 #include "osi/include/wakelock.h"
 #include "osi/semaphore.h"
+#include "osi/timing_wheel.h"
 #include "stack/include/main_thread.h"
 
 using base::Bind;
@@ -91,6 +92,7 @@ struct alarm_t {
   uint64_t prev_deadline_ms;  // Previous deadline - used for accounting of
                               // periodic timers
   bool is_periodic;
+  timing_wheel_entry_t wheel_entry;  // Links the alarm in |alarms| while armed
   fixed_queue_t* queue;  // The processing queue to add this alarm to
   alarm_callback_t callback;
   void* data;
@@ -107,14 +109,21 @@ struct alarm_t {
 int64_t TIMER_INTERVAL_FOR_WAKELOCK_IN_MS = 3000;
 static const clockid_t CLOCK_ID = CLOCK_BOOTTIME;
 
+// An alarm may fire up to 1/2^ALARM_SLACK_SHIFT of its period late (about
+// 0.4%) if that saves re-arming the timer for an earlier deadline. Alarms
+// with periods under 256ms are never delayed.
+static const int ALARM_SLACK_SHIFT = 8;
+
 // This mutex ensures that the |alarm_set|, |alarm_cancel|, and alarm callback
 // functions execute serially and not concurrently. As a result, this mutex
-// also protects the |alarms| list.
+// also protects the |alarms| timing wheel.
 static std::mutex alarms_mutex;
-static list_t* alarms;
+static timing_wheel_t* alarms;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
+// Deadline the timers are currently armed for, UINT64_MAX if disarmed.
+static uint64_t armed_deadline_ms = UINT64_MAX;
 
 // All alarm callbacks are dispatched from |dispatcher_thread|
 static thread_t* dispatcher_thread;
@@ -133,7 +142,7 @@ static void alarm_set_internal(alarm_t* alarm, uint64_t period_ms,
                                fixed_queue_t* queue, bool for_msg_loop);
 static void alarm_cancel_internal(alarm_t* alarm);
 static void remove_pending_alarm(alarm_t* alarm);
-static void schedule_next_instance(alarm_t* alarm);
+static bool schedule_next_instance(alarm_t* alarm);
 static void reschedule_root_alarm(void);
 static void alarm_queue_ready(fixed_queue_t* queue, void* context);
 static void timer_callback(void* data);
@@ -233,7 +242,7 @@ static void alarm_set_internal(alarm_t* alarm, uint64_t period_ms,
   alarm->data = data;
   alarm->for_msg_loop = for_msg_loop;
 
-  schedule_next_instance(alarm);
+  if (schedule_next_instance(alarm)) reschedule_root_alarm();
   alarm->stats.scheduled_count++;
 }
 
@@ -255,8 +264,8 @@ void alarm_cancel(alarm_t* alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |alarms_mutex|
 static void alarm_cancel_internal(alarm_t* alarm) {
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = timing_wheel_contains(&alarm->wheel_entry) &&
+                          alarm->deadline_ms <= armed_deadline_ms;
 
   remove_pending_alarm(alarm);
 
@@ -296,8 +305,9 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
+  timing_wheel_free(alarms);
   alarms = NULL;
+  armed_deadline_ms = UINT64_MAX;
 }
 
 static bool lazy_initialize(void) {
@@ -310,9 +320,9 @@ static bool lazy_initialize(void) {
 
   std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  alarms = list_new(NULL);
+  alarms = timing_wheel_new(0);
   if (!alarms) {
-    log::error("unable to allocate alarm list.");
+    log::error("unable to allocate alarm timing wheel.");
     goto error;
   }
 
@@ -375,7 +385,7 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
-  list_free(alarms);
+  timing_wheel_free(alarms);
   alarms = NULL;
 
   return false;
@@ -393,10 +403,10 @@ static uint64_t now_ms(void) {
   return (ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL);
 }
 
-// Remove alarm from internal alarm list and the processing queue
+// Remove alarm from internal timing wheel and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  timing_wheel_remove(alarms, &alarm->wheel_entry);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -409,12 +419,13 @@ static void remove_pending_alarm(alarm_t* alarm) {
   }
 }
 
+// Returns true if the timers need to be re-armed for the new deadline.
 // Must be called with |alarms_mutex| held
-static void schedule_next_instance(alarm_t* alarm) {
-  // If the alarm is currently set and it's at the start of the list,
-  // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+static bool schedule_next_instance(alarm_t* alarm) {
+  // If the alarm is what the timers are armed for, we'll need to re-schedule
+  // since we've adjusted the earliest deadline.
+  bool needs_reschedule = timing_wheel_contains(&alarm->wheel_entry) &&
+                          alarm->deadline_ms <= armed_deadline_ms;
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -425,28 +436,14 @@ static void schedule_next_instance(alarm_t* alarm) {
         ((just_now_ms - alarm->creation_time_ms) % alarm->period_ms);
   alarm->deadline_ms = just_now_ms + (alarm->period_ms - ms_into_period);
 
-  // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t*)list_front(alarms))->deadline_ms > alarm->deadline_ms) {
-    list_prepend(alarms, alarm);
-  } else {
-    for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-         node = list_next(node)) {
-      list_node_t* next = list_next(node);
-      if (next == list_end(alarms) ||
-          ((alarm_t*)list_node(next))->deadline_ms > alarm->deadline_ms) {
-        list_insert_after(alarms, node, alarm);
-        break;
-      }
-    }
-  }
+  alarm->wheel_entry.data = alarm;
+  timing_wheel_insert(alarms, &alarm->wheel_entry, alarm->deadline_ms);
 
   // If the new alarm has the earliest deadline, we need to re-evaluate our
-  // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
-    reschedule_root_alarm();
-  }
+  // schedule, unless the timers already fire within the alarm's slack.
+  uint64_t slack_ms = alarm->period_ms >> ALARM_SLACK_SHIFT;
+  return needs_reschedule ||
+         (armed_deadline_ms > alarm->deadline_ms + slack_ms);
 }
 
 // NOTE: must be called with |alarms_mutex| held
@@ -454,17 +451,18 @@ static void reschedule_root_alarm(void) {
   log::assert_that(alarms != NULL, "assert failed: alarms != NULL");
 
   const bool timer_was_set = timer_set;
-  alarm_t* next;
+  uint64_t next_deadline_ms;
   int64_t next_expiration;
 
   // If used in a zeroed state, disarms the timer.
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  armed_deadline_ms = UINT64_MAX;
+  if (!timing_wheel_next_deadline(alarms, &next_deadline_ms)) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
-  next_expiration = next->deadline_ms - now_ms();
+  armed_deadline_ms = next_deadline_ms;
+  next_expiration = next_deadline_ms - now_ms();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
       if (!wakelock_acquire()) {
@@ -472,8 +470,8 @@ static void reschedule_root_alarm(void) {
       }
     }
 
-    timer_time.it_value.tv_sec = (next->deadline_ms / 1000);
-    timer_time.it_value.tv_nsec = (next->deadline_ms % 1000) * 1000000LL;
+    timer_time.it_value.tv_sec = (next_deadline_ms / 1000);
+    timer_time.it_value.tv_nsec = (next_deadline_ms % 1000) * 1000000LL;
 
     // It is entirely unsafe to call timer_settime(2) with a zeroed timerspec
     // for timers with *_ALARM clock IDs. Although the man page states that the
@@ -498,8 +496,8 @@ static void reschedule_root_alarm(void) {
     struct itimerspec wakeup_time;
     memset(&wakeup_time, 0, sizeof(wakeup_time));
 
-    wakeup_time.it_value.tv_sec = (next->deadline_ms / 1000);
-    wakeup_time.it_value.tv_nsec = (next->deadline_ms % 1000) * 1000000LL;
+    wakeup_time.it_value.tv_sec = (next_deadline_ms / 1000);
+    wakeup_time.it_value.tv_nsec = (next_deadline_ms % 1000) * 1000000LL;
     if (timer_settime(wakeup_timer, TIMER_ABSTIME, &wakeup_time, NULL) == -1)
       log::error("unable to set wakeup timer: {}", strerror(errno));
   }
@@ -522,8 +520,7 @@ done:
   // milliseconds) and the timer expired normally before we called
   // |timer_gettime|. Worst case, |alarm_expired| is signaled twice for that
   // alarm. Nothing bad should happen in that case though since the callback
-  // dispatch function checks to make sure the timer at the head of the list
-  // actually expired.
+  // dispatch function only dispatches the alarms that actually expired.
   if (timer_set) {
     struct itimerspec time_to_expire;
     timer_gettime(timer, &time_to_expire);
@@ -613,39 +610,42 @@ static void callback_dispatch(void* /* context */) {
     if (!dispatcher_thread_active) break;
 
     std::lock_guard<std::mutex> lock(alarms_mutex);
-    alarm_t* alarm;
-
-    // Take into account that the alarm may get cancelled before we get to it.
-    // We're done here if there are no alarms or the alarm at the front is in
-    // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline_ms >
-            now_ms()) {
-      reschedule_root_alarm();
-      continue;
-    }
-
-    list_remove(alarms, alarm);
 
-    if (alarm->is_periodic) {
-      alarm->prev_deadline_ms = alarm->deadline_ms;
-      schedule_next_instance(alarm);
-      alarm->stats.rescheduled_count++;
+    // Take into account that alarms may get cancelled before we get to them;
+    // those are no longer in the wheel. Collect every alarm that expired
+    // first, so that periodic alarms rescheduled below with a deadline that
+    // already passed are only dispatched on the next wakeup.
+    std::vector<alarm_t*> expired;
+    uint64_t just_now_ms = now_ms();
+    timing_wheel_entry_t* entry;
+    while ((entry = timing_wheel_pop_expired(alarms, just_now_ms)) != NULL) {
+      expired.push_back(static_cast<alarm_t*>(entry->data));
     }
-    reschedule_root_alarm();
 
-    // Enqueue the alarm for processing
-    if (alarm->for_msg_loop) {
-      if (!get_main_thread()) {
-        log::error("message loop already NULL. Alarm: {}", alarm->stats.name);
-        continue;
+    for (alarm_t* alarm : expired) {
+      if (alarm->is_periodic) {
+        alarm->prev_deadline_ms = alarm->deadline_ms;
+        schedule_next_instance(alarm);
+        alarm->stats.rescheduled_count++;
       }
 
-      alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
-      get_main_thread()->DoInThread(FROM_HERE, alarm->closure.i.callback());
-    } else {
-      fixed_queue_enqueue(alarm->queue, alarm);
+      // Enqueue the alarm for processing
+      if (alarm->for_msg_loop) {
+        if (!get_main_thread()) {
+          log::error("message loop already NULL. Alarm: {}",
+                     alarm->stats.name);
+          continue;
+        }
+
+        alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
+        get_main_thread()->DoInThread(FROM_HERE, alarm->closure.i.callback());
+      } else {
+        fixed_queue_enqueue(alarm->queue, alarm);
+      }
     }
+
+    // Re-arm the timers once for everything dispatched above.
+    reschedule_root_alarm();
   }
 
   log::info("Callback thread exited");
@@ -711,6 +711,46 @@ static void dump_stat(int fd, stat_t* stat, const char* description) {
           (unsigned long long)average_time_ms);
 }
 
+typedef struct {
+  int fd;
+  uint64_t just_now_ms;
+} alarm_dump_context_t;
+
+static void dump_alarm(timing_wheel_entry_t* entry, void* context) {
+  const alarm_dump_context_t* dump =
+      static_cast<alarm_dump_context_t*>(context);
+  int fd = dump->fd;
+  uint64_t just_now_ms = dump->just_now_ms;
+  alarm_t* alarm = static_cast<alarm_t*>(entry->data);
+  alarm_stats_t* stats = &alarm->stats;
+
+  dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
+          (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
+
+  dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
+          "    Action counts (sched/resched/exec/cancel)",
+          stats->scheduled_count, stats->rescheduled_count,
+          stats->total_updates, stats->canceled_count);
+
+  dprintf(fd, "%-51s: %zu / %zu\n",
+          "    Deviation counts (overdue/premature)",
+          stats->overdue_scheduling.count, stats->premature_scheduling.count);
+
+  dprintf(fd, "%-51s: %llu / %llu / %lld\n",
+          "    Time in ms (since creation/interval/remaining)",
+          (unsigned long long)(just_now_ms - alarm->creation_time_ms),
+          (unsigned long long)alarm->period_ms,
+          (long long)(alarm->deadline_ms - just_now_ms));
+
+  dump_stat(fd, &stats->overdue_scheduling,
+            "    Overdue scheduling time in ms (total/max/avg)");
+
+  dump_stat(fd, &stats->premature_scheduling,
+            "    Premature scheduling time in ms (total/max/avg)");
+
+  dprintf(fd, "\n");
+}
+
 void alarm_debug_dump(int fd) {
   dprintf(fd, "\nBluetooth Alarms Statistics:\n");
 
@@ -721,40 +761,10 @@ void alarm_debug_dump(int fd) {
     return;
   }
 
-  uint64_t just_now_ms = now_ms();
+  alarm_dump_context_t context = {.fd = fd, .just_now_ms = now_ms()};
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n\n", timing_wheel_size(alarms));
 
   // Dump info for each alarm
-  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
-    alarm_stats_t* stats = &alarm->stats;
-
-    dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
-            (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
-
-    dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
-            "    Action counts (sched/resched/exec/cancel)",
-            stats->scheduled_count, stats->rescheduled_count,
-            stats->total_updates, stats->canceled_count);
-
-    dprintf(fd, "%-51s: %zu / %zu\n",
-            "    Deviation counts (overdue/premature)",
-            stats->overdue_scheduling.count, stats->premature_scheduling.count);
-
-    dprintf(fd, "%-51s: %llu / %llu / %lld\n",
-            "    Time in ms (since creation/interval/remaining)",
-            (unsigned long long)(just_now_ms - alarm->creation_time_ms),
-            (unsigned long long)alarm->period_ms,
-            (long long)(alarm->deadline_ms - just_now_ms));
-
-    dump_stat(fd, &stats->overdue_scheduling,
-              "    Overdue scheduling time in ms (total/max/avg)");
-
-    dump_stat(fd, &stats->premature_scheduling,
-              "    Premature scheduling time in ms (total/max/avg)");
-
-    dprintf(fd, "\n");
-  }
+  timing_wheel_foreach(alarms, dump_alarm, &context);
 }
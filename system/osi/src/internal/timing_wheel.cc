@@ -0,0 +1,282 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_timing_wheel"
+
+#include "osi/timing_wheel.h"
+
+#include <bluetooth/log.h>
+
+#include "osi/include/allocator.h"
+
+using namespace bluetooth;
+
+#define SLOT_BITS 6
+#define SLOTS_PER_LEVEL (1 << SLOT_BITS)
+#define SLOT_MASK (SLOTS_PER_LEVEL - 1)
+
+// Eight levels cover 2^48 ms. Deadlines further away are clamped, which only
+// matters for alarms set thousands of years ahead.
+#define LEVELS 8
+#define WHEEL_SPAN_BITS (SLOT_BITS * LEVELS)
+
+// |level| value of the entries in the expired list.
+#define EXPIRED_LEVEL LEVELS
+
+struct timing_wheel_t {
+  // Wheel time. Every entry in a slot expires after it.
+  uint64_t now_ms;
+  size_t size;
+  // Bit N of |occupied[L]| is set when |slots[L][N]| is not empty.
+  uint64_t occupied[LEVELS];
+  // List heads; only |prev| and |next| are used.
+  timing_wheel_entry_t slots[LEVELS][SLOTS_PER_LEVEL];
+  timing_wheel_entry_t expired;
+};
+
+static void slot_init(timing_wheel_entry_t* head) {
+  head->prev = head;
+  head->next = head;
+}
+
+static bool slot_empty(const timing_wheel_entry_t* head) {
+  return head->next == head;
+}
+
+static void slot_append(timing_wheel_entry_t* head,
+                        timing_wheel_entry_t* entry) {
+  entry->prev = head->prev;
+  entry->next = head;
+  head->prev->next = entry;
+  head->prev = entry;
+}
+
+static void entry_unlink(timing_wheel_entry_t* entry) {
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+  entry->prev = NULL;
+  entry->next = NULL;
+}
+
+static uint64_t level_shift(int level) { return SLOT_BITS * level; }
+
+// Links |entry| at the level where its deadline and the wheel time only
+// differ in that level's bits, so that its slot is always ahead of the
+// wheel time on that level.
+static void place(timing_wheel_t* wheel, timing_wheel_entry_t* entry) {
+  if (entry->deadline_ms <= wheel->now_ms) {
+    entry->level = EXPIRED_LEVEL;
+    entry->slot = 0;
+    slot_append(&wheel->expired, entry);
+    return;
+  }
+
+  int highest_bit = 63 - __builtin_clzll(entry->deadline_ms ^ wheel->now_ms);
+  int level = highest_bit / SLOT_BITS;
+  int slot = (entry->deadline_ms >> level_shift(level)) & SLOT_MASK;
+
+  entry->level = level;
+  entry->slot = slot;
+  slot_append(&wheel->slots[level][slot], entry);
+  wheel->occupied[level] |= (1ULL << slot);
+}
+
+// Finds the earliest non-empty slot. Slots on a level all start before the
+// slots on the level above, so the first occupied level holds it.
+static bool next_slot(const timing_wheel_t* wheel, int* level, int* slot,
+                      uint64_t* start_ms) {
+  for (int l = 0; l < LEVELS; l++) {
+    if (wheel->occupied[l] == 0) continue;
+
+    int s = __builtin_ctzll(wheel->occupied[l]);
+    uint64_t block_mask = (1ULL << level_shift(l + 1)) - 1;
+    *level = l;
+    *slot = s;
+    *start_ms = (wheel->now_ms & ~block_mask) |
+                ((uint64_t)s << level_shift(l));
+    return true;
+  }
+  return false;
+}
+
+// Moves the wheel time forward to |now_ms|, cascading the slots it passes
+// to the lower levels and the expired list.
+static void advance(timing_wheel_t* wheel, uint64_t now_ms) {
+  if (now_ms <= wheel->now_ms) return;
+
+  int level;
+  int slot;
+  uint64_t start_ms;
+  while (next_slot(wheel, &level, &slot, &start_ms) && start_ms <= now_ms) {
+    wheel->now_ms = start_ms;
+
+    timing_wheel_entry_t* head = &wheel->slots[level][slot];
+    timing_wheel_entry_t pending;
+    slot_init(&pending);
+    if (!slot_empty(head)) {
+      pending.next = head->next;
+      pending.prev = head->prev;
+      pending.next->prev = &pending;
+      pending.prev->next = &pending;
+      slot_init(head);
+    }
+    wheel->occupied[level] &= ~(1ULL << slot);
+
+    while (!slot_empty(&pending)) {
+      timing_wheel_entry_t* entry = pending.next;
+      entry_unlink(entry);
+      place(wheel, entry);
+    }
+  }
+
+  wheel->now_ms = now_ms;
+}
+
+timing_wheel_t* timing_wheel_new(uint64_t now_ms) {
+  timing_wheel_t* ret =
+      static_cast<timing_wheel_t*>(osi_calloc(sizeof(timing_wheel_t)));
+
+  ret->now_ms = now_ms;
+  for (int l = 0; l < LEVELS; l++) {
+    for (int s = 0; s < SLOTS_PER_LEVEL; s++) slot_init(&ret->slots[l][s]);
+  }
+  slot_init(&ret->expired);
+
+  return ret;
+}
+
+static void unlink_all(timing_wheel_entry_t* head) {
+  while (!slot_empty(head)) entry_unlink(head->next);
+}
+
+void timing_wheel_free(timing_wheel_t* wheel) {
+  if (!wheel) return;
+
+  for (int l = 0; l < LEVELS; l++) {
+    for (int s = 0; s < SLOTS_PER_LEVEL; s++) unlink_all(&wheel->slots[l][s]);
+  }
+  unlink_all(&wheel->expired);
+  osi_free(wheel);
+}
+
+void timing_wheel_insert(timing_wheel_t* wheel, timing_wheel_entry_t* entry,
+                         uint64_t deadline_ms) {
+  log::assert_that(wheel != NULL, "assert failed: wheel != NULL");
+  log::assert_that(entry != NULL, "assert failed: entry != NULL");
+  log::assert_that(!timing_wheel_contains(entry),
+                   "assert failed: !timing_wheel_contains(entry)");
+
+  // Keep the deadline within the span of the top level.
+  uint64_t latest_ms =
+      wheel->now_ms | ((1ULL << WHEEL_SPAN_BITS) - 1);
+  entry->deadline_ms = (deadline_ms < latest_ms) ? deadline_ms : latest_ms;
+
+  place(wheel, entry);
+  wheel->size++;
+}
+
+void timing_wheel_remove(timing_wheel_t* wheel, timing_wheel_entry_t* entry) {
+  log::assert_that(wheel != NULL, "assert failed: wheel != NULL");
+  log::assert_that(entry != NULL, "assert failed: entry != NULL");
+
+  if (!timing_wheel_contains(entry)) return;
+
+  entry_unlink(entry);
+  if (entry->level != EXPIRED_LEVEL &&
+      slot_empty(&wheel->slots[entry->level][entry->slot])) {
+    wheel->occupied[entry->level] &= ~(1ULL << entry->slot);
+  }
+  wheel->size--;
+}
+
+bool timing_wheel_contains(const timing_wheel_entry_t* entry) {
+  return entry->next != NULL;
+}
+
+size_t timing_wheel_size(const timing_wheel_t* wheel) {
+  log::assert_that(wheel != NULL, "assert failed: wheel != NULL");
+  return wheel->size;
+}
+
+bool timing_wheel_next_deadline(const timing_wheel_t* wheel,
+                                uint64_t* deadline_ms) {
+  log::assert_that(wheel != NULL, "assert failed: wheel != NULL");
+  log::assert_that(deadline_ms != NULL, "assert failed: deadline_ms != NULL");
+
+  if (!slot_empty(&wheel->expired)) {
+    *deadline_ms = wheel->expired.next->deadline_ms;
+    return true;
+  }
+
+  int level;
+  int slot;
+  uint64_t start_ms;
+  if (!next_slot(wheel, &level, &slot, &start_ms)) return false;
+
+  // All the entries of a level 0 slot share its deadline.
+  if (level == 0) {
+    *deadline_ms = start_ms;
+    return true;
+  }
+
+  const timing_wheel_entry_t* head = &wheel->slots[level][slot];
+  uint64_t earliest_ms = head->next->deadline_ms;
+  for (const timing_wheel_entry_t* entry = head->next; entry != head;
+       entry = entry->next) {
+    if (entry->deadline_ms < earliest_ms) earliest_ms = entry->deadline_ms;
+  }
+  *deadline_ms = earliest_ms;
+  return true;
+}
+
+timing_wheel_entry_t* timing_wheel_pop_expired(timing_wheel_t* wheel,
+                                               uint64_t now_ms) {
+  log::assert_that(wheel != NULL, "assert failed: wheel != NULL");
+
+  advance(wheel, now_ms);
+  if (slot_empty(&wheel->expired)) return NULL;
+
+  timing_wheel_entry_t* entry = wheel->expired.next;
+  entry_unlink(entry);
+  wheel->size--;
+  return entry;
+}
+
+static void foreach_in_slot(const timing_wheel_entry_t* head,
+                            timing_wheel_iter_cb callback, void* context) {
+  for (timing_wheel_entry_t* entry = head->next; entry != head;
+       entry = entry->next) {
+    callback(entry, context);
+  }
+}
+
+void timing_wheel_foreach(const timing_wheel_t* wheel,
+                          timing_wheel_iter_cb callback, void* context) {
+  log::assert_that(wheel != NULL, "assert failed: wheel != NULL");
+  log::assert_that(callback != NULL, "assert failed: callback != NULL");
+
+  foreach_in_slot(&wheel->expired, callback, context);
+  for (int l = 0; l < LEVELS; l++) {
+    uint64_t occupied = wheel->occupied[l];
+    while (occupied) {
+      int s = __builtin_ctzll(occupied);
+      occupied &= occupied - 1;
+      foreach_in_slot(&wheel->slots[l][s], callback, context);
+    }
+  }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "common/message_loop_thread.h"
+#include "osi/include/alarm.h"
+
+using ::benchmark::State;
+
+bluetooth::common::MessageLoopThread* get_main_thread() { return nullptr; }
+
+namespace {
+
+// Live alarms are armed far enough in the future to never fire during a run,
+// like the per-link L2CAP, AVDTP and SMP timers they stand for.
+constexpr uint64_t kLiveAlarmBaseMs = 600000;
+constexpr uint64_t kAlarmIntervalMs = 30000;
+
+void noop_cb(void* /* data */) {}
+
+class BM_OsiAlarm : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    for (int i = 0; i < st.range(0); i++) {
+      alarm_t* alarm = alarm_new(("alarm_benchmark.live[" + std::to_string(i) + "]").c_str());
+      alarm_set(alarm, kLiveAlarmBaseMs + i * 37, noop_cb, nullptr);
+      live_alarms_.push_back(alarm);
+    }
+    alarm_ = alarm_new("alarm_benchmark.measured");
+  }
+
+  void TearDown(State& st) override {
+    alarm_free(alarm_);
+    alarm_ = nullptr;
+    for (alarm_t* alarm : live_alarms_) alarm_free(alarm);
+    live_alarms_.clear();
+    alarm_cleanup();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<alarm_t*> live_alarms_;
+  alarm_t* alarm_ = nullptr;
+};
+
+}  // namespace
+
+// Arming and cancelling a timer, e.g. a response timeout that is cancelled
+// once the response arrives.
+BENCHMARK_DEFINE_F(BM_OsiAlarm, set_cancel)(State& state) {
+  uint64_t i = 0;
+  for (auto _ : state) {
+    alarm_set(alarm_, kAlarmIntervalMs + (i++ % 1000), noop_cb, nullptr);
+    alarm_cancel(alarm_);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Re-arming a timer that is already armed, e.g. an idle timer pushed back on
+// every packet.
+BENCHMARK_DEFINE_F(BM_OsiAlarm, rearm)(State& state) {
+  uint64_t i = 0;
+  for (auto _ : state) {
+    alarm_set(alarm_, kAlarmIntervalMs + (i++ % 1000), noop_cb, nullptr);
+  }
+  alarm_cancel(alarm_);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Argument: number of live alarms.
+BENCHMARK_REGISTER_F(BM_OsiAlarm, set_cancel)->RangeMultiplier(4)->Range(1, 4096);
+BENCHMARK_REGISTER_F(BM_OsiAlarm, rearm)->RangeMultiplier(4)->Range(1, 4096);
+
+BENCHMARK_MAIN();
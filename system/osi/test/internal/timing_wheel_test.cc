@@ -0,0 +1,176 @@
+#include "osi/timing_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kStartMs = 123456;
+
+class TimingWheelTest : public ::testing::Test {
+ protected:
+  void SetUp() override { wheel_ = timing_wheel_new(kStartMs); }
+
+  void TearDown() override { timing_wheel_free(wheel_); }
+
+  timing_wheel_t* wheel_;
+};
+
+TEST_F(TimingWheelTest, test_new_free_simple) {
+  EXPECT_EQ(timing_wheel_size(wheel_), 0u);
+  uint64_t deadline_ms;
+  EXPECT_FALSE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 1000000), nullptr);
+}
+
+TEST_F(TimingWheelTest, test_free_null) { timing_wheel_free(NULL); }
+
+TEST_F(TimingWheelTest, test_expires_at_deadline) {
+  timing_wheel_entry_t entry = {};
+  timing_wheel_insert(wheel_, &entry, kStartMs + 100);
+  EXPECT_TRUE(timing_wheel_contains(&entry));
+  EXPECT_EQ(timing_wheel_size(wheel_), 1u);
+
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 99), nullptr);
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 100), &entry);
+  EXPECT_FALSE(timing_wheel_contains(&entry));
+  EXPECT_EQ(timing_wheel_size(wheel_), 0u);
+}
+
+TEST_F(TimingWheelTest, test_past_deadline_expires_immediately) {
+  timing_wheel_entry_t entry = {};
+  timing_wheel_insert(wheel_, &entry, kStartMs - 10);
+
+  uint64_t deadline_ms;
+  ASSERT_TRUE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(deadline_ms, kStartMs - 10);
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs), &entry);
+}
+
+TEST_F(TimingWheelTest, test_next_deadline_on_upper_levels) {
+  timing_wheel_entry_t entries[3] = {};
+  timing_wheel_insert(wheel_, &entries[0], kStartMs + 3600000);
+  timing_wheel_insert(wheel_, &entries[1], kStartMs + 70000);
+  timing_wheel_insert(wheel_, &entries[2], kStartMs + 70003);
+
+  uint64_t deadline_ms;
+  ASSERT_TRUE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(deadline_ms, kStartMs + 70000);
+
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 69999), nullptr);
+  ASSERT_TRUE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(deadline_ms, kStartMs + 70000);
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 70000), &entries[1]);
+
+  ASSERT_TRUE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(deadline_ms, kStartMs + 70003);
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 3600000), &entries[2]);
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 3600000), &entries[0]);
+}
+
+TEST_F(TimingWheelTest, test_remove) {
+  timing_wheel_entry_t first = {};
+  timing_wheel_entry_t second = {};
+  timing_wheel_insert(wheel_, &first, kStartMs + 5000);
+  timing_wheel_insert(wheel_, &second, kStartMs + 6000);
+
+  timing_wheel_remove(wheel_, &first);
+  EXPECT_FALSE(timing_wheel_contains(&first));
+  EXPECT_EQ(timing_wheel_size(wheel_), 1u);
+
+  uint64_t deadline_ms;
+  ASSERT_TRUE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(deadline_ms, kStartMs + 6000);
+
+  // Removing an entry that is not in the wheel does nothing.
+  timing_wheel_remove(wheel_, &first);
+  EXPECT_EQ(timing_wheel_size(wheel_), 1u);
+
+  timing_wheel_remove(wheel_, &second);
+  EXPECT_FALSE(timing_wheel_next_deadline(wheel_, &deadline_ms));
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 10000), nullptr);
+}
+
+TEST_F(TimingWheelTest, test_reinsert_after_remove) {
+  timing_wheel_entry_t entry = {};
+  timing_wheel_insert(wheel_, &entry, kStartMs + 5000);
+  timing_wheel_remove(wheel_, &entry);
+  timing_wheel_insert(wheel_, &entry, kStartMs + 20);
+
+  EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 20), &entry);
+}
+
+TEST_F(TimingWheelTest, test_same_deadline_keeps_insertion_order) {
+  timing_wheel_entry_t entries[10] = {};
+  for (auto& entry : entries) {
+    timing_wheel_insert(wheel_, &entry, kStartMs + 300);
+  }
+
+  for (auto& entry : entries) {
+    EXPECT_EQ(timing_wheel_pop_expired(wheel_, kStartMs + 300), &entry);
+  }
+}
+
+TEST_F(TimingWheelTest, test_foreach) {
+  timing_wheel_entry_t entries[4] = {};
+  timing_wheel_insert(wheel_, &entries[0], kStartMs);
+  timing_wheel_insert(wheel_, &entries[1], kStartMs + 1);
+  timing_wheel_insert(wheel_, &entries[2], kStartMs + 1000);
+  timing_wheel_insert(wheel_, &entries[3], kStartMs + 10000000);
+
+  std::vector<timing_wheel_entry_t*> seen;
+  timing_wheel_foreach(
+      wheel_,
+      [](timing_wheel_entry_t* entry, void* context) {
+        static_cast<std::vector<timing_wheel_entry_t*>*>(context)->push_back(
+            entry);
+      },
+      &seen);
+
+  ASSERT_EQ(seen.size(), 4u);
+  for (auto& entry : entries) {
+    EXPECT_NE(std::find(seen.begin(), seen.end(), &entry), seen.end());
+  }
+}
+
+TEST_F(TimingWheelTest, test_random_deadlines_expire_in_order) {
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<uint64_t> delay(1, 10000000);
+
+  std::vector<timing_wheel_entry_t> entries(2000);
+  for (auto& entry : entries) {
+    entry = {};
+    timing_wheel_insert(wheel_, &entry, kStartMs + delay(rng));
+  }
+  // Drop every third entry to exercise removal across all levels.
+  size_t removed = 0;
+  for (size_t i = 0; i < entries.size(); i += 3) {
+    timing_wheel_remove(wheel_, &entries[i]);
+    removed++;
+  }
+  ASSERT_EQ(timing_wheel_size(wheel_), entries.size() - removed);
+
+  uint64_t now_ms = kStartMs;
+  uint64_t last_deadline_ms = 0;
+  size_t popped = 0;
+  uint64_t deadline_ms;
+  while (timing_wheel_next_deadline(wheel_, &deadline_ms)) {
+    ASSERT_GE(deadline_ms, now_ms);
+    EXPECT_EQ(timing_wheel_pop_expired(wheel_, deadline_ms - 1), nullptr);
+    now_ms = deadline_ms;
+
+    timing_wheel_entry_t* entry;
+    while ((entry = timing_wheel_pop_expired(wheel_, now_ms)) != nullptr) {
+      EXPECT_EQ(entry->deadline_ms, now_ms);
+      EXPECT_GE(entry->deadline_ms, last_deadline_ms);
+      last_deadline_ms = entry->deadline_ms;
+      popped++;
+    }
+  }
+  EXPECT_EQ(popped, entries.size() - removed);
+}
+
+}  // namespace
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hardware/avrcp/avrcp.h"
+
+namespace bluetooth {
+namespace avrcp {
+
+// A helper class caching the lists fetched from the AVRCP Media Interface
+// layer for browsing. Remote devices page through the now playing list and
+// folders a few items at a time, and each page would otherwise fetch the whole
+// list again. The lists are shared and immutable, so a page or the item count
+// is read without copying the list.
+//
+// The cache is versioned by a generation counter, increased whenever a media
+// or folder update invalidates part of it; it plays the role of the UID counter
+// of a database aware player. A list is only cached if no invalidation
+// happened while it was being fetched.
+//
+// The media interface reports queue and metadata changes, but not changes of
+// the media library content, so folders also expire after kFolderMaxAge.
+class BrowseCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using SongList = std::shared_ptr<const std::vector<SongInfo>>;
+  using ItemList = std::shared_ptr<const std::vector<ListItem>>;
+
+  // Folders kept, over all browsed players
+  static constexpr size_t kMaxFolders = 4;
+  // Long enough to page through a folder, short enough to pick up library
+  // changes the media interface doesn't report
+  static constexpr Clock::duration kFolderMaxAge = std::chrono::seconds(10);
+
+  uint16_t generation() const { return generation_; }
+
+  // Returns nullptr if the now playing list isn't cached
+  SongList now_playing() const { return now_playing_; }
+  const std::string& curr_song_id() const { return curr_song_id_; }
+
+  SongList set_now_playing(uint16_t generation, std::string curr_song_id,
+                           std::vector<SongInfo> song_list) {
+    auto songs =
+        std::make_shared<const std::vector<SongInfo>>(std::move(song_list));
+    if (generation == generation_) {
+      now_playing_ = songs;
+      curr_song_id_ = std::move(curr_song_id);
+    }
+    return songs;
+  }
+
+  // Returns nullptr if the folder isn't cached or has expired
+  ItemList folder(int player_id, const std::string& folder_id,
+                  Clock::time_point now = Clock::now()) {
+    for (auto it = folders_.begin(); it != folders_.end(); it++) {
+      if (it->player_id == player_id && it->folder_id == folder_id) {
+        if (now - it->fetched >= kFolderMaxAge) {
+          folders_.erase(it);
+          return nullptr;
+        }
+        // Keep the most recently used folder first
+        folders_.splice(folders_.begin(), folders_, it);
+        return it->items;
+      }
+    }
+    return nullptr;
+  }
+
+  ItemList set_folder(uint16_t generation, int player_id,
+                      std::string folder_id, std::vector<ListItem> item_list,
+                      Clock::time_point now = Clock::now()) {
+    auto items =
+        std::make_shared<const std::vector<ListItem>>(std::move(item_list));
+    if (generation == generation_) {
+      folders_.remove_if([&](const Folder& folder) {
+        return folder.player_id == player_id && folder.folder_id == folder_id;
+      });
+      folders_.push_front({player_id, std::move(folder_id), items, now});
+      if (folders_.size() > kMaxFolders) folders_.pop_back();
+    }
+    return items;
+  }
+
+  void invalidate_now_playing() {
+    generation_++;
+    now_playing_.reset();
+    curr_song_id_.clear();
+  }
+
+  void invalidate_folders() {
+    generation_++;
+    folders_.clear();
+  }
+
+  void invalidate_folders(int player_id) {
+    generation_++;
+    folders_.remove_if([player_id](const Folder& folder) {
+      return folder.player_id == player_id;
+    });
+  }
+
+  void clear() {
+    invalidate_now_playing();
+    invalidate_folders();
+  }
+
+ private:
+  struct Folder {
+    int player_id;
+    std::string folder_id;
+    ItemList items;
+    Clock::time_point fetched;
+  };
+
+  uint16_t generation_ = 0;
+  SongList now_playing_;
+  std::string curr_song_id_;
+  std::list<Folder> folders_;
+};
+
+}  // namespace avrcp
+}  // namespace bluetooth
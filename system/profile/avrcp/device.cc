@@ -667,6 +667,7 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
   // Anytime we use the now playing list, update our map so that its always
   // current
   now_playing_ids_.clear();
+  now_playing_ids_source_.reset();
   uint64_t uid = 0;
   for (const SongInfo& song : song_list) {
     now_playing_ids_.insert(song.media_id);
@@ -1124,15 +1125,14 @@ void Device::HandleGetFolderItems(uint8_t label,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
       break;
     case Scope::VFS:
-      media_interface_->GetFolderItems(
-          curr_browsed_player_id_, CurrentFolder(),
-          base::Bind(&Device::GetVFSListResponse,
-                     weak_ptr_factory_.GetWeakPtr(), label, pkt));
+      GetCachedFolderItems(base::Bind(&Device::GetVFSListResponse,
+                                      weak_ptr_factory_.GetWeakPtr(), label,
+                                      pkt));
       break;
     case Scope::NOW_PLAYING:
-      media_interface_->GetNowPlayingList(
-          base::Bind(&Device::GetNowPlayingListResponse,
-                     weak_ptr_factory_.GetWeakPtr(), label, pkt));
+      GetCachedNowPlayingList(base::Bind(&Device::GetNowPlayingListResponse,
+                                         weak_ptr_factory_.GetWeakPtr(), label,
+                                         pkt));
       break;
     default:
       log::error("{}: scope={}", address_, pkt->GetScope());
@@ -1143,6 +1143,52 @@ void Device::HandleGetFolderItems(uint8_t label,
   }
 }
 
+void Device::GetCachedNowPlayingList(NowPlayingListCallback cb) {
+  auto song_list = browse_cache_.now_playing();
+  if (song_list != nullptr) {
+    cb.Run(browse_cache_.curr_song_id(), song_list);
+    return;
+  }
+
+  media_interface_->GetNowPlayingList(
+      base::Bind(&Device::NowPlayingListFetched, weak_ptr_factory_.GetWeakPtr(),
+                 browse_cache_.generation(), cb));
+}
+
+void Device::NowPlayingListFetched(uint16_t generation,
+                                   NowPlayingListCallback cb,
+                                   std::string curr_song_id,
+                                   std::vector<SongInfo> song_list) {
+  // Not cached if the list changed while it was being fetched
+  auto songs = browse_cache_.set_now_playing(generation, curr_song_id,
+                                             std::move(song_list));
+  cb.Run(curr_song_id, songs);
+}
+
+void Device::GetCachedFolderItems(FolderItemsCallback cb) {
+  std::string folder_id = CurrentFolder();
+  auto items = browse_cache_.folder(curr_browsed_player_id_, folder_id);
+  if (items != nullptr) {
+    cb.Run(items);
+    return;
+  }
+
+  media_interface_->GetFolderItems(
+      curr_browsed_player_id_, folder_id,
+      base::Bind(&Device::FolderItemsFetched, weak_ptr_factory_.GetWeakPtr(),
+                 browse_cache_.generation(), curr_browsed_player_id_,
+                 folder_id, cb));
+}
+
+void Device::FolderItemsFetched(uint16_t generation, int player_id,
+                                std::string folder_id, FolderItemsCallback cb,
+                                std::vector<ListItem> item_list) {
+  auto items = browse_cache_.set_folder(generation, player_id,
+                                        std::move(folder_id),
+                                        std::move(item_list));
+  cb.Run(items);
+}
+
 void Device::HandleGetTotalNumberOfItems(
     uint8_t label, std::shared_ptr<GetTotalNumberOfItemsRequest> pkt) {
   if (!pkt->IsValid()) {
@@ -1163,13 +1209,12 @@ void Device::HandleGetTotalNumberOfItems(
       break;
     }
     case Scope::VFS:
-      media_interface_->GetFolderItems(
-          curr_browsed_player_id_, CurrentFolder(),
+      GetCachedFolderItems(
           base::Bind(&Device::GetTotalNumberOfItemsVFSResponse,
                      weak_ptr_factory_.GetWeakPtr(), label));
       break;
     case Scope::NOW_PLAYING:
-      media_interface_->GetNowPlayingList(
+      GetCachedNowPlayingList(
           base::Bind(&Device::GetTotalNumberOfItemsNowPlayingResponse,
                      weak_ptr_factory_.GetWeakPtr(), label));
       break;
@@ -1189,20 +1234,21 @@ void Device::GetTotalNumberOfItemsMediaPlayersResponse(
 }
 
 void Device::GetTotalNumberOfItemsVFSResponse(uint8_t label,
-                                              std::vector<ListItem> list) {
-  log::verbose("num_items={}", list.size());
+                                              BrowseCache::ItemList list) {
+  log::verbose("num_items={}", list->size());
 
   auto builder = GetTotalNumberOfItemsResponseBuilder::MakeBuilder(
-      Status::NO_ERROR, 0x0000, list.size());
+      Status::NO_ERROR, 0x0000, list->size());
   send_message(label, true, std::move(builder));
 }
 
 void Device::GetTotalNumberOfItemsNowPlayingResponse(
-    uint8_t label, std::string curr_song_id, std::vector<SongInfo> list) {
-  log::verbose("num_items={}", list.size());
+    uint8_t label, const std::string& /* curr_song_id */,
+    BrowseCache::SongList list) {
+  log::verbose("num_items={}", list->size());
 
   auto builder = GetTotalNumberOfItemsResponseBuilder::MakeBuilder(
-      Status::NO_ERROR, 0x0000, list.size());
+      Status::NO_ERROR, 0x0000, list->size());
   send_message(label, true, std::move(builder));
 }
 
@@ -1245,19 +1291,17 @@ void Device::HandleChangePath(uint8_t label,
     log::verbose("Popping Path from stack: new path=\"{}\"", CurrentFolder());
   }
 
-  media_interface_->GetFolderItems(
-      curr_browsed_player_id_, CurrentFolder(),
-      base::Bind(&Device::ChangePathResponse, weak_ptr_factory_.GetWeakPtr(),
-                 label, pkt));
+  GetCachedFolderItems(base::Bind(&Device::ChangePathResponse,
+                                  weak_ptr_factory_.GetWeakPtr(), label, pkt));
 }
 
 void Device::ChangePathResponse(uint8_t label,
                                 std::shared_ptr<ChangePathRequest> pkt,
-                                std::vector<ListItem> list) {
+                                BrowseCache::ItemList list) {
   // TODO (apanicke): Reconstruct the VFS ID's here. Right now it gets
   // reconstructed in GetFolderItemsVFS
   auto builder =
-      ChangePathResponseBuilder::MakeBuilder(Status::NO_ERROR, list.size());
+      ChangePathResponseBuilder::MakeBuilder(Status::NO_ERROR, list->size());
   send_message(label, true, std::move(builder));
 }
 
@@ -1283,7 +1327,7 @@ void Device::HandleGetItemAttributes(
 
   switch (pkt->GetScope()) {
     case Scope::NOW_PLAYING: {
-      media_interface_->GetNowPlayingList(
+      GetCachedNowPlayingList(
           base::Bind(&Device::GetItemAttributesNowPlayingResponse,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
     } break;
@@ -1292,8 +1336,7 @@ void Device::HandleGetItemAttributes(
       // then we can auto send the error without calling up. We do this check
       // later right now though in order to prevent race conditions with updates
       // on the media layer.
-      media_interface_->GetFolderItems(
-          curr_browsed_player_id_, CurrentFolder(),
+      GetCachedFolderItems(
           base::Bind(&Device::GetItemAttributesVFSResponse,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
       break;
@@ -1305,7 +1348,7 @@ void Device::HandleGetItemAttributes(
 
 void Device::GetItemAttributesNowPlayingResponse(
     uint8_t label, std::shared_ptr<GetItemAttributesRequest> pkt,
-    std::string curr_media_id, std::vector<SongInfo> song_list) {
+    const std::string& curr_media_id, BrowseCache::SongList song_list) {
   log::verbose("uid=0x{:x}", pkt->GetUid());
   auto builder = GetItemAttributesResponseBuilder::MakeBuilder(Status::NO_ERROR,
                                                                browse_mtu_);
@@ -1318,11 +1361,11 @@ void Device::GetItemAttributesNowPlayingResponse(
   log::verbose("media_id=\"{}\"", media_id);
 
   SongInfo info;
-  if (song_list.size() == 1) {
+  if (song_list->size() == 1) {
     log::verbose("Send out the only song in the queue as now playing song.");
-    info = song_list.front();
+    info = song_list->front();
   } else {
-    for (const auto& temp : song_list) {
+    for (const auto& temp : *song_list) {
       if (temp.media_id == media_id) {
         info = temp;
       }
@@ -1354,7 +1397,7 @@ void Device::GetItemAttributesNowPlayingResponse(
 
 void Device::GetItemAttributesVFSResponse(
     uint8_t label, std::shared_ptr<GetItemAttributesRequest> pkt,
-    std::vector<ListItem> item_list) {
+    BrowseCache::ItemList item_list) {
   log::verbose("uid=0x{:x}", pkt->GetUid());
 
   auto media_id = vfs_ids_.get_media_id(pkt->GetUid());
@@ -1372,7 +1415,7 @@ void Device::GetItemAttributesVFSResponse(
   ListItem item_requested;
   item_requested.type = ListItem::SONG;
 
-  for (const auto& temp : item_list) {
+  for (const auto& temp : *item_list) {
     if ((temp.type == ListItem::FOLDER && temp.folder.media_id == media_id) ||
         (temp.type == ListItem::SONG && temp.song.media_id == media_id)) {
       item_requested = temp;
@@ -1470,7 +1513,7 @@ std::set<AttributeEntry> filter_attributes_requested(
 
 void Device::GetVFSListResponse(uint8_t label,
                                 std::shared_ptr<GetFolderItemsRequest> pkt,
-                                std::vector<ListItem> items) {
+                                BrowseCache::ItemList item_list) {
   log::verbose("start_item={} end_item={}", pkt->GetStartItem(),
                pkt->GetEndItem());
 
@@ -1480,12 +1523,16 @@ void Device::GetVFSListResponse(uint8_t label,
 
   // TODO (apanicke): Add test that checks if vfs_ids_ is the correct size after
   // an operation.
-  for (const auto& item : items) {
-    if (item.type == ListItem::FOLDER) {
-      vfs_ids_.insert(item.folder.media_id);
-    } else if (item.type == ListItem::SONG) {
-      vfs_ids_.insert(item.song.media_id);
+  const auto& items = *item_list;
+  if (vfs_ids_source_ != item_list) {
+    for (const auto& item : items) {
+      if (item.type == ListItem::FOLDER) {
+        vfs_ids_.insert(item.folder.media_id);
+      } else if (item.type == ListItem::SONG) {
+        vfs_ids_.insert(item.song.media_id);
+      }
     }
+    vfs_ids_source_ = item_list;
   }
 
   // Add the elements retrieved in the last get folder items request and map
@@ -1534,14 +1581,19 @@ void Device::GetVFSListResponse(uint8_t label,
 
 void Device::GetNowPlayingListResponse(
     uint8_t label, std::shared_ptr<GetFolderItemsRequest> pkt,
-    std::string /* unused curr_song_id */, std::vector<SongInfo> song_list) {
+    const std::string& /* unused curr_song_id */,
+    BrowseCache::SongList songs) {
   log::verbose("");
   auto builder = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
       Status::NO_ERROR, 0x0000, browse_mtu_);
 
-  now_playing_ids_.clear();
-  for (const SongInfo& song : song_list) {
-    now_playing_ids_.insert(song.media_id);
+  const auto& song_list = *songs;
+  if (now_playing_ids_source_ != songs) {
+    now_playing_ids_.clear();
+    for (const SongInfo& song : song_list) {
+      now_playing_ids_.insert(song.media_id);
+    }
+    now_playing_ids_source_ = songs;
   }
 
   for (size_t i = pkt->GetStartItem();
@@ -1612,6 +1664,7 @@ void Device::SetBrowsedPlayerResponse(
   }
 
   curr_browsed_player_id_ = pkt->GetPlayerId();
+  browse_cache_.invalidate_folders(curr_browsed_player_id_);
 
   // Clear the path and push the new root.
   current_path_ = std::stack<std::string>();
@@ -1630,6 +1683,9 @@ void Device::SendMediaUpdate(bool metadata, bool play_status, bool queue) {
   log::verbose("Metadata={} : play_status= {} : queue={} : is_silence={}",
                metadata, play_status, queue, is_silence);
 
+  // The now playing list holds the current song ID
+  if (queue || metadata) browse_cache_.invalidate_now_playing();
+
   if (queue) {
     HandleNowPlayingUpdate();
   }
@@ -1650,6 +1706,9 @@ void Device::SendFolderUpdate(bool available_players, bool addressed_player,
                    "assert failed: media_interface_ != nullptr");
   log::verbose("");
 
+  if (available_players || uids) browse_cache_.invalidate_folders();
+  if (addressed_player) browse_cache_.invalidate_now_playing();
+
   if (available_players) {
     HandleAvailablePlayerUpdate();
   }
@@ -1765,6 +1824,7 @@ void Device::HandleNowPlayingNotificationResponse(
   }
 
   now_playing_ids_.clear();
+  now_playing_ids_source_.reset();
   for (const SongInfo& song : song_list) {
     now_playing_ids_.insert(song.media_id);
   }
@@ -1835,6 +1895,7 @@ void Device::DeviceDisconnected() {
   // to reset the local volume var to be sure we send the correct value
   // to the remote device on the next connection.
   volume_ = VOL_NOT_SUPPORTED;
+  browse_cache_.clear();
 }
 
 static std::string volumeToStr(int8_t volume) {
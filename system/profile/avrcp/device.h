@@ -43,6 +43,7 @@
 #include "packet/avrcp/set_browsed_player.h"
 #include "packet/avrcp/set_player_application_setting_value.h"
 #include "packet/avrcp/vendor_packet.h"
+#include "profile/avrcp/browse_cache.h"
 #include "profile/avrcp/media_id_map.h"
 #include "raw_address.h"
 
@@ -223,10 +224,10 @@ class Device {
       uint16_t curr_player, std::vector<MediaPlayerInfo> players);
   virtual void GetVFSListResponse(uint8_t label,
                                   std::shared_ptr<GetFolderItemsRequest> pkt,
-                                  std::vector<ListItem> items);
+                                  BrowseCache::ItemList items);
   virtual void GetNowPlayingListResponse(
       uint8_t label, std::shared_ptr<GetFolderItemsRequest> pkt,
-      std::string curr_song_id, std::vector<SongInfo> song_list);
+      const std::string& curr_song_id, BrowseCache::SongList song_list);
 
   // GET TOTAL NUMBER OF ITEMS
   virtual void HandleGetTotalNumberOfItems(
@@ -234,19 +235,20 @@ class Device {
   virtual void GetTotalNumberOfItemsMediaPlayersResponse(
       uint8_t label, uint16_t curr_player, std::vector<MediaPlayerInfo> list);
   virtual void GetTotalNumberOfItemsVFSResponse(uint8_t label,
-                                                std::vector<ListItem> items);
+                                                BrowseCache::ItemList items);
   virtual void GetTotalNumberOfItemsNowPlayingResponse(
-      uint8_t label, std::string curr_song_id, std::vector<SongInfo> song_list);
+      uint8_t label, const std::string& curr_song_id,
+      BrowseCache::SongList song_list);
 
   // GET ITEM ATTRIBUTES
   virtual void HandleGetItemAttributes(
       uint8_t label, std::shared_ptr<GetItemAttributesRequest> request);
   virtual void GetItemAttributesNowPlayingResponse(
       uint8_t label, std::shared_ptr<GetItemAttributesRequest> pkt,
-      std::string curr_media_id, std::vector<SongInfo> song_list);
+      const std::string& curr_media_id, BrowseCache::SongList song_list);
   virtual void GetItemAttributesVFSResponse(
       uint8_t label, std::shared_ptr<GetItemAttributesRequest> pkt,
-      std::vector<ListItem> item_list);
+      BrowseCache::ItemList item_list);
 
   // SET BROWSED PLAYER
   virtual void HandleSetBrowsedPlayer(
@@ -260,7 +262,7 @@ class Device {
                                 std::shared_ptr<ChangePathRequest> request);
   virtual void ChangePathResponse(uint8_t label,
                                   std::shared_ptr<ChangePathRequest> request,
-                                  std::vector<ListItem> list);
+                                  BrowseCache::ItemList list);
 
   // PLAY ITEM
   virtual void HandlePlayItem(uint8_t label,
@@ -315,6 +317,19 @@ class Device {
   friend std::ostream& operator<<(std::ostream& out, const Device& c);
 
  private:
+  // Browsing lists, served from browse_cache_ when possible
+  using NowPlayingListCallback = base::Callback<void(
+      const std::string& curr_song_id, BrowseCache::SongList song_list)>;
+  using FolderItemsCallback = base::Callback<void(BrowseCache::ItemList)>;
+  void GetCachedNowPlayingList(NowPlayingListCallback cb);
+  void GetCachedFolderItems(FolderItemsCallback cb);
+  void NowPlayingListFetched(uint16_t generation, NowPlayingListCallback cb,
+                             std::string curr_song_id,
+                             std::vector<SongInfo> song_list);
+  void FolderItemsFetched(uint16_t generation, int player_id,
+                          std::string folder_id, FolderItemsCallback cb,
+                          std::vector<ListItem> items);
+
   // This should always contain one item which represents the root id on the
   // current player.
   std::string CurrentFolder() const {
@@ -372,6 +387,11 @@ class Device {
   MediaIdMap vfs_ids_;
   MediaIdMap now_playing_ids_;
 
+  BrowseCache browse_cache_;
+  // Lists the ID maps were last filled from, to only map a list once
+  BrowseCache::ItemList vfs_ids_source_;
+  BrowseCache::SongList now_playing_ids_source_;
+
   uint32_t play_pos_interval_ = 0;
 
   SongInfo last_song_info_;
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Paging through a large now playing list in 10 item windows, as car head
+// units do: fetching the whole list for every page, as done before the browse
+// cache, and serving the pages from the cache.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "profile/avrcp/browse_cache.h"
+#include "profile/avrcp/media_id_map.h"
+
+using ::benchmark::State;
+using bluetooth::avrcp::Attribute;
+using bluetooth::avrcp::AttributeEntry;
+using bluetooth::avrcp::BrowseCache;
+using bluetooth::avrcp::MediaIdMap;
+using bluetooth::avrcp::SongInfo;
+
+namespace {
+
+constexpr size_t kPageSize = 10;
+
+// Stands in for the list the media interface builds from the Java layer
+std::vector<SongInfo> make_library(size_t num_songs) {
+  std::vector<SongInfo> songs;
+  songs.reserve(num_songs);
+  for (size_t i = 0; i < num_songs; i++) {
+    std::string id = std::to_string(i);
+    songs.push_back(
+        {"media_id_" + id,
+         {AttributeEntry(Attribute::TITLE, "Title " + id),
+          AttributeEntry(Attribute::ARTIST_NAME, "Artist " + id),
+          AttributeEntry(Attribute::ALBUM_NAME, "Album " + id)}});
+  }
+  return songs;
+}
+
+size_t read_page(const std::vector<SongInfo>& songs, MediaIdMap& ids,
+                 size_t start) {
+  size_t bytes = 0;
+  for (size_t i = start; i < start + kPageSize && i < songs.size(); i++) {
+    bytes += ids.get_uid(songs[i].media_id);
+    for (const auto& attribute : songs[i].attributes) {
+      bytes += attribute.value().size();
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+static void BM_PageUncached(State& state) {
+  size_t num_songs = state.range(0);
+  std::vector<SongInfo> library = make_library(num_songs);
+  MediaIdMap ids;
+
+  size_t start = 0;
+  for (auto _ : state) {
+    // Fetch and index the whole list for one page
+    std::vector<SongInfo> songs = library;
+    ids.clear();
+    for (const SongInfo& song : songs) ids.insert(song.media_id);
+    benchmark::DoNotOptimize(read_page(songs, ids, start));
+    start = (start + kPageSize) % num_songs;
+  }
+}
+BENCHMARK(BM_PageUncached)->Arg(1000)->Arg(10000);
+
+static void BM_PageCached(State& state) {
+  size_t num_songs = state.range(0);
+  BrowseCache cache;
+  cache.set_now_playing(cache.generation(), "media_id_0",
+                        make_library(num_songs));
+  MediaIdMap ids;
+  for (const SongInfo& song : *cache.now_playing()) ids.insert(song.media_id);
+
+  size_t start = 0;
+  for (auto _ : state) {
+    BrowseCache::SongList songs = cache.now_playing();
+    benchmark::DoNotOptimize(read_page(*songs, ids, start));
+    start = (start + kPageSize) % num_songs;
+  }
+}
+BENCHMARK(BM_PageCached)->Arg(1000)->Arg(10000);
+
+static void BM_CountCached(State& state) {
+  BrowseCache cache;
+  cache.set_now_playing(cache.generation(), "media_id_0",
+                        make_library(state.range(0)));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.now_playing()->size());
+  }
+}
+BENCHMARK(BM_CountCached)->Arg(10000);
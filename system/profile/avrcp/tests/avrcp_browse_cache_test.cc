@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "browse_cache.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace avrcp {
+
+namespace {
+
+std::vector<ListItem> make_folder(const std::string& media_id) {
+  ListItem item = {ListItem::FOLDER, FolderInfo{media_id, true, "Folder"},
+                   SongInfo()};
+  return {item};
+}
+
+}  // namespace
+
+TEST(AvrcpBrowseCacheTest, folderIsCachedTest) {
+  BrowseCache cache;
+  auto now = BrowseCache::Clock::now();
+
+  EXPECT_EQ(cache.folder(1, "root", now), nullptr);
+  auto items = cache.set_folder(cache.generation(), 1, "root",
+                                make_folder("a"), now);
+  EXPECT_EQ(cache.folder(1, "root", now), items);
+  EXPECT_EQ(cache.folder(2, "root", now), nullptr);
+}
+
+TEST(AvrcpBrowseCacheTest, folderExpiresTest) {
+  BrowseCache cache;
+  auto now = BrowseCache::Clock::now();
+
+  auto items = cache.set_folder(cache.generation(), 1, "root",
+                                make_folder("a"), now);
+  now += BrowseCache::kFolderMaxAge - std::chrono::milliseconds(1);
+  EXPECT_EQ(cache.folder(1, "root", now), items);
+
+  // Library changes are not reported, the folder is fetched again
+  now += std::chrono::milliseconds(1);
+  EXPECT_EQ(cache.folder(1, "root", now), nullptr);
+  EXPECT_EQ(cache.folder(1, "root", now - std::chrono::seconds(1)), nullptr);
+}
+
+TEST(AvrcpBrowseCacheTest, racingFetchIsNotCachedTest) {
+  BrowseCache cache;
+  auto now = BrowseCache::Clock::now();
+
+  uint16_t generation = cache.generation();
+  cache.invalidate_folders();
+  auto items = cache.set_folder(generation, 1, "root", make_folder("a"), now);
+  ASSERT_NE(items, nullptr);
+  EXPECT_EQ(cache.folder(1, "root", now), nullptr);
+}
+
+}  // namespace avrcp
+}  // namespace bluetooth
@@ -960,6 +960,46 @@ TEST_F(AvrcpDeviceTest, getNowPlayingListTest) {
   SendBrowseMessage(1, request);
 }
 
+TEST_F(AvrcpDeviceTest, nowPlayingListCacheTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr,
+                                  nullptr);
+  SetBipClientStatus(false);
+
+  SongInfo info = {"test_id", {AttributeEntry(Attribute::TITLE, "Test Song")}};
+  std::vector<SongInfo> list = {info};
+
+  // Fetched once for both pages, then again once the queue changed
+  EXPECT_CALL(interface, GetNowPlayingList(_))
+      .Times(2)
+      .WillRepeatedly(InvokeCb<0>("test_id", list));
+
+  auto request = TestBrowsePacket::Make(get_folder_items_request_now_playing);
+  for (uint8_t label = 1; label <= 2; label++) {
+    auto expected_response =
+        GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(Status::NO_ERROR,
+                                                             0x0000, 0xFFFF);
+    expected_response->AddSong(
+        MediaElementItem(1, "Test Song", info.attributes));
+    EXPECT_CALL(response_cb,
+                Call(label, true, matchPacket(std::move(expected_response))))
+        .Times(1);
+    SendBrowseMessage(label, request);
+  }
+
+  test_device->SendMediaUpdate(false, false, true);
+
+  auto expected_response = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  expected_response->AddSong(MediaElementItem(1, "Test Song", info.attributes));
+  EXPECT_CALL(response_cb,
+              Call(3, true, matchPacket(std::move(expected_response))))
+      .Times(1);
+  SendBrowseMessage(3, request);
+}
+
 TEST_F(AvrcpDeviceTest, getNowPlayingListWithCoverArtTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -1084,8 +1124,9 @@ TEST_F(AvrcpDeviceTest, changePathTest) {
   ListItem item3 = {ListItem::FOLDER, info3, SongInfo()};
   ListItem item4 = {ListItem::FOLDER, info4, SongInfo()};
   std::vector<ListItem> list1 = {item2, item3, item4};
+  // Served from the browse cache after the first request
   EXPECT_CALL(interface, GetFolderItems(_, "test_id1", _))
-      .Times(3)
+      .Times(1)
       .WillRepeatedly(InvokeCb<2>(list1));
 
   std::vector<ListItem> list2 = {};
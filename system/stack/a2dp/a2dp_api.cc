@@ -343,6 +343,17 @@ tA2DP_STATUS A2DP_FindService(uint16_t service_uuid, const RawAddress& bd_addr,
   a2dp_cb.find.service_uuid = service_uuid;
   a2dp_cb.find.p_cback = p_cback;
 
+  /* a bonded peer discovered before is answered from the SDP record cache,
+   * without paging it */
+  if (get_legacy_stack_sdp_api()->service.SDP_ReadCachedRecords(
+          bd_addr, a2dp_cb.find.p_db)) {
+    log::info(
+        "A2DP service discovery for peer {} UUID 0x{:04x}: cached records",
+        bd_addr, service_uuid);
+    a2dp_sdp_cback(bd_addr, SDP_SUCCESS);
+    return A2DP_SUCCESS;
+  }
+
   /* perform service search */
   if (!get_legacy_stack_sdp_api()->service.SDP_ServiceSearchAttributeRequest(
           bd_addr, a2dp_cb.find.p_db, a2dp_sdp_cback)) {
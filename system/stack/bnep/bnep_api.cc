@@ -326,7 +326,10 @@ tBNEP_RESULT BNEP_Disconnect(uint16_t handle) {
  *                  BNEP_MTU_EXCEDED        - If the data length is greater than
  *                                            the MTU
  *                  BNEP_IGNORE_CMD         - If the packet is filtered out
- *                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full
+ *                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full. The
+ *                                            buffer is left to the caller,
+ *                                            to be written again once the
+ *                                            data flow is back on.
  *                  BNEP_SUCCESS            - If written successfully
  *
  ******************************************************************************/
@@ -342,6 +345,12 @@ tBNEP_RESULT BNEP_WriteBuf(uint16_t handle, const RawAddress& dest_addr,
   }
 
   p_bcb = &(bnep_cb.bcb[handle - 1]);
+
+  /* Check transmit queue, before the buffer is changed */
+  if (fixed_queue_length(p_bcb->xmit_q) >= BNEP_MAX_XMITQ_DEPTH) {
+    return (BNEP_Q_SIZE_EXCEEDED);
+  }
+
   /* Check MTU size */
   if (p_buf->len > BNEP_MTU_SIZE) {
     log::error("length {} exceeded MTU {}", p_buf->len, BNEP_MTU_SIZE);
@@ -400,12 +409,6 @@ tBNEP_RESULT BNEP_WriteBuf(uint16_t handle, const RawAddress& dest_addr,
     }
   }
 
-  /* Check transmit queue */
-  if (fixed_queue_length(p_bcb->xmit_q) >= BNEP_MAX_XMITQ_DEPTH) {
-    osi_free(p_buf);
-    return (BNEP_Q_SIZE_EXCEEDED);
-  }
-
   /* Build the BNEP header */
   bnepu_build_bnep_hdr(p_bcb, p_buf, protocol, src_addr, dest_addr,
                        fw_ext_present);
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <list>
 #include <map>
 #include <memory>
@@ -34,6 +36,7 @@
 #include "main/shim/entry.h"
 #include "main/shim/hci_layer.h"
 #include "os/log.h"
+#include "os/stats.h"
 #include "osi/include/allocator.h"
 #include "stack/include/bt_hdr.h"
 #include "stack/include/bt_types.h"
@@ -54,8 +57,17 @@ static constexpr uint8_t kStateFlagIsConnected = 0x02;
 static constexpr uint8_t kStateFlagHasDataPathSet = 0x04;
 static constexpr uint8_t kStateFlagIsBroadcast = 0x10;
 
+/* CIS and BIS connection handles are indexed directly, as the controller
+ * allocates them from the 12-bit HCI handle space.
+ */
+static constexpr size_t kIsoHandleTableSize = HCI_HANDLE_MAX + 1;
+
 constexpr char kBtmLogTag[] = "ISO";
 
+static os::StatsCounter stats_tx_sdus("iso.tx_sdus");
+static os::StatsCounter stats_tx_dropped_sdus("iso.tx_dropped_sdus");
+static os::StatsCounter stats_rx_sdus("iso.rx_sdus");
+
 struct iso_sync_info {
   uint16_t seq_nb;
 };
@@ -83,8 +95,18 @@ struct iso_base {
     uint64_t evt_last_lost_us = 0;
   };
 
+  struct sdu_tx_stats {
+    size_t sdu_count = 0;
+    size_t late_sdu_count = 0;
+    size_t jitter_samples = 0;
+    uint64_t jitter_sum_us = 0;
+    uint64_t jitter_max_us = 0;
+    uint64_t last_sdu_us = 0;
+  };
+
   credits_stats cr_stats;
   event_stats evt_stats;
+  sdu_tx_stats tx_stats;
 };
 
 typedef iso_base iso_cis;
@@ -148,21 +170,33 @@ struct iso_impl {
       log::assert_that(len >= (3) + (cis_cnt * sizeof(uint16_t)),
                        "Invalid CIS count: {}", cis_cnt);
 
+      /* Drop the event rather than index the handle table out of bounds */
+      uint8_t* handles = stream;
+      for (int i = 0; i < cis_cnt; i++) {
+        STREAM_TO_UINT16(conn_handle, handles);
+        if (conn_handle >= kIsoHandleTableSize) {
+          log::error("Invalid CIS handle: 0x{:x}, dropping CIG {} event",
+                     conn_handle, cig_id);
+          return;
+        }
+      }
+
       /* Remove entries for the reconfigured CIG */
       if (evt_code == kIsoEventCigOnReconfigureCmpl) {
         auto cis_it = conn_hdl_to_cis_map_.cbegin();
         while (cis_it != conn_hdl_to_cis_map_.cend()) {
-          if (cis_it->second->cig_id == evt.cig_id)
+          if (cis_it->second->cig_id == evt.cig_id) {
+            cis_hdl_table_[cis_it->first] = nullptr;
             cis_it = conn_hdl_to_cis_map_.erase(cis_it);
-          else
+          } else {
             ++cis_it;
+          }
         }
       }
 
       evt.conn_handles.reserve(cis_cnt);
       for (int i = 0; i < cis_cnt; i++) {
         STREAM_TO_UINT16(conn_handle, stream);
-
         evt.conn_handles.push_back(conn_handle);
 
         auto cis = std::unique_ptr<iso_cis>(new iso_cis());
@@ -171,6 +205,7 @@ struct iso_impl {
         cis->sync_info = {.seq_nb = 0};
         cis->used_credits = 0;
         cis->state_flags = kStateFlagsNone;
+        cis_hdl_table_[conn_handle] = cis.get();
         conn_hdl_to_cis_map_[conn_handle] = std::move(cis);
       }
     }
@@ -236,10 +271,12 @@ struct iso_impl {
     if (evt.status == HCI_SUCCESS) {
       auto cis_it = conn_hdl_to_cis_map_.cbegin();
       while (cis_it != conn_hdl_to_cis_map_.cend()) {
-        if (cis_it->second->cig_id == evt.cig_id)
+        if (cis_it->second->cig_id == evt.cig_id) {
+          cis_hdl_table_[cis_it->first] = nullptr;
           cis_it = conn_hdl_to_cis_map_.erase(cis_it);
-        else
+        } else {
           ++cis_it;
+        }
       }
     }
 
@@ -561,9 +598,12 @@ struct iso_impl {
     uint16_t seq_nb = iso->sync_info.seq_nb;
     iso->sync_info.seq_nb = (seq_nb + 1) & 0xffff;
 
+    update_tx_stats(iso);
+
     if (iso_credits_ == 0 || data_len > iso_buffer_size_) {
       iso->cr_stats.credits_underflow_bytes += data_len;
       iso->cr_stats.credits_underflow_count++;
+      stats_tx_dropped_sdus.Increment();
       iso->cr_stats.credits_last_underflow_us =
           bluetooth::common::time_get_os_boottime_us();
 
@@ -576,6 +616,7 @@ struct iso_impl {
 
     iso_credits_--;
     iso->used_credits++;
+    stats_tx_sdus.Increment();
 
     BT_HDR* packet = prepare_hci_packet(iso_handle, seq_nb, data_len);
     memcpy(packet->data + kIsoHeaderWithoutTsLen, data, data_len);
@@ -584,6 +625,30 @@ struct iso_impl {
     hci->transmit_downward(packet, iso_buffer_size_);
   }
 
+  /* Tracks how regularly the SDUs are delivered by the audio source, compared
+   * to the negotiated SDU interval. An SDU arriving more than half of the
+   * interval after its due time is counted as late.
+   */
+  static void update_tx_stats(iso_base* iso) {
+    uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+    auto& stats = iso->tx_stats;
+
+    if (stats.last_sdu_us != 0 && iso->sdu_itv != 0) {
+      uint64_t delta_us = now_us - stats.last_sdu_us;
+      uint64_t jitter_us = (delta_us > iso->sdu_itv)
+                               ? (delta_us - iso->sdu_itv)
+                               : (iso->sdu_itv - delta_us);
+
+      stats.jitter_samples++;
+      stats.jitter_sum_us += jitter_us;
+      stats.jitter_max_us = std::max(stats.jitter_max_us, jitter_us);
+      if (delta_us > iso->sdu_itv + iso->sdu_itv / 2) stats.late_sdu_count++;
+    }
+
+    stats.last_sdu_us = now_us;
+    stats.sdu_count++;
+  }
+
   void process_cis_est_pkt(uint8_t len, uint8_t* data) {
     cis_establish_cmpl_evt evt;
 
@@ -658,6 +723,9 @@ struct iso_impl {
       iso_credits_ += cis->used_credits;
       cis->used_credits = 0;
 
+      /* Do not account the reconnection gap as SDU jitter */
+      cis->tx_stats.last_sdu_us = 0;
+
       /* Data path is considered still valid, but can be reconfigured only once
        * CIS is reestablished.
        */
@@ -665,18 +733,11 @@ struct iso_impl {
   }
 
   void handle_gd_num_completed_pkts(uint16_t handle, uint16_t credits) {
-    auto iter = conn_hdl_to_cis_map_.find(handle);
-    if (iter != conn_hdl_to_cis_map_.end()) {
-      iter->second->used_credits -= credits;
-      iso_credits_ += credits;
-      return;
-    }
+    iso_base* iso = GetIsoIfKnown(handle);
+    if (iso == nullptr) return;
 
-    iter = conn_hdl_to_bis_map_.find(handle);
-    if (iter != conn_hdl_to_bis_map_.end()) {
-      iter->second->used_credits -= credits;
-      iso_credits_ += credits;
-    }
+    iso->used_credits -= credits;
+    iso_credits_ += credits;
   }
 
   void process_create_big_cmpl_pkt(uint8_t len, uint8_t* data) {
@@ -705,6 +766,20 @@ struct iso_impl {
                      "Invalid packet length: {}. Number of bis: {}", len,
                      num_bis);
 
+    if (evt.status == HCI_SUCCESS) {
+      /* Drop the event rather than index the handle table out of bounds */
+      uint8_t* handles = data;
+      for (auto i = 0; i < num_bis; ++i) {
+        uint16_t conn_handle;
+        STREAM_TO_UINT16(conn_handle, handles);
+        if (conn_handle >= kIsoHandleTableSize) {
+          log::error("Invalid BIS handle: 0x{:x}, dropping BIG {} event",
+                     conn_handle, evt.big_id);
+          return;
+        }
+      }
+    }
+
     for (auto i = 0; i < num_bis; ++i) {
       uint16_t conn_handle;
       STREAM_TO_UINT16(conn_handle, data);
@@ -718,6 +793,7 @@ struct iso_impl {
         bis->sync_info = {.seq_nb = 0};
         bis->used_credits = 0;
         bis->state_flags = kStateFlagIsBroadcast;
+        bis_hdl_table_[conn_handle] = bis.get();
         conn_hdl_to_bis_map_[conn_handle] = std::move(bis);
       }
     }
@@ -746,6 +822,7 @@ struct iso_impl {
     auto bis_it = conn_hdl_to_bis_map_.cbegin();
     while (bis_it != conn_hdl_to_bis_map_.cend()) {
       if (bis_it->second->big_handle == evt.big_id) {
+        bis_hdl_table_[bis_it->first] = nullptr;
         bis_it = conn_hdl_to_bis_map_.erase(bis_it);
         is_known_handle = true;
       } else {
@@ -824,6 +901,7 @@ struct iso_impl {
                            : kIsoHeaderWithoutTsLen))
       return;
 
+    stats_rx_sdus.Increment();
     log::assert_that(cig_callbacks_ != nullptr, "Invalid CIG callbacks");
 
     STREAM_TO_UINT16(handle, stream);
@@ -864,15 +942,15 @@ struct iso_impl {
   }
 
   iso_cis* GetCisIfKnown(uint16_t cis_conn_handle) {
-    auto cis_it = conn_hdl_to_cis_map_.find(cis_conn_handle);
-    return (cis_it != conn_hdl_to_cis_map_.end()) ? cis_it->second.get()
-                                                  : nullptr;
+    return (cis_conn_handle < kIsoHandleTableSize)
+               ? cis_hdl_table_[cis_conn_handle]
+               : nullptr;
   }
 
   iso_bis* GetBisIfKnown(uint16_t bis_conn_handle) {
-    auto bis_it = conn_hdl_to_bis_map_.find(bis_conn_handle);
-    return (bis_it != conn_hdl_to_bis_map_.end()) ? bis_it->second.get()
-                                                  : nullptr;
+    return (bis_conn_handle < kIsoHandleTableSize)
+               ? bis_hdl_table_[bis_conn_handle]
+               : nullptr;
   }
 
   iso_base* GetIsoIfKnown(uint16_t iso_handle) {
@@ -927,6 +1005,19 @@ struct iso_impl {
                  : 0llu));
   }
 
+  static void dump_tx_stats(int fd, const iso_base::sdu_tx_stats& stats) {
+    dprintf(fd, "        SDU TX Stats:\n");
+    dprintf(fd, "          SDUs sent (count): %zu\n", stats.sdu_count);
+    dprintf(fd, "          Late SDUs (count): %zu\n", stats.late_sdu_count);
+    dprintf(fd, "          Average jitter (us): %llu\n",
+            (stats.jitter_samples > 0
+                 ? (unsigned long long)stats.jitter_sum_us /
+                       stats.jitter_samples
+                 : 0llu));
+    dprintf(fd, "          Max jitter (us): %llu\n",
+            (unsigned long long)stats.jitter_max_us);
+  }
+
   void dump(int fd) const {
     dprintf(fd, "  ----------------\n ");
     dprintf(fd, "  ISO Manager:\n");
@@ -946,6 +1037,7 @@ struct iso_impl {
               cis_pair.second->state_flags.load());
       dump_credits_stats(fd, cis_pair.second->cr_stats);
       dump_event_stats(fd, cis_pair.second->evt_stats);
+      dump_tx_stats(fd, cis_pair.second->tx_stats);
     }
     dprintf(fd, "    BISes:\n");
     for (auto const& cis_pair : conn_hdl_to_bis_map_) {
@@ -958,12 +1050,16 @@ struct iso_impl {
               cis_pair.second->state_flags.load());
       dump_credits_stats(fd, cis_pair.second->cr_stats);
       dump_event_stats(fd, cis_pair.second->evt_stats);
+      dump_tx_stats(fd, cis_pair.second->tx_stats);
     }
     dprintf(fd, "  ----------------\n ");
   }
 
   std::map<uint16_t, std::unique_ptr<iso_cis>> conn_hdl_to_cis_map_;
   std::map<uint16_t, std::unique_ptr<iso_bis>> conn_hdl_to_bis_map_;
+  /* Non-owning, handle indexed views of the above maps for the data path */
+  std::array<iso_cis*, kIsoHandleTableSize> cis_hdl_table_{};
+  std::array<iso_bis*, kIsoHandleTableSize> bis_hdl_table_{};
   std::map<uint16_t, RawAddress> cis_hdl_to_addr;
 
   std::atomic_uint16_t iso_credits_;
@@ -27,6 +27,7 @@
 #include "gatt_int.h"
 #include "internal_include/bt_target.h"
 #include "l2c_api.h"
+#include "os/stats.h"
 #include "osi/include/allocator.h"
 #include "stack/include/bt_hdr.h"
 #include "stack/include/bt_types.h"
@@ -41,6 +42,9 @@ using base::StringPrintf;
 using bluetooth::Uuid;
 using namespace bluetooth;
 
+static bluetooth::os::StatsCounter stats_tx_pdus("gatt.tx_pdus");
+static bluetooth::os::StatsCounter stats_tx_congested("gatt.tx_congested");
+
 /**********************************************************************
  *   ATT protocol message building utility                              *
  **********************************************************************/
@@ -376,6 +380,7 @@ tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, uint16_t lcid,
                                     BT_HDR* p_toL2CAP) {
   uint16_t l2cap_ret;
 
+  stats_tx_pdus.Increment();
   if (lcid == L2CAP_ATT_CID) {
     log::debug("Sending ATT message on att fixed channel");
     l2cap_ret = L2CA_SendFixedChnlData(lcid, tcb.peer_bda, p_toL2CAP);
@@ -389,6 +394,7 @@ tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, uint16_t lcid,
     return GATT_INTERNAL_ERROR;
   } else if (l2cap_ret == L2CAP_DW_CONGESTED) {
     log::verbose("ATT congested, message accepted");
+    stats_tx_congested.Increment();
     return GATT_CONGESTED;
   }
   return GATT_SUCCESS;
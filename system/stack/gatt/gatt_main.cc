@@ -34,6 +34,7 @@
 #include "internal_include/stack_config.h"
 #include "l2c_api.h"
 #include "main/shim/acl_api.h"
+#include "os/stats.h"
 #include "osi/include/allocator.h"
 #include "osi/include/properties.h"
 #include "rust/src/connection/ffi/connection_shim.h"
@@ -99,6 +100,8 @@ static const tL2CAP_APPL_INFO dyn_info = {gatt_l2cif_connect_ind_cback,
 
 tGATT_CB gatt_cb;
 
+static bluetooth::os::StatsCounter stats_rx_pdus("gatt.rx_pdus");
+
 /*******************************************************************************
  *
  * Function         gatt_init
@@ -1024,6 +1027,7 @@ void gatt_data_process(tGATT_TCB& tcb, uint16_t cid, BT_HDR* p_buf) {
     return;
   }
 
+  stats_rx_pdus.Increment();
   uint16_t msg_len = p_buf->len - 1;
   STREAM_TO_UINT8(op_code, p);
 
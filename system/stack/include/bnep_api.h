@@ -285,7 +285,10 @@ tBNEP_RESULT BNEP_Disconnect(uint16_t handle);
  *                  BNEP_MTU_EXCEDED        - If the data length is greater
  *                                            than MTU
  *                  BNEP_IGNORE_CMD         - If the packet is filtered out
- *                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full
+ *                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full. The
+ *                                            buffer is left to the caller,
+ *                                            to be written again once the
+ *                                            data flow is back on.
  *                  BNEP_SUCCESS            - If written successfully
  *
  ******************************************************************************/
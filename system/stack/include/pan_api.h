@@ -379,6 +379,8 @@ tPAN_RESULT PAN_Write(uint16_t handle, const RawAddress& dst,
  * Returns          PAN_SUCCESS       - if the data is sent successfully
  *                  PAN_FAILURE       - if the connection is not found or
  *                                           there is an error in sending data
+ *                  PAN_Q_SIZE_EXCEEDED - if the transmit queue is full, the
+ *                                        buffer is not released
  *
  ******************************************************************************/
 tPAN_RESULT PAN_WriteBuf(uint16_t handle, const RawAddress& dst,
@@ -139,6 +139,26 @@ struct tSdpApi {
     [[nodiscard]] bool (*SDP_ServiceSearchAttributeRequest2)(
         const RawAddress&, tSDP_DISCOVERY_DB*,
         base::RepeatingCallback<tSDP_DISC_CMPL_CB> complete_callback);
+
+    /*******************************************************************************
+
+      Function         SDP_ReadCachedRecords
+
+      Description      This function fills a discovery database with the
+                       records cached by a previous discovery of the device
+                       with the same UUID and attribute filters. The records
+                       are not checked against the device, a regular search
+                       must be run to refresh them.
+
+      parameters:      bd_addr     - (input) device address
+                       p_db        - (input) discovery database, initialized
+                                             with SDP_InitDiscoveryDb
+
+      Returns          true if cached records were found, false otherwise.
+
+     ******************************************************************************/
+    [[nodiscard]] bool (*SDP_ReadCachedRecords)(const RawAddress& bd_addr,
+                                                tSDP_DISCOVERY_DB* p_db);
   } service;
 
   struct {
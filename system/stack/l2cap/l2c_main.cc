@@ -33,6 +33,7 @@
 #include "internal_include/bt_target.h"
 #include "main/shim/entry.h"
 #include "os/log.h"
+#include "os/stats.h"
 #include "osi/include/allocator.h"
 #include "stack/include/bt_hdr.h"
 #include "stack/include/bt_psm_types.h"
@@ -54,6 +55,8 @@ static void process_l2cap_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len);
 /******************************************************************************/
 tL2C_CB l2cb;
 
+static bluetooth::os::StatsCounter stats_rx_packets("l2cap.rx_packets");
+
 /*******************************************************************************
  *
  * Function         l2c_rcv_acl_data
@@ -67,6 +70,8 @@ tL2C_CB l2cb;
 void l2c_rcv_acl_data(BT_HDR* p_msg) {
   uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
 
+  stats_rx_packets.Increment();
+
   /* Extract the handle */
   uint16_t handle;
   STREAM_TO_UINT16(handle, p);
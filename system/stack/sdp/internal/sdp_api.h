@@ -100,6 +100,19 @@ bool SDP_ServiceSearchAttributeRequest2(
     const RawAddress& p_bd_addr, tSDP_DISCOVERY_DB* p_db,
     base::RepeatingCallback<tSDP_DISC_CMPL_CB> complete_callback);
 
+/*******************************************************************************
+ *
+ * Function         SDP_ReadCachedRecords
+ *
+ * Description      This function fills a discovery database with the records
+ *                  cached by a previous discovery of the device, without
+ *                  connecting to it.
+ *
+ * Returns          true if cached records were found, false otherwise.
+ *
+ ******************************************************************************/
+bool SDP_ReadCachedRecords(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db);
+
 /* API of utilities to find data in the local discovery database */
 
 /*******************************************************************************
@@ -436,3 +449,17 @@ uint8_t SDP_GetNumDiRecords(const tSDP_DISCOVERY_DB* p_db);
 uint16_t SDP_GetDiRecord(uint8_t getRecordIndex,
                          tSDP_DI_GET_RECORD* device_info,
                          const tSDP_DISCOVERY_DB* p_db);
+
+/*******************************************************************************
+ *
+ * Function         SDP_Dumpsys
+ *
+ * Description      This function provides dumpsys data during the dumpsys
+ *                  procedure.
+ *
+ * Parameters:      fd: Descriptor used to write the SDP internals
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_Dumpsys(int fd);
@@ -30,8 +30,10 @@
 #include <string.h>
 
 #include <cstdint>
+#include <vector>
 
 #include "internal_include/bt_target.h"
+#include "main/shim/dumpsys.h"
 #include "os/log.h"
 #include "stack/include/bt_types.h"
 #include "stack/include/bt_uuid16.h"
@@ -213,6 +215,26 @@ bool SDP_ServiceSearchAttributeRequest2(
   return (true);
 }
 
+/*******************************************************************************
+ *
+ * Function         SDP_ReadCachedRecords
+ *
+ * Description      This function fills a discovery database with the records
+ *                  cached by a previous discovery of the device with the same
+ *                  UUID and attribute filters, without connecting to it.
+ *
+ * Returns          true if cached records were found, false otherwise.
+ *
+ ******************************************************************************/
+bool SDP_ReadCachedRecords(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db) {
+  std::vector<uint8_t> records;
+
+  if (p_db == NULL || !sdp_disc_cache_read(bd_addr, p_db, records))
+    return (false);
+
+  return sdp_disc_load_records(p_db, bd_addr, records);
+}
+
 /*******************************************************************************
  *
  * Function         SDP_FindAttributeInRec
@@ -1060,6 +1082,32 @@ uint16_t SDP_SetLocalDiRecord(const tSDP_DI_RECORD* p_device_info,
   return result;
 }
 
+#define DUMPSYS_TAG "shim::legacy::sdp"
+void SDP_Dumpsys(int fd) {
+  LOG_DUMPSYS_TITLE(fd, DUMPSYS_TAG);
+
+  const tSDP_SERVER_CACHE_STATS server = sdp_server_cache_get_stats();
+  LOG_DUMPSYS(fd,
+              "server_cache entries:%zu hits:%llu misses:%llu "
+              "invalidations:%llu",
+              server.entries, (unsigned long long)server.hits,
+              (unsigned long long)server.misses,
+              (unsigned long long)server.invalidations);
+
+  const tSDP_DISC_CACHE_STATS disc = sdp_disc_cache_get_stats();
+  const uint64_t lookups = disc.hits + disc.misses + disc.stale;
+  LOG_DUMPSYS(fd,
+              "discovery_cache enabled:%s devices:%zu hits:%llu misses:%llu "
+              "stale:%llu hit_rate:%llu%% saved_ms:%llu sync_reads:%llu",
+              sdp_disc_cache_is_enabled() ? "true" : "false", disc.devices,
+              (unsigned long long)disc.hits, (unsigned long long)disc.misses,
+              (unsigned long long)disc.stale,
+              (unsigned long long)(lookups ? disc.hits * 100 / lookups : 0),
+              (unsigned long long)disc.saved_ms,
+              (unsigned long long)disc.sync_reads);
+}
+#undef DUMPSYS_TAG
+
 namespace {
 bluetooth::legacy::stack::sdp::tSdpApi api_ = {
     .service =
@@ -1071,6 +1119,7 @@ bluetooth::legacy::stack::sdp::tSdpApi api_ = {
                 ::SDP_ServiceSearchAttributeRequest,
             .SDP_ServiceSearchAttributeRequest2 =
                 ::SDP_ServiceSearchAttributeRequest2,
+            .SDP_ReadCachedRecords = ::SDP_ReadCachedRecords,
         },
     .db =
         {
@@ -321,6 +321,7 @@ bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
         return (false);
       }
 
+      sdp_server_cache_invalidate();
       return SDP_AddAttributeToRecord(p_rec, attr_id, attr_type, attr_len,
                                       p_val);
     }
@@ -389,6 +390,8 @@ bool SDP_DeleteRecord(uint32_t handle) {
   uint16_t xx, yy, zz;
   tSDP_RECORD* p_rec = &sdp_cb.server_db.record[0];
 
+  sdp_server_cache_invalidate();
+
   if (handle == 0 || sdp_cb.server_db.num_records == 0) {
     /* Delete all records in the database */
     sdp_cb.server_db.num_records = 0;
@@ -26,12 +26,16 @@
 
 #include <bluetooth/log.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
+#include "common/time_util.h"
 #include "internal_include/bt_target.h"
 #include "osi/include/allocator.h"
 #include "stack/include/bt_hdr.h"
 #include "stack/include/bt_types.h"
+#include "stack/include/btm_sec_api.h"
 #include "stack/include/sdpdefs.h"
 #include "stack/sdp/sdp_discovery_db.h"
 #include "stack/sdp/sdpint.h"
@@ -512,7 +516,8 @@ static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
  * Returns          pointer to next byte or NULL if error
  *
  ******************************************************************************/
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
+static uint8_t* save_attr_seq(tSDP_DISCOVERY_DB* p_db, const RawAddress& bd_addr,
+                              uint8_t* p, uint8_t* p_msg_end) {
   uint32_t seq_len, attr_len;
   uint16_t attr_id;
   uint8_t type, *p_seq_end;
@@ -531,7 +536,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
   }
 
   /* Create a record */
-  p_rec = add_record(p_ccb->p_db, p_ccb->device_address);
+  p_rec = add_record(p_db, bd_addr);
   if (!p_rec) {
     log::warn("SDP - DB full add_record");
     return (NULL);
@@ -555,7 +560,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
     BE_STREAM_TO_UINT16(attr_id, p);
 
     /* Now, add the attribute value */
-    p = add_attr(p, p_seq_end, p_ccb->p_db, p_rec, attr_id, NULL, 0);
+    p = add_attr(p, p_seq_end, p_db, p_rec, attr_id, NULL, 0);
 
     if (!p) {
       log::warn("SDP - DB full add_attr");
@@ -732,14 +737,20 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
     return;
   }
 
+  uint8_t* p_records = p;
   while (p < p_end) {
-    p = save_attr_seq(p_ccb, p, &p_ccb->rsp_list[p_ccb->list_len]);
+    p = save_attr_seq(p_ccb->p_db, p_ccb->device_address, p,
+                      &p_ccb->rsp_list[p_ccb->list_len]);
     if (!p) {
       sdp_disconnect(p_ccb, SDP_DB_FULL);
       return;
     }
   }
 
+  if (p_ccb->use_disc_cache) {
+    sdp_disc_cache_store(p_ccb, p_records, p_end - p_records);
+  }
+
   /* Since we got everything we need, disconnect the call */
   sdpu_log_attribute_metrics(p_ccb->device_address, p_ccb->p_db);
   sdp_disconnect(p_ccb, SDP_SUCCESS);
@@ -806,11 +817,17 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
       }
 
       /* Save the response in the database. Stop on any error */
-      if (!save_attr_seq(p_ccb, &p_ccb->rsp_list[0],
+      if (!save_attr_seq(p_ccb->p_db, p_ccb->device_address,
+                         &p_ccb->rsp_list[0],
                          &p_ccb->rsp_list[p_ccb->list_len])) {
         sdp_disconnect(p_ccb, SDP_DB_FULL);
         return;
       }
+      if (p_ccb->use_disc_cache) {
+        p_ccb->disc_records.insert(p_ccb->disc_records.end(),
+                                   &p_ccb->rsp_list[0],
+                                   &p_ccb->rsp_list[p_ccb->list_len]);
+      }
       p_ccb->list_len = 0;
       p_ccb->cur_handle++;
     }
@@ -870,12 +887,42 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
     alarm_set_on_mloop(p_ccb->sdp_conn_timer, SDP_INACT_TIMEOUT_MS,
                        sdp_conn_timer_timeout, p_ccb);
   } else {
+    if (p_ccb->use_disc_cache) {
+      sdp_disc_cache_store(p_ccb, p_ccb->disc_records.data(),
+                           p_ccb->disc_records.size());
+    }
     sdpu_log_attribute_metrics(p_ccb->device_address, p_ccb->p_db);
     sdp_disconnect(p_ccb, SDP_SUCCESS);
     return;
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         sdp_disc_complete_from_cache
+ *
+ * Description      This function is called once the record handles have been
+ *                  read from the server. If they match the cached ones, the
+ *                  cached records are saved in the database and the discovery
+ *                  completes without reading the attributes again.
+ *
+ * Returns          true if the discovery was completed
+ *
+ ******************************************************************************/
+static bool sdp_disc_complete_from_cache(tCONN_CB* p_ccb) {
+  std::vector<uint8_t> records;
+
+  if (!p_ccb->use_disc_cache || !sdp_disc_cache_lookup(p_ccb, records))
+    return false;
+
+  if (!sdp_disc_load_records(p_ccb->p_db, p_ccb->device_address, records)) {
+    sdp_disconnect(p_ccb, SDP_DB_FULL);
+    return true;
+  }
+  sdp_disconnect(p_ccb, SDP_SUCCESS);
+  return true;
+}
+
 /******************************************************************************
  *
  * Function         process_service_search_rsp
@@ -903,6 +950,15 @@ static void process_service_search_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 
   orig = p_ccb->num_handles;
   p_ccb->num_handles += cur_handles;
+  if (p_ccb->num_handles == 0 && p_ccb->is_attr_search) {
+    /* The handles were only read to check the cache, which has to be dropped.
+     * Let the actual request report the result. */
+    sdp_disc_complete_from_cache(p_ccb);
+    p_ccb->disc_state = SDP_DISC_WAIT_SEARCH_ATTR;
+    process_service_search_attr_rsp(p_ccb, NULL, NULL);
+    return;
+  }
+
   if (p_ccb->num_handles == 0 || p_ccb->num_handles < orig) {
     log::warn("SDP - Rcvd ServiceSearchRsp, no matches");
     sdp_disconnect(p_ccb, SDP_NO_RECS_MATCH);
@@ -934,6 +990,12 @@ static void process_service_search_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
     }
     /* stay in the same state */
     sdp_snd_service_search_req(p_ccb, cont_len, p_reply);
+  } else if (sdp_disc_complete_from_cache(p_ccb)) {
+    return;
+  } else if (p_ccb->is_attr_search) {
+    p_ccb->disc_state = SDP_DISC_WAIT_SEARCH_ATTR;
+
+    process_service_search_attr_rsp(p_ccb, NULL, NULL);
   } else {
     /* change state */
     p_ccb->disc_state = SDP_DISC_WAIT_ATTR;
@@ -954,7 +1016,15 @@ static void process_service_search_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  *
  ******************************************************************************/
 void sdp_disc_connected(tCONN_CB* p_ccb) {
-  if (p_ccb->is_attr_search) {
+  p_ccb->disc_start_ms = bluetooth::common::time_get_os_boottime_ms();
+  /* A miss costs an extra ServiceSearch and the records are persisted, so
+   * only the records of bonded devices are cached */
+  p_ccb->use_disc_cache = sdp_disc_cache_is_enabled() &&
+                          btm_sec_is_a_bonded_dev(p_ccb->device_address);
+
+  /* Cached records are checked against the record handles of the server, so
+   * read them first even for a combined search */
+  if (p_ccb->is_attr_search && !p_ccb->use_disc_cache) {
     p_ccb->disc_state = SDP_DISC_WAIT_SEARCH_ATTR;
 
     process_service_search_attr_rsp(p_ccb, NULL, NULL);
@@ -1026,3 +1096,36 @@ void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg) {
     sdp_disconnect(p_ccb, SDP_GENERIC_ERROR);
   }
 }
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_load_records
+ *
+ * Description      This function saves a list of previously discovered
+ *                  attribute sequences in a discovery database, as if they
+ *                  had just been received from the server.
+ *
+ * Returns          true if all the records were saved
+ *
+ ******************************************************************************/
+bool sdp_disc_load_records(tSDP_DISCOVERY_DB* p_db, const RawAddress& bd_addr,
+                           std::vector<uint8_t>& records) {
+  uint8_t* p = records.data();
+  uint8_t* p_end = p + records.size();
+
+  if (p_db->raw_data) {
+    uint32_t cpy_len = std::min<uint32_t>(p_db->raw_size - p_db->raw_used,
+                                          records.size());
+    memcpy(&p_db->raw_data[p_db->raw_used], p, cpy_len);
+    p_db->raw_used += cpy_len;
+  }
+
+  while (p < p_end) {
+    p = save_attr_seq(p_db, bd_addr, p, p_end);
+    if (!p) {
+      log::warn("Unable to load cached records of {}", bd_addr);
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,358 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the cache of records discovered on remote devices.
+ *
+ *  The attribute lists read during a discovery are kept per device and per
+ *  set of UUID/attribute filters, together with the record handles that
+ *  matched, and persisted in the device section of the config file. On the
+ *  next discovery with the same filters, only a ServiceSearch is sent: if
+ *  the peer returns the same record handles, the cached attribute lists are
+ *  used instead of reading them again. Only the records of bonded devices
+ *  are cached, and the cache is off unless enabled by a property.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "sdp_discovery"
+
+#include <bluetooth/log.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "btif/include/btif_config.h"
+#include "common/time_util.h"
+#include "internal_include/bt_target.h"
+#include "osi/include/properties.h"
+#include "stack/include/bt_types.h"
+#include "stack/sdp/sdp_discovery_db.h"
+#include "stack/sdp/sdpint.h"
+#include "storage/config_keys.h"
+#include "types/bluetooth/uuid.h"
+#include "types/raw_address.h"
+
+using bluetooth::Uuid;
+using namespace bluetooth;
+
+namespace {
+
+/* Version of the persisted format, bump when it changes */
+constexpr uint8_t kPersistedVersion = 1;
+
+struct CacheEntry {
+  std::vector<Uuid> uuid_filters;
+  std::vector<uint16_t> attr_filters;
+  std::vector<uint32_t> handles;
+  std::vector<uint8_t> records; /* Concatenated attribute lists */
+  uint32_t discovery_ms;        /* Duration of the discovery that read them */
+};
+
+std::unordered_map<RawAddress, std::vector<CacheEntry>> cache;
+tSDP_DISC_CACHE_STATS stats;
+
+bool entry_matches(const CacheEntry& entry, const tSDP_DISCOVERY_DB* p_db) {
+  return entry.uuid_filters.size() == p_db->num_uuid_filters &&
+         std::equal(entry.uuid_filters.begin(), entry.uuid_filters.end(),
+                    p_db->uuid_filters) &&
+         entry.attr_filters.size() == p_db->num_attr_filters &&
+         std::equal(entry.attr_filters.begin(), entry.attr_filters.end(),
+                    p_db->attr_filters);
+}
+
+std::vector<uint8_t> serialize(const std::vector<CacheEntry>& entries) {
+  std::vector<uint8_t> out;
+  auto put16 = [&out](uint16_t v) {
+    out.push_back(v >> 8);
+    out.push_back(v);
+  };
+  auto put32 = [&put16](uint32_t v) {
+    put16(v >> 16);
+    put16(v);
+  };
+
+  out.push_back(kPersistedVersion);
+  out.push_back(entries.size());
+  for (const CacheEntry& entry : entries) {
+    out.push_back(entry.uuid_filters.size());
+    for (const Uuid& uuid : entry.uuid_filters) {
+      const Uuid::UUID128Bit& bytes = uuid.To128BitBE();
+      out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+    out.push_back(entry.attr_filters.size());
+    for (uint16_t attr : entry.attr_filters) put16(attr);
+    put16(entry.handles.size());
+    for (uint32_t handle : entry.handles) put32(handle);
+    put32(entry.discovery_ms);
+    put16(entry.records.size());
+    out.insert(out.end(), entry.records.begin(), entry.records.end());
+  }
+  return out;
+}
+
+bool deserialize(const std::vector<uint8_t>& in,
+                 std::vector<CacheEntry>& entries) {
+  const uint8_t* p = in.data();
+  const uint8_t* p_end = p + in.size();
+  auto available = [&p, p_end](size_t len) {
+    return (size_t)(p_end - p) >= len;
+  };
+
+  if (!available(2)) return false;
+  uint8_t version, num_entries;
+  STREAM_TO_UINT8(version, p);
+  STREAM_TO_UINT8(num_entries, p);
+  if (version != kPersistedVersion) return false;
+
+  for (uint8_t xx = 0; xx < num_entries; xx++) {
+    CacheEntry entry;
+    uint8_t num_uuids, num_attrs;
+    uint16_t num_handles, records_len;
+
+    if (!available(1)) return false;
+    STREAM_TO_UINT8(num_uuids, p);
+    if (num_uuids > SDP_MAX_UUID_FILTERS ||
+        !available(num_uuids * Uuid::kNumBytes128 + 1))
+      return false;
+    for (uint8_t yy = 0; yy < num_uuids; yy++) {
+      entry.uuid_filters.push_back(Uuid::From128BitBE(p));
+      p += Uuid::kNumBytes128;
+    }
+
+    STREAM_TO_UINT8(num_attrs, p);
+    if (num_attrs > SDP_MAX_ATTR_FILTERS || !available(num_attrs * 2 + 2))
+      return false;
+    entry.attr_filters.resize(num_attrs);
+    for (uint16_t& attr : entry.attr_filters) BE_STREAM_TO_UINT16(attr, p);
+
+    BE_STREAM_TO_UINT16(num_handles, p);
+    if (num_handles > SDP_MAX_DISC_SERVER_RECS ||
+        !available(num_handles * 4 + 6))
+      return false;
+    entry.handles.resize(num_handles);
+    for (uint32_t& handle : entry.handles) BE_STREAM_TO_UINT32(handle, p);
+
+    BE_STREAM_TO_UINT32(entry.discovery_ms, p);
+    BE_STREAM_TO_UINT16(records_len, p);
+    if (!available(records_len)) return false;
+    entry.records.assign(p, p + records_len);
+    p += records_len;
+
+    entries.push_back(std::move(entry));
+  }
+  return true;
+}
+
+/* Returns the entries of |bd_addr|, reading them from the config if needed */
+std::vector<CacheEntry>& get_device_entries(const RawAddress& bd_addr) {
+  auto it = cache.find(bd_addr);
+  if (it != cache.end()) return it->second;
+
+  if (cache.size() >= SDP_DISC_CACHE_MAX_DEVICES) {
+    /* The entries are persisted, they can be read again when needed */
+    cache.erase(cache.begin());
+  }
+
+  std::vector<CacheEntry>& entries = cache[bd_addr];
+  size_t len = btif_config_get_bin_length(bd_addr.ToString(),
+                                          BTIF_STORAGE_KEY_SDP_RECORD_CACHE);
+  if (len == 0) return entries;
+
+  std::vector<uint8_t> persisted(len);
+  if (!btif_config_get_bin(bd_addr.ToString(),
+                           BTIF_STORAGE_KEY_SDP_RECORD_CACHE, persisted.data(),
+                           &len) ||
+      !deserialize(persisted, entries)) {
+    log::warn("Dropping invalid cached SDP records for {}", bd_addr);
+    entries.clear();
+    if (!btif_config_remove(bd_addr.ToString(),
+                            BTIF_STORAGE_KEY_SDP_RECORD_CACHE)) {
+      log::warn("Unable to remove cached SDP records for {}", bd_addr);
+    }
+  }
+  return entries;
+}
+
+void persist_device_entries(const RawAddress& bd_addr,
+                            const std::vector<CacheEntry>& entries) {
+  if (entries.empty()) {
+    if (!btif_config_remove(bd_addr.ToString(),
+                            BTIF_STORAGE_KEY_SDP_RECORD_CACHE)) {
+      log::warn("Unable to remove cached SDP records for {}", bd_addr);
+    }
+    return;
+  }
+
+  std::vector<uint8_t> persisted = serialize(entries);
+  if (!btif_config_set_bin(bd_addr.ToString(),
+                           BTIF_STORAGE_KEY_SDP_RECORD_CACHE, persisted.data(),
+                           persisted.size())) {
+    log::warn("Unable to save cached SDP records for {}", bd_addr);
+  }
+}
+
+}  // namespace
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_cache_is_enabled
+ *
+ * Description      Checks whether discovered records are cached.
+ *
+ * Returns          true if the remote record cache is enabled
+ *
+ ******************************************************************************/
+bool sdp_disc_cache_is_enabled(void) {
+  return osi_property_get_bool(SDP_DISC_CACHE_ENABLE_PROPERTY, false);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_cache_lookup
+ *
+ * Description      Looks up the records cached for the device and filters of
+ *                  a discovery, once the record handles have been read from
+ *                  the peer. An entry whose handles no longer match is
+ *                  dropped.
+ *
+ * Returns          true if |records| were filled from the cache
+ *
+ ******************************************************************************/
+bool sdp_disc_cache_lookup(const tCONN_CB* p_ccb,
+                           std::vector<uint8_t>& records) {
+  std::vector<CacheEntry>& entries = get_device_entries(p_ccb->device_address);
+  auto it = std::find_if(entries.begin(), entries.end(),
+                         [p_ccb](const CacheEntry& entry) {
+                           return entry_matches(entry, p_ccb->p_db);
+                         });
+  if (it == entries.end()) {
+    stats.misses++;
+    return false;
+  }
+
+  if (it->handles.size() != p_ccb->num_handles ||
+      !std::equal(it->handles.begin(), it->handles.end(), p_ccb->handles)) {
+    log::info("Cached SDP records of {} are stale", p_ccb->device_address);
+    stats.stale++;
+    entries.erase(it);
+    persist_device_entries(p_ccb->device_address, entries);
+    return false;
+  }
+
+  const uint64_t elapsed_ms =
+      common::time_get_os_boottime_ms() - p_ccb->disc_start_ms;
+  if (it->discovery_ms > elapsed_ms) {
+    stats.saved_ms += it->discovery_ms - elapsed_ms;
+  }
+  stats.hits++;
+
+  log::verbose("Using {} cached SDP records of {}", it->handles.size(),
+               p_ccb->device_address);
+  records = it->records;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_cache_store
+ *
+ * Description      Saves the attribute lists read by a completed discovery.
+ *                  Discoveries whose record handles are not known cannot be
+ *                  validated later, and are not cached.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_disc_cache_store(const tCONN_CB* p_ccb, const uint8_t* p_records,
+                          size_t len) {
+  if (p_ccb->num_handles == 0 || len > SDP_DISC_CACHE_MAX_RECORDS_LEN) return;
+
+  CacheEntry entry;
+  entry.uuid_filters.assign(p_ccb->p_db->uuid_filters,
+                            p_ccb->p_db->uuid_filters +
+                                p_ccb->p_db->num_uuid_filters);
+  entry.attr_filters.assign(p_ccb->p_db->attr_filters,
+                            p_ccb->p_db->attr_filters +
+                                p_ccb->p_db->num_attr_filters);
+  entry.handles.assign(p_ccb->handles, p_ccb->handles + p_ccb->num_handles);
+  entry.records.assign(p_records, p_records + len);
+  entry.discovery_ms = static_cast<uint32_t>(
+      common::time_get_os_boottime_ms() - p_ccb->disc_start_ms);
+
+  std::vector<CacheEntry>& entries = get_device_entries(p_ccb->device_address);
+  entries.erase(std::remove_if(entries.begin(), entries.end(),
+                               [p_ccb](const CacheEntry& e) {
+                                 return entry_matches(e, p_ccb->p_db);
+                               }),
+                entries.end());
+  if (entries.size() >= SDP_DISC_CACHE_MAX_ENTRIES) {
+    entries.erase(entries.begin());
+  }
+  entries.push_back(std::move(entry));
+  persist_device_entries(p_ccb->device_address, entries);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_cache_read
+ *
+ * Description      Reads the records cached for a device and the filters of
+ *                  |p_db|, without checking them against the peer.
+ *
+ * Returns          true if |records| were filled from the cache
+ *
+ ******************************************************************************/
+bool sdp_disc_cache_read(const RawAddress& bd_addr,
+                         const tSDP_DISCOVERY_DB* p_db,
+                         std::vector<uint8_t>& records) {
+  if (!sdp_disc_cache_is_enabled()) return false;
+
+  const std::vector<CacheEntry>& entries = get_device_entries(bd_addr);
+  auto it = std::find_if(
+      entries.begin(), entries.end(),
+      [p_db](const CacheEntry& entry) { return entry_matches(entry, p_db); });
+  if (it == entries.end()) return false;
+
+  stats.sync_reads++;
+  records = it->records;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_cache_reset
+ *
+ * Description      Drops the in-memory copy of the cache and clears the
+ *                  statistics. Persisted entries are kept.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_disc_cache_reset(void) {
+  cache.clear();
+  stats = {};
+}
+
+tSDP_DISC_CACHE_STATS sdp_disc_cache_get_stats(void) {
+  tSDP_DISC_CACHE_STATS current = stats;
+  current.devices = cache.size();
+  return current;
+}
@@ -404,6 +404,8 @@ void sdp_conn_timer_timeout(void* data) {
 void sdp_init(void) {
   /* Clears all structures and local SDP database (if Server is enabled) */
   sdp_cb = {};
+  sdp_server_cache_reset();
+  sdp_disc_cache_reset();
 
   for (int i = 0; i < SDP_MAX_CONNECTIONS; i++) {
     sdp_cb.ccb[i].sdp_conn_timer = alarm_new("sdp.sdp_conn_timer");
@@ -440,4 +442,6 @@ void sdp_free(void) {
     sdp_cb.ccb[i].sdp_conn_timer = NULL;
   }
   sdp_cb = {};
+  sdp_server_cache_reset();
+  sdp_disc_cache_reset();
 }
@@ -27,6 +27,7 @@
 #include <bluetooth/log.h>
 #include <string.h>  // memcpy
 
+#include <algorithm>
 #include <cstdint>
 
 #include "btif/include/btif_profile_storage.h"
@@ -429,6 +430,86 @@ static const tSDP_RECORD* sdp_upgrade_pse_record(const tSDP_RECORD* p_rec,
   return &pbap_102_sdp_rec;
 }
 
+/*******************************************************************************
+ *
+ * Function         process_cached_rsp
+ *
+ * Description      This function sends the next slice of the pre-serialized
+ *                  attribute list held in p_ccb->cached_rsp, handling the
+ *                  continuation state of the request.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void process_cached_rsp(tCONN_CB* p_ccb, uint16_t trans_num,
+                               uint8_t rsp_pdu, uint16_t max_list_len,
+                               uint8_t* p_req, uint8_t* p_req_end) {
+  uint16_t cont_offset = 0, len_to_send, rsp_param_len;
+  uint8_t *p_rsp, *p_rsp_start, *p_rsp_param_len;
+  const std::vector<uint8_t>& list = *p_ccb->cached_rsp;
+
+  if (*p_req) {
+    if (*p_req++ != SDP_CONTINUATION_LEN ||
+        (p_req + sizeof(cont_offset) > p_req_end)) {
+      sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
+                              SDP_TEXT_BAD_CONT_LEN);
+      return;
+    }
+    BE_STREAM_TO_UINT16(cont_offset, p_req);
+
+    if (cont_offset != p_ccb->cont_offset || cont_offset >= list.size()) {
+      sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
+                              SDP_TEXT_BAD_CONT_INX);
+      return;
+    }
+  } else {
+    p_ccb->cont_offset = 0;
+  }
+
+  len_to_send = std::min<size_t>(max_list_len, list.size() - cont_offset);
+
+  /* Get a buffer to use to build the response */
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(SDP_DATA_BUF_SIZE);
+  p_buf->offset = L2CAP_MIN_OFFSET;
+  p_rsp = p_rsp_start = (uint8_t*)(p_buf + 1) + L2CAP_MIN_OFFSET;
+
+  /* Start building a rsponse */
+  UINT8_TO_BE_STREAM(p_rsp, rsp_pdu);
+  UINT16_TO_BE_STREAM(p_rsp, trans_num);
+
+  /* Skip the parameter length, add it when we know the length */
+  p_rsp_param_len = p_rsp;
+  p_rsp += 2;
+
+  UINT16_TO_BE_STREAM(p_rsp, len_to_send);
+  memcpy(p_rsp, &list[cont_offset], len_to_send);
+  p_rsp += len_to_send;
+
+  p_ccb->cont_offset += len_to_send;
+
+  /* If anything left to send, continuation needed */
+  if (p_ccb->cont_offset < list.size()) {
+    UINT8_TO_BE_STREAM(p_rsp, SDP_CONTINUATION_LEN);
+    UINT16_TO_BE_STREAM(p_rsp, p_ccb->cont_offset);
+  } else {
+    UINT8_TO_BE_STREAM(p_rsp, 0);
+    p_ccb->cached_rsp.reset();
+  }
+
+  /* Go back and put the parameter length into the buffer */
+  rsp_param_len = p_rsp - p_rsp_param_len - 2;
+  UINT16_TO_BE_STREAM(p_rsp_param_len, rsp_param_len);
+
+  /* Set the length of the SDP data in the buffer */
+  p_buf->len = p_rsp - p_rsp_start;
+
+  /* Send the buffer through L2CAP */
+  if (L2CA_DataWrite(p_ccb->connection_id, p_buf) != L2CAP_DW_SUCCESS) {
+    log::warn("Unable to write L2CAP data peer:{} cid:{} len:{}",
+              p_ccb->device_address, p_ccb->connection_id, p_buf->len);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         process_service_attr_req
@@ -496,6 +577,17 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     return;
   }
 
+  /* Serve the response from the cache when it does not depend on the peer.
+   * Continuations keep slicing the buffer picked by the first request. */
+  if (!*p_req) {
+    p_ccb->cached_rsp = sdp_server_cache_get_attr_rsp(p_rec, &attr_seq_sav);
+  }
+  if (p_ccb->cached_rsp) {
+    process_cached_rsp(p_ccb, trans_num, SDP_PDU_SERVICE_ATTR_RSP,
+                       max_list_len, p_req, p_req_end);
+    return;
+  }
+
   if (bluetooth::common::init_flags::
           pbap_pse_dynamic_version_upgrade_is_enabled()) {
     p_rec = sdp_upgrade_pse_record(p_rec, p_ccb->device_address);
@@ -863,6 +955,18 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     return;
   }
 
+  /* Serve the response from the cache when none of the matching records
+   * depends on the peer */
+  if (!*p_req) {
+    p_ccb->cached_rsp =
+        sdp_server_cache_get_search_attr_rsp(&uid_seq, &attr_seq_sav);
+  }
+  if (p_ccb->cached_rsp) {
+    process_cached_rsp(p_ccb, trans_num, SDP_PDU_SERVICE_SEARCH_ATTR_RSP,
+                       max_list_len, p_req, p_req_end);
+    return;
+  }
+
   /* Free and reallocate buffer */
   osi_free(p_ccb->rsp_list);
   p_ccb->rsp_list = (uint8_t*)osi_malloc(max_list_len);
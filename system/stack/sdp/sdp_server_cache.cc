@@ -0,0 +1,288 @@
+/******************************************************************************
+ *
+ *  Copyright 2024 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the cache of pre-serialized SDP server responses.
+ *
+ *  Attribute lists built for ServiceAttribute and ServiceSearchAttribute
+ *  requests only depend on the local database, except for the records the
+ *  server rewrites per peer (AVRCP target, HFP AG, PBAP PSE). Responses for
+ *  all other records are serialized once and served from the cache until the
+ *  database is modified.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "sdp_server"
+
+#include <bluetooth/log.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/init_flags.h"
+#include "internal_include/bt_target.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/bt_uuid16.h"
+#include "stack/include/sdpdefs.h"
+#include "stack/sdp/sdpint.h"
+
+using namespace bluetooth;
+
+namespace {
+
+/* Offset of the profile UUID in a profile descriptor list attribute */
+constexpr uint8_t kProfileDescUuidPosition = 3;
+
+/* Key type prefixes, so that both request types can share one map */
+constexpr char kKeyServiceAttr = 'a';
+constexpr char kKeyServiceSearchAttr = 's';
+
+std::unordered_map<std::string, std::shared_ptr<const std::vector<uint8_t>>>
+    cache;
+tSDP_SERVER_CACHE_STATS stats;
+
+void append_attr_seq_to_key(std::string& key, const tSDP_ATTR_SEQ* attr_seq) {
+  for (uint16_t xx = 0; xx < attr_seq->num_attr; xx++) {
+    key.push_back(static_cast<char>(attr_seq->attr_entry[xx].start >> 8));
+    key.push_back(static_cast<char>(attr_seq->attr_entry[xx].start));
+    key.push_back(static_cast<char>(attr_seq->attr_entry[xx].end >> 8));
+    key.push_back(static_cast<char>(attr_seq->attr_entry[xx].end));
+  }
+}
+
+/* Appends the attributes of |p_rec| matching |attr_seq|, in request order */
+void append_attributes(std::vector<uint8_t>& out, const tSDP_RECORD* p_rec,
+                       const tSDP_ATTR_SEQ* attr_seq) {
+  for (uint16_t xx = 0; xx < attr_seq->num_attr; xx++) {
+    uint16_t start = attr_seq->attr_entry[xx].start;
+    const uint16_t end = attr_seq->attr_entry[xx].end;
+
+    const tSDP_ATTRIBUTE* p_attr;
+    while ((p_attr = sdp_db_find_attr_in_rec(p_rec, start, end)) != nullptr) {
+      size_t offset = out.size();
+      out.resize(offset + sdpu_get_attrib_entry_len(p_attr));
+      sdpu_build_attrib_entry(&out[offset], p_attr);
+
+      if (p_attr->id >= end) break;
+      start = p_attr->id + 1;
+    }
+  }
+}
+
+/* Prepends a data element sequence header the same way the legacy response
+ * builder does: a 2 byte header for short lists, 3 bytes otherwise */
+void prepend_seq_header(std::vector<uint8_t>& list) {
+  const size_t len = list.size();
+  if (len + 3 > 255) {
+    list.insert(list.begin(),
+                {(uint8_t)((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD),
+                 (uint8_t)(len >> 8), (uint8_t)len});
+  } else {
+    list.insert(list.begin(),
+                {(uint8_t)((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE),
+                 (uint8_t)len});
+  }
+}
+
+std::shared_ptr<const std::vector<uint8_t>> store(
+    std::string key, std::vector<uint8_t> list) {
+  if (list.size() > UINT16_MAX) {
+    /* Continuation offsets are 16 bits, let the legacy path handle it */
+    return nullptr;
+  }
+  if (cache.size() >= SDP_SERVER_CACHE_MAX_ENTRIES) {
+    log::verbose("SDP server cache full, dropping {} entries", cache.size());
+    cache.clear();
+  }
+  auto entry = std::make_shared<const std::vector<uint8_t>>(std::move(list));
+  cache[std::move(key)] = entry;
+  return entry;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> lookup(const std::string& key) {
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    stats.misses++;
+    return nullptr;
+  }
+  stats.hits++;
+  return it->second;
+}
+
+}  // namespace
+
+/*******************************************************************************
+ *
+ * Function         sdp_server_cache_is_cacheable
+ *
+ * Description      Checks whether the response content for a record is the
+ *                  same for every peer, i.e. the server does not apply any
+ *                  dynamic rewrite to it.
+ *
+ * Returns          true if responses for the record can be cached
+ *
+ ******************************************************************************/
+bool sdp_server_cache_is_cacheable(const tSDP_RECORD* p_rec) {
+  const tSDP_ATTRIBUTE* p_attr = sdp_db_find_attr_in_rec(
+      p_rec, ATTR_ID_SERVICE_CLASS_ID_LIST, ATTR_ID_SERVICE_CLASS_ID_LIST);
+  if (p_attr != nullptr) {
+    /* AVRCP target version and features are adjusted per peer */
+    if (sdpu_is_service_id_avrc_target(p_attr)) return false;
+
+    /* PBAP PSE records may be upgraded to 1.2 per peer */
+    if (bluetooth::common::init_flags::
+            pbap_pse_dynamic_version_upgrade_is_enabled() &&
+        p_attr->len >= 3 &&
+        ((p_attr->value_ptr[1] << 8) | p_attr->value_ptr[2]) ==
+            UUID_SERVCLASS_PBAP_PSE) {
+      return false;
+    }
+  }
+
+  /* The HFP AG profile version is adjusted per peer */
+  p_attr = sdp_db_find_attr_in_rec(p_rec, ATTR_ID_BT_PROFILE_DESC_LIST,
+                                   ATTR_ID_BT_PROFILE_DESC_LIST);
+  if (p_attr != nullptr &&
+      bluetooth::common::init_flags::hfp_dynamic_version_is_enabled() &&
+      p_attr->len > kProfileDescUuidPosition + 1 &&
+      ((p_attr->value_ptr[kProfileDescUuidPosition] << 8) |
+       p_attr->value_ptr[kProfileDescUuidPosition + 1]) ==
+          UUID_SERVCLASS_HF_HANDSFREE) {
+    return false;
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_server_cache_get_attr_rsp
+ *
+ * Description      Returns the serialized attribute list (including the data
+ *                  element sequence header) for a ServiceAttribute request,
+ *                  building and caching it if needed.
+ *
+ * Returns          the attribute list, or nullptr if it cannot be cached
+ *
+ ******************************************************************************/
+std::shared_ptr<const std::vector<uint8_t>> sdp_server_cache_get_attr_rsp(
+    const tSDP_RECORD* p_rec, const tSDP_ATTR_SEQ* attr_seq) {
+  if (!sdp_server_cache_is_cacheable(p_rec)) return nullptr;
+
+  std::string key(1, kKeyServiceAttr);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    key.push_back(static_cast<char>(p_rec->record_handle >> shift));
+  }
+  append_attr_seq_to_key(key, attr_seq);
+
+  auto entry = lookup(key);
+  if (entry != nullptr) return entry;
+
+  std::vector<uint8_t> list;
+  append_attributes(list, p_rec, attr_seq);
+  prepend_seq_header(list);
+  return store(std::move(key), std::move(list));
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_server_cache_get_search_attr_rsp
+ *
+ * Description      Returns the serialized attribute lists of all the records
+ *                  matching |uid_seq| for a ServiceSearchAttribute request,
+ *                  building and caching it if needed.
+ *
+ * Returns          the attribute lists, or nullptr if any of the matching
+ *                  records cannot be cached
+ *
+ ******************************************************************************/
+std::shared_ptr<const std::vector<uint8_t>>
+sdp_server_cache_get_search_attr_rsp(const tSDP_UUID_SEQ* uid_seq,
+                                     const tSDP_ATTR_SEQ* attr_seq) {
+  std::string key(1, kKeyServiceSearchAttr);
+  for (uint16_t xx = 0; xx < uid_seq->num_uids; xx++) {
+    const tUID_ENT& uuid = uid_seq->uuid_entry[xx];
+    key.push_back(static_cast<char>(uuid.len));
+    key.append(reinterpret_cast<const char*>(uuid.value), uuid.len);
+  }
+  key.push_back('/');
+  append_attr_seq_to_key(key, attr_seq);
+
+  auto entry = lookup(key);
+  if (entry != nullptr) return entry;
+
+  std::vector<uint8_t> list;
+  std::vector<uint8_t> rec_list;
+  for (const tSDP_RECORD* p_rec = sdp_db_service_search(nullptr, uid_seq);
+       p_rec != nullptr; p_rec = sdp_db_service_search(p_rec, uid_seq)) {
+    if (!sdp_server_cache_is_cacheable(p_rec)) return nullptr;
+
+    rec_list.clear();
+    append_attributes(rec_list, p_rec, attr_seq);
+    if (rec_list.empty()) continue;
+
+    /* Records are always wrapped with a 3 byte sequence header */
+    list.push_back((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
+    list.push_back(static_cast<uint8_t>(rec_list.size() >> 8));
+    list.push_back(static_cast<uint8_t>(rec_list.size()));
+    list.insert(list.end(), rec_list.begin(), rec_list.end());
+  }
+  prepend_seq_header(list);
+  return store(std::move(key), std::move(list));
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_server_cache_invalidate
+ *
+ * Description      Drops every cached response. Called whenever the local
+ *                  database is modified.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_server_cache_invalidate(void) {
+  if (cache.empty()) return;
+  log::verbose("Invalidating {} cached SDP responses", cache.size());
+  cache.clear();
+  stats.invalidations++;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_server_cache_reset
+ *
+ * Description      Drops every cached response and clears the statistics.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_server_cache_reset(void) {
+  cache.clear();
+  stats = {};
+}
+
+tSDP_SERVER_CACHE_STATS sdp_server_cache_get_stats(void) {
+  tSDP_SERVER_CACHE_STATS current = stats;
+  current.entries = cache.size();
+  return current;
+}
@@ -433,10 +433,13 @@ void sdpu_release_ccb(tCONN_CB& ccb) {
   /* Drop any response pointer we may be holding */
   ccb.con_state = SDP_STATE_IDLE;
   ccb.is_attr_search = false;
+  ccb.use_disc_cache = false;
 
   /* Free the response buffer */
   if (ccb.rsp_list) log::verbose("releasing SDP rsp_list");
   osi_free_and_reset((void**)&ccb.rsp_list);
+  ccb.cached_rsp.reset();
+  ccb.disc_records = {};
 }
 
 /*******************************************************************************
@@ -29,6 +29,8 @@
 #include <base/strings/stringprintf.h>
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "internal_include/bt_target.h"
 #include "macros.h"
@@ -61,6 +63,26 @@
 #define MAX_UUIDS_PER_SEQ 16
 #define MAX_ATTR_PER_SEQ 16
 
+/* Max number of pre-serialized responses kept by the SDP server */
+#ifndef SDP_SERVER_CACHE_MAX_ENTRIES
+#define SDP_SERVER_CACHE_MAX_ENTRIES 64
+#endif
+
+/* Remote record cache: enable property and limits */
+#ifndef SDP_DISC_CACHE_ENABLE_PROPERTY
+#define SDP_DISC_CACHE_ENABLE_PROPERTY \
+  "persist.bluetooth.sdp.discovery_cache.enable"
+#endif
+#ifndef SDP_DISC_CACHE_MAX_DEVICES
+#define SDP_DISC_CACHE_MAX_DEVICES 16
+#endif
+#ifndef SDP_DISC_CACHE_MAX_ENTRIES
+#define SDP_DISC_CACHE_MAX_ENTRIES 8 /* per device */
+#endif
+#ifndef SDP_DISC_CACHE_MAX_RECORDS_LEN
+#define SDP_DISC_CACHE_MAX_RECORDS_LEN 4096
+#endif
+
 /* Max length we support for any attribute */
 #ifdef SDP_MAX_ATTR_LEN
 #define MAX_ATTR_LEN SDP_MAX_ATTR_LEN
@@ -210,6 +232,13 @@ struct tCONN_CB {
   uint16_t cont_offset;     /* Continuation state data in the server response */
   tSDP_CONT_INFO cont_info; /* structure to hold continuation information for
                                the server response */
+  std::shared_ptr<const std::vector<uint8_t>>
+      cached_rsp; /* Pre-serialized response being sent with continuation */
+
+  uint64_t disc_start_ms; /* Time the discovery procedure started */
+  bool use_disc_cache;    /* Discovery checks and fills the record cache */
+  std::vector<uint8_t> disc_records; /* Attribute lists read so far, saved
+                                        in the remote record cache */
   tCONN_CB() = default;
 
  private:
@@ -319,10 +348,53 @@ const tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(const tSDP_RECORD* p_rec,
  */
 void sdp_server_handle_client_req(tCONN_CB* p_ccb, BT_HDR* p_msg);
 
+/* Functions provided by sdp_server_cache.cc
+ */
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t invalidations;
+  size_t entries;
+} tSDP_SERVER_CACHE_STATS;
+
+bool sdp_server_cache_is_cacheable(const tSDP_RECORD* p_rec);
+std::shared_ptr<const std::vector<uint8_t>> sdp_server_cache_get_attr_rsp(
+    const tSDP_RECORD* p_rec, const tSDP_ATTR_SEQ* attr_seq);
+std::shared_ptr<const std::vector<uint8_t>>
+sdp_server_cache_get_search_attr_rsp(const tSDP_UUID_SEQ* uid_seq,
+                                     const tSDP_ATTR_SEQ* attr_seq);
+void sdp_server_cache_invalidate(void);
+void sdp_server_cache_reset(void);
+tSDP_SERVER_CACHE_STATS sdp_server_cache_get_stats(void);
+
+/* Functions provided by sdp_discovery_cache.cc
+ */
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t stale;
+  uint64_t sync_reads;
+  uint64_t saved_ms; /* Discovery time saved by cache hits */
+  size_t devices;
+} tSDP_DISC_CACHE_STATS;
+
+bool sdp_disc_cache_is_enabled(void);
+bool sdp_disc_cache_lookup(const tCONN_CB* p_ccb,
+                           std::vector<uint8_t>& records);
+void sdp_disc_cache_store(const tCONN_CB* p_ccb, const uint8_t* p_records,
+                          size_t len);
+bool sdp_disc_cache_read(const RawAddress& bd_addr,
+                         const tSDP_DISCOVERY_DB* p_db,
+                         std::vector<uint8_t>& records);
+void sdp_disc_cache_reset(void);
+tSDP_DISC_CACHE_STATS sdp_disc_cache_get_stats(void);
+
 /* Functions provided by sdp_discovery.cc
  */
 void sdp_disc_connected(tCONN_CB* p_ccb);
 void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg);
+bool sdp_disc_load_records(tSDP_DISCOVERY_DB* p_db, const RawAddress& bd_addr,
+                           std::vector<uint8_t>& records);
 
 void update_pce_entry_to_interop_database(RawAddress remote_addr);
 bool is_sdp_pbap_pce_disabled(RawAddress remote_addr);
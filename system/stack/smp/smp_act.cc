@@ -27,9 +27,9 @@
 #include "btif/include/core_callbacks.h"
 #include "btif/include/stack_manager_t.h"
 #include "crypto_toolbox/crypto_toolbox.h"
+#include "crypto_toolbox/p256.h"
 #include "device/include/interop.h"
 #include "internal_include/bt_target.h"
-#include "p_256_ecc_pp.h"
 #include "smp_int.h"
 #include "stack/btm/btm_ble_sec.h"
 #include "stack/btm/btm_dev.h"
@@ -729,9 +729,9 @@ void smp_process_pairing_public_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
   STREAM_TO_ARRAY(p_cb->peer_publ_key.x, p, BT_OCTET32_LEN);
   STREAM_TO_ARRAY(p_cb->peer_publ_key.y, p, BT_OCTET32_LEN);
 
-  Point pt;
-  memcpy(pt.x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
-  memcpy(pt.y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+  crypto_toolbox::p256::PublicKey pt;
+  memcpy(pt.x.data(), p_cb->peer_publ_key.x, BT_OCTET32_LEN);
+  memcpy(pt.y.data(), p_cb->peer_publ_key.y, BT_OCTET32_LEN);
 
   if (!memcmp(p_cb->peer_publ_key.x, p_cb->loc_publ_key.x, BT_OCTET32_LEN)) {
     log::warn("Remote and local public keys can't match");
@@ -741,7 +741,7 @@ void smp_process_pairing_public_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
     return;
   }
 
-  if (!ECC_ValidatePoint(pt)) {
+  if (!crypto_toolbox::p256::IsValidPoint(pt)) {
     tSMP_INT_DATA smp;
     smp.status = SMP_PAIR_AUTH_FAIL;
     smp_sm_event(p_cb, SMP_AUTH_CMPL_EVT, &smp);
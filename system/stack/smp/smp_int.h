@@ -486,6 +486,8 @@ void smp_generate_stk(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 void smp_generate_ltk(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 void smp_generate_passkey(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 void smp_generate_rand_cont(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
+void smp_set_entropy_source();
+void smp_init_key_pair_pool();
 void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 void smp_compute_dhkey(tSMP_CB* p_cb);
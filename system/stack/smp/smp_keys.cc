@@ -32,9 +32,10 @@
 #include <cstring>
 
 #include "crypto_toolbox/crypto_toolbox.h"
+#include "crypto_toolbox/entropy_pool.h"
+#include "crypto_toolbox/p256.h"
 #include "hci/controller_interface.h"
 #include "main/shim/entry.h"
-#include "p_256_ecc_pp.h"
 #include "smp_int.h"
 #include "stack/btm/btm_ble_sec.h"
 #include "stack/btm/btm_dev.h"
@@ -59,8 +60,10 @@ using namespace bluetooth;
 static void smp_process_stk(tSMP_CB* p_cb, Octet16* p);
 static Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb);
 static void smp_process_private_key(tSMP_CB* p_cb);
+static void smp_process_local_public_key(tSMP_CB* p_cb);
 
-static void send_ble_rand(OnceCallback<void(uint64_t)> callback);
+static void smp_generate_rand(OnceCallback<void(uint64_t)> callback);
+static void smp_generate_rand128(tSMP_CB* p_cb, base::OnceClosure callback);
 
 #define SMP_PASSKEY_MASK 0x000fffff
 
@@ -68,6 +71,17 @@ static void send_ble_rand(OnceCallback<void(uint64_t)> callback);
 // This needs to be cleared on a successfult pairing using the oob data
 static tSMP_LOC_OOB_DATA saved_local_oob_data = {};
 
+// Local key pairs for LE Secure Connections, generated ahead of pairing
+static crypto_toolbox::p256::KeyPairPool& smp_key_pair_pool() {
+  static crypto_toolbox::p256::KeyPairPool* pool =
+      new crypto_toolbox::p256::KeyPairPool([](uint8_t* data, size_t len) {
+        crypto_toolbox::GetEntropyPool().Generate(data, len);
+      });
+  return *pool;
+}
+
+void smp_init_key_pair_pool() { smp_key_pair_pool(); }
+
 void smp_save_local_oob_data(tSMP_CB* p_cb) {
   saved_local_oob_data = p_cb->sc_oob_data.loc_oob_data;
 }
@@ -146,7 +160,7 @@ void smp_proc_passkey(tSMP_CB* p_cb, uint64_t rand) {
 void smp_generate_passkey(tSMP_CB* p_cb, tSMP_INT_DATA* /* p_data */) {
   log::verbose("addr:{}", p_cb->pairing_bda);
   /* generate MRand or SRand */
-  send_ble_rand(BindOnce(&smp_proc_passkey, p_cb));
+  smp_generate_rand(BindOnce(&smp_proc_passkey, p_cb));
 }
 
 /*******************************************************************************
@@ -208,7 +222,7 @@ void smp_generate_csrk(tSMP_CB* p_cb, tSMP_INT_DATA* /* p_data */) {
     smp_compute_csrk(p_cb->div, p_cb);
   } else {
     log::verbose("Generate DIV for CSRK");
-    send_ble_rand(BindOnce(
+    smp_generate_rand(BindOnce(
         [](tSMP_CB* p_cb, uint64_t rand) {
           uint16_t div = static_cast<uint16_t>(rand);
           smp_compute_csrk(div, p_cb);
@@ -407,19 +421,7 @@ void smp_generate_srand_mrand_confirm(tSMP_CB* p_cb,
                                       tSMP_INT_DATA* /* p_data */) {
   log::verbose("addr:{}", p_cb->pairing_bda);
   /* generate MRand or SRand */
-  send_ble_rand(BindOnce(
-      [](tSMP_CB* p_cb, uint64_t rand) {
-        memcpy(p_cb->rand.data(), (uint8_t*)&rand, sizeof(uint64_t));
-        /* generate 64 MSB of MRand or SRand */
-        send_ble_rand(BindOnce(
-            [](tSMP_CB* p_cb, uint64_t rand) {
-              memcpy(p_cb->rand.data() + sizeof(uint64_t), (uint8_t*)&rand,
-                     sizeof(uint64_t));
-              smp_generate_confirm(p_cb);
-            },
-            p_cb));
-      },
-      p_cb));
+  smp_generate_rand128(p_cb, base::BindOnce(&smp_generate_confirm, p_cb));
 }
 
 /*******************************************************************************
@@ -525,7 +527,7 @@ static void smp_generate_ltk_cont(uint16_t div, tSMP_CB* p_cb) {
   p_cb->ltk = ltk;
 
   /* generate EDIV and rand now */
-  send_ble_rand(BindOnce(&smp_generate_y, p_cb));
+  smp_generate_rand(BindOnce(&smp_generate_y, p_cb));
 }
 
 /*******************************************************************************
@@ -562,7 +564,7 @@ void smp_generate_ltk(tSMP_CB* p_cb, tSMP_INT_DATA* /* p_data */) {
     log::verbose("Generate DIV for LTK");
 
     /* generate MRand or SRand */
-    send_ble_rand(BindOnce(
+    smp_generate_rand(BindOnce(
         [](tSMP_CB* p_cb, uint64_t rand) {
           uint16_t div = static_cast<uint16_t>(rand);
           smp_generate_ltk_cont(div, p_cb);
@@ -594,8 +596,8 @@ Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb) {
  *
  * Description      This function is called to create private key used to
  *                  calculate public key and DHKey.
- *                  The function starts private key creation requesting
- *                  for the controller to generate [0-7] octets of private key.
+ *                  The key pair is taken from the pool generated in the
+ *                  background, unless the OOB data provides one.
  *
  * Returns          void
  *
@@ -625,29 +627,11 @@ void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* /* p_data */) {
     log::warn("OOB Association Model with no saved data present");
   }
 
-  send_ble_rand(BindOnce(
-      [](tSMP_CB* p_cb, uint64_t rand) {
-        memcpy(p_cb->private_key, (uint8_t*)&rand, sizeof(uint64_t));
-        send_ble_rand(BindOnce(
-            [](tSMP_CB* p_cb, uint64_t rand) {
-              memcpy(&p_cb->private_key[8], (uint8_t*)&rand, sizeof(uint64_t));
-              send_ble_rand(BindOnce(
-                  [](tSMP_CB* p_cb, uint64_t rand) {
-                    memcpy(&p_cb->private_key[16], (uint8_t*)&rand,
-                           sizeof(uint64_t));
-                    send_ble_rand(BindOnce(
-                        [](tSMP_CB* p_cb, uint64_t rand) {
-                          memcpy(&p_cb->private_key[24], (uint8_t*)&rand,
-                                 sizeof(uint64_t));
-                          smp_process_private_key(p_cb);
-                        },
-                        p_cb));
-                  },
-                  p_cb));
-            },
-            p_cb));
-      },
-      p_cb));
+  crypto_toolbox::p256::KeyPair key_pair = smp_key_pair_pool().Take();
+  memcpy(p_cb->private_key, key_pair.private_key.data(), BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.x, key_pair.public_key.x.data(), BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.y, key_pair.public_key.y.data(), BT_OCTET32_LEN);
+  smp_process_local_public_key(p_cb);
 }
 
 /*******************************************************************************
@@ -720,16 +704,32 @@ void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* /* p_data */) {
  *
  ******************************************************************************/
 void smp_process_private_key(tSMP_CB* p_cb) {
-  Point public_key;
-  BT_OCTET32 private_key;
+  crypto_toolbox::p256::Scalar private_key;
+  crypto_toolbox::p256::PublicKey public_key;
 
   log::verbose("addr:{}", p_cb->pairing_bda);
 
-  memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-  ECC_PointMult(&public_key, &(curve_p256.G), (uint32_t*)private_key);
-  memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
-  memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
+  memcpy(private_key.data(), p_cb->private_key, BT_OCTET32_LEN);
+  if (!crypto_toolbox::p256::ComputePublicKey(private_key, &public_key)) {
+    log::error("Invalid private key");
+  }
+  memcpy(p_cb->loc_publ_key.x, public_key.x.data(), BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.y, public_key.y.data(), BT_OCTET32_LEN);
+
+  smp_process_local_public_key(p_cb);
+}
 
+/*******************************************************************************
+ *
+ * Function         smp_process_local_public_key
+ *
+ * Description      This function notifies SM that private key / public key
+ *                  pair is created.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_process_local_public_key(tSMP_CB* p_cb) {
   smp_debug_print_nbyte_little_endian(p_cb->private_key, "private",
                                       BT_OCTET32_LEN);
   smp_debug_print_nbyte_little_endian(p_cb->loc_publ_key.x, "local public(x)",
@@ -753,18 +753,21 @@ void smp_process_private_key(tSMP_CB* p_cb) {
  *
  ******************************************************************************/
 void smp_compute_dhkey(tSMP_CB* p_cb) {
-  Point peer_publ_key, new_publ_key;
-  BT_OCTET32 private_key;
+  crypto_toolbox::p256::Scalar private_key, dhkey = {};
+  crypto_toolbox::p256::PublicKey peer_publ_key;
 
   log::verbose("addr:{}", p_cb->pairing_bda);
 
-  memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-  memcpy(peer_publ_key.x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
-  memcpy(peer_publ_key.y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+  memcpy(private_key.data(), p_cb->private_key, BT_OCTET32_LEN);
+  memcpy(peer_publ_key.x.data(), p_cb->peer_publ_key.x, BT_OCTET32_LEN);
+  memcpy(peer_publ_key.y.data(), p_cb->peer_publ_key.y, BT_OCTET32_LEN);
 
-  ECC_PointMult(&new_publ_key, &peer_publ_key, (uint32_t*)private_key);
+  if (!crypto_toolbox::p256::ComputeDhKey(private_key, peer_publ_key,
+                                          &dhkey)) {
+    log::error("Invalid peer public key");
+  }
 
-  memcpy(p_cb->dhkey, new_publ_key.x, BT_OCTET32_LEN);
+  memcpy(p_cb->dhkey, dhkey.data(), BT_OCTET32_LEN);
 
   smp_debug_print_nbyte_little_endian(p_cb->dhkey, "Old DHKey", BT_OCTET32_LEN);
 
@@ -1059,23 +1062,47 @@ bool smp_calculate_long_term_key_from_link_key(tSMP_CB* p_cb) {
  */
 void smp_start_nonce_generation(tSMP_CB* p_cb) {
   log::verbose("start generating nonce");
-  send_ble_rand(BindOnce(
-      [](tSMP_CB* p_cb, uint64_t rand) {
-        memcpy(p_cb->rand.data(), (uint8_t*)&rand, sizeof(uint64_t));
-        send_ble_rand(BindOnce(
-            [](tSMP_CB* p_cb, uint64_t rand) {
-              memcpy(p_cb->rand.data() + sizeof(uint64_t), (uint8_t*)&rand,
-                     sizeof(uint64_t));
-              log::verbose("round {}, done", p_cb->round);
-              /* notifies SM that it has new nonce. */
-              smp_sm_event(p_cb, SMP_HAVE_LOC_NONCE_EVT, NULL);
-            },
-            p_cb));
-      },
-      p_cb));
+  smp_generate_rand128(p_cb, base::BindOnce(
+                                 [](tSMP_CB* p_cb) {
+                                   log::verbose("round {}, done", p_cb->round);
+                                   /* notifies SM that it has new nonce. */
+                                   smp_sm_event(p_cb, SMP_HAVE_LOC_NONCE_EVT,
+                                                NULL);
+                                 },
+                                 p_cb));
+}
+
+/* Random values come from the entropy pool, without waiting for the
+ * controller. The callback still runs from a main thread task, as it did when
+ * each value was read with LE Rand. */
+static void smp_generate_rand(OnceCallback<void(uint64_t)> callback) {
+  uint64_t rand;
+  crypto_toolbox::GetEntropyPool().Generate(reinterpret_cast<uint8_t*>(&rand),
+                                            sizeof(rand));
+  do_in_main_thread(FROM_HERE, base::BindOnce(std::move(callback), rand));
+}
+
+/* Same for the 128 bit random value in p_cb->rand */
+static void smp_generate_rand128(tSMP_CB* p_cb, base::OnceClosure callback) {
+  crypto_toolbox::GetEntropyPool().Generate(p_cb->rand.data(),
+                                            p_cb->rand.size());
+  do_in_main_thread(FROM_HERE, std::move(callback));
+}
+
+/* Reads len bytes of entropy from the controller, 8 per LE Rand command */
+static void smp_read_controller_entropy(size_t len) {
+  for (size_t offset = 0; offset < len; offset += sizeof(uint64_t)) {
+    bluetooth::shim::GetController()->LeRand(
+        get_main_thread()->BindOnce([](uint64_t rand) {
+          crypto_toolbox::GetEntropyPool().AddEntropy(
+              reinterpret_cast<uint8_t*>(&rand), sizeof(rand));
+        }));
+  }
 }
 
-static void send_ble_rand(OnceCallback<void(uint64_t)> callback) {
-  bluetooth::shim::GetController()->LeRand(
-      get_main_thread()->BindOnce(std::move(callback)));
+void smp_set_entropy_source() {
+  crypto_toolbox::GetEntropyPool().SetEntropySource([](size_t len) {
+    do_in_main_thread(FROM_HERE,
+                      base::BindOnce(&smp_read_controller_entropy, len));
+  });
 }
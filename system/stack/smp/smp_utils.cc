@@ -36,7 +36,6 @@
 #include "main/shim/entry.h"
 #include "main/shim/helpers.h"
 #include "osi/include/allocator.h"
-#include "p_256_ecc_pp.h"
 #include "smp_int.h"
 #include "stack/btm/btm_ble_sec.h"
 #include "stack/btm/btm_dev.h"
@@ -897,8 +896,10 @@ void tSMP_CB::init(uint8_t security_mode) {
   log::verbose("init_security_mode:{}", init_security_mode);
 
   smp_l2cap_if_init();
-  /* initialization of P-256 parameters */
-  p_256_init_curve();
+  /* seed random values from the controller, then start generating local
+   * P-256 key pairs */
+  smp_set_entropy_source();
+  smp_init_key_pair_pool();
 
   /* Initialize failure case for certification */
   smp_cb.cert_failure = static_cast<tSMP_STATUS>(
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "btm_iso_api.h"
+#include "hci/controller_interface_mock.h"
+#include "hci/include/hci_layer.h"
+#include "mock_hcic_layer.h"
+#include "osi/include/allocator.h"
+#include "stack/btm/btm_dev.h"
+#include "stack/include/bt_hdr.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/hcidefs.h"
+#include "test/mock/mock_main_shim_entry.h"
+#include "test/mock/mock_main_shim_hci_layer.h"
+
+using ::benchmark::State;
+using bluetooth::hci::IsoManager;
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t /* handle */) {
+  return nullptr;
+}
+void BTM_LogHistory(const std::string& /* tag */,
+                    const RawAddress& /* bd_addr */,
+                    const std::string& /* msg */,
+                    const std::string& /* extra */) {}
+
+namespace {
+
+constexpr uint8_t kCigId = 1;
+constexpr uint16_t kSduLen = 120;
+/* Handle, length, sequence number and SDU length, no timestamp */
+constexpr uint16_t kIsoDataHeaderLen = 8;
+constexpr uint32_t kSduItvUs = 10000;
+/* Spread the handles over the whole HCI handle space */
+constexpr uint16_t kHandleStride = 0x00E0;
+
+size_t sent_bytes = 0;
+
+void transmit_downward(void* data, uint16_t /* iso_buffer_size */) {
+  sent_bytes += static_cast<BT_HDR*>(data)->len;
+  osi_free(data);
+}
+
+hci_t interface = {.set_data_cb = nullptr,
+                   .transmit_command = nullptr,
+                   .transmit_downward = transmit_downward};
+
+class NoopCigCallbacks : public bluetooth::hci::iso_manager::CigCallbacks {
+ public:
+  void OnSetupIsoDataPath(uint8_t /* status */, uint16_t /* conn_handle */,
+                          uint8_t /* cig_id */) override {}
+  void OnRemoveIsoDataPath(uint8_t /* status */, uint16_t /* conn_handle */,
+                           uint8_t /* cig_id */) override {}
+  void OnIsoLinkQualityRead(uint8_t /* conn_handle */, uint8_t /* cig_id */,
+                            uint32_t /* txUnackedPackets */,
+                            uint32_t /* txFlushedPackets */,
+                            uint32_t /* txLastSubeventPackets */,
+                            uint32_t /* retransmittedPackets */,
+                            uint32_t /* crcErrorPackets */,
+                            uint32_t /* rxUnreceivedPackets */,
+                            uint32_t /* duplicatePackets */) override {}
+  void OnCisEvent(uint8_t /* event */, void* /* data */) override {}
+  void OnCigEvent(uint8_t /* event */, void* /* data */) override {}
+};
+
+class BM_IsoManager : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+
+    handles_.clear();
+    for (int i = 0; i < st.range(0); i++) {
+      handles_.push_back(kHandleStride * (i + 1));
+    }
+
+    /* Fixtures outlive the benchmark run, so the mocks only live in between
+     * SetUp() and TearDown().
+     */
+    hcic_interface_ = std::make_unique<NiceMock<hcic::MockHcicInterface>>();
+    controller_ = std::make_unique<
+        NiceMock<bluetooth::hci::testing::MockControllerInterface>>();
+
+    hcic::SetMockHcicInterface(hcic_interface_.get());
+    bluetooth::shim::testing::hci_layer_set_interface(&interface);
+    bluetooth::hci::testing::mock_controller_ = controller_.get();
+
+    iso_sizes_.total_num_le_packets_ = handles_.size();
+    iso_sizes_.le_data_packet_length_ = 1024;
+    ON_CALL(*controller_, GetControllerIsoBufferSize())
+        .WillByDefault(Return(iso_sizes_));
+
+    ON_CALL(*hcic_interface_, SetCigParams)
+        .WillByDefault([this](auto cig_id, auto,
+                              base::OnceCallback<void(uint8_t*, uint16_t)> cb) {
+          std::vector<uint8_t> buf(3 + sizeof(uint16_t) * handles_.size());
+          uint8_t* p = buf.data();
+          UINT8_TO_STREAM(p, HCI_SUCCESS);
+          UINT8_TO_STREAM(p, cig_id);
+          UINT8_TO_STREAM(p, handles_.size());
+          for (auto handle : handles_) UINT16_TO_STREAM(p, handle);
+          std::move(cb).Run(buf.data(), buf.size());
+        });
+    ON_CALL(*hcic_interface_, CreateCis)
+        .WillByDefault(
+            [](uint8_t num_cis, const EXT_CIS_CREATE_CFG* cis_cfg,
+               base::OnceCallback<void(uint8_t*, uint16_t)> /* cb */) {
+              for (; num_cis != 0; num_cis--, cis_cfg++) {
+                std::vector<uint8_t> buf(28);
+                uint8_t* p = buf.data();
+                UINT8_TO_STREAM(p, HCI_SUCCESS);
+                UINT16_TO_STREAM(p, cis_cfg->cis_conn_handle);
+                IsoManager::GetInstance()->HandleHciEvent(
+                    HCI_BLE_CIS_EST_EVT, buf.data(), buf.size());
+              }
+            });
+    ON_CALL(*hcic_interface_, SetupIsoDataPath)
+        .WillByDefault(
+            [](uint16_t iso_handle, uint8_t, uint8_t, uint8_t, uint16_t,
+               uint16_t, uint32_t, std::vector<uint8_t>,
+               base::OnceCallback<void(uint8_t*, uint16_t)> cb) {
+              std::vector<uint8_t> buf(3);
+              uint8_t* p = buf.data();
+              UINT8_TO_STREAM(p, HCI_SUCCESS);
+              UINT16_TO_STREAM(p, iso_handle);
+              std::move(cb).Run(buf.data(), buf.size());
+            });
+
+    auto iso = IsoManager::GetInstance();
+    iso->Start();
+    iso->RegisterCigCallbacks(&cig_callbacks_);
+
+    bluetooth::hci::iso_manager::cig_create_params cig_params = {
+        .sdu_itv_mtos = kSduItvUs,
+        .sdu_itv_stom = kSduItvUs,
+    };
+    for (size_t i = 0; i < handles_.size(); i++) {
+      cig_params.cis_cfgs.push_back({
+          .cis_id = static_cast<uint8_t>(i),
+          .max_sdu_size_mtos = kSduLen,
+          .max_sdu_size_stom = kSduLen,
+      });
+    }
+    iso->CreateCig(kCigId, cig_params);
+
+    bluetooth::hci::iso_manager::cis_establish_params conn_params;
+    for (auto handle : handles_) conn_params.conn_pairs.push_back({handle, 1});
+    iso->EstablishCis(conn_params);
+
+    bluetooth::hci::iso_manager::iso_data_path_params path_params = {
+        .data_path_dir = bluetooth::hci::iso_manager::kIsoDataPathDirectionIn,
+        .data_path_id = bluetooth::hci::iso_manager::kIsoDataPathHci,
+    };
+    for (auto handle : handles_) iso->SetupIsoDataPath(handle, path_params);
+    sent_bytes = 0;
+  }
+
+  void TearDown(State& st) override {
+    IsoManager::GetInstance()->Stop();
+
+    hcic::SetMockHcicInterface(nullptr);
+    bluetooth::shim::testing::hci_layer_set_interface(nullptr);
+    bluetooth::hci::testing::mock_controller_ = nullptr;
+    hcic_interface_.reset();
+    controller_.reset();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<uint16_t> handles_;
+  std::unique_ptr<NiceMock<hcic::MockHcicInterface>> hcic_interface_;
+  std::unique_ptr<NiceMock<bluetooth::hci::testing::MockControllerInterface>>
+      controller_;
+  bluetooth::hci::LeBufferSize iso_sizes_;
+  NoopCigCallbacks cig_callbacks_;
+};
+
+}  // namespace
+
+/* Audio source pushing one SDU per stream, with the controller returning the
+ * credit for each packet before the next SDU interval.
+ */
+BENCHMARK_DEFINE_F(BM_IsoManager, SendSdu)(State& st) {
+  auto iso = IsoManager::GetInstance();
+  std::vector<uint8_t> sdu(kSduLen, 0xA5);
+
+  for (auto _ : st) {
+    for (auto handle : handles_) {
+      iso->SendIsoData(handle, sdu.data(), sdu.size());
+    }
+    for (auto handle : handles_) {
+      iso->HandleNumComplDataPkts(handle, 1);
+    }
+  }
+  st.SetItemsProcessed(st.iterations() * handles_.size());
+  st.SetBytesProcessed(sent_bytes);
+}
+
+/* Incoming SDUs on every stream, with no sequence number gaps */
+BENCHMARK_DEFINE_F(BM_IsoManager, ReceiveSdu)(State& st) {
+  auto iso = IsoManager::GetInstance();
+  const uint16_t iso_len = kIsoDataHeaderLen + kSduLen;
+
+  std::vector<BT_HDR*> msgs;
+  for (auto handle : handles_) {
+    BT_HDR* p_msg = (BT_HDR*)osi_calloc(sizeof(BT_HDR) + iso_len);
+    p_msg->len = iso_len;
+    uint8_t* p = p_msg->data;
+    UINT16_TO_STREAM(p, handle);
+    UINT16_TO_STREAM(p, kSduLen + 4);
+    msgs.push_back(p_msg);
+  }
+
+  uint16_t seq_nb = 0;
+  for (auto _ : st) {
+    for (auto p_msg : msgs) {
+      uint8_t* p = p_msg->data + 4;
+      UINT16_TO_STREAM(p, seq_nb);
+      UINT16_TO_STREAM(p, kSduLen);
+      iso->HandleIsoData(p_msg);
+    }
+    seq_nb++;
+  }
+  st.SetItemsProcessed(st.iterations() * handles_.size());
+
+  for (auto p_msg : msgs) osi_free(p_msg);
+}
+
+BENCHMARK_REGISTER_F(BM_IsoManager, SendSdu)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+BENCHMARK_REGISTER_F(BM_IsoManager, ReceiveSdu)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8);
+
+BENCHMARK_MAIN();
@@ -623,6 +623,21 @@ TEST_F(IsoManagerDeathTest, CreateCigCallbackInvalidRspPacket2) {
               ::testing::KilledBySignal(SIGABRT), "Invalid CIS count");
 }
 
+// Check that a CIS handle out of range from a faulty controller is dropped
+TEST_F(IsoManagerTest, CreateCigCallbackInvalidCisHandle) {
+  uint8_t hci_mock_rsp_buffer[] = {0x00, 0x80, 0x02, 0x01, 0x00, 0x00, 0x10};
+  ON_CALL(hcic_interface_, SetCigParams)
+      .WillByDefault(
+          [&hci_mock_rsp_buffer](
+              auto, auto, base::OnceCallback<void(uint8_t*, uint16_t)> cb) {
+            std::move(cb).Run(hci_mock_rsp_buffer, sizeof(hci_mock_rsp_buffer));
+            return 0;
+          });
+
+  EXPECT_CALL(*cig_callbacks_, OnCigEvent(_, _)).Times(0);
+  IsoManager::GetInstance()->CreateCig(128, kDefaultCigParams);
+}
+
 // Check if IsoManager properly handles error responses from HCI layer
 TEST_F(IsoManagerTest, CreateCigCallbackInvalidStatus) {
   uint8_t rsp_cig_id = 128;
@@ -2509,6 +2524,29 @@ TEST_F(IsoManagerTest, HandleIsoData) {
   IsoManager::GetInstance()->HandleIsoData(dummy_msg.data());
 }
 
+TEST_F(IsoManagerTest, HandleIsoDataReservedHandle) {
+  IsoManager::GetInstance()->CreateCig(
+      volatile_test_cig_create_cmpl_evt_.cig_id, kDefaultCigParams);
+
+  auto handle = volatile_test_cig_create_cmpl_evt_.conn_handles[0];
+  IsoManager::GetInstance()->EstablishCis({{{handle, 1}}});
+
+  EXPECT_CALL(
+      *cig_callbacks_,
+      OnCisEvent(bluetooth::hci::iso_manager::kIsoEventCisDataAvailable, _))
+      .Times(0);
+
+  /* Handles above HCI_HANDLE_MAX are reserved and never map to a CIS */
+  std::vector<uint8_t> dummy_msg(18);
+  uint8_t* p = dummy_msg.data();
+  UINT16_TO_STREAM(p, BT_EVT_TO_BTU_HCI_ISO);
+  UINT16_TO_STREAM(p, 10);  // .len
+  UINT16_TO_STREAM(p, 0);   // .offset
+  UINT16_TO_STREAM(p, 0);   // .layer_specific
+  UINT16_TO_STREAM(p, HCI_HANDLE_MAX + 1);
+  IsoManager::GetInstance()->HandleIsoData(dummy_msg.data());
+}
+
 /* This test case simulates HCI thread scheduling events on the main thread,
  * without knowing the we are already shutting down the stack and Iso Manager
  * is already stopped.
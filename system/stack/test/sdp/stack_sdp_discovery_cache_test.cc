@@ -0,0 +1,357 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/bt_uuid16.h"
+#include "stack/include/sdp_api.h"
+#include "stack/include/sdpdefs.h"
+#include "stack/sdp/sdpint.h"
+#include "storage/config_keys.h"
+#include "test/fake/fake_osi.h"
+#include "test/mock/mock_btif_config.h"
+#include "test/mock/mock_osi_properties.h"
+#include "test/mock/mock_stack_btm_sec.h"
+#include "test/mock/mock_stack_l2cap_api.h"
+
+using bluetooth::legacy::stack::sdp::get_legacy_stack_sdp_api;
+
+namespace {
+
+const RawAddress kRawAddress = RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+constexpr uint16_t kCid = 0x0042;
+constexpr uint32_t kSdpDbSize = 4096;
+constexpr uint32_t kHandle = 0x00010001;
+
+/* Attribute list of one Audio Sink record: record handle and class list */
+constexpr uint8_t kAttrList[] = {
+    0x35, 0x10,                                      // Sequence, 16 bytes
+    0x09, 0x00, 0x00, 0x0a, 0x00, 0x01, 0x00, 0x01,  // Record handle
+    0x09, 0x00, 0x01, 0x35, 0x03, 0x19, 0x11, 0x0b,  // Audio Sink class
+};
+
+std::vector<std::vector<uint8_t>> sent_pdus;
+std::map<std::string, std::vector<uint8_t>> config;
+
+std::vector<uint8_t> service_search_rsp(const std::vector<uint32_t>& handles) {
+  std::vector<uint8_t> pdu(10 + handles.size() * 4);
+  uint8_t* p = pdu.data();
+  UINT8_TO_BE_STREAM(p, SDP_PDU_SERVICE_SEARCH_RSP);
+  UINT16_TO_BE_STREAM(p, 0);
+  UINT16_TO_BE_STREAM(p, pdu.size() - 5);
+  UINT16_TO_BE_STREAM(p, handles.size());
+  UINT16_TO_BE_STREAM(p, handles.size());
+  for (uint32_t handle : handles) UINT32_TO_BE_STREAM(p, handle);
+  UINT8_TO_BE_STREAM(p, 0);
+  return pdu;
+}
+
+std::vector<uint8_t> attr_rsp(uint8_t pdu_id) {
+  std::vector<uint8_t> list(kAttrList, kAttrList + sizeof(kAttrList));
+  if (pdu_id == SDP_PDU_SERVICE_SEARCH_ATTR_RSP) {
+    /* Wrap the record in the list of records */
+    list.insert(list.begin(),
+                {(DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+                 (uint8_t)sizeof(kAttrList)});
+  }
+
+  std::vector<uint8_t> pdu(8 + list.size());
+  uint8_t* p = pdu.data();
+  UINT8_TO_BE_STREAM(p, pdu_id);
+  UINT16_TO_BE_STREAM(p, 0);
+  UINT16_TO_BE_STREAM(p, pdu.size() - 5);
+  UINT16_TO_BE_STREAM(p, list.size());
+  memcpy(p, list.data(), list.size());
+  p += list.size();
+  UINT8_TO_BE_STREAM(p, 0);
+  return pdu;
+}
+
+class StackSdpDiscoveryCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fake_osi_ = std::make_unique<test::fake::FakeOsi>();
+    test::mock::stack_l2cap_api::L2CA_RegisterWithSecurity.body =
+        [](uint16_t psm, const tL2CAP_APPL_INFO& /* p_cb_info */,
+           bool /* enable_snoop */, tL2CAP_ERTM_INFO* /* p_ertm_info */,
+           uint16_t /* my_mtu */, uint16_t /* required_remote_mtu */,
+           uint16_t /* sec_level */) { return psm; };
+    test::mock::stack_l2cap_api::L2CA_ConnectReqWithSecurity.body =
+        [](uint16_t /* psm */, const RawAddress& /* p_bd_addr */,
+           uint16_t /* sec_level */) { return kCid; };
+    test::mock::stack_l2cap_api::L2CA_DataWrite.body = [](uint16_t /* cid */,
+                                                          BT_HDR* p_data) {
+      const uint8_t* p = (const uint8_t*)(p_data + 1) + p_data->offset;
+      sent_pdus.emplace_back(p, p + p_data->len);
+      osi_free_and_reset((void**)&p_data);
+      return (uint8_t)L2CAP_DW_SUCCESS;
+    };
+    test::mock::stack_l2cap_api::L2CA_DisconnectReq.body =
+        [](uint16_t /* cid */) { return true; };
+    test::mock::osi_properties::osi_property_get_bool.body =
+        [](const char* key, bool default_value) {
+          if (!strcmp(key, SDP_DISC_CACHE_ENABLE_PROPERTY)) return true;
+          return default_value;
+        };
+    test::mock::stack_btm_sec::btm_sec_is_a_bonded_dev.body =
+        [](const RawAddress& /* bda */) { return true; };
+    test::mock::btif_config::btif_config_get_bin_length.body =
+        [](const std::string& section, const std::string& key) -> size_t {
+      auto it = config.find(section + "/" + key);
+      return it == config.end() ? 0 : it->second.size();
+    };
+    test::mock::btif_config::btif_config_get_bin.body =
+        [](const std::string& section, const std::string& key, uint8_t* value,
+           size_t* length) {
+          auto it = config.find(section + "/" + key);
+          if (it == config.end() || *length < it->second.size()) return false;
+          memcpy(value, it->second.data(), it->second.size());
+          *length = it->second.size();
+          return true;
+        };
+    test::mock::btif_config::btif_config_set_bin.body =
+        [](const std::string& section, const std::string& key,
+           const uint8_t* value, size_t length) {
+          config[section + "/" + key].assign(value, value + length);
+          return true;
+        };
+    test::mock::btif_config::btif_config_remove.body =
+        [](const std::string& section, const std::string& key) {
+          return config.erase(section + "/" + key) != 0;
+        };
+
+    sent_pdus.clear();
+    config.clear();
+    sdp_init();
+    p_db_ = (tSDP_DISCOVERY_DB*)osi_malloc(kSdpDbSize);
+  }
+
+  void TearDown() override {
+    if (p_ccb_ != nullptr) sdpu_release_ccb(*p_ccb_);
+    osi_free(p_db_);
+    sdp_free();
+    test::mock::btif_config::btif_config_remove = {};
+    test::mock::btif_config::btif_config_set_bin = {};
+    test::mock::btif_config::btif_config_get_bin = {};
+    test::mock::btif_config::btif_config_get_bin_length = {};
+    test::mock::stack_btm_sec::btm_sec_is_a_bonded_dev = {};
+    test::mock::osi_properties::osi_property_get_bool = {};
+    test::mock::stack_l2cap_api::L2CA_DisconnectReq = {};
+    test::mock::stack_l2cap_api::L2CA_DataWrite = {};
+    test::mock::stack_l2cap_api::L2CA_ConnectReqWithSecurity = {};
+    test::mock::stack_l2cap_api::L2CA_RegisterWithSecurity = {};
+    fake_osi_.reset();
+  }
+
+  void InitDb() {
+    const bluetooth::Uuid uuid =
+        bluetooth::Uuid::From16Bit(UUID_SERVCLASS_AUDIO_SINK);
+    ASSERT_TRUE(get_legacy_stack_sdp_api()->service.SDP_InitDiscoveryDb(
+        p_db_, kSdpDbSize, 1, &uuid, 0, nullptr));
+  }
+
+  /* Starts a discovery and fast forwards to the connected state */
+  void StartDiscovery(bool attr_search) {
+    if (p_ccb_ != nullptr) sdpu_release_ccb(*p_ccb_);
+    InitDb();
+    sent_pdus.clear();
+
+    if (attr_search) {
+      ASSERT_TRUE(
+          get_legacy_stack_sdp_api()->service.SDP_ServiceSearchAttributeRequest(
+              kRawAddress, p_db_,
+              [](const RawAddress& /* bd_addr */, tSDP_RESULT /* result */) {}));
+    } else {
+      ASSERT_TRUE(get_legacy_stack_sdp_api()->service.SDP_ServiceSearchRequest(
+          kRawAddress, p_db_,
+          [](const RawAddress& /* bd_addr */, tSDP_RESULT /* result */) {}));
+    }
+    p_ccb_ = sdpu_find_ccb_by_db(p_db_);
+    ASSERT_NE(nullptr, p_ccb_);
+    p_ccb_->con_state = SDP_STATE_CONNECTED;
+    p_ccb_->con_flags = SDP_FLAGS_IS_ORIG;
+    p_ccb_->disconnect_reason = SDP_GENERIC_ERROR;
+    sdp_disc_connected(p_ccb_);
+  }
+
+  void Receive(const std::vector<uint8_t>& pdu) {
+    BT_HDR* p_msg = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + pdu.size());
+    p_msg->offset = 0;
+    p_msg->len = pdu.size();
+    memcpy(p_msg + 1, pdu.data(), pdu.size());
+    sdp_disc_server_rsp(p_ccb_, p_msg);
+    osi_free(p_msg);
+  }
+
+  /* Runs a full discovery of the Audio Sink record */
+  void Discover(bool attr_search) {
+    StartDiscovery(attr_search);
+    ASSERT_EQ(1u, sent_pdus.size());
+    ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_REQ, sent_pdus.back()[0]);
+    Receive(service_search_rsp({kHandle}));
+    ASSERT_EQ(2u, sent_pdus.size());
+    if (attr_search) {
+      ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_ATTR_REQ, sent_pdus.back()[0]);
+      Receive(attr_rsp(SDP_PDU_SERVICE_SEARCH_ATTR_RSP));
+    } else {
+      ASSERT_EQ(SDP_PDU_SERVICE_ATTR_REQ, sent_pdus.back()[0]);
+      Receive(attr_rsp(SDP_PDU_SERVICE_ATTR_RSP));
+    }
+    ASSERT_EQ(SDP_SUCCESS, p_ccb_->disconnect_reason);
+    ASSERT_NE(nullptr, get_legacy_stack_sdp_api()->db.SDP_FindServiceInDb(
+                           p_db_, UUID_SERVCLASS_AUDIO_SINK, nullptr));
+  }
+
+  std::unique_ptr<test::fake::FakeOsi> fake_osi_;
+  tSDP_DISCOVERY_DB* p_db_{nullptr};
+  tCONN_CB* p_ccb_{nullptr};
+};
+
+}  // namespace
+
+TEST_F(StackSdpDiscoveryCacheTest, records_are_persisted) {
+  Discover(false);
+
+  ASSERT_EQ(1u, config.count(kRawAddress.ToString() + "/" +
+                             BTIF_STORAGE_KEY_SDP_RECORD_CACHE));
+  ASSERT_EQ(1u, sdp_disc_cache_get_stats().misses);
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, same_handles_skip_attribute_requests) {
+  Discover(false);
+
+  /* The cache is reloaded from the config after a restart */
+  sdpu_release_ccb(*p_ccb_);
+  p_ccb_ = nullptr;
+  sdp_free();
+  sdp_init();
+
+  StartDiscovery(false);
+  Receive(service_search_rsp({kHandle}));
+
+  ASSERT_EQ(1u, sent_pdus.size());
+  ASSERT_EQ(SDP_SUCCESS, p_ccb_->disconnect_reason);
+  ASSERT_NE(nullptr, get_legacy_stack_sdp_api()->db.SDP_FindServiceInDb(
+                         p_db_, UUID_SERVCLASS_AUDIO_SINK, nullptr));
+  ASSERT_EQ(1u, sdp_disc_cache_get_stats().hits);
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, attr_search_validates_handles) {
+  Discover(true);
+
+  StartDiscovery(true);
+  ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_REQ, sent_pdus.back()[0]);
+  Receive(service_search_rsp({kHandle}));
+
+  ASSERT_EQ(1u, sent_pdus.size());
+  ASSERT_EQ(SDP_SUCCESS, p_ccb_->disconnect_reason);
+  ASSERT_NE(nullptr, get_legacy_stack_sdp_api()->db.SDP_FindServiceInDb(
+                         p_db_, UUID_SERVCLASS_AUDIO_SINK, nullptr));
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, different_handles_drop_entry) {
+  Discover(false);
+
+  StartDiscovery(false);
+  Receive(service_search_rsp({kHandle + 1}));
+
+  ASSERT_EQ(2u, sent_pdus.size());
+  ASSERT_EQ(SDP_PDU_SERVICE_ATTR_REQ, sent_pdus.back()[0]);
+  ASSERT_EQ(1u, sdp_disc_cache_get_stats().stale);
+  ASSERT_EQ(0u, config.count(kRawAddress.ToString() + "/" +
+                             BTIF_STORAGE_KEY_SDP_RECORD_CACHE));
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, no_handles_fall_back_to_search_attr) {
+  Discover(true);
+
+  StartDiscovery(true);
+  Receive(service_search_rsp({}));
+
+  ASSERT_EQ(2u, sent_pdus.size());
+  ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_ATTR_REQ, sent_pdus.back()[0]);
+  ASSERT_EQ(1u, sdp_disc_cache_get_stats().stale);
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, disabled_cache_is_not_used) {
+  test::mock::osi_properties::osi_property_get_bool.body =
+      [](const char* /* key */, bool /* default_value */) { return false; };
+
+  StartDiscovery(true);
+  ASSERT_EQ(1u, sent_pdus.size());
+  ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_ATTR_REQ, sent_pdus.back()[0]);
+  Receive(attr_rsp(SDP_PDU_SERVICE_SEARCH_ATTR_RSP));
+
+  ASSERT_EQ(SDP_SUCCESS, p_ccb_->disconnect_reason);
+  ASSERT_TRUE(config.empty());
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, cache_is_off_by_default) {
+  test::mock::osi_properties::osi_property_get_bool = {};
+
+  StartDiscovery(true);
+  ASSERT_EQ(1u, sent_pdus.size());
+  ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_ATTR_REQ, sent_pdus.back()[0]);
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, unbonded_device_is_not_cached) {
+  test::mock::stack_btm_sec::btm_sec_is_a_bonded_dev.body =
+      [](const RawAddress& /* bda */) { return false; };
+
+  StartDiscovery(false);
+  Receive(service_search_rsp({kHandle}));
+  ASSERT_EQ(2u, sent_pdus.size());
+  Receive(attr_rsp(SDP_PDU_SERVICE_ATTR_RSP));
+
+  ASSERT_EQ(SDP_SUCCESS, p_ccb_->disconnect_reason);
+  ASSERT_TRUE(config.empty());
+  ASSERT_EQ(0u, sdp_disc_cache_get_stats().misses);
+}
+
+TEST_F(StackSdpDiscoveryCacheTest, SDP_ReadCachedRecords) {
+  InitDb();
+  ASSERT_FALSE(get_legacy_stack_sdp_api()->service.SDP_ReadCachedRecords(
+      kRawAddress, p_db_));
+
+  Discover(false);
+  sdpu_release_ccb(*p_ccb_);
+  p_ccb_ = nullptr;
+
+  InitDb();
+  ASSERT_TRUE(get_legacy_stack_sdp_api()->service.SDP_ReadCachedRecords(
+      kRawAddress, p_db_));
+  ASSERT_NE(nullptr, get_legacy_stack_sdp_api()->db.SDP_FindServiceInDb(
+                         p_db_, UUID_SERVCLASS_AUDIO_SINK, nullptr));
+  ASSERT_EQ(1u, sdp_disc_cache_get_stats().sync_reads);
+
+  /* Records are cached per set of filters */
+  const uint16_t attr = ATTR_ID_SERVICE_CLASS_ID_LIST;
+  const bluetooth::Uuid uuid =
+      bluetooth::Uuid::From16Bit(UUID_SERVCLASS_AUDIO_SINK);
+  ASSERT_TRUE(get_legacy_stack_sdp_api()->service.SDP_InitDiscoveryDb(
+      p_db_, kSdpDbSize, 1, &uuid, 1, &attr));
+  ASSERT_FALSE(get_legacy_stack_sdp_api()->service.SDP_ReadCachedRecords(
+      kRawAddress, p_db_));
+}
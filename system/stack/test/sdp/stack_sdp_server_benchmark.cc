@@ -0,0 +1,155 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/bt_uuid16.h"
+#include "stack/include/sdp_api.h"
+#include "stack/include/sdpdefs.h"
+#include "stack/sdp/sdpint.h"
+#include "test/fake/fake_osi.h"
+#include "test/mock/mock_stack_l2cap_api.h"
+
+using ::benchmark::State;
+using bluetooth::legacy::stack::sdp::get_legacy_stack_sdp_api;
+
+namespace {
+
+constexpr uint16_t kMtu = 672;
+constexpr uint16_t kServices[] = {
+    UUID_SERVCLASS_SERIAL_PORT,   UUID_SERVCLASS_AUDIO_SOURCE,
+    UUID_SERVCLASS_AG_HANDSFREE,  UUID_SERVCLASS_PHONE_ACCESS,
+    UUID_SERVCLASS_MESSAGE_ACCESS, UUID_SERVCLASS_PANU,
+    UUID_SERVCLASS_OBEX_OBJECT_PUSH, UUID_SERVCLASS_PNP_INFORMATION,
+};
+constexpr char kServiceName[] = "Benchmark service";
+
+size_t rsp_bytes = 0;
+
+class BM_SdpServer : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    fake_osi_ = std::make_unique<test::fake::FakeOsi>();
+    test::mock::stack_l2cap_api::L2CA_RegisterWithSecurity.body =
+        [](uint16_t psm, const tL2CAP_APPL_INFO& /* p_cb_info */,
+           bool /* enable_snoop */, tL2CAP_ERTM_INFO* /* p_ertm_info */,
+           uint16_t /* my_mtu */, uint16_t /* required_remote_mtu */,
+           uint16_t /* sec_level */) { return psm; };
+    test::mock::stack_l2cap_api::L2CA_DataWrite.body = [](uint16_t /* cid */,
+                                                          BT_HDR* p_data) {
+      rsp_bytes += p_data->len;
+      osi_free_and_reset((void**)&p_data);
+      return (uint8_t)L2CAP_DW_SUCCESS;
+    };
+    sdp_init();
+
+    for (uint16_t service_uuid : kServices) {
+      uint32_t handle = get_legacy_stack_sdp_api()->handle.SDP_CreateRecord();
+      get_legacy_stack_sdp_api()->handle.SDP_AddServiceClassIdList(
+          handle, 1, &service_uuid);
+      tSDP_PROTOCOL_ELEM proto_list[2] = {};
+      proto_list[0].protocol_uuid = UUID_PROTOCOL_L2CAP;
+      proto_list[1].protocol_uuid = UUID_PROTOCOL_RFCOMM;
+      proto_list[1].num_params = 1;
+      proto_list[1].params[0] = 3;
+      get_legacy_stack_sdp_api()->handle.SDP_AddProtocolList(handle, 2,
+                                                             proto_list);
+      get_legacy_stack_sdp_api()->handle.SDP_AddAttribute(
+          handle, ATTR_ID_SERVICE_NAME, TEXT_STR_DESC_TYPE,
+          (uint32_t)sizeof(kServiceName), (uint8_t*)kServiceName);
+    }
+
+    p_ccb_ = sdpu_allocate_ccb();
+    p_ccb_->con_state = SDP_STATE_CONNECTED;
+    p_ccb_->connection_id = 0x0041;
+    p_ccb_->rem_mtu_size = kMtu;
+
+    /* ServiceSearchAttribute for all attributes of all L2CAP services */
+    const uint8_t params[] = {
+        (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+        3,
+        (UUID_DESC_TYPE << 3) | SIZE_TWO_BYTES,
+        (uint8_t)(UUID_PROTOCOL_L2CAP >> 8),
+        (uint8_t)UUID_PROTOCOL_L2CAP,
+        (uint8_t)(kMtu >> 8),
+        (uint8_t)kMtu,
+        (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+        5,
+        (UINT_DESC_TYPE << 3) | SIZE_FOUR_BYTES,
+        0x00,
+        0x00,
+        0xff,
+        0xff,
+        0x00,
+    };
+    p_msg_ = (BT_HDR*)osi_calloc(sizeof(BT_HDR) + 5 + sizeof(params));
+    uint8_t* p = (uint8_t*)(p_msg_ + 1);
+    UINT8_TO_BE_STREAM(p, SDP_PDU_SERVICE_SEARCH_ATTR_REQ);
+    UINT16_TO_BE_STREAM(p, 0x0001);
+    UINT16_TO_BE_STREAM(p, sizeof(params));
+    memcpy(p, params, sizeof(params));
+    p_msg_->len = 5 + sizeof(params);
+    rsp_bytes = 0;
+  }
+
+  void TearDown(State& st) override {
+    osi_free(p_msg_);
+    sdpu_release_ccb(*p_ccb_);
+    get_legacy_stack_sdp_api()->handle.SDP_DeleteRecord(0);
+    sdp_free();
+    test::mock::stack_l2cap_api::L2CA_RegisterWithSecurity = {};
+    test::mock::stack_l2cap_api::L2CA_DataWrite = {};
+    fake_osi_.reset();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::unique_ptr<test::fake::FakeOsi> fake_osi_;
+  tCONN_CB* p_ccb_ = nullptr;
+  BT_HDR* p_msg_ = nullptr;
+};
+
+}  // namespace
+
+/* First request from a new peer: the response has to be serialized */
+BENCHMARK_DEFINE_F(BM_SdpServer, ServiceSearchAttr_Uncached)(State& state) {
+  for (auto _ : state) {
+    sdp_server_cache_invalidate();
+    sdp_server_handle_client_req(p_ccb_, p_msg_);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(rsp_bytes);
+}
+BENCHMARK_REGISTER_F(BM_SdpServer, ServiceSearchAttr_Uncached);
+
+/* Every later request is served from the pre-serialized buffer */
+BENCHMARK_DEFINE_F(BM_SdpServer, ServiceSearchAttr_Cached)(State& state) {
+  for (auto _ : state) {
+    sdp_server_handle_client_req(p_ccb_, p_msg_);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(rsp_bytes);
+}
+BENCHMARK_REGISTER_F(BM_SdpServer, ServiceSearchAttr_Cached);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,303 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/bt_uuid16.h"
+#include "stack/include/sdp_api.h"
+#include "stack/include/sdpdefs.h"
+#include "stack/sdp/sdpint.h"
+#include "test/fake/fake_osi.h"
+#include "test/mock/mock_stack_l2cap_api.h"
+
+using bluetooth::legacy::stack::sdp::get_legacy_stack_sdp_api;
+
+namespace {
+
+constexpr uint16_t kCid = 0x0041;
+constexpr uint16_t kTransNum = 0x1234;
+/* Small enough to force the responses into several continuations */
+constexpr uint16_t kMtu = 48;
+constexpr char kServiceName[] =
+    "A service name long enough to need more than one response fragment";
+
+std::vector<std::vector<uint8_t>> sent_pdus;
+
+struct ParsedRsp {
+  uint8_t pdu_id;
+  std::vector<uint8_t> attr_list;
+  std::vector<uint8_t> cont_state;
+};
+
+ParsedRsp parse_rsp(const std::vector<uint8_t>& pdu) {
+  ParsedRsp rsp = {};
+  const uint8_t* p = pdu.data();
+  uint16_t trans_num, param_len, byte_count;
+  BE_STREAM_TO_UINT8(rsp.pdu_id, p);
+  BE_STREAM_TO_UINT16(trans_num, p);
+  BE_STREAM_TO_UINT16(param_len, p);
+  EXPECT_EQ(kTransNum, trans_num);
+  EXPECT_EQ(pdu.size(), 5u + param_len);
+  if (rsp.pdu_id == SDP_PDU_ERROR_RESPONSE) return rsp;
+
+  BE_STREAM_TO_UINT16(byte_count, p);
+  rsp.attr_list.assign(p, p + byte_count);
+  p += byte_count;
+  uint8_t cont_len = *p++;
+  rsp.cont_state.assign(p, p + cont_len);
+  return rsp;
+}
+
+class StackSdpServerCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fake_osi_ = std::make_unique<test::fake::FakeOsi>();
+    test::mock::stack_l2cap_api::L2CA_RegisterWithSecurity.body =
+        [](uint16_t psm, const tL2CAP_APPL_INFO& /* p_cb_info */,
+           bool /* enable_snoop */, tL2CAP_ERTM_INFO* /* p_ertm_info */,
+           uint16_t /* my_mtu */, uint16_t /* required_remote_mtu */,
+           uint16_t /* sec_level */) { return psm; };
+    test::mock::stack_l2cap_api::L2CA_DataWrite.body = [](uint16_t /* cid */,
+                                                          BT_HDR* p_data) {
+      const uint8_t* p = (uint8_t*)(p_data + 1) + p_data->offset;
+      sent_pdus.emplace_back(p, p + p_data->len);
+      osi_free_and_reset((void**)&p_data);
+      return (uint8_t)L2CAP_DW_SUCCESS;
+    };
+    sdp_init();
+    sent_pdus.clear();
+
+    handle_ = get_legacy_stack_sdp_api()->handle.SDP_CreateRecord();
+    ASSERT_NE(0u, handle_);
+    uint16_t service_uuid = UUID_SERVCLASS_SERIAL_PORT;
+    ASSERT_TRUE(get_legacy_stack_sdp_api()->handle.SDP_AddServiceClassIdList(
+        handle_, 1, &service_uuid));
+    ASSERT_TRUE(get_legacy_stack_sdp_api()->handle.SDP_AddAttribute(
+        handle_, ATTR_ID_SERVICE_NAME, TEXT_STR_DESC_TYPE,
+        (uint32_t)sizeof(kServiceName), (uint8_t*)kServiceName));
+
+    p_ccb_ = sdpu_allocate_ccb();
+    ASSERT_NE(nullptr, p_ccb_);
+    p_ccb_->con_state = SDP_STATE_CONNECTED;
+    p_ccb_->connection_id = kCid;
+    p_ccb_->rem_mtu_size = kMtu;
+  }
+
+  void TearDown() override {
+    sdpu_release_ccb(*p_ccb_);
+    get_legacy_stack_sdp_api()->handle.SDP_DeleteRecord(0);
+    sdp_free();
+    test::mock::stack_l2cap_api::L2CA_RegisterWithSecurity = {};
+    test::mock::stack_l2cap_api::L2CA_DataWrite = {};
+    fake_osi_.reset();
+  }
+
+  /* Sends a ServiceSearchAttribute request for all the attributes of the
+   * records matching |uuid| */
+  ParsedRsp SendSearchAttrReq(uint16_t uuid,
+                              const std::vector<uint8_t>& cont_state) {
+    std::vector<uint8_t> params = {
+        (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+        3,
+        (UUID_DESC_TYPE << 3) | SIZE_TWO_BYTES,
+        (uint8_t)(uuid >> 8),
+        (uint8_t)uuid,
+        (uint8_t)(kMtu >> 8),
+        (uint8_t)kMtu,
+        (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+        5,
+        (UINT_DESC_TYPE << 3) | SIZE_FOUR_BYTES,
+        0x00,
+        0x00,
+        0xff,
+        0xff,
+        (uint8_t)cont_state.size(),
+    };
+    params.insert(params.end(), cont_state.begin(), cont_state.end());
+    return SendReq(SDP_PDU_SERVICE_SEARCH_ATTR_REQ, params);
+  }
+
+  ParsedRsp SendReq(uint8_t pdu_id, const std::vector<uint8_t>& params) {
+    BT_HDR* p_msg = (BT_HDR*)osi_calloc(sizeof(BT_HDR) + 5 + params.size());
+    uint8_t* p = (uint8_t*)(p_msg + 1);
+    UINT8_TO_BE_STREAM(p, pdu_id);
+    UINT16_TO_BE_STREAM(p, kTransNum);
+    UINT16_TO_BE_STREAM(p, params.size());
+    memcpy(p, params.data(), params.size());
+    p_msg->len = 5 + params.size();
+
+    sent_pdus.clear();
+    sdp_server_handle_client_req(p_ccb_, p_msg);
+    osi_free(p_msg);
+
+    EXPECT_EQ(1u, sent_pdus.size());
+    return parse_rsp(sent_pdus.back());
+  }
+
+  /* Runs a full ServiceSearchAttribute transaction and returns the
+   * reassembled attribute list */
+  std::vector<uint8_t> SearchAttr(uint16_t uuid) {
+    std::vector<uint8_t> attr_list;
+    std::vector<uint8_t> cont_state;
+    do {
+      ParsedRsp rsp = SendSearchAttrReq(uuid, cont_state);
+      EXPECT_EQ(SDP_PDU_SERVICE_SEARCH_ATTR_RSP, rsp.pdu_id);
+      if (rsp.pdu_id != SDP_PDU_SERVICE_SEARCH_ATTR_RSP) break;
+      attr_list.insert(attr_list.end(), rsp.attr_list.begin(),
+                       rsp.attr_list.end());
+      cont_state = rsp.cont_state;
+    } while (!cont_state.empty());
+    return attr_list;
+  }
+
+  std::unique_ptr<test::fake::FakeOsi> fake_osi_;
+  uint32_t handle_ = 0;
+  tCONN_CB* p_ccb_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(StackSdpServerCacheTest, search_attr_served_from_cache) {
+  std::vector<uint8_t> first = SearchAttr(UUID_SERVCLASS_SERIAL_PORT);
+  ASSERT_GT(first.size(), (size_t)kMtu);
+
+  // Outer sequence, one record sequence, then the record handle attribute
+  ASSERT_EQ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE, first[0]);
+  ASSERT_EQ(first.size() - 2, first[1]);
+  ASSERT_EQ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD, first[2]);
+  ASSERT_EQ(first.size() - 5, (size_t)((first[3] << 8) | first[4]));
+
+  tSDP_SERVER_CACHE_STATS stats = sdp_server_cache_get_stats();
+  ASSERT_EQ(0u, stats.hits);
+  ASSERT_EQ(1u, stats.misses);
+  ASSERT_EQ(1u, stats.entries);
+
+  ASSERT_EQ(first, SearchAttr(UUID_SERVCLASS_SERIAL_PORT));
+  stats = sdp_server_cache_get_stats();
+  ASSERT_EQ(1u, stats.hits);
+  ASSERT_EQ(1u, stats.misses);
+}
+
+TEST_F(StackSdpServerCacheTest, add_attribute_invalidates_cache) {
+  std::vector<uint8_t> first = SearchAttr(UUID_SERVCLASS_SERIAL_PORT);
+
+  uint8_t psm[] = {0x10, 0x01};
+  ASSERT_TRUE(get_legacy_stack_sdp_api()->handle.SDP_AddAttribute(
+      handle_, ATTR_ID_GOEP_L2CAP_PSM, UINT_DESC_TYPE, sizeof(psm), psm));
+  tSDP_SERVER_CACHE_STATS stats = sdp_server_cache_get_stats();
+  ASSERT_EQ(1u, stats.invalidations);
+  ASSERT_EQ(0u, stats.entries);
+
+  std::vector<uint8_t> second = SearchAttr(UUID_SERVCLASS_SERIAL_PORT);
+  ASSERT_EQ(first.size() + 3 /* id */ + 3 /* value */, second.size());
+  ASSERT_EQ(2u, sdp_server_cache_get_stats().misses);
+}
+
+TEST_F(StackSdpServerCacheTest, continuation_survives_invalidation) {
+  std::vector<uint8_t> expected = SearchAttr(UUID_SERVCLASS_SERIAL_PORT);
+
+  ParsedRsp rsp = SendSearchAttrReq(UUID_SERVCLASS_SERIAL_PORT, {});
+  ASSERT_FALSE(rsp.cont_state.empty());
+  std::vector<uint8_t> attr_list = rsp.attr_list;
+
+  // The pending transaction keeps slicing the buffer it started with
+  get_legacy_stack_sdp_api()->handle.SDP_DeleteRecord(handle_);
+  std::vector<uint8_t> cont_state = rsp.cont_state;
+  while (!cont_state.empty()) {
+    rsp = SendSearchAttrReq(UUID_SERVCLASS_SERIAL_PORT, cont_state);
+    ASSERT_EQ(SDP_PDU_SERVICE_SEARCH_ATTR_RSP, rsp.pdu_id);
+    attr_list.insert(attr_list.end(), rsp.attr_list.begin(),
+                     rsp.attr_list.end());
+    cont_state = rsp.cont_state;
+  }
+  ASSERT_EQ(expected, attr_list);
+  ASSERT_EQ(nullptr, p_ccb_->cached_rsp);
+}
+
+TEST_F(StackSdpServerCacheTest, bad_continuation_offset) {
+  ParsedRsp rsp = SendSearchAttrReq(UUID_SERVCLASS_SERIAL_PORT, {});
+  ASSERT_EQ(2u, rsp.cont_state.size());
+
+  rsp = SendSearchAttrReq(UUID_SERVCLASS_SERIAL_PORT, {0xff, 0xff});
+  ASSERT_EQ(SDP_PDU_ERROR_RESPONSE, rsp.pdu_id);
+}
+
+TEST_F(StackSdpServerCacheTest, service_attr_served_from_cache) {
+  std::vector<uint8_t> params = {
+      (uint8_t)(handle_ >> 24),
+      (uint8_t)(handle_ >> 16),
+      (uint8_t)(handle_ >> 8),
+      (uint8_t)handle_,
+      0x00,
+      0xff,
+      (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+      3,
+      (UINT_DESC_TYPE << 3) | SIZE_TWO_BYTES,
+      (uint8_t)(ATTR_ID_SERVICE_CLASS_ID_LIST >> 8),
+      (uint8_t)ATTR_ID_SERVICE_CLASS_ID_LIST,
+      0x00,
+  };
+  ParsedRsp rsp = SendReq(SDP_PDU_SERVICE_ATTR_REQ, params);
+  ASSERT_EQ(SDP_PDU_SERVICE_ATTR_RSP, rsp.pdu_id);
+  ASSERT_TRUE(rsp.cont_state.empty());
+
+  // Sequence header, attribute id, then the service class UUID sequence
+  const std::vector<uint8_t> expected = {
+      (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+      8,
+      (UINT_DESC_TYPE << 3) | SIZE_TWO_BYTES,
+      (uint8_t)(ATTR_ID_SERVICE_CLASS_ID_LIST >> 8),
+      (uint8_t)ATTR_ID_SERVICE_CLASS_ID_LIST,
+      (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+      3,
+      (UUID_DESC_TYPE << 3) | SIZE_TWO_BYTES,
+      (uint8_t)(UUID_SERVCLASS_SERIAL_PORT >> 8),
+      (uint8_t)UUID_SERVCLASS_SERIAL_PORT,
+  };
+  ASSERT_EQ(expected, rsp.attr_list);
+
+  rsp = SendReq(SDP_PDU_SERVICE_ATTR_REQ, params);
+  ASSERT_EQ(expected, rsp.attr_list);
+  ASSERT_EQ(1u, sdp_server_cache_get_stats().hits);
+}
+
+TEST_F(StackSdpServerCacheTest, avrcp_target_record_not_cacheable) {
+  uint32_t handle = get_legacy_stack_sdp_api()->handle.SDP_CreateRecord();
+  uint16_t service_uuid = UUID_SERVCLASS_AV_REM_CTRL_TARGET;
+  ASSERT_TRUE(get_legacy_stack_sdp_api()->handle.SDP_AddServiceClassIdList(
+      handle, 1, &service_uuid));
+
+  ASSERT_TRUE(sdp_server_cache_is_cacheable(sdp_db_find_record(handle_)));
+  ASSERT_FALSE(sdp_server_cache_is_cacheable(sdp_db_find_record(handle)));
+
+  tSDP_UUID_SEQ uid_seq = {};
+  uid_seq.num_uids = 1;
+  uid_seq.uuid_entry[0].len = 2;
+  uid_seq.uuid_entry[0].value[0] = (uint8_t)(service_uuid >> 8);
+  uid_seq.uuid_entry[0].value[1] = (uint8_t)service_uuid;
+  tSDP_ATTR_SEQ attr_seq = {};
+  attr_seq.num_attr = 1;
+  attr_seq.attr_entry[0].start = 0x0000;
+  attr_seq.attr_entry[0].end = 0xffff;
+  ASSERT_EQ(nullptr, sdp_server_cache_get_search_attr_rsp(&uid_seq, &attr_seq));
+}
@@ -19,9 +19,11 @@
 #include <gtest/gtest.h>
 #include <stdarg.h>
 
+#include <cstring>
 #include <string>
 
 #include "crypto_toolbox/crypto_toolbox.h"
+#include "crypto_toolbox/p256.h"
 #include "hci/include/packet_fragmenter.h"
 #include "internal_include/stack_config.h"
 #include "stack/btm/btm_int_types.h"
@@ -29,7 +31,6 @@
 #include "stack/include/bt_octets.h"
 #include "stack/include/btm_ble_api.h"
 #include "stack/include/smp_status.h"
-#include "stack/smp/p_256_ecc_pp.h"
 #include "stack/smp/smp_int.h"
 #include "test/mock/mock_stack_acl.h"
 #include "types/hci_role.h"
@@ -319,6 +320,23 @@ TEST_F(SmpCalculateConfirmTest, test_smp_calculate_comfirm_as_central) {
   test::mock::stack_acl::BTM_ReadRemoteConnectionAddr = {};
 }
 
+namespace {
+
+// Coordinates as 32 bit words, least significant first
+struct Point {
+  uint32_t x[8];
+  uint32_t y[8];
+};
+
+bool ECC_ValidatePoint(const Point& p) {
+  crypto_toolbox::p256::PublicKey public_key;
+  memcpy(public_key.x.data(), p.x, sizeof(p.x));
+  memcpy(public_key.y.data(), p.y, sizeof(p.y));
+  return crypto_toolbox::p256::IsValidPoint(public_key);
+}
+
+}  // namespace
+
 // Test ECC point validation
 TEST(SmpEccValidationTest, test_valid_points) {
   Point p;
@@ -370,9 +388,7 @@ TEST(SmpEccValidationTest, test_valid_points) {
 }
 
 TEST(SmpEccValidationTest, test_invalid_points) {
-  Point p;
-  multiprecision_init(p.x);
-  multiprecision_init(p.y);
+  Point p = {};
 
   EXPECT_FALSE(ECC_ValidatePoint(p));
 
@@ -0,0 +1,444 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "bt_headless_a2dp"
+
+#include "test/headless/a2dp/a2dp.h"
+
+#include <base/strings/string_number_conversions.h>
+#include <bluetooth/log.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "btif/include/btif_a2dp_source.h"
+#include "include/hardware/bluetooth.h"
+#include "include/hardware/bt_av.h"
+#include "test/headless/get_options.h"
+#include "test/headless/headless.h"
+#include "types/raw_address.h"
+
+#ifndef __ANDROID__
+#include "audio_hal_interface/a2dp_encoding_host.h"
+#include "hal/hci_hal_host.h"
+#include "main/shim/helpers.h"
+#include "test/headless/a2dp/fake_sink_controller.h"
+#endif  // __ANDROID__
+
+extern bt_interface_t bluetoothInterface;
+
+using namespace bluetooth::test::headless;
+using namespace bluetooth;
+
+namespace {
+
+constexpr char kUsage[] =
+    "Usage: a2dp [seconds=<s>] [credits=<n>] [acl_size=<bytes>] "
+    "[slot_us=<us>] [jitter_us=<us>] [sink_delay_ms=<ms>]";
+
+struct Config {
+  unsigned seconds{10};
+  // Controller ACL buffers and their size.
+  unsigned credits{8};
+  unsigned acl_size{1021};
+  // Air time of one ACL packet, and up to |jitter_us| of random delay added
+  // to it to stand for retransmissions and interference.
+  unsigned slot_us{3750};
+  unsigned jitter_us{0};
+  // Audio buffered by the sink before it starts playing.
+  unsigned sink_delay_ms{100};
+
+  bool Parse(std::list<std::string> options) {
+    for (const auto& option : options) {
+      auto v = GetOpt::Split(option);
+      unsigned value;
+      if (v.size() != 2 || !base::StringToUint(v[1], &value)) return false;
+      if (v[0] == "seconds") {
+        seconds = value;
+      } else if (v[0] == "credits") {
+        credits = value;
+      } else if (v[0] == "acl_size") {
+        acl_size = value;
+      } else if (v[0] == "slot_us") {
+        slot_us = value;
+      } else if (v[0] == "jitter_us") {
+        jitter_us = value;
+      } else if (v[0] == "sink_delay_ms") {
+        sink_delay_ms = value;
+      } else {
+        return false;
+      }
+    }
+    // Sizes of the HCI Read Buffer Size parameters
+    return seconds > 0 && credits > 0 && credits <= UINT16_MAX &&
+           acl_size > 0 && acl_size <= UINT16_MAX;
+  }
+};
+
+#ifndef __ANDROID__
+
+// The PCM of the audio server, as configured with SetAudioConfig(), and the
+// SBC configuration offered by the sink.
+constexpr uint32_t kSampleRate = 44100;
+constexpr uint32_t kPcmBytesPerSample = 2 /* channels */ * 2;
+constexpr uint32_t kSamplesPerSbcFrame = 16 /* blocks */ * 8 /* subbands */;
+
+// Data socket of the audio server, see a2dp_encoding_host.cc
+constexpr char kAudioSocketDir[] = "/var/run/bluetooth/audio";
+constexpr char kAudioSocketPath[] = "/var/run/bluetooth/audio/.a2dp_data";
+
+const RawAddress kSinkAddress({0xc0, 0xde, 0xc0, 0xde, 0xa2, 0xd9});
+
+constexpr auto kConnectTimeout = std::chrono::seconds(10);
+constexpr auto kStartTimeout = std::chrono::seconds(5);
+
+class LatencyStats {
+ public:
+  void Add(int64_t us) { samples_us_.push_back(us); }
+
+  std::string ToString() {
+    if (samples_us_.empty()) return "no samples";
+    std::sort(samples_us_.begin(), samples_us_.end());
+    int64_t total = 0;
+    for (auto us : samples_us_) total += us;
+    return fmt::format("n:{} avg:{}us p50:{}us p99:{}us max:{}us",
+                       samples_us_.size(), total / (int64_t)samples_us_.size(),
+                       Percentile(50), Percentile(99), samples_us_.back());
+  }
+
+ private:
+  int64_t Percentile(size_t p) const {
+    return samples_us_[(samples_us_.size() - 1) * p / 100];
+  }
+
+  std::vector<int64_t> samples_us_;
+};
+
+// Same clock as the times of FakeSinkController::MediaPacket
+uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Connection and audio states reported by the A2DP source profile.
+struct SourceState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  btav_connection_state_t connection{BTAV_CONNECTION_STATE_DISCONNECTED};
+  btav_audio_state_t audio{BTAV_AUDIO_STATE_STOPPED};
+
+  template <typename Predicate>
+  bool WaitFor(std::chrono::seconds timeout, Predicate predicate) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return cv.wait_for(lock, timeout, [this, &predicate] {
+      return predicate(connection, audio);
+    });
+  }
+} source_state;
+
+btav_source_callbacks_t source_callbacks = {
+    .size = sizeof(btav_source_callbacks_t),
+    .connection_state_cb =
+        [](const RawAddress& /* bd_addr */, btav_connection_state_t state,
+           const btav_error_t& /* error */) {
+          std::lock_guard<std::mutex> lock(source_state.mutex);
+          source_state.connection = state;
+          source_state.cv.notify_all();
+        },
+    .audio_state_cb =
+        [](const RawAddress& /* bd_addr */, btav_audio_state_t state) {
+          std::lock_guard<std::mutex> lock(source_state.mutex);
+          source_state.audio = state;
+          source_state.cv.notify_all();
+        },
+    .audio_config_cb =
+        [](const RawAddress& /* bd_addr */,
+           btav_a2dp_codec_config_t /* codec_config */,
+           std::vector<btav_a2dp_codec_config_t> /* local_capabilities */,
+           std::vector<btav_a2dp_codec_config_t> /* selectable */) {},
+    .mandatory_codec_preferred_cb =
+        [](const RawAddress& /* bd_addr */) { return false; },
+};
+
+// Stands for the audio server: writes a 1kHz tone at -6dBFS on both channels
+// to the data socket, in real time, in chunks of 10ms.
+class PcmWriter {
+ public:
+  bool Start() {
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, kAudioSocketPath, sizeof(addr.sun_path) - 1);
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<struct sockaddr*>(&addr),
+                           sizeof(addr)) < 0) {
+      LOG_CONSOLE("Unable to connect to %s: %s", kAudioSocketPath,
+                  strerror(errno));
+      if (fd_ >= 0) close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    stopping_ = false;
+    thread_ = std::thread(&PcmWriter::Loop, this);
+    return true;
+  }
+
+  void Stop() {
+    if (!thread_.joinable()) return;
+    stopping_ = true;
+    thread_.join();
+    close(fd_);
+    fd_ = -1;
+  }
+
+  // When the PCM at |offset| bytes in the stream was written
+  uint64_t WriteTimeUs(uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (write_us_.empty()) return 0;
+    return write_us_[std::min(static_cast<size_t>(offset / kChunkSize),
+                              write_us_.size() - 1)];
+  }
+
+  uint64_t BytesWritten() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_us_.size() * kChunkSize;
+  }
+
+ private:
+  static constexpr uint64_t kChunkSize = kSampleRate / 100 * kPcmBytesPerSample;
+
+  void Loop() {
+    std::vector<int16_t> chunk(kChunkSize / sizeof(int16_t));
+    uint64_t phase = 0;
+    auto next = std::chrono::steady_clock::now();
+    while (!stopping_) {
+      for (size_t i = 0; i + 1 < chunk.size(); i += 2) {
+        int16_t sample = (int16_t)(16384 * std::sin(2 * M_PI * 1000 *
+                                                    (phase++ % kSampleRate) /
+                                                    kSampleRate));
+        chunk[i] = sample;
+        chunk[i + 1] = sample;
+      }
+      const uint8_t* data = reinterpret_cast<const uint8_t*>(chunk.data());
+      for (size_t offset = 0; offset < kChunkSize;) {
+        ssize_t n =
+            send(fd_, data + offset, kChunkSize - offset, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+          LOG_CONSOLE("Unable to write PCM: %s", strerror(errno));
+          return;
+        }
+        offset += n;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_us_.push_back(now_us());
+      }
+      next += std::chrono::milliseconds(10);
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  int fd_{-1};
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+  std::mutex mutex_;
+  std::vector<uint64_t> write_us_;
+};
+
+// Reports what the sink received: the latency of each media packet from the
+// write of its PCM by the audio server to the controller and to the sink, the
+// time it spent in the controller, how long the stack was left without ACL
+// credits, and whether the packet arrived in time for a sink playing
+// |sink_delay_ms| behind the first packet. The PCM offset of a packet is
+// derived from its RTP timestamp, assuming the encoder read the stream from its
+// first byte.
+//
+// The stages before the controller are reported by the A2DP source itself, in
+// the dump of btif_a2dp_source_debug_dump() printed before: the PCM read and
+// encode times per encoder tick, the jitter of the ticks (enqueue scheduling),
+// the TX queue length and queueing time, its dropouts and the PCM underflows.
+// The time a packet waited for an ACL credit is not measured on its own: it is
+// bounded by the credit stalls.
+void Report(const Config& config, const FakeSinkController::Stats& stats,
+            PcmWriter& writer, const struct rusage& rusage_start) {
+  struct rusage rusage_end;
+  getrusage(RUSAGE_SELF, &rusage_end);
+  auto to_us = [](const struct timeval& tv) {
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+  };
+  uint64_t process_cpu_us =
+      to_us(rusage_end.ru_utime) + to_us(rusage_end.ru_stime) -
+      to_us(rusage_start.ru_utime) - to_us(rusage_start.ru_stime);
+
+  LatencyStats to_controller;
+  LatencyStats controller;
+  LatencyStats end_to_end;
+  LatencyStats credit_stalls;
+  for (auto us : stats.credit_stalls_us) credit_stalls.Add(us);
+  uint64_t samples = 0;
+  uint64_t underruns = 0;
+  if (!stats.media.empty()) {
+    const auto& first = stats.media.front();
+    uint64_t playout_start_us = first.complete_us + config.sink_delay_ms * 1000;
+    for (const auto& packet : stats.media) {
+      uint64_t offset = (uint32_t)(packet.timestamp - first.timestamp);
+      uint64_t write_us = writer.WriteTimeUs(offset * kPcmBytesPerSample);
+      to_controller.Add(packet.received_us - write_us);
+      controller.Add(packet.complete_us - packet.received_us);
+      end_to_end.Add(packet.complete_us - write_us);
+      if (packet.complete_us >
+          playout_start_us + offset * 1000000 / kSampleRate) {
+        underruns++;
+      }
+      samples += packet.frames * kSamplesPerSbcFrame;
+    }
+  }
+  double audio_seconds = (double)samples / kSampleRate;
+
+  LOG_CONSOLE("credits:%u acl_size:%u slot_us:%u jitter_us:%u", config.credits,
+              config.acl_size, config.slot_us, config.jitter_us);
+  LOG_CONSOLE("pcm written:%.2fs received:%.2fs media_packets:%zu",
+              (double)writer.BytesWritten() / kPcmBytesPerSample / kSampleRate,
+              audio_seconds, stats.media.size());
+  LOG_CONSOLE("acl_packets:%llu credits_exhausted:%llu",
+              (unsigned long long)stats.acl_packets,
+              (unsigned long long)stats.credits_exhausted);
+  LOG_CONSOLE("to controller    %s", to_controller.ToString().c_str());
+  LOG_CONSOLE("controller       %s", controller.ToString().c_str());
+  LOG_CONSOLE("end to end       %s", end_to_end.ToString().c_str());
+  LOG_CONSOLE("credit stalls    %s", credit_stalls.ToString().c_str());
+  LOG_CONSOLE("underruns:%llu", (unsigned long long)underruns);
+  if (audio_seconds > 0) {
+    LOG_CONSOLE("cpu per second of audio process:%.2fms",
+                process_cpu_us / 1000.0 / audio_seconds);
+  }
+}
+
+// Plays the tone to the connected sink for |seconds|, as the audio server
+int stream(const Config& config, FakeSinkController& sink) {
+  mkdir(kAudioSocketDir, 0770);
+  audio::a2dp::SetAudioConfig({
+      .sample_rate = BTAV_A2DP_CODEC_SAMPLE_RATE_44100,
+      .bits_per_sample = BTAV_A2DP_CODEC_BITS_PER_SAMPLE_16,
+      .channel_mode = BTAV_A2DP_CODEC_CHANNEL_MODE_STEREO,
+  });
+  // The active device is set asynchronously
+  for (int i = 0; i < 50 && !audio::a2dp::StartRequest(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  if (!source_state.WaitFor(kStartTimeout, [](auto, auto audio) {
+        return audio == BTAV_AUDIO_STATE_STARTED;
+      })) {
+    LOG_CONSOLE("Unable to start the stream");
+    return -1;
+  }
+
+  PcmWriter writer;
+  if (!writer.Start()) {
+    audio::a2dp::StopRequest();
+    return -1;
+  }
+  struct rusage rusage_start;
+  getrusage(RUSAGE_SELF, &rusage_start);
+  sink.TakeStats();
+  std::this_thread::sleep_for(std::chrono::seconds(config.seconds));
+  btif_a2dp_source_debug_dump(console_fd);
+  writer.Stop();
+  audio::a2dp::StopRequest();
+  Report(config, sink.TakeStats(), writer, rusage_start);
+  return 0;
+}
+
+int stream_to_sink(const Config& config, FakeSinkController& sink) {
+  auto* source = reinterpret_cast<const btav_source_interface_t*>(
+      bluetoothInterface.get_profile_interface(BT_PROFILE_ADVANCED_AUDIO_ID));
+  std::vector<btav_a2dp_codec_info_t> supported_codecs;
+  if (source == nullptr ||
+      source->init(&source_callbacks, 1, {}, {}, &supported_codecs) !=
+          BT_STATUS_SUCCESS) {
+    LOG_CONSOLE("Unable to initialize the A2DP source");
+    return -1;
+  }
+
+  int rc = -1;
+  source->connect(kSinkAddress);
+  if (source_state.WaitFor(kConnectTimeout, [](auto connection, auto) {
+        return connection == BTAV_CONNECTION_STATE_CONNECTED;
+      })) {
+    source->set_active_device(kSinkAddress);
+    rc = stream(config, sink);
+  } else {
+    LOG_CONSOLE("Unable to connect to the sink");
+  }
+  source->disconnect(kSinkAddress);
+  source_state.WaitFor(kConnectTimeout, [](auto connection, auto) {
+    return connection == BTAV_CONNECTION_STATE_DISCONNECTED;
+  });
+  source->cleanup();
+  return rc;
+}
+
+#endif  // __ANDROID__
+
+}  // namespace
+
+// The controller is emulated on the H4 socket of the host HAL, so the
+// subcommand runs on host builds only.
+int bluetooth::test::headless::A2dp::Run() {
+  Config config;
+  if (!config.Parse(options_.non_options_)) {
+    LOG_CONSOLE("%s", kUsage);
+    return -1;
+  }
+
+#ifdef __ANDROID__
+  LOG_CONSOLE("a2dp streams to a fake controller, run it on a host build");
+  return -1;
+#else
+  FakeSinkController sink({
+      .sink_address = bluetooth::ToGdAddress(kSinkAddress),
+      .credits = static_cast<uint16_t>(config.credits),
+      .acl_size = static_cast<uint16_t>(config.acl_size),
+      .slot_us = config.slot_us,
+      .jitter_us = config.jitter_us,
+  });
+  uint16_t port = sink.Start();
+  if (port == 0) return -1;
+  hal::HciHalHostRootcanalConfig::Get()->SetPort(port);
+
+  int rc = RunOnHeadlessStack<int>(
+      [&config, &sink]() { return stream_to_sink(config, sink); });
+  sink.Stop();
+  return rc;
+#endif  // __ANDROID__
+}
@@ -0,0 +1,956 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "bt_headless_a2dp"
+
+#include "test/headless/a2dp/fake_sink_controller.h"
+
+#include <arpa/inet.h>
+#include <bluetooth/log.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "hci/hci_packets.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+namespace bluetooth {
+namespace test {
+namespace headless {
+
+namespace {
+
+using hci::ErrorCode;
+using hci::OpCode;
+
+// H4 packet types, see hal/hci_hal_host.cc
+constexpr uint8_t kH4Command = 0x01;
+constexpr uint8_t kH4Acl = 0x02;
+constexpr uint8_t kH4Sco = 0x03;
+constexpr uint8_t kH4Event = 0x04;
+constexpr uint8_t kH4Iso = 0x05;
+
+constexpr uint16_t kSinkHandle = 0x0001;
+constexpr uint8_t kControllerAddress[6] = {0x01, 0x00, 0x00, 0xad, 0xde, 0xc0};
+
+// ACL packet boundary flags
+constexpr uint8_t kContinuingFragment = 0x1;
+constexpr uint8_t kFirstAutomaticallyFlushable = 0x2;
+
+constexpr uint16_t kSignalingCid = 0x0001;
+constexpr uint16_t kPsmSdp = 0x0001;
+constexpr uint16_t kPsmAvdtp = 0x0019;
+constexpr uint16_t kSinkMtu = 1005;
+
+// BR/EDR with EDR, Secure Simple Pairing and LE
+constexpr uint64_t kFeatures =
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::LMP_3_SLOT_PACKETS) |
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::LMP_5_SLOT_PACKETS) |
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::ENCRYPTION) |
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::ROLE_SWITCH) |
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::SNIFF_MODE) |
+    static_cast<uint64_t>(
+        hci::LMPFeaturesPage0Bits::ENHANCED_DATA_RATE_ACL_2_MB_S_MODE) |
+    static_cast<uint64_t>(
+        hci::LMPFeaturesPage0Bits::ENHANCED_DATA_RATE_ACL_3_MB_S_MODE) |
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::LE_SUPPORTED_CONTROLLER) |
+    static_cast<uint64_t>(
+        hci::LMPFeaturesPage0Bits::SECURE_SIMPLE_PAIRING_CONTROLLER) |
+    static_cast<uint64_t>(hci::LMPFeaturesPage0Bits::EXTENDED_FEATURES);
+// Page 1: Secure Simple Pairing and LE supported by the host
+constexpr uint64_t kHostFeatures = 0x03;
+
+// AVDTP signals, see stack/avdt/avdt_int.h
+constexpr uint8_t kAvdtpDiscover = 0x01;
+constexpr uint8_t kAvdtpGetCapabilities = 0x02;
+constexpr uint8_t kAvdtpSetConfiguration = 0x03;
+constexpr uint8_t kAvdtpGetConfiguration = 0x04;
+constexpr uint8_t kAvdtpReconfigure = 0x05;
+constexpr uint8_t kAvdtpOpen = 0x06;
+constexpr uint8_t kAvdtpStart = 0x07;
+constexpr uint8_t kAvdtpClose = 0x08;
+constexpr uint8_t kAvdtpSuspend = 0x09;
+constexpr uint8_t kAvdtpAbort = 0x0a;
+constexpr uint8_t kAvdtpSecurityControl = 0x0b;
+constexpr uint8_t kAvdtpGetAllCapabilities = 0x0c;
+constexpr uint8_t kAvdtpDelayReport = 0x0d;
+
+constexpr uint8_t kAvdtpResponseAccept = 0x02;
+constexpr uint8_t kAvdtpGeneralReject = 0x01;
+
+// The only stream end point of the sink: SEID 1, audio, sink
+constexpr uint8_t kSinkSep[] = {0x01 << 2, 0x01 << 3};
+// Media transport, and SBC 44.1kHz joint stereo, 16 blocks, 8 subbands,
+// loudness, bitpool 2..53
+constexpr uint8_t kSinkCapabilities[] = {0x01, 0x00, 0x07, 0x06, 0x00, 0x00,
+                                         0x21, 0x15, 0x02, 0x35};
+
+// Services of the sink record, see HandleSdp()
+constexpr uint16_t kSdpUuids[] = {0x0019, 0x0100, 0x1002, 0x110b, 0x110d};
+
+uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint16_t Get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+uint16_t Get16Be(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+
+void Put16(std::vector<uint8_t>& v, uint16_t value) {
+  v.push_back(value & 0xff);
+  v.push_back(value >> 8);
+}
+
+void Put16Be(std::vector<uint8_t>& v, uint16_t value) {
+  v.push_back(value >> 8);
+  v.push_back(value & 0xff);
+}
+
+std::vector<uint8_t> Signal(uint8_t code, uint8_t id,
+                            const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> signal = {code, id};
+  Put16(signal, data.size());
+  signal.insert(signal.end(), data.begin(), data.end());
+  return signal;
+}
+
+// SDP data element sequence holding |elements|
+std::vector<uint8_t> Sequence(const std::vector<uint8_t>& elements) {
+  std::vector<uint8_t> sequence = {0x35, static_cast<uint8_t>(elements.size())};
+  sequence.insert(sequence.end(), elements.begin(), elements.end());
+  return sequence;
+}
+
+std::vector<uint8_t> Uuid16(uint16_t uuid) {
+  return {0x19, static_cast<uint8_t>(uuid >> 8),
+          static_cast<uint8_t>(uuid & 0xff)};
+}
+
+std::vector<uint8_t> Uint16(uint16_t value) {
+  return {0x09, static_cast<uint8_t>(value >> 8),
+          static_cast<uint8_t>(value & 0xff)};
+}
+
+std::vector<uint8_t> Concat(std::initializer_list<std::vector<uint8_t>> parts) {
+  std::vector<uint8_t> v;
+  for (const auto& part : parts) v.insert(v.end(), part.begin(), part.end());
+  return v;
+}
+
+// The A2DP sink record of the sink
+std::vector<uint8_t> SinkRecord() {
+  return Sequence(Concat({
+      Uint16(0x0000),  // ServiceRecordHandle
+      {0x0a, 0x00, 0x01, 0x00, 0x01},
+      Uint16(0x0001),  // ServiceClassIDList
+      Sequence(Uuid16(0x110b)),
+      Uint16(0x0004),  // ProtocolDescriptorList: L2CAP, AVDTP 1.3
+      Sequence(Concat({Sequence(Concat({Uuid16(0x0100), Uint16(kPsmAvdtp)})),
+                       Sequence(Concat({Uuid16(0x0019), Uint16(0x0103)}))})),
+      Uint16(0x0005),  // BrowseGroupList
+      Sequence(Uuid16(0x1002)),
+      Uint16(0x0009),  // BluetoothProfileDescriptorList: A2DP 1.3
+      Sequence(Sequence(Concat({Uuid16(0x110d), Uint16(0x0103)}))),
+      Uint16(0x0311),  // SupportedFeatures: headphone
+      Uint16(0x0001),
+  }));
+}
+
+// Whether the SDP search pattern at |data| matches the sink record
+bool MatchesSinkRecord(const uint8_t* data, size_t len) {
+  if (len < 2 || data[0] != 0x35) return false;
+  size_t end = std::min(len, static_cast<size_t>(2 + data[1]));
+  for (size_t i = 2; i < end;) {
+    uint16_t uuid;
+    size_t size;
+    switch (data[i]) {
+      case 0x19:
+        size = 2;
+        break;
+      case 0x1a:
+        size = 4;
+        break;
+      case 0x1c:
+        size = 16;
+        break;
+      default:
+        return false;
+    }
+    if (i + 1 + size > end) return false;
+    // 32 and 128 bit UUIDs derived from the base UUID
+    uuid = Get16Be(&data[i + 1 + (size == 2 ? 0 : 2)]);
+    if (std::find(std::begin(kSdpUuids), std::end(kSdpUuids), uuid) !=
+        std::end(kSdpUuids)) {
+      return true;
+    }
+    i += 1 + size;
+  }
+  return false;
+}
+
+// Commands answered with Command Status, among the ones the stack may send
+bool IsStatusCommand(OpCode op_code) {
+  switch (op_code) {
+    case OpCode::INQUIRY:
+    case OpCode::CREATE_CONNECTION:
+    case OpCode::DISCONNECT:
+    case OpCode::ADD_SCO_CONNECTION:
+    case OpCode::ACCEPT_CONNECTION_REQUEST:
+    case OpCode::REJECT_CONNECTION_REQUEST:
+    case OpCode::CHANGE_CONNECTION_PACKET_TYPE:
+    case OpCode::AUTHENTICATION_REQUESTED:
+    case OpCode::SET_CONNECTION_ENCRYPTION:
+    case OpCode::CHANGE_CONNECTION_LINK_KEY:
+    case OpCode::CENTRAL_LINK_KEY:
+    case OpCode::REMOTE_NAME_REQUEST:
+    case OpCode::READ_REMOTE_SUPPORTED_FEATURES:
+    case OpCode::READ_REMOTE_EXTENDED_FEATURES:
+    case OpCode::READ_REMOTE_VERSION_INFORMATION:
+    case OpCode::READ_CLOCK_OFFSET:
+    case OpCode::SETUP_SYNCHRONOUS_CONNECTION:
+    case OpCode::ACCEPT_SYNCHRONOUS_CONNECTION:
+    case OpCode::REJECT_SYNCHRONOUS_CONNECTION:
+    case OpCode::ENHANCED_SETUP_SYNCHRONOUS_CONNECTION:
+    case OpCode::ENHANCED_ACCEPT_SYNCHRONOUS_CONNECTION:
+    case OpCode::TRUNCATED_PAGE:
+    case OpCode::HOLD_MODE:
+    case OpCode::SNIFF_MODE:
+    case OpCode::EXIT_SNIFF_MODE:
+    case OpCode::PARK_STATE:
+    case OpCode::EXIT_PARK_STATE:
+    case OpCode::QOS_SETUP:
+    case OpCode::SWITCH_ROLE:
+    case OpCode::FLOW_SPECIFICATION:
+    case OpCode::REFRESH_ENCRYPTION_KEY:
+    case OpCode::LE_CREATE_CONNECTION:
+    case OpCode::LE_CONNECTION_UPDATE:
+    case OpCode::LE_READ_REMOTE_FEATURES:
+    case OpCode::LE_START_ENCRYPTION:
+    case OpCode::LE_READ_LOCAL_P_256_PUBLIC_KEY:
+    case OpCode::LE_GENERATE_DHKEY_V1:
+    case OpCode::LE_GENERATE_DHKEY_V2:
+    case OpCode::LE_SET_PHY:
+    case OpCode::LE_EXTENDED_CREATE_CONNECTION:
+    case OpCode::LE_PERIODIC_ADVERTISING_CREATE_SYNC:
+    case OpCode::LE_CREATE_CIS:
+    case OpCode::LE_ACCEPT_CIS_REQUEST:
+    case OpCode::LE_CREATE_BIG:
+    case OpCode::LE_TERMINATE_BIG:
+    case OpCode::LE_BIG_CREATE_SYNC:
+    case OpCode::LE_REQUEST_PEER_SCA:
+    case OpCode::LE_READ_REMOTE_TRANSMIT_POWER_LEVEL:
+    case OpCode::LE_SUBRATE_REQUEST:
+    case OpCode::LE_CS_READ_REMOTE_SUPPORTED_CAPABILITIES:
+    case OpCode::LE_CS_SECURITY_ENABLE:
+    case OpCode::LE_CS_CREATE_CONFIG:
+    case OpCode::LE_CS_REMOVE_CONFIG:
+    case OpCode::LE_CS_READ_REMOTE_FAE_TABLE:
+    case OpCode::LE_CS_PROCEDURE_ENABLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+FakeSinkController::FakeSinkController(const Config& config)
+    : config_(config) {}
+
+FakeSinkController::~FakeSinkController() { Stop(); }
+
+uint16_t FakeSinkController::Start() {
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    log::error("Unable to create socket: {}", strerror(errno));
+    return 0;
+  }
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t addr_len = sizeof(addr);
+  if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr),
+           sizeof(addr)) < 0 ||
+      listen(listen_fd_, 1) < 0 ||
+      getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr),
+                  &addr_len) < 0) {
+    log::error("Unable to listen: {}", strerror(errno));
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return 0;
+  }
+  stopping_ = false;
+  thread_ = std::thread(&FakeSinkController::Loop, this);
+  return ntohs(addr.sin_port);
+}
+
+void FakeSinkController::Stop() {
+  if (!thread_.joinable()) return;
+  stopping_ = true;
+  thread_.join();
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+  close(listen_fd_);
+  listen_fd_ = -1;
+}
+
+FakeSinkController::Stats FakeSinkController::TakeStats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  Stats stats = std::move(stats_);
+  stats_ = Stats();
+  return stats;
+}
+
+void FakeSinkController::Loop() {
+  while (!stopping_) {
+    // Wakes up for the next completion, and at least every 100ms to notice
+    // Stop()
+    uint64_t timeout_us = 100000;
+    if (!in_flight_.empty()) {
+      uint64_t now = now_us();
+      timeout_us = std::min(
+          timeout_us, in_flight_.front() > now ? in_flight_.front() - now : 0);
+    }
+    struct timespec timeout = {0, static_cast<long>(timeout_us * 1000)};
+    struct pollfd pfd = {fd_ >= 0 ? fd_ : listen_fd_, POLLIN, 0};
+    int rc = ppoll(&pfd, 1, &timeout, nullptr);
+    if (rc < 0 && errno != EINTR) {
+      log::error("Unable to poll: {}", strerror(errno));
+      return;
+    }
+
+    if (rc > 0 && fd_ < 0) {
+      // The HAL of a new stack
+      fd_ = accept(listen_fd_, nullptr, nullptr);
+      if (fd_ >= 0) {
+        int flag = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+      }
+      rx_.clear();
+      Reset();
+    } else if (rc > 0) {
+      uint8_t buffer[4096];
+      ssize_t n = read(fd_, buffer, sizeof(buffer));
+      if (n <= 0) {
+        close(fd_);
+        fd_ = -1;
+        rx_.clear();
+        Reset();
+        continue;
+      }
+      rx_.insert(rx_.end(), buffer, buffer + n);
+      HandlePackets();
+    }
+    if (fd_ >= 0) CompletePackets(now_us());
+  }
+}
+
+void FakeSinkController::Reset() {
+  handle_ = 0;
+  pdu_.clear();
+  channels_.clear();
+  next_cid_ = 0x0040;
+  stream_configuration_.clear();
+  in_flight_.clear();
+  link_free_us_ = 0;
+  credits_exhausted_us_ = 0;
+}
+
+void FakeSinkController::HandlePackets() {
+  while (!rx_.empty()) {
+    size_t header_size;
+    size_t payload_size;
+    switch (rx_[0]) {
+      case kH4Command:
+      case kH4Sco:
+        header_size = 3;
+        if (rx_.size() < 1 + header_size) return;
+        payload_size = rx_[3];
+        break;
+      case kH4Acl:
+        header_size = 4;
+        if (rx_.size() < 1 + header_size) return;
+        payload_size = Get16(&rx_[3]);
+        break;
+      case kH4Iso:
+        header_size = 4;
+        if (rx_.size() < 1 + header_size) return;
+        payload_size = Get16(&rx_[3]) & 0x3fff;
+        break;
+      default:
+        log::error("Unexpected H4 packet type {}", rx_[0]);
+        rx_.clear();
+        return;
+    }
+    size_t size = 1 + header_size + payload_size;
+    if (rx_.size() < size) return;
+    if (rx_[0] == kH4Command) {
+      HandleCommand(&rx_[1], size - 1);
+    } else if (rx_[0] == kH4Acl) {
+      HandleAcl(&rx_[1], size - 1);
+    }
+    rx_.erase(rx_.begin(), rx_.begin() + size);
+  }
+}
+
+void FakeSinkController::HandleCommand(const uint8_t* data, size_t len) {
+  auto op_code = static_cast<OpCode>(Get16(data));
+  const uint8_t* params = data + 3;
+  size_t params_len = len - 3;
+  auto status = [this, op_code](ErrorCode error) {
+    SendEvent(hci::CommandStatusBuilder::Create(
+        error, 1, op_code, std::make_unique<packet::RawBuilder>()));
+  };
+  auto address = [params, params_len]() {
+    uint8_t bytes[hci::Address::kLength] = {};
+    std::copy(params, params + std::min(params_len, sizeof(bytes)), bytes);
+    return hci::Address(bytes);
+  };
+  bool connected_handle =
+      handle_ != 0 && params_len >= 2 && (Get16(params) & 0x0fff) == handle_;
+
+  switch (op_code) {
+    case OpCode::RESET:
+      Reset();
+      break;
+    case OpCode::READ_LOCAL_VERSION_INFORMATION: {
+      hci::LocalVersionInformation version;
+      version.hci_version_ = hci::HciVersion::V_5_0;
+      version.hci_revision_ = 0;
+      version.lmp_version_ = hci::LmpVersion::V_5_0;
+      version.manufacturer_name_ = 0xffff;
+      version.lmp_subversion_ = 0;
+      SendEvent(hci::ReadLocalVersionInformationCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, version));
+      return;
+    }
+    case OpCode::READ_LOCAL_SUPPORTED_COMMANDS: {
+      std::array<uint8_t, 64> commands{};
+      std::fill(commands.begin(), commands.begin() + 37, 0xff);
+      SendEvent(hci::ReadLocalSupportedCommandsCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, commands));
+      return;
+    }
+    case OpCode::READ_LOCAL_SUPPORTED_FEATURES:
+      SendEvent(hci::ReadLocalSupportedFeaturesCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, kFeatures));
+      return;
+    case OpCode::READ_LOCAL_EXTENDED_FEATURES: {
+      uint8_t page = params_len >= 1 ? params[0] : 0;
+      SendEvent(hci::ReadLocalExtendedFeaturesCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, page, 1,
+          page == 0 ? kFeatures : (page == 1 ? kHostFeatures : 0)));
+      return;
+    }
+    case OpCode::READ_BUFFER_SIZE:
+      SendEvent(hci::ReadBufferSizeCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, config_.acl_size, 0, config_.credits, 0));
+      return;
+    case OpCode::LE_READ_BUFFER_SIZE_V1: {
+      // Dedicated LE buffers, the stack would take half of the ACL ones
+      hci::LeBufferSize le_buffer_size;
+      le_buffer_size.le_data_packet_length_ = 251;
+      le_buffer_size.total_num_le_packets_ = 8;
+      SendEvent(hci::LeReadBufferSizeV1CompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, le_buffer_size));
+      return;
+    }
+    case OpCode::READ_BD_ADDR:
+      SendEvent(hci::ReadBdAddrCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, hci::Address(kControllerAddress)));
+      return;
+    case OpCode::LE_READ_FILTER_ACCEPT_LIST_SIZE:
+      SendEvent(hci::LeReadFilterAcceptListSizeCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, 8));
+      return;
+    case OpCode::LE_READ_RESOLVING_LIST_SIZE:
+      SendEvent(hci::LeReadResolvingListSizeCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, 8));
+      return;
+    case OpCode::LE_READ_NUMBER_OF_SUPPORTED_ADVERTISING_SETS:
+      SendEvent(
+          hci::LeReadNumberOfSupportedAdvertisingSetsCompleteBuilder::Create(
+              1, ErrorCode::SUCCESS, 4));
+      return;
+    case OpCode::LE_READ_MAXIMUM_ADVERTISING_DATA_LENGTH:
+      SendEvent(hci::LeReadMaximumAdvertisingDataLengthCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, 251));
+      return;
+    case OpCode::LE_RAND:
+      SendEvent(hci::LeRandCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS,
+          (static_cast<uint64_t>(rng_()) << 32) | rng_()));
+      return;
+
+    // Paging and pairing of the sink
+    case OpCode::CREATE_CONNECTION: {
+      status(ErrorCode::SUCCESS);
+      hci::Address peer = address();
+      if (peer != config_.sink_address || handle_ != 0) {
+        SendEvent(hci::ConnectionCompleteBuilder::Create(
+            ErrorCode::PAGE_TIMEOUT, 0, peer, hci::LinkType::ACL,
+            hci::Enable::DISABLED));
+        return;
+      }
+      handle_ = kSinkHandle;
+      SendEvent(hci::ConnectionCompleteBuilder::Create(
+          ErrorCode::SUCCESS, handle_, peer, hci::LinkType::ACL,
+          hci::Enable::DISABLED));
+      return;
+    }
+    case OpCode::REMOTE_NAME_REQUEST: {
+      status(ErrorCode::SUCCESS);
+      hci::Address peer = address();
+      std::array<uint8_t, 248> name{};
+      constexpr char kName[] = "Headless A2DP sink";
+      std::copy(std::begin(kName), std::end(kName), name.begin());
+      SendEvent(hci::RemoteNameRequestCompleteBuilder::Create(
+          peer == config_.sink_address ? ErrorCode::SUCCESS
+                                       : ErrorCode::PAGE_TIMEOUT,
+          peer, name));
+      return;
+    }
+    case OpCode::READ_REMOTE_SUPPORTED_FEATURES:
+      if (!connected_handle) break;
+      status(ErrorCode::SUCCESS);
+      SendEvent(hci::ReadRemoteSupportedFeaturesCompleteBuilder::Create(
+          ErrorCode::SUCCESS, handle_, kFeatures));
+      return;
+    case OpCode::READ_REMOTE_EXTENDED_FEATURES: {
+      if (!connected_handle || params_len < 3) break;
+      status(ErrorCode::SUCCESS);
+      uint8_t page = params[2];
+      SendEvent(hci::ReadRemoteExtendedFeaturesCompleteBuilder::Create(
+          ErrorCode::SUCCESS, handle_, page, 1,
+          page == 0 ? kFeatures : (page == 1 ? kHostFeatures : 0)));
+      return;
+    }
+    case OpCode::READ_REMOTE_VERSION_INFORMATION:
+      if (!connected_handle) break;
+      status(ErrorCode::SUCCESS);
+      SendEvent(hci::ReadRemoteVersionInformationCompleteBuilder::Create(
+          ErrorCode::SUCCESS, handle_,
+          static_cast<uint8_t>(hci::LmpVersion::V_5_0), 0xffff, 0));
+      return;
+    case OpCode::READ_CLOCK_OFFSET:
+      if (!connected_handle) break;
+      status(ErrorCode::SUCCESS);
+      SendEvent(hci::ReadClockOffsetCompleteBuilder::Create(ErrorCode::SUCCESS,
+                                                            handle_, 0));
+      return;
+    case OpCode::AUTHENTICATION_REQUESTED:
+      if (!connected_handle) break;
+      status(ErrorCode::SUCCESS);
+      SendEvent(hci::LinkKeyRequestBuilder::Create(config_.sink_address));
+      return;
+    case OpCode::LINK_KEY_REQUEST_REPLY:
+      SendEvent(hci::LinkKeyRequestReplyCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, address()));
+      SendEvent(hci::AuthenticationCompleteBuilder::Create(ErrorCode::SUCCESS,
+                                                           handle_));
+      return;
+    case OpCode::LINK_KEY_REQUEST_NEGATIVE_REPLY:
+      // Pairs again with Just Works: the sink has no input nor output
+      SendEvent(hci::LinkKeyRequestNegativeReplyCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, address()));
+      SendEvent(hci::IoCapabilityRequestBuilder::Create(config_.sink_address));
+      return;
+    case OpCode::IO_CAPABILITY_REQUEST_REPLY:
+      SendEvent(hci::IoCapabilityRequestReplyCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, address()));
+      SendEvent(hci::IoCapabilityResponseBuilder::Create(
+          config_.sink_address, hci::IoCapability::NO_INPUT_NO_OUTPUT,
+          hci::OobDataPresent::NOT_PRESENT,
+          hci::AuthenticationRequirements::NO_BONDING));
+      SendEvent(
+          hci::UserConfirmationRequestBuilder::Create(config_.sink_address, 0));
+      return;
+    case OpCode::USER_CONFIRMATION_REQUEST_REPLY: {
+      SendEvent(hci::UserConfirmationRequestReplyCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, address()));
+      std::array<uint8_t, 16> link_key;
+      std::generate(link_key.begin(), link_key.end(), std::ref(rng_));
+      SendEvent(hci::SimplePairingCompleteBuilder::Create(
+          ErrorCode::SUCCESS, config_.sink_address));
+      SendEvent(hci::LinkKeyNotificationBuilder::Create(
+          config_.sink_address, link_key,
+          hci::KeyType::UNAUTHENTICATED_P192));
+      SendEvent(hci::AuthenticationCompleteBuilder::Create(ErrorCode::SUCCESS,
+                                                           handle_));
+      return;
+    }
+    case OpCode::USER_CONFIRMATION_REQUEST_NEGATIVE_REPLY:
+      SendEvent(
+          hci::UserConfirmationRequestNegativeReplyCompleteBuilder::Create(
+              1, ErrorCode::SUCCESS, address()));
+      SendEvent(hci::SimplePairingCompleteBuilder::Create(
+          ErrorCode::AUTHENTICATION_FAILURE, config_.sink_address));
+      SendEvent(hci::AuthenticationCompleteBuilder::Create(
+          ErrorCode::AUTHENTICATION_FAILURE, handle_));
+      return;
+    case OpCode::SET_CONNECTION_ENCRYPTION:
+      if (!connected_handle) break;
+      status(ErrorCode::SUCCESS);
+      SendEvent(hci::EncryptionChangeBuilder::Create(
+          ErrorCode::SUCCESS, handle_, hci::EncryptionEnabled::ON));
+      return;
+    case OpCode::READ_ENCRYPTION_KEY_SIZE:
+      if (!connected_handle) break;
+      SendEvent(hci::ReadEncryptionKeySizeCompleteBuilder::Create(
+          1, ErrorCode::SUCCESS, handle_, 16));
+      return;
+    case OpCode::DISCONNECT: {
+      if (!connected_handle) break;
+      status(ErrorCode::SUCCESS);
+      uint16_t handle = handle_;
+      Reset();
+      SendEvent(hci::DisconnectionCompleteBuilder::Create(
+          ErrorCode::SUCCESS, handle,
+          ErrorCode::CONNECTION_TERMINATED_BY_LOCAL_HOST));
+      return;
+    }
+    default:
+      break;
+  }
+
+  if ((Get16(data) >> 10) == 0x3f) {
+    // Vendor capabilities are read as unsupported, see hci/hci_layer.cc
+    status(ErrorCode::UNKNOWN_HCI_COMMAND);
+  } else if (IsStatusCommand(op_code)) {
+    // Sniff mode, role switch, LE connections...
+    status(connected_handle || handle_ == 0 ? ErrorCode::COMMAND_DISALLOWED
+                                            : ErrorCode::UNKNOWN_CONNECTION);
+  } else {
+    // Parameters read back by the stack are zero
+    auto payload = std::make_unique<packet::RawBuilder>();
+    payload->AddOctets1(static_cast<uint8_t>(ErrorCode::SUCCESS));
+    payload->AddOctets(std::vector<uint8_t>(251, 0));
+    SendEvent(hci::CommandCompleteBuilder::Create(1, op_code,
+                                                  std::move(payload)));
+  }
+}
+
+void FakeSinkController::HandleAcl(const uint8_t* data, size_t len) {
+  uint16_t handle = Get16(data) & 0x0fff;
+  uint8_t boundary = (Get16(data) >> 12) & 0x3;
+  if (handle != handle_) return;
+
+  // The packet holds a controller buffer until it is sent over the air
+  uint64_t now = now_us();
+  uint64_t jitter =
+      config_.jitter_us == 0 ? 0 : rng_() % (config_.jitter_us + 1);
+  link_free_us_ = std::max(link_free_us_, now) + config_.slot_us + jitter;
+  in_flight_.push_back(link_free_us_);
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.acl_packets++;
+    if (in_flight_.size() >= config_.credits) stats_.credits_exhausted++;
+  }
+  if (in_flight_.size() >= config_.credits && credits_exhausted_us_ == 0) {
+    credits_exhausted_us_ = now;
+  }
+
+  if (boundary == kContinuingFragment) {
+    if (pdu_.empty()) return;
+    pdu_.insert(pdu_.end(), data + 4, data + len);
+  } else {
+    pdu_.assign(data + 4, data + len);
+    pdu_received_us_ = now;
+  }
+  if (pdu_.size() < 4 || pdu_.size() < 4u + Get16(pdu_.data())) return;
+  std::vector<uint8_t> pdu = std::move(pdu_);
+  pdu_.clear();
+  HandleL2cap(handle, pdu, pdu_received_us_, link_free_us_);
+}
+
+void FakeSinkController::HandleL2cap(uint16_t handle,
+                                     const std::vector<uint8_t>& pdu,
+                                     uint64_t received_us,
+                                     uint64_t complete_us) {
+  uint16_t cid = Get16(&pdu[2]);
+  const uint8_t* payload = pdu.data() + 4;
+  size_t payload_len = Get16(pdu.data());
+  if (cid == kSignalingCid) {
+    HandleSignaling(handle, payload, payload_len);
+    return;
+  }
+  auto channel = channels_.find(cid);
+  if (channel == channels_.end()) return;
+  if (channel->second.psm == kPsmSdp) {
+    HandleSdp(handle, channel->second, payload, payload_len);
+  } else if (channel->second.media) {
+    HandleMedia(payload, payload_len, received_us, complete_us);
+  } else {
+    HandleAvdtp(handle, channel->second, payload, payload_len);
+  }
+}
+
+void FakeSinkController::HandleSignaling(uint16_t handle, const uint8_t* data,
+                                         size_t len) {
+  for (size_t offset = 0; offset + 4 <= len;) {
+    uint8_t code = data[offset];
+    uint8_t id = data[offset + 1];
+    size_t signal_len = Get16(&data[offset + 2]);
+    const uint8_t* p = &data[offset + 4];
+    offset += 4 + signal_len;
+    if (offset > len) return;
+
+    std::vector<uint8_t> rsp;
+    switch (code) {
+      case 0x02: {  // Connection Request
+        if (signal_len < 4) return;
+        uint16_t psm = Get16(p);
+        uint16_t scid = Get16(p + 2);
+        if (psm != kPsmSdp && psm != kPsmAvdtp) {
+          Put16(rsp, 0);
+          Put16(rsp, scid);
+          Put16(rsp, 0x0002);  // PSM not supported
+          Put16(rsp, 0);
+          SendL2cap(handle, kSignalingCid, Signal(0x03, id, rsp));
+          break;
+        }
+        // The second AVDTP channel carries the media of the stream
+        bool media = false;
+        for (const auto& [cid, channel] : channels_) {
+          media |= channel.psm == kPsmAvdtp && !channel.media;
+        }
+        uint16_t local_cid = next_cid_++;
+        channels_[local_cid] = Channel{psm, scid, psm == kPsmAvdtp && media};
+        Put16(rsp, local_cid);
+        Put16(rsp, scid);
+        Put16(rsp, 0);
+        Put16(rsp, 0);
+        SendL2cap(handle, kSignalingCid, Signal(0x03, id, rsp));
+
+        std::vector<uint8_t> req;
+        Put16(req, scid);
+        Put16(req, 0);
+        req.push_back(0x01);  // MTU
+        req.push_back(2);
+        Put16(req, kSinkMtu);
+        SendL2cap(handle, kSignalingCid, Signal(0x04, next_signal_id_++, req));
+        break;
+      }
+      case 0x04: {  // Configuration Request
+        if (signal_len < 4) return;
+        auto channel = channels_.find(Get16(p));
+        if (channel == channels_.end()) break;
+        Put16(rsp, channel->second.remote_cid);
+        Put16(rsp, 0);
+        Put16(rsp, 0);  // Success
+        SendL2cap(handle, kSignalingCid, Signal(0x05, id, rsp));
+        break;
+      }
+      case 0x06: {  // Disconnection Request
+        if (signal_len < 4) return;
+        channels_.erase(Get16(p));
+        rsp.assign(p, p + 4);
+        SendL2cap(handle, kSignalingCid, Signal(0x07, id, rsp));
+        break;
+      }
+      case 0x08:  // Echo Request
+        rsp.assign(p, p + signal_len);
+        SendL2cap(handle, kSignalingCid, Signal(0x09, id, rsp));
+        break;
+      case 0x0a: {  // Information Request
+        if (signal_len < 2) return;
+        uint16_t type = Get16(p);
+        Put16(rsp, type);
+        if (type == 0x0002) {  // Extended features: none
+          Put16(rsp, 0);
+          Put16(rsp, 0);
+          Put16(rsp, 0);
+        } else if (type == 0x0003) {  // Fixed channels: signaling
+          Put16(rsp, 0);
+          rsp.insert(rsp.end(), {0x02, 0, 0, 0, 0, 0, 0, 0});
+        } else {
+          Put16(rsp, 0x0001);  // Not supported
+        }
+        SendL2cap(handle, kSignalingCid, Signal(0x0b, id, rsp));
+        break;
+      }
+      case 0x01:  // Command Reject
+      case 0x03:  // Connection Response
+      case 0x05:  // Configuration Response
+      case 0x07:  // Disconnection Response
+      case 0x0b:  // Information Response
+        break;
+      default:
+        Put16(rsp, 0);  // Command not understood
+        SendL2cap(handle, kSignalingCid, Signal(0x01, id, rsp));
+        break;
+    }
+  }
+}
+
+void FakeSinkController::HandleSdp(uint16_t handle, const Channel& channel,
+                                   const uint8_t* data, size_t len) {
+  if (len < 5) return;
+  uint8_t pdu_id = data[0];
+  uint16_t transaction_id = Get16Be(data + 1);
+  bool match = MatchesSinkRecord(data + 5, len - 5);
+
+  std::vector<uint8_t> params;
+  uint8_t rsp_id;
+  if (pdu_id == 0x06) {  // Service Search Attribute
+    rsp_id = 0x07;
+    auto lists = Sequence(match ? SinkRecord() : std::vector<uint8_t>());
+    Put16Be(params, lists.size());
+    params.insert(params.end(), lists.begin(), lists.end());
+  } else if (pdu_id == 0x02) {  // Service Search
+    rsp_id = 0x03;
+    Put16Be(params, match ? 1 : 0);
+    Put16Be(params, match ? 1 : 0);
+    if (match) params.insert(params.end(), {0x00, 0x01, 0x00, 0x01});
+  } else if (pdu_id == 0x04) {  // Service Attribute, of the only record
+    rsp_id = 0x05;
+    auto record = SinkRecord();
+    Put16Be(params, record.size());
+    params.insert(params.end(), record.begin(), record.end());
+  } else {
+    rsp_id = 0x01;  // Error: invalid request syntax
+    Put16Be(params, 0x0003);
+  }
+  if (rsp_id != 0x01) params.push_back(0x00);  // No continuation
+
+  std::vector<uint8_t> rsp = {rsp_id};
+  Put16Be(rsp, transaction_id);
+  Put16Be(rsp, params.size());
+  rsp.insert(rsp.end(), params.begin(), params.end());
+  SendL2cap(handle, channel.remote_cid, rsp);
+}
+
+void FakeSinkController::HandleAvdtp(uint16_t handle, const Channel& channel,
+                                     const uint8_t* data, size_t len) {
+  // Single packet commands only, the stack sends no fragmented signal
+  if (len < 2 || (data[0] & 0x0f) != 0) return;
+  uint8_t label = data[0] >> 4;
+  uint8_t signal = data[1] & 0x3f;
+
+  std::vector<uint8_t> rsp = {
+      static_cast<uint8_t>((label << 4) | kAvdtpResponseAccept), signal};
+  switch (signal) {
+    case kAvdtpDiscover:
+      rsp.insert(rsp.end(), std::begin(kSinkSep), std::end(kSinkSep));
+      break;
+    case kAvdtpGetCapabilities:
+    case kAvdtpGetAllCapabilities:
+      rsp.insert(rsp.end(), std::begin(kSinkCapabilities),
+                 std::end(kSinkCapabilities));
+      break;
+    case kAvdtpSetConfiguration:
+      if (len > 4) stream_configuration_.assign(data + 4, data + len);
+      break;
+    case kAvdtpGetConfiguration:
+      rsp.insert(rsp.end(), stream_configuration_.begin(),
+                 stream_configuration_.end());
+      break;
+    case kAvdtpReconfigure:
+    case kAvdtpOpen:
+    case kAvdtpStart:
+    case kAvdtpClose:
+    case kAvdtpSuspend:
+    case kAvdtpAbort:
+    case kAvdtpSecurityControl:
+    case kAvdtpDelayReport:
+      break;
+    default:
+      rsp = {static_cast<uint8_t>((label << 4) | kAvdtpGeneralReject), signal};
+      break;
+  }
+  SendL2cap(handle, channel.remote_cid, rsp);
+}
+
+void FakeSinkController::HandleMedia(const uint8_t* data, size_t len,
+                                     uint64_t received_us,
+                                     uint64_t complete_us) {
+  // RTP header with its contributing sources, then the SBC media header
+  if (len < 12) return;
+  size_t header_size = 12 + 4 * (data[0] & 0x0f);
+  if (len <= header_size) return;
+  uint32_t timestamp = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) |
+                       static_cast<uint32_t>(data[7]);
+  uint8_t frames = data[header_size] & 0x0f;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_.media.push_back({timestamp, frames, received_us, complete_us});
+}
+
+void FakeSinkController::CompletePackets(uint64_t now) {
+  uint16_t completed = 0;
+  while (!in_flight_.empty() && in_flight_.front() <= now) {
+    in_flight_.pop_front();
+    completed++;
+  }
+  if (completed == 0) return;
+  if (credits_exhausted_us_ != 0) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.credit_stalls_us.push_back(now - credits_exhausted_us_);
+    credits_exhausted_us_ = 0;
+  }
+  hci::CompletedPackets packets;
+  packets.connection_handle_ = handle_;
+  packets.host_num_of_completed_packets_ = completed;
+  SendEvent(hci::NumberOfCompletedPacketsBuilder::Create({packets}));
+}
+
+void FakeSinkController::SendEvent(
+    std::unique_ptr<packet::BasePacketBuilder> event) {
+  std::vector<uint8_t> bytes;
+  packet::BitInserter inserter(bytes);
+  event->Serialize(inserter);
+  Send(kH4Event, bytes);
+}
+
+void FakeSinkController::SendL2cap(uint16_t handle, uint16_t cid,
+                                   const std::vector<uint8_t>& payload) {
+  // Signals and SDP responses fit in one packet of the default host buffers
+  std::vector<uint8_t> acl;
+  Put16(acl, handle | (kFirstAutomaticallyFlushable << 12));
+  Put16(acl, payload.size() + 4);
+  Put16(acl, payload.size());
+  Put16(acl, cid);
+  acl.insert(acl.end(), payload.begin(), payload.end());
+  Send(kH4Acl, acl);
+}
+
+void FakeSinkController::Send(uint8_t type,
+                              const std::vector<uint8_t>& packet) {
+  std::vector<uint8_t> bytes = {type};
+  bytes.insert(bytes.end(), packet.begin(), packet.end());
+  for (size_t offset = 0; offset < bytes.size();) {
+    ssize_t n = write(fd_, bytes.data() + offset, bytes.size() - offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      log::warn("Unable to send to the HAL: {}", strerror(errno));
+      return;
+    }
+    offset += n;
+  }
+}
+
+}  // namespace headless
+}  // namespace test
+}  // namespace bluetooth
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "hci/address.h"
+#include "packet/base_packet_builder.h"
+
+namespace bluetooth {
+namespace test {
+namespace headless {
+
+// A controller with an A2DP sink in range, served to the stack over the H4
+// socket of the host HCI HAL (see hal/hci_hal_host.h) in place of rootcanal.
+//
+// The controller answers the commands of the stack and pages the sink, which
+// pairs with Just Works and plays the accepting side of L2CAP, SDP and AVDTP.
+// Each ACL packet of the stack holds one of |credits| controller buffers for
+// |slot_us| of air time, plus up to |jitter_us| of random delay standing for
+// retransmissions, before Number Of Completed Packets returns it.
+class FakeSinkController {
+ public:
+  struct Config {
+    hci::Address sink_address;
+    uint16_t credits;
+    uint16_t acl_size;
+    uint32_t slot_us;
+    uint32_t jitter_us;
+  };
+
+  // A media packet received by the sink, times are in microseconds of
+  // std::chrono::steady_clock
+  struct MediaPacket {
+    uint32_t timestamp;    // RTP timestamp, in samples
+    uint8_t frames;        // SBC frames
+    uint64_t received_us;  // first ACL packet received from the stack
+    uint64_t complete_us;  // last ACL packet sent over the air
+  };
+
+  struct Stats {
+    uint64_t acl_packets{0};
+    // ACL packets which took the last free controller buffer
+    uint64_t credits_exhausted{0};
+    // How long the stack was left without credits, each time it was: from the
+    // ACL packet taking the last free buffer to the Number Of Completed
+    // Packets returning one
+    std::vector<uint64_t> credit_stalls_us;
+    std::vector<MediaPacket> media;
+  };
+
+  explicit FakeSinkController(const Config& config);
+  ~FakeSinkController();
+
+  // Listens on a local port for the HAL, returns the port or 0 on failure.
+  // The HAL connects again each time the stack is enabled.
+  uint16_t Start();
+  void Stop();
+
+  // Returns the statistics gathered since the previous call
+  Stats TakeStats();
+
+ private:
+  struct Channel {
+    uint16_t psm;
+    uint16_t remote_cid;
+    bool media;
+  };
+
+  void Loop();
+  void Reset();
+  void HandlePackets();
+  void HandleCommand(const uint8_t* data, size_t len);
+  void HandleAcl(const uint8_t* data, size_t len);
+  void HandleL2cap(uint16_t handle, const std::vector<uint8_t>& pdu,
+                   uint64_t received_us, uint64_t complete_us);
+  void HandleSignaling(uint16_t handle, const uint8_t* data, size_t len);
+  void HandleSdp(uint16_t handle, const Channel& channel, const uint8_t* data,
+                 size_t len);
+  void HandleAvdtp(uint16_t handle, const Channel& channel, const uint8_t* data,
+                   size_t len);
+  void HandleMedia(const uint8_t* data, size_t len, uint64_t received_us,
+                   uint64_t complete_us);
+  void CompletePackets(uint64_t now_us);
+
+  void SendEvent(std::unique_ptr<packet::BasePacketBuilder> event);
+  void SendL2cap(uint16_t handle, uint16_t cid,
+                 const std::vector<uint8_t>& payload);
+  void Send(uint8_t type, const std::vector<uint8_t>& packet);
+
+  const Config config_;
+  int listen_fd_{-1};
+  int fd_{-1};
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+  std::mt19937 rng_{0};
+  std::vector<uint8_t> rx_;
+
+  // Link to the sink, only used on |thread_|
+  uint16_t handle_{0};
+  std::vector<uint8_t> pdu_;
+  uint64_t pdu_received_us_{0};
+  std::map<uint16_t, Channel> channels_;
+  uint16_t next_cid_{0x0040};
+  uint8_t next_signal_id_{1};
+  std::vector<uint8_t> stream_configuration_;
+
+  // Completion times of the ACL packets holding a controller buffer
+  std::deque<uint64_t> in_flight_;
+  uint64_t link_free_us_{0};
+  // When the controller buffers were all taken, 0 while one is free
+  uint64_t credits_exhausted_us_{0};
+
+  std::mutex stats_mutex_;
+  Stats stats_;
+};
+
+}  // namespace headless
+}  // namespace test
+}  // namespace bluetooth
@@ -36,6 +36,7 @@ enum OptionType {
   kOptionStdErr = 4,
   kOptionFlags = 5,
   kOptionClear = 6,
+  kOptionTrace = 7,
 };
 
 constexpr struct option long_options[] = {
@@ -46,6 +47,7 @@ constexpr struct option long_options[] = {
     {"stderr", no_argument, 0, 0},        // kOptionStdErr
     {"flags", required_argument, 0, 0},   // kOptionFlags
     {"clear", no_argument, 0, 0},         // kOptionDevice
+    {"trace", required_argument, 0, 0},   // kOptionTrace
     {0, 0, 0, 0}};
 
 const char* kShortArgs = "cd:l:u:";
@@ -66,6 +68,10 @@ void bluetooth::test::headless::GetOpt::Usage() const {
   fprintf(stdout, "%s  --loop=<loop>       Number of loops\n", name_);
   fprintf(stdout, "%s  --msleep=<msecs>    Sleep msec between loops\n", name_);
   fprintf(stdout, "%s  --stderr            Dump stderr to stdout\n", name_);
+  fprintf(stdout,
+          "%s  --trace=<path>      Write a Chrome trace of the stack enable "
+          "and disable\n",
+          name_);
   fflush(nullptr);
 }
 
@@ -141,6 +147,10 @@ void bluetooth::test::headless::GetOpt::ProcessOption(int option_index,
     case kOptionClear:
       clear_logcat_ = true;
       break;
+    case kOptionTrace:
+      if (!optarg) return;
+      trace_path_ = optarg;
+      break;
     default:
       fflush(nullptr);
       valid_ = false;
@@ -52,6 +52,9 @@ class GetOpt {
   bool close_stderr_{true};
   bool clear_logcat_{false};
 
+  // Chrome trace of the stack enable and disable, not written if empty
+  std::string trace_path_;
+
   mutable std::list<std::string> non_options_;
 
   static std::vector<std::string> Split(std::string);
@@ -26,6 +26,7 @@
 #include <memory>
 
 #include "gd/os/log.h"
+#include "gd/os/trace.h"
 #include "include/hardware/bluetooth.h"
 #include "test/headless/bt_stack_info.h"
 #include "test/headless/interface.h"
@@ -274,6 +275,7 @@ bt_os_callouts_t bt_os_callouts{
 
 void HeadlessStack::SetUp() {
   log::info("Entry");
+  bluetooth::os::ScopedTrace trace("headless", "set_up");
 
   const bool start_restricted = false;
   const bool is_common_criteria_mode = false;
@@ -312,6 +314,7 @@ void HeadlessStack::SetUp() {
 }
 
 void HeadlessStack::TearDown() {
+  bluetooth::os::ScopedTrace trace("headless", "tear_down");
   bluetooth::test::headless::stop_messenger();
 
   log::info("Stack has disabled");
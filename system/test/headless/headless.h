@@ -21,6 +21,7 @@
 
 #include <unordered_map>
 
+#include "gd/os/trace.h"
 #include "include/hardware/bluetooth.h"
 #include "test/headless/bt_stack_info.h"
 #include "test/headless/get_options.h"
@@ -71,6 +72,9 @@ class HeadlessRun : public HeadlessStack {
   template <typename T>
   T RunOnHeadlessStack(ExecutionUnit<T> func) {
     log::info("{}", kHeadlessInitialSentinel);
+    if (!options_.trace_path_.empty()) {
+      bluetooth::os::StartTracing();
+    }
     SetUp();
     log::info("{}", kHeadlessStartSentinel);
 
@@ -94,6 +98,12 @@ class HeadlessRun : public HeadlessStack {
 
     log::info("{}", kHeadlessStopSentinel);
     TearDown();
+    if (!options_.trace_path_.empty()) {
+      bluetooth::os::StopTracing();
+      if (bluetooth::os::WriteChromeTrace(options_.trace_path_)) {
+        LOG_CONSOLE("Wrote trace to %s", options_.trace_path_.c_str());
+      }
+    }
     log::info("{}", kHeadlessFinalSentinel);
     return rc;
   }
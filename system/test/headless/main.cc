@@ -26,6 +26,7 @@
 #include <unordered_map>
 
 #include "os/log.h"           // android log only
+#include "test/headless/a2dp/a2dp.h"
 #include "test/headless/adapter/adapter.h"
 #include "test/headless/connect/connect.h"
 #include "test/headless/discovery/discovery.h"
@@ -94,6 +95,8 @@ class Main : public HeadlessTest<int> {
  public:
   Main(const bluetooth::test::headless::GetOpt& options)
       : HeadlessTest<int>(options) {
+    test_nodes_.emplace(
+        "a2dp", std::make_unique<bluetooth::test::headless::A2dp>(options));
     test_nodes_.emplace(
         "adapter",
         std::make_unique<bluetooth::test::headless::Adapter>(options));
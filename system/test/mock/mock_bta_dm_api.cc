@@ -58,6 +58,8 @@ struct BTA_DmCheckLeAudioCapable BTA_DmCheckLeAudioCapable;
 struct BTA_DmClearEventFilter BTA_DmClearEventFilter;
 struct BTA_DmClearEventMask BTA_DmClearEventMask;
 struct BTA_DmClearFilterAcceptList BTA_DmClearFilterAcceptList;
+struct BTA_DmBeginLeListUpdates BTA_DmBeginLeListUpdates;
+struct BTA_DmCommitLeListUpdates BTA_DmCommitLeListUpdates;
 struct BTA_DmConfirm BTA_DmConfirm;
 struct BTA_DmDisconnectAllAcls BTA_DmDisconnectAllAcls;
 struct BTA_DmDiscover BTA_DmDiscover;
@@ -205,6 +207,14 @@ void BTA_DmClearFilterAcceptList(void) {
   inc_func_call_count(__func__);
   test::mock::bta_dm_api::BTA_DmClearFilterAcceptList();
 }
+void BTA_DmBeginLeListUpdates(void) {
+  inc_func_call_count(__func__);
+  test::mock::bta_dm_api::BTA_DmBeginLeListUpdates();
+}
+void BTA_DmCommitLeListUpdates(void) {
+  inc_func_call_count(__func__);
+  test::mock::bta_dm_api::BTA_DmCommitLeListUpdates();
+}
 void BTA_DmConfirm(const RawAddress& bd_addr, bool accept) {
   inc_func_call_count(__func__);
   test::mock::bta_dm_api::BTA_DmConfirm(bd_addr, accept);
@@ -321,6 +321,24 @@ struct BTA_DmClearFilterAcceptList {
 };
 extern struct BTA_DmClearFilterAcceptList BTA_DmClearFilterAcceptList;
 
+// Name: BTA_DmBeginLeListUpdates
+// Params: void
+// Return: void
+struct BTA_DmBeginLeListUpdates {
+  std::function<void(void)> body{[](void) {}};
+  void operator()(void) { body(); };
+};
+extern struct BTA_DmBeginLeListUpdates BTA_DmBeginLeListUpdates;
+
+// Name: BTA_DmCommitLeListUpdates
+// Params: void
+// Return: void
+struct BTA_DmCommitLeListUpdates {
+  std::function<void(void)> body{[](void) {}};
+  void operator()(void) { body(); };
+};
+extern struct BTA_DmCommitLeListUpdates BTA_DmCommitLeListUpdates;
+
 // Name: BTA_DmConfirm
 // Params: const RawAddress& bd_addr, bool accept
 // Return: void
@@ -75,6 +75,10 @@ void BTA_GATTC_AppRegister(tBTA_GATTC_CBACK* /* p_client_cb */,
                            bool /* eatt_support */) {
   inc_func_call_count(__func__);
 }
+void BTA_GATTC_RunAfterQueuedOpens(base::OnceClosure callback) {
+  inc_func_call_count(__func__);
+  std::move(callback).Run();
+}
 void BTA_GATTC_CancelOpen(tGATT_IF /* client_if */,
                           const RawAddress& /* remote_bda */,
                           bool /* is_direct */) {
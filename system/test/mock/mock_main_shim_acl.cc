@@ -208,6 +208,12 @@ void shim::legacy::Acl::ClearAddressResolution() {
   inc_func_call_count(__func__);
 }
 
+void shim::legacy::Acl::BeginLeListUpdates() { inc_func_call_count(__func__); }
+
+void shim::legacy::Acl::CommitLeListUpdates() {
+  inc_func_call_count(__func__);
+}
+
 void shim::legacy::Acl::SetSystemSuspendState(bool /* suspended */) {
   inc_func_call_count(__func__);
 }
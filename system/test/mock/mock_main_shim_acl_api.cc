@@ -93,6 +93,12 @@ void bluetooth::shim::ACL_RemoveFromAddressResolution(
 void bluetooth::shim::ACL_ClearAddressResolution() {
   inc_func_call_count(__func__);
 }
+void bluetooth::shim::ACL_BeginLeListUpdates() {
+  inc_func_call_count(__func__);
+}
+void bluetooth::shim::ACL_CommitLeListUpdates() {
+  inc_func_call_count(__func__);
+}
 void bluetooth::shim::ACL_LeSetDefaultSubrate(uint16_t /* subrate_min */,
                                               uint16_t /* subrate_max */,
                                               uint16_t /* max_latency */,
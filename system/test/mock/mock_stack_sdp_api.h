@@ -155,6 +155,19 @@ struct SDP_ServiceSearchAttributeRequest2 {
 };
 extern struct SDP_ServiceSearchAttributeRequest2
     SDP_ServiceSearchAttributeRequest2;
+// Name: SDP_ReadCachedRecords
+// Params: const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db
+// Returns: bool
+struct SDP_ReadCachedRecords {
+  std::function<bool(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db)> body{
+      [](const RawAddress& /* bd_addr */, tSDP_DISCOVERY_DB* /* p_db */) {
+        return false;
+      }};
+  bool operator()(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db) {
+    return body(bd_addr, p_db);
+  };
+};
+extern struct SDP_ReadCachedRecords SDP_ReadCachedRecords;
 // Name: SDP_ServiceSearchRequest
 // Params: const RawAddress& p_bd_addr, tSDP_DISCOVERY_DB* p_db,
 // tSDP_DISC_CMPL_CB* p_cb Returns: bool
@@ -39,6 +39,12 @@ bool UIPC_Send(tUIPC_STATE& /* uipc */, tUIPC_CH_ID /* ch_id */,
   inc_func_call_count(__func__);
   return mock_uipc_send_ret;
 }
+bool UIPC_SendFds(tUIPC_STATE& /* uipc */, tUIPC_CH_ID /* ch_id */,
+                  const uint8_t* /* p_buf */, uint16_t /* msglen */,
+                  const int* /* fds */, size_t /* num_fds */) {
+  inc_func_call_count(__func__);
+  return mock_uipc_send_ret;
+}
 int uipc_start_main_server_thread(tUIPC_STATE& /* uipc */) {
   inc_func_call_count(__func__);
   return 0;
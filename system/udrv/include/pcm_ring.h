@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/*
+ * Single producer, single consumer PCM ring in shared memory.
+ *
+ * An alternative to the UIPC audio channel for the host audio paths: the
+ * samples are copied once into a memfd mapping shared with the audio server
+ * instead of going through a socket, and the consumer is only woken up through
+ * an eventfd when it is actually waiting for data.
+ *
+ * One side creates the ring and passes the memfd and the eventfd to the other
+ * side (e.g. over the control socket with SCM_RIGHTS), which attaches to it.
+ * The memfd is sealed against resizing, and positions written by the other
+ * side that do not fit in the ring reset it instead of being followed.
+ */
+
+/* Layout of the shared memory header. The positions are free running byte
+ * counters, each on its own cache line.
+ */
+struct tPCM_RING_SHARED {
+  alignas(64) std::atomic<uint64_t> write_pos;
+  alignas(64) std::atomic<uint64_t> read_pos;
+  alignas(64) std::atomic<uint32_t> reader_waiting;
+  uint32_t capacity;
+};
+
+struct tPCM_RING {
+  int mem_fd{-1};
+  int data_fd{-1};
+  size_t map_size{0};
+  /* Local copy of shared->capacity, which the other side could change */
+  uint32_t capacity{0};
+  tPCM_RING_SHARED* shared{nullptr};
+  uint8_t* data{nullptr};
+
+  tPCM_RING() = default;
+  tPCM_RING(const tPCM_RING&) = delete;
+  tPCM_RING& operator=(const tPCM_RING&) = delete;
+  ~tPCM_RING();
+};
+
+/**
+ * Create a PCM ring
+ *
+ * @param capacity Ring size in bytes, rounded up to a power of two
+ * @return the ring, or nullptr on failure
+ */
+std::unique_ptr<tPCM_RING> PCM_RING_Create(uint32_t capacity);
+
+/**
+ * Attach to a PCM ring created by the other side
+ *
+ * @param mem_fd Shared memory file descriptor, owned by the ring on success
+ * @param data_fd Data eventfd, owned by the ring on success
+ * @return the ring, or nullptr on failure
+ */
+std::unique_ptr<tPCM_RING> PCM_RING_Attach(int mem_fd, int data_fd);
+
+/**
+ * Write to the ring without blocking
+ *
+ * @param p_buf Samples to write
+ * @param len Bytes to write
+ * @return the number of bytes written, less than len when the ring is full
+ */
+uint32_t PCM_RING_Write(tPCM_RING& ring, const uint8_t* p_buf, uint32_t len);
+
+/**
+ * Read from the ring
+ *
+ * @param p_buf Buffer for the samples
+ * @param len Bytes to read
+ * @param timeout_ms How long to wait for len bytes to be available, as the
+ *                   UIPC channel read poll timeout
+ * @return the number of bytes read
+ */
+uint32_t PCM_RING_Read(tPCM_RING& ring, uint8_t* p_buf, uint32_t len,
+                       int timeout_ms);
+
+/**
+ * Number of bytes available for reading
+ */
+uint32_t PCM_RING_Available(const tPCM_RING& ring);
+
+/**
+ * Drop everything written so far, as UIPC_REQ_RX_FLUSH. Called by the reader.
+ */
+void PCM_RING_Flush(tPCM_RING& ring);
@@ -33,6 +33,8 @@
 
 #define DEFAULT_READ_POLL_TMO_MS 100
 
+#define UIPC_MAX_SEND_FDS 4
+
 typedef uint8_t tUIPC_CH_ID;
 
 /* Events generated */
@@ -119,6 +121,20 @@ void UIPC_Close(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id);
 bool UIPC_Send(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint16_t msg_evt,
                const uint8_t* p_buf, uint16_t msglen);
 
+/**
+ * Send a message over UIPC along with file descriptors
+ *
+ * @param ch_id Channel ID
+ * @param p_buf Buffer for the message, at least one octet
+ * @param msglen Message length
+ * @param fds File descriptors passed to the peer with SCM_RIGHTS, they stay
+ *            open on this side
+ * @param num_fds Number of file descriptors, at most UIPC_MAX_SEND_FDS
+ * @return true on success, otherwise false
+ */
+bool UIPC_SendFds(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, const uint8_t* p_buf,
+                  uint16_t msglen, const int* fds, size_t num_fds);
+
 /**
  * Read a message from UIPC
  *
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Loopback comparison of the UIPC audio channel and the shared memory PCM
+// ring. A writer thread stands for the audio server and delivers one
+// timestamped PCM period per tick; the benchmark thread reads it the way the
+// A2DP and LE Audio host paths do and records the delivery latency and the
+// process CPU time spent per period.
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "osi/include/socket_utils/sockets.h"
+#include "udrv/include/pcm_ring.h"
+#include "udrv/include/uipc.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// 10 ms of 48 kHz 16 bit stereo, delivered faster than real time to keep the
+// runs short, and the A2DP host data read poll timeout.
+constexpr size_t kPeriodBytes = 1920;
+constexpr auto kTickInterval = std::chrono::microseconds(500);
+constexpr int kReadPollTimeoutMs = 10;
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t process_cpu_us() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// Paces the writer thread and collects the reader side latencies.
+class Loopback {
+ public:
+  template <typename WriteFn>
+  void StartWriter(WriteFn write) {
+    running_ = true;
+    writer_ = std::thread([this, write]() {
+      std::vector<uint8_t> period(kPeriodBytes);
+      auto next = std::chrono::steady_clock::now();
+      while (running_) {
+        next += kTickInterval;
+        std::this_thread::sleep_until(next);
+        int64_t timestamp = now_ns();
+        memcpy(period.data(), &timestamp, sizeof(timestamp));
+        if (!write(period.data(), period.size())) overruns_++;
+      }
+    });
+  }
+
+  void StopWriter() {
+    running_ = false;
+    if (writer_.joinable()) writer_.join();
+  }
+
+  void OnPeriod(const uint8_t* period) {
+    int64_t timestamp;
+    memcpy(&timestamp, period, sizeof(timestamp));
+    latencies_ns_.push_back(now_ns() - timestamp);
+  }
+
+  void Report(State& state, int64_t cpu_us) {
+    if (latencies_ns_.empty()) return;
+    std::sort(latencies_ns_.begin(), latencies_ns_.end());
+    int64_t total = 0;
+    for (int64_t latency : latencies_ns_) total += latency;
+    size_t n = latencies_ns_.size();
+    state.counters["latency_avg_us"] = total / n / 1000.0;
+    state.counters["latency_p99_us"] = latencies_ns_[n * 99 / 100] / 1000.0;
+    state.counters["latency_max_us"] = latencies_ns_[n - 1] / 1000.0;
+    state.counters["cpu_us_per_period"] = (double)cpu_us / n;
+    state.counters["overruns"] = overruns_.load();
+    state.SetBytesProcessed(n * kPeriodBytes);
+  }
+
+ private:
+  std::atomic<bool> running_{false};
+  std::atomic<int> overruns_{0};
+  std::thread writer_;
+  std::vector<int64_t> latencies_ns_;
+};
+
+std::unique_ptr<tUIPC_STATE> uipc;
+
+void uipc_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event != UIPC_OPEN_EVT) return;
+  // Read directly from the benchmark thread, as btif_a2dp_data_cb does.
+  UIPC_Ioctl(*uipc, ch_id, UIPC_REG_REMOVE_ACTIVE_READSET, nullptr);
+  UIPC_Ioctl(*uipc, ch_id, UIPC_SET_READ_POLL_TMO,
+             reinterpret_cast<void*>(kReadPollTimeoutMs));
+}
+
+int connect_uipc_client(const std::string& path) {
+  return osi_socket_local_client(path.c_str(),
+#ifdef __ANDROID__
+                                 ANDROID_SOCKET_NAMESPACE_ABSTRACT,
+#else   // !__ANDROID__
+                                 ANDROID_SOCKET_NAMESPACE_FILESYSTEM,
+#endif  // __ANDROID__
+                                 SOCK_STREAM);
+}
+
+}  // namespace
+
+static void BM_UipcLoopback(State& state) {
+  std::string path = "/tmp/bt_pcm_ring_benchmark." + std::to_string(getpid());
+  uipc = UIPC_Init();
+  UIPC_Open(*uipc, UIPC_CH_ID_AV_AUDIO, uipc_data_cb, path.c_str());
+  int client_fd = connect_uipc_client(path);
+  if (client_fd < 0) {
+    state.SkipWithError("unable to connect to the UIPC channel");
+    UIPC_Close(*uipc, UIPC_CH_ID_ALL);
+    uipc.reset();
+    return;
+  }
+  // Wait for the UIPC thread to accept the connection.
+  while (uipc->ch[UIPC_CH_ID_AV_AUDIO].fd == -1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  Loopback loopback;
+  loopback.StartWriter([client_fd](const uint8_t* p_buf, size_t len) {
+    return send(client_fd, p_buf, len, MSG_NOSIGNAL | MSG_DONTWAIT) ==
+           (ssize_t)len;
+  });
+
+  std::vector<uint8_t> period(kPeriodBytes);
+  int64_t cpu_start_us = process_cpu_us();
+  for (auto _ : state) {
+    if (UIPC_Read(*uipc, UIPC_CH_ID_AV_AUDIO, period.data(), period.size()) ==
+        period.size()) {
+      loopback.OnPeriod(period.data());
+    }
+  }
+  int64_t cpu_us = process_cpu_us() - cpu_start_us;
+
+  loopback.StopWriter();
+  close(client_fd);
+  UIPC_Close(*uipc, UIPC_CH_ID_ALL);
+  uipc.reset();
+  unlink(path.c_str());
+  loopback.Report(state, cpu_us);
+}
+BENCHMARK(BM_UipcLoopback)->Iterations(4000)->UseRealTime();
+
+static void BM_PcmRingLoopback(State& state) {
+  auto reader = PCM_RING_Create(kPeriodBytes * 32);
+  auto writer = reader == nullptr ? nullptr
+                                  : PCM_RING_Attach(dup(reader->mem_fd),
+                                                    dup(reader->data_fd));
+  if (writer == nullptr) {
+    state.SkipWithError("unable to attach to the PCM ring");
+    return;
+  }
+
+  Loopback loopback;
+  loopback.StartWriter([&writer](const uint8_t* p_buf, size_t len) {
+    // Drop whole periods on overrun, like a full socket buffer would.
+    if (writer->capacity - PCM_RING_Available(*writer) < len) {
+      return false;
+    }
+    return PCM_RING_Write(*writer, p_buf, len) == len;
+  });
+
+  std::vector<uint8_t> period(kPeriodBytes);
+  int64_t cpu_start_us = process_cpu_us();
+  for (auto _ : state) {
+    if (PCM_RING_Read(*reader, period.data(), period.size(),
+                      kReadPollTimeoutMs) == period.size()) {
+      loopback.OnPeriod(period.data());
+    }
+  }
+  int64_t cpu_us = process_cpu_us() - cpu_start_us;
+
+  loopback.StopWriter();
+  loopback.Report(state, cpu_us);
+}
+BENCHMARK(BM_PcmRingLoopback)->Iterations(4000)->UseRealTime();
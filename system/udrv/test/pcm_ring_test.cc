@@ -0,0 +1,201 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udrv/include/pcm_ring.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> make_pattern(size_t len, uint8_t seed) {
+  std::vector<uint8_t> buf(len);
+  std::iota(buf.begin(), buf.end(), seed);
+  return buf;
+}
+
+TEST(PcmRingTest, create_rounds_capacity_up) {
+  auto ring = PCM_RING_Create(1000);
+  ASSERT_NE(ring, nullptr);
+  EXPECT_EQ(ring->shared->capacity, 1024u);
+  EXPECT_EQ(PCM_RING_Available(*ring), 0u);
+
+  EXPECT_EQ(PCM_RING_Create(0), nullptr);
+}
+
+TEST(PcmRingTest, write_read_wraps_around) {
+  auto ring = PCM_RING_Create(64);
+  ASSERT_NE(ring, nullptr);
+
+  std::vector<uint8_t> out(48);
+  for (uint8_t seed = 0; seed < 10; seed++) {
+    auto in = make_pattern(48, seed);
+    ASSERT_EQ(PCM_RING_Write(*ring, in.data(), in.size()), 48u);
+    EXPECT_EQ(PCM_RING_Available(*ring), 48u);
+    ASSERT_EQ(PCM_RING_Read(*ring, out.data(), out.size(), 0), 48u);
+    EXPECT_EQ(in, out);
+  }
+}
+
+TEST(PcmRingTest, write_stops_when_full) {
+  auto ring = PCM_RING_Create(64);
+  ASSERT_NE(ring, nullptr);
+
+  auto in = make_pattern(100, 0);
+  EXPECT_EQ(PCM_RING_Write(*ring, in.data(), in.size()), 64u);
+  EXPECT_EQ(PCM_RING_Write(*ring, in.data(), in.size()), 0u);
+
+  std::vector<uint8_t> out(100);
+  EXPECT_EQ(PCM_RING_Read(*ring, out.data(), out.size(), 0), 64u);
+  EXPECT_TRUE(std::equal(in.begin(), in.begin() + 64, out.begin()));
+}
+
+TEST(PcmRingTest, read_times_out) {
+  auto ring = PCM_RING_Create(64);
+  ASSERT_NE(ring, nullptr);
+
+  auto in = make_pattern(16, 0);
+  PCM_RING_Write(*ring, in.data(), in.size());
+
+  std::vector<uint8_t> out(32);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(PCM_RING_Read(*ring, out.data(), out.size(), 20), 16u);
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+  EXPECT_EQ(ring->shared->reader_waiting.load(), 0u);
+}
+
+TEST(PcmRingTest, flush) {
+  auto ring = PCM_RING_Create(64);
+  ASSERT_NE(ring, nullptr);
+
+  auto in = make_pattern(40, 0);
+  PCM_RING_Write(*ring, in.data(), in.size());
+  PCM_RING_Flush(*ring);
+  EXPECT_EQ(PCM_RING_Available(*ring), 0u);
+  EXPECT_EQ(PCM_RING_Write(*ring, in.data(), in.size()), 40u);
+}
+
+TEST(PcmRingTest, attach_shares_the_ring) {
+  auto writer = PCM_RING_Create(256);
+  ASSERT_NE(writer, nullptr);
+
+  auto reader =
+      PCM_RING_Attach(dup(writer->mem_fd), dup(writer->data_fd));
+  ASSERT_NE(reader, nullptr);
+  EXPECT_NE(reader->shared, writer->shared);
+  EXPECT_EQ(reader->shared->capacity, 256u);
+
+  auto in = make_pattern(200, 3);
+  PCM_RING_Write(*writer, in.data(), in.size());
+  std::vector<uint8_t> out(200);
+  EXPECT_EQ(PCM_RING_Read(*reader, out.data(), out.size(), 0), 200u);
+  EXPECT_EQ(in, out);
+  EXPECT_EQ(PCM_RING_Available(*writer), 0u);
+}
+
+TEST(PcmRingTest, attach_rejects_invalid_memory) {
+  int fd = memfd_create("pcm_ring_test", 0);
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(PCM_RING_Attach(fd, -1), nullptr);
+  close(fd);
+}
+
+TEST(PcmRingTest, attach_rejects_unsealed_memory) {
+  int fd = memfd_create("pcm_ring_test", MFD_ALLOW_SEALING);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(ftruncate(fd, sizeof(tPCM_RING_SHARED) + 64), 0);
+  tPCM_RING_SHARED header{};
+  header.capacity = 64;
+  ASSERT_EQ(pwrite(fd, &header, sizeof(header), 0), (ssize_t)sizeof(header));
+
+  EXPECT_EQ(PCM_RING_Attach(fd, -1), nullptr);
+  close(fd);
+}
+
+TEST(PcmRingTest, shared_capacity_is_not_trusted) {
+  auto writer = PCM_RING_Create(256);
+  ASSERT_NE(writer, nullptr);
+  auto reader =
+      PCM_RING_Attach(dup(writer->mem_fd), dup(writer->data_fd));
+  ASSERT_NE(reader, nullptr);
+
+  auto in = make_pattern(200, 0);
+  ASSERT_EQ(PCM_RING_Write(*writer, in.data(), in.size()), 200u);
+  writer->shared->capacity = 16;
+
+  std::vector<uint8_t> out(200);
+  EXPECT_EQ(PCM_RING_Read(*reader, out.data(), out.size(), 0), 200u);
+  EXPECT_EQ(in, out);
+}
+
+TEST(PcmRingTest, corrupted_positions_reset_the_ring) {
+  auto writer = PCM_RING_Create(64);
+  ASSERT_NE(writer, nullptr);
+  auto reader =
+      PCM_RING_Attach(dup(writer->mem_fd), dup(writer->data_fd));
+  ASSERT_NE(reader, nullptr);
+
+  std::vector<uint8_t> out(64);
+  writer->shared->write_pos = 1 << 20;
+  EXPECT_EQ(PCM_RING_Available(*reader), 0u);
+  EXPECT_EQ(PCM_RING_Read(*reader, out.data(), out.size(), 0), 0u);
+  EXPECT_EQ(reader->shared->read_pos.load(), 1u << 20);
+
+  reader->shared->read_pos = (1 << 20) + 1000;
+  auto in = make_pattern(48, 0);
+  EXPECT_EQ(PCM_RING_Write(*writer, in.data(), in.size()), 0u);
+  EXPECT_EQ(PCM_RING_Write(*writer, in.data(), in.size()), 48u);
+  EXPECT_EQ(PCM_RING_Read(*reader, out.data(), 48, 0), 48u);
+  EXPECT_TRUE(std::equal(in.begin(), in.end(), out.begin()));
+}
+
+TEST(PcmRingTest, blocked_reader_is_woken_up) {
+  constexpr size_t kPeriod = 512;
+  constexpr int kPeriods = 200;
+  auto ring = PCM_RING_Create(kPeriod * 4);
+  ASSERT_NE(ring, nullptr);
+
+  std::thread writer([&ring]() {
+    for (int i = 0; i < kPeriods; i++) {
+      auto in = make_pattern(kPeriod, i);
+      size_t written = 0;
+      while (written < kPeriod) {
+        written +=
+            PCM_RING_Write(*ring, in.data() + written, kPeriod - written);
+        if (written < kPeriod) std::this_thread::yield();
+      }
+      if (i % 16 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  });
+
+  std::vector<uint8_t> out(kPeriod);
+  for (int i = 0; i < kPeriods; i++) {
+    ASSERT_EQ(PCM_RING_Read(*ring, out.data(), out.size(), 1000), kPeriod);
+    EXPECT_EQ(out, make_pattern(kPeriod, i));
+  }
+  writer.join();
+}
+
+}  // namespace
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "osi/include/socket_utils/sockets.h"
+#include "udrv/include/pcm_ring.h"
+#include "udrv/include/uipc.h"
+
+namespace {
+
+constexpr uint32_t kPeriod = 512;
+constexpr int kPeriods = 400;
+
+std::atomic<bool> ctrl_connected{false};
+
+void uipc_ctrl_cb(tUIPC_CH_ID /* ch_id */, tUIPC_EVENT event) {
+  if (event == UIPC_OPEN_EVT) ctrl_connected = true;
+}
+
+std::vector<uint8_t> make_pattern(size_t len, uint8_t seed) {
+  std::vector<uint8_t> buf(len);
+  std::iota(buf.begin(), buf.end(), seed);
+  return buf;
+}
+
+// Receives the octet and the descriptors sent with UIPC_SendFds(), as the
+// audio HAL does after the ACK of A2DP_CTRL_GET_PCM_RING.
+size_t receive_fds(int fd, int* fds, size_t max_fds) {
+  uint8_t msg;
+  struct iovec iov;
+  iov.iov_base = &msg;
+  iov.iov_len = sizeof(msg);
+  union {
+    char buf[CMSG_SPACE(sizeof(int) * UIPC_MAX_SEND_FDS)];
+    struct cmsghdr align;
+  } control;
+
+  struct msghdr hdr = {};
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = control.buf;
+  hdr.msg_controllen = sizeof(control.buf);
+  if (recvmsg(fd, &hdr, MSG_CMSG_CLOEXEC) != sizeof(msg)) return 0;
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+  if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS) return 0;
+  size_t num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+  if (num_fds > max_fds) return 0;
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * num_fds);
+  return num_fds;
+}
+
+// The A2DP control channel, with the stack on the UIPC side and the audio HAL
+// on the client side.
+class UipcPcmRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = "/tmp/bt_uipc_pcm_ring_test." + std::to_string(getpid());
+    ctrl_connected = false;
+    uipc_ = UIPC_Init();
+    ASSERT_TRUE(UIPC_Open(*uipc_, UIPC_CH_ID_AV_CTRL, uipc_ctrl_cb,
+                          path_.c_str()));
+    client_fd_ = osi_socket_local_client(path_.c_str(),
+#ifdef __ANDROID__
+                                         ANDROID_SOCKET_NAMESPACE_ABSTRACT,
+#else   // !__ANDROID__
+                                         ANDROID_SOCKET_NAMESPACE_FILESYSTEM,
+#endif  // __ANDROID__
+                                         SOCK_STREAM);
+    ASSERT_GE(client_fd_, 0);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!ctrl_connected && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(ctrl_connected);
+  }
+
+  void TearDown() override {
+    if (client_fd_ >= 0) close(client_fd_);
+    UIPC_Close(*uipc_, UIPC_CH_ID_ALL);
+    uipc_.reset();
+    unlink(path_.c_str());
+  }
+
+  std::string path_;
+  std::unique_ptr<tUIPC_STATE> uipc_;
+  int client_fd_ = -1;
+};
+
+TEST_F(UipcPcmRingTest, send_fds_rejects_invalid_parameters) {
+  uint8_t msg = 0;
+  int fds[UIPC_MAX_SEND_FDS + 1] = {};
+  EXPECT_FALSE(UIPC_SendFds(*uipc_, UIPC_CH_ID_AV_CTRL, &msg, 1, fds, 0));
+  EXPECT_FALSE(UIPC_SendFds(*uipc_, UIPC_CH_ID_AV_CTRL, &msg, 1, fds,
+                            UIPC_MAX_SEND_FDS + 1));
+  EXPECT_FALSE(UIPC_SendFds(*uipc_, UIPC_CH_ID_AV_CTRL, &msg, 0, fds, 1));
+  EXPECT_FALSE(UIPC_SendFds(*uipc_, UIPC_CH_NUM, &msg, 1, fds, 1));
+}
+
+TEST_F(UipcPcmRingTest, stream_through_ring_sent_over_ctrl_channel) {
+  auto reader = PCM_RING_Create(kPeriod * 4);
+  ASSERT_NE(reader, nullptr);
+  uint8_t msg = 0;
+  int fds[] = {reader->mem_fd, reader->data_fd};
+  ASSERT_TRUE(UIPC_SendFds(*uipc_, UIPC_CH_ID_AV_CTRL, &msg, sizeof(msg), fds,
+                           2));
+
+  int received[UIPC_MAX_SEND_FDS];
+  ASSERT_EQ(receive_fds(client_fd_, received, UIPC_MAX_SEND_FDS), 2u);
+  auto writer = PCM_RING_Attach(received[0], received[1]);
+  ASSERT_NE(writer, nullptr);
+
+  std::thread hal([&writer]() {
+    for (int i = 0; i < kPeriods; i++) {
+      auto in = make_pattern(kPeriod, i);
+      uint32_t written = 0;
+      while (written < kPeriod) {
+        written +=
+            PCM_RING_Write(*writer, in.data() + written, kPeriod - written);
+        if (written < kPeriod) std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<uint8_t> out(kPeriod);
+  for (int i = 0; i < kPeriods; i++) {
+    ASSERT_EQ(PCM_RING_Read(*reader, out.data(), out.size(), 1000), kPeriod);
+    EXPECT_EQ(out, make_pattern(kPeriod, i));
+  }
+  hal.join();
+}
+
+}  // namespace
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "pcm_ring"
+
+#include "udrv/include/pcm_ring.h"
+
+#include <bluetooth/log.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include "osi/include/osi.h"
+
+using namespace bluetooth;
+
+namespace {
+
+constexpr uint32_t kMaxCapacity = 1 << 24;
+constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+uint32_t round_up_to_power_of_two(uint32_t value) {
+  uint32_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+uint64_t now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+bool map_ring(tPCM_RING& ring) {
+  struct stat st;
+  if (fstat(ring.mem_fd, &st) < 0 ||
+      st.st_size < (off_t)sizeof(tPCM_RING_SHARED)) {
+    log::error("invalid shared memory");
+    return false;
+  }
+
+  void* addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    ring.mem_fd, 0);
+  if (addr == MAP_FAILED) {
+    log::error("mmap failed ({})", strerror(errno));
+    return false;
+  }
+  ring.map_size = st.st_size;
+  ring.shared = static_cast<tPCM_RING_SHARED*>(addr);
+  ring.data = static_cast<uint8_t*>(addr) + sizeof(tPCM_RING_SHARED);
+  return true;
+}
+
+/* Bytes written and not read yet. The positions live in memory the other
+ * process can write, so a distance larger than the capacity is a fault.
+ */
+bool ring_used(const tPCM_RING& ring, uint64_t write_pos, uint64_t read_pos,
+               uint32_t* used) {
+  uint64_t distance = write_pos - read_pos;
+  if (distance > ring.capacity) {
+    log::error("corrupted ring, write_pos={} read_pos={} capacity={}",
+               write_pos, read_pos, ring.capacity);
+    return false;
+  }
+  *used = (uint32_t)distance;
+  return true;
+}
+
+/* Copies between the ring and |p_buf| from the free running position |pos|,
+ * wrapping around the end of the ring. |len| is at most the capacity.
+ */
+void copy_to_ring(tPCM_RING& ring, uint64_t pos, const uint8_t* p_buf,
+                  uint32_t len) {
+  uint32_t capacity = ring.capacity;
+  uint32_t offset = pos & (capacity - 1);
+  uint32_t first = std::min(len, capacity - offset);
+  memcpy(ring.data + offset, p_buf, first);
+  memcpy(ring.data, p_buf + first, len - first);
+}
+
+void copy_from_ring(const tPCM_RING& ring, uint64_t pos, uint8_t* p_buf,
+                    uint32_t len) {
+  uint32_t capacity = ring.capacity;
+  uint32_t offset = pos & (capacity - 1);
+  uint32_t first = std::min(len, capacity - offset);
+  memcpy(p_buf, ring.data + offset, first);
+  memcpy(p_buf + first, ring.data, len - first);
+}
+
+}  // namespace
+
+tPCM_RING::~tPCM_RING() {
+  if (shared != nullptr) munmap(shared, map_size);
+  if (data_fd != -1) close(data_fd);
+  if (mem_fd != -1) close(mem_fd);
+}
+
+std::unique_ptr<tPCM_RING> PCM_RING_Create(uint32_t capacity) {
+  if (capacity == 0 || capacity > kMaxCapacity) {
+    log::error("invalid capacity {}", capacity);
+    return nullptr;
+  }
+  capacity = round_up_to_power_of_two(capacity);
+
+  auto ring = std::make_unique<tPCM_RING>();
+  ring->mem_fd = memfd_create("bt_pcm_ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (ring->mem_fd < 0) {
+    log::error("memfd_create failed ({})", strerror(errno));
+    return nullptr;
+  }
+  if (ftruncate(ring->mem_fd, sizeof(tPCM_RING_SHARED) + capacity) < 0) {
+    log::error("ftruncate failed ({})", strerror(errno));
+    return nullptr;
+  }
+  /* The other side must not be able to shrink the mapping under us */
+  if (fcntl(ring->mem_fd, F_ADD_SEALS, kRequiredSeals) < 0) {
+    log::error("sealing failed ({})", strerror(errno));
+    return nullptr;
+  }
+
+  ring->data_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (ring->data_fd < 0) {
+    log::error("eventfd failed ({})", strerror(errno));
+    return nullptr;
+  }
+
+  if (!map_ring(*ring)) return nullptr;
+  new (ring->shared) tPCM_RING_SHARED();
+  ring->shared->capacity = capacity;
+  ring->capacity = capacity;
+  return ring;
+}
+
+std::unique_ptr<tPCM_RING> PCM_RING_Attach(int mem_fd, int data_fd) {
+  auto ring = std::make_unique<tPCM_RING>();
+  ring->mem_fd = mem_fd;
+  ring->data_fd = data_fd;
+
+  /* Without the seals the creator could truncate the memory and fault us */
+  int seals = fcntl(mem_fd, F_GET_SEALS);
+  bool valid = seals >= 0 && (seals & kRequiredSeals) == kRequiredSeals &&
+               map_ring(*ring);
+  if (valid) {
+    /* Read once: the shared copy is never trusted again */
+    ring->capacity = ring->shared->capacity;
+    valid = ring->capacity != 0 && ring->capacity <= kMaxCapacity &&
+            (ring->capacity & (ring->capacity - 1)) == 0 &&
+            ring->map_size >= sizeof(tPCM_RING_SHARED) + ring->capacity;
+  }
+  if (!valid) {
+    log::error("invalid ring");
+    /* The caller keeps the descriptors on failure */
+    ring->mem_fd = -1;
+    ring->data_fd = -1;
+    return nullptr;
+  }
+  return ring;
+}
+
+uint32_t PCM_RING_Write(tPCM_RING& ring, const uint8_t* p_buf, uint32_t len) {
+  tPCM_RING_SHARED* shared = ring.shared;
+  uint64_t write_pos = shared->write_pos.load(std::memory_order_relaxed);
+  uint64_t read_pos = shared->read_pos.load(std::memory_order_acquire);
+  uint32_t used;
+  if (!ring_used(ring, write_pos, read_pos, &used)) {
+    /* Drop what was written and start over from the reader position */
+    shared->write_pos.store(read_pos, std::memory_order_seq_cst);
+    return 0;
+  }
+  len = std::min(len, ring.capacity - used);
+  if (len == 0) return 0;
+
+  copy_to_ring(ring, write_pos, p_buf, len);
+  shared->write_pos.store(write_pos + len, std::memory_order_seq_cst);
+
+  /* Only pay for the syscall when the reader is sleeping */
+  if (shared->reader_waiting.load(std::memory_order_seq_cst)) {
+    eventfd_write(ring.data_fd, 1);
+  }
+  return len;
+}
+
+uint32_t PCM_RING_Available(const tPCM_RING& ring) {
+  uint32_t used;
+  if (!ring_used(ring, ring.shared->write_pos.load(std::memory_order_acquire),
+                 ring.shared->read_pos.load(std::memory_order_relaxed),
+                 &used)) {
+    return 0;
+  }
+  return used;
+}
+
+uint32_t PCM_RING_Read(tPCM_RING& ring, uint8_t* p_buf, uint32_t len,
+                       int timeout_ms) {
+  tPCM_RING_SHARED* shared = ring.shared;
+  uint64_t deadline_ms = now_ms() + std::max(timeout_ms, 0);
+  uint32_t n_read = 0;
+
+  while (n_read < len) {
+    uint64_t write_pos = shared->write_pos.load(std::memory_order_acquire);
+    uint64_t read_pos = shared->read_pos.load(std::memory_order_relaxed);
+    uint32_t available;
+    if (!ring_used(ring, write_pos, read_pos, &available)) {
+      /* Drop what is in the ring and start over from the writer position */
+      shared->read_pos.store(write_pos, std::memory_order_release);
+      break;
+    }
+    if (available == 0) {
+      int64_t remaining_ms = (int64_t)(deadline_ms - now_ms());
+      if (timeout_ms <= 0 || remaining_ms <= 0) break;
+
+      /* Announce the wait before checking again, so that a write done in
+       * between either is seen here or wakes us up.
+       */
+      shared->reader_waiting.store(1, std::memory_order_seq_cst);
+      if (PCM_RING_Available(ring) == 0) {
+        struct pollfd pfd;
+        pfd.fd = ring.data_fd;
+        pfd.events = POLLIN;
+        int poll_ret;
+        OSI_NO_INTR(poll_ret = poll(&pfd, 1, remaining_ms));
+        if (poll_ret < 0) {
+          log::error("poll() failed: errno {} ({})", errno, strerror(errno));
+          shared->reader_waiting.store(0, std::memory_order_relaxed);
+          break;
+        }
+      }
+      shared->reader_waiting.store(0, std::memory_order_relaxed);
+      eventfd_t value;
+      eventfd_read(ring.data_fd, &value);
+      continue;
+    }
+
+    uint32_t n = std::min(len - n_read, available);
+    copy_from_ring(ring, read_pos, p_buf + n_read, n);
+    shared->read_pos.store(read_pos + n, std::memory_order_release);
+    n_read += n;
+  }
+
+  return n_read;
+}
+
+void PCM_RING_Flush(tPCM_RING& ring) {
+  ring.shared->read_pos.store(
+      ring.shared->write_pos.load(std::memory_order_acquire),
+      std::memory_order_release);
+}